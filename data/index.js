@@ -3,11 +3,27 @@ var humidity_element
 var time_element
 var update_interval
 var timer_interval
+var event_source
+var json_etag
 var json_time
 var update_time
 
 function init(){
-update_interval=window.setInterval(update,1000)
+if(typeof(EventSource)=='function'){
+event_source=new EventSource('events')
+event_source.addEventListener('measurement',(event)=>{
+setMeasurements(JSON.parse(event.data))
+})
+event_source.addEventListener('error',()=>{
+//AclosedeventsourcemeanstheESPrejectedtheconnection.
+if(event_source.readyState==EventSource.CLOSED){
+console.warn('Event stream unavailable, falling back to polling.')
+startPolling()
+}
+})
+}else{
+startPolling()
+}
 timer_interval=window.setInterval(timer,1000)
 temp_element=document.getElementById('temp')
 humidity_element=document.getElementById('humid')
@@ -16,8 +32,26 @@ json_time=parseTimeString(time_element.innerText)
 update_time=Date.now()
 }
 
+function startPolling(){
+if(update_interval==undefined){
+update_interval=window.setInterval(update,1000)
+}
+}
+
+function setMeasurements(data){
+temp_element.innerText=data.temperature
+humidity_element.innerText=data.humidity
+time_element.innerText=time_element.dateTime=data.time
+json_time=parseTimeString(data.time)
+update_time=Date.now()
+}
+
 function update(){
-var options={method:'GET'}
+//Sendtheentitytagmanually,sothatunchangedmeasurementsresultin a304responseinsteadofacachedbody.
+var options={method:'GET',cache:'no-store',headers:{}}
+if(json_etag!=undefined){
+options.headers['If-None-Match']=json_etag
+}
 var timeout
 if(typeof(AbortController)=='function'){
 const abort=new AbortController();
@@ -30,13 +64,15 @@ fetch('data.json',options)
 if(timeout!=undefined){
 clearTimeout(timeout)
 }
+if(res.status==304){
+return null
+}
+json_etag=res.headers.get('ETag')
 return res.json()
 }).then((out)=>{
-temp_element.innerText=out.temperature
-humidity_element.innerText=out.humidity
-time_element.innerText=time_element.dateTime=out.time
-json_time=parseTimeString(out.time)
-update_time=Date.now()
+if(out!=null){
+setMeasurements(out)
+}
 }).catch((err)=>{
 if(timeout!=undefined){
 clearTimeout(timeout)
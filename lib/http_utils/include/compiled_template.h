@@ -0,0 +1,137 @@
+/*
+ * compiled_template.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_HTTP_UTILS_COMPILED_TEMPLATE_H_
+#define LIB_HTTP_UTILS_COMPILED_TEMPLATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace http {
+
+/**
+ * A static file with placeholders, parsed into a list of literal spans and placeholder ids once.
+ *
+ * Placeholders are formatted like this: $NAME$.
+ * Placeholders whose name isn't known are replaced with their name.
+ * A single delimiter without a matching closing delimiter is kept as is.
+ *
+ * The literal spans point into the original file, so it has to outlive the compiled template.
+ */
+class CompiledTemplate {
+public:
+	/**
+	 * The placeholder id of literal segments.
+	 */
+	static constexpr uint8_t LITERAL = UINT8_MAX;
+
+	/**
+	 * A single part of the compiled template.
+	 * Either a literal span of the original file, or a placeholder.
+	 */
+	struct Segment {
+		/**
+		 * A pointer to the first byte of the literal span.
+		 * NULL for placeholders.
+		 */
+		const uint8_t *data;
+
+		/**
+		 * The length of the literal span.
+		 * Zero for placeholders.
+		 */
+		size_t len;
+
+		/**
+		 * The index of the placeholder in the placeholder list, or LITERAL for literal spans.
+		 */
+		uint8_t placeholder;
+	};
+
+	/**
+	 * Parses the given file into a list of segments.
+	 *
+	 * @param start			A pointer to the first byte of the file.
+	 * @param end			A pointer to the first byte after the file.
+	 * 						For C strings this is the terminating NUL byte.
+	 * @param placeholders	The names of the placeholders to replace, without delimiters.
+	 * 						The index of a name is the index of its value when filling the template.
+	 * 						Only the first LITERAL names are used.
+	 * @param delimiter		The character starting and ending a placeholder.
+	 */
+	CompiledTemplate(const uint8_t *start, const uint8_t *end,
+			const std::vector<std::string> &placeholders,
+			const char delimiter = '$');
+
+	/**
+	 * Gets the number of bytes of all literal spans combined.
+	 *
+	 * @return	The length of the template without any placeholders.
+	 */
+	size_t getLiteralLength() const;
+
+	/**
+	 * Calculates the length of this template with the given placeholder values.
+	 *
+	 * @param values	The value of each placeholder, by placeholder index.
+	 * 					Placeholders without a value are replaced with an empty string.
+	 * @return	The number of bytes the filled template consists of.
+	 */
+	size_t getLength(const std::vector<std::string> &values) const;
+
+	/**
+	 * Writes a part of the filled template to the given buffer.
+	 *
+	 * This function is stateless, and can start at any index.
+	 * It never writes beyond the end of the filled template, and placeholder values may be split between calls.
+	 *
+	 * @param values	The value of each placeholder, by placeholder index.
+	 * 					Placeholders without a value are replaced with an empty string.
+	 * @param buffer	The buffer to write the data to.
+	 * @param max_len	The max number of bytes to write.
+	 * @param index		The offset in the filled template to start at.
+	 * @return	The number of bytes written to the buffer.
+	 * 			Zero if index is at or after the end of the filled template.
+	 */
+	size_t fill(const std::vector<std::string> &values, uint8_t *buffer,
+			const size_t max_len, size_t index) const;
+
+	/**
+	 * Gets the segments this template consists of.
+	 *
+	 * @return	The compiled segments.
+	 */
+	const std::vector<Segment>& getSegments() const;
+
+private:
+	/**
+	 * The segments this template consists of, in order.
+	 */
+	std::vector<Segment> _segments;
+
+	/**
+	 * The total length of all literal segments.
+	 */
+	size_t _literal_len = 0;
+
+	/**
+	 * Appends a literal span to the segment list.
+	 * Empty spans are ignored.
+	 *
+	 * @param data	The first byte of the span.
+	 * @param len	The length of the span.
+	 */
+	void _addLiteral(const uint8_t *data, const size_t len);
+};
+}
+
+#endif /* LIB_HTTP_UTILS_COMPILED_TEMPLATE_H_ */
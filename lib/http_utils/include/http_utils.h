@@ -0,0 +1,101 @@
+/*
+ * http_utils.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_HTTP_UTILS_HTTP_UTILS_H_
+#define LIB_HTTP_UTILS_HTTP_UTILS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace http {
+
+/**
+ * The max number of candidates a single negotiation can choose from.
+ * Additional candidates are ignored.
+ */
+static constexpr size_t MAX_NEGOTIATION_CANDIDATES = 8;
+
+/**
+ * The q-value used to represent a weight of 1, since q-values are parsed as thousandths.
+ */
+static constexpr uint16_t MAX_QVALUE = 1000;
+
+/**
+ * Selects the best media type for an Accept header from a list of candidates.
+ *
+ * Supports media ranges with a wildcard subtype or type and subtype, as well as a single "*".
+ * Each candidate uses the q-value of the most specific media range matching it.
+ * Media type parameters other than the q-value are ignored.
+ * Matching is case insensitive.
+ *
+ * The header is read in a single pass, without any heap allocation.
+ * Invalid list elements are ignored.
+ *
+ * @param header			The value of the Accept header.
+ * 							NULL if the request had no Accept header, meaning every candidate is acceptable.
+ * @param candidates		The media types the server can send, like "text/plain", ordered by server preference.
+ * @param candidates_len	The number of candidates.
+ * 							At most MAX_NEGOTIATION_CANDIDATES are considered.
+ * @return	The index of the candidate with the highest q-value, or the first of them on a tie.
+ * 			-1 if no candidate is acceptable.
+ */
+int8_t negotiateMediaType(const char *header, const char *const candidates[],
+		const size_t candidates_len);
+
+/**
+ * Selects the best content coding for an Accept-Encoding header from a list of candidates.
+ *
+ * Supports the "*" wildcard, and treats "x-gzip" as an alias of "gzip".
+ * "identity" is acceptable unless explicitly excluded, either directly or by "*;q=0".
+ * Matching is case insensitive.
+ *
+ * The header is read in a single pass, without any heap allocation.
+ * Invalid list elements are ignored.
+ *
+ * @param header			The value of the Accept-Encoding header.
+ * 							NULL if the request had no Accept-Encoding header, meaning every candidate is acceptable.
+ * @param candidates		The content codings the server can send, like "gzip" or "identity", ordered by server preference.
+ * @param candidates_len	The number of candidates.
+ * 							At most MAX_NEGOTIATION_CANDIDATES are considered.
+ * @return	The index of the candidate with the highest q-value, or the first of them on a tie.
+ * 			-1 if no candidate is acceptable.
+ */
+int8_t negotiateEncoding(const char *header, const char *const candidates[],
+		const size_t candidates_len);
+
+/**
+ * Calculates the q-value of each candidate content coding for an Accept-Encoding header.
+ *
+ * Uses the same rules as negotiateEncoding, but lets the caller choose between the acceptable codings.
+ * For example by the size of the representation using each of them.
+ *
+ * @param header			The value of the Accept-Encoding header.
+ * 							NULL if the request had no Accept-Encoding header, meaning every candidate is acceptable.
+ * @param candidates		The content codings the server can send.
+ * @param candidates_len	The number of candidates.
+ * 							At most MAX_NEGOTIATION_CANDIDATES are considered, the others get a q-value of 0.
+ * @param qvalues			The array to write the q-values to, in thousandths.
+ * 							Has to have room for candidates_len values.
+ * 							Candidates that aren't acceptable get a q-value of 0.
+ */
+void getEncodingQValues(const char *header, const char *const candidates[],
+		const size_t candidates_len, int16_t qvalues[]);
+
+/**
+ * Parses a q-value, as defined in RFC 9110, section 12.4.2.
+ *
+ * @param value	The first character of the q-value.
+ * @param len	The length of the q-value.
+ * @return	The q-value in thousandths, or -1 if the value is invalid.
+ */
+int16_t parseQValue(const char *value, const size_t len);
+}
+
+#endif /* LIB_HTTP_UTILS_HTTP_UTILS_H_ */
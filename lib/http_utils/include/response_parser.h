@@ -0,0 +1,241 @@
+/*
+ * response_parser.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_HTTP_UTILS_RESPONSE_PARSER_H_
+#define LIB_HTTP_UTILS_RESPONSE_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace http {
+
+/**
+ * An incremental parser for HTTP/1.x responses, for clients sending requests over a persistent connection.
+ *
+ * The response can be fed to the parser in segments of any size, as they are received.
+ * The parser reads the status line and the headers required to find the end of the response,
+ * and skips the body, so the connection can be reused for the next request.
+ *
+ * The parser never allocates memory.
+ * Header lines longer than the line buffer are truncated, which is only an error for the framing headers.
+ * Other headers can be read using a header callback, called once for each complete header line.
+ */
+class ResponseParser {
+public:
+	/**
+	 * A callback receiving a header of the response.
+	 * The name and value aren't NUL terminated, and are only valid during the call.
+	 *
+	 * @param arg		The argument given when setting the callback.
+	 * @param name		The header name, as sent by the server.
+	 * @param name_len	The length of the header name.
+	 * @param value		The header value, without surrounding whitespace.
+	 * @param value_len	The length of the header value.
+	 */
+	typedef void (*HeaderCallback)(void *arg, const char *name,
+			const size_t name_len, const char *value, const size_t value_len);
+
+	/**
+	 * The size of the buffer for the current line, in bytes.
+	 * The status line, and the Content-Length and Transfer-Encoding headers have to fit into this.
+	 */
+	static constexpr size_t LINE_BUFFER_SIZE = 64;
+
+	/**
+	 * The part of the response the parser is currently reading.
+	 */
+	enum class State : uint8_t {
+		STATUS_LINE,
+		HEADERS,
+		BODY,
+		BODY_UNTIL_CLOSE,
+		CHUNK_SIZE,
+		CHUNK_DATA,
+		CHUNK_DATA_END,
+		TRAILERS,
+		DONE,
+		FAILED
+	};
+
+private:
+	/**
+	 * The part of the response the parser is currently reading.
+	 */
+	State _state;
+
+	/**
+	 * The callback to call for each header, or NULL.
+	 */
+	HeaderCallback _header_callback;
+
+	/**
+	 * The argument to give to the header callback.
+	 */
+	void *_header_callback_arg;
+
+	/**
+	 * The status code of the response, or 0 if the status line wasn't read yet.
+	 */
+	uint16_t _status_code;
+
+	/**
+	 * Whether the connection can be used for another request after this response.
+	 */
+	bool _keep_alive;
+
+	/**
+	 * Whether the response has a Transfer-Encoding header.
+	 */
+	bool _has_transfer_encoding;
+
+	/**
+	 * Whether the last transfer coding of the response is chunked.
+	 */
+	bool _chunked;
+
+	/**
+	 * Whether the response has a Content-Length header.
+	 */
+	bool _has_content_length;
+
+	/**
+	 * The number of body bytes left in the body, or the current chunk.
+	 */
+	uint64_t _remaining;
+
+	/**
+	 * The current line, without the line break.
+	 * Not NUL terminated.
+	 */
+	char _line[LINE_BUFFER_SIZE];
+
+	/**
+	 * The number of bytes in the line buffer.
+	 */
+	size_t _line_len;
+
+	/**
+	 * Whether the current line didn't fit the line buffer.
+	 */
+	bool _line_truncated;
+
+	/**
+	 * Handles the complete line in the line buffer, and changes the state accordingly.
+	 */
+	void handleLine();
+
+	/**
+	 * Parses the status line in the line buffer.
+	 *
+	 * @return	Whether the status line was valid.
+	 */
+	bool parseStatusLine();
+
+	/**
+	 * Parses the header line in the line buffer.
+	 *
+	 * @return	False if the header makes the response invalid.
+	 */
+	bool parseHeader();
+
+	/**
+	 * Parses the chunk size line in the line buffer.
+	 *
+	 * @return	Whether the chunk size was valid.
+	 */
+	bool parseChunkSize();
+
+	/**
+	 * Decides how the body is framed, after the end of the headers.
+	 */
+	void startBody();
+
+public:
+	/**
+	 * Creates a new parser, waiting for the status line of a response.
+	 */
+	ResponseParser();
+
+	/**
+	 * Resets this parser, to parse the next response on the same connection.
+	 * Keeps the header callback.
+	 */
+	void reset();
+
+	/**
+	 * Sets the callback to call for each header of the following responses.
+	 * Headers longer than the line buffer aren't given to the callback, since they were truncated.
+	 * The headers of interim responses, like "100 Continue", are given to the callback too.
+	 *
+	 * @param callback	The callback to call, or NULL to remove it.
+	 * @param arg		An argument to give to the callback.
+	 */
+	void setHeaderCallback(const HeaderCallback callback, void *arg = NULL);
+
+	/**
+	 * Parses the next segment of the response.
+	 *
+	 * Stops at the end of the response, so the rest of the data belongs to the next one.
+	 *
+	 * @param data	The received data.
+	 * @param len	The number of received bytes.
+	 * @return	The number of bytes belonging to the current response.
+	 */
+	size_t parse(const uint8_t *data, const size_t len);
+
+	/**
+	 * Tells the parser that the connection was closed.
+	 * Ends a response without a length, and marks any other unfinished response as failed.
+	 *
+	 * @return	Whether the response is complete.
+	 */
+	bool finish();
+
+	/**
+	 * Gets the part of the response the parser is currently reading.
+	 *
+	 * @return	The current state.
+	 */
+	State getState() const;
+
+	/**
+	 * Checks whether the whole response was read.
+	 *
+	 * @return	Whether the response is complete.
+	 */
+	bool done() const;
+
+	/**
+	 * Checks whether the response was invalid.
+	 * A failed parser ignores all further data until it is reset.
+	 *
+	 * @return	Whether the response couldn't be parsed.
+	 */
+	bool failed() const;
+
+	/**
+	 * Gets the status code of the response.
+	 *
+	 * @return	The status code, or 0 if the status line wasn't read yet.
+	 */
+	uint16_t getStatusCode() const;
+
+	/**
+	 * Checks whether the connection can be reused after this response.
+	 * Only meaningful once the response is complete.
+	 *
+	 * @return	False if the server closes the connection after this response.
+	 */
+	bool isKeepAlive() const;
+};
+
+} /* namespace http */
+
+#endif /* LIB_HTTP_UTILS_RESPONSE_PARSER_H_ */
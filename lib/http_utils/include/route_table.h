@@ -0,0 +1,165 @@
+/*
+ * route_table.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_HTTP_UTILS_ROUTE_TABLE_H_
+#define LIB_HTTP_UTILS_ROUTE_TABLE_H_
+
+#include <stddef.h>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace http {
+
+/**
+ * A lookup table mapping literal request paths to a value, like a request handler.
+ *
+ * The routes are kept in an array sorted by path, so a lookup is a binary search without any heap allocation.
+ * Inserting a route is linear in the number of routes, so routes should be registered at startup.
+ *
+ * A route also handles all paths below it, unless a longer route matches.
+ * For example "/timings" handles "/timings/unknown", but not "/timingsx".
+ *
+ * @tparam T	The type of the value stored for each route.
+ */
+template<typename T>
+class RouteTable {
+public:
+	/**
+	 * A single route, consisting of its path and its value.
+	 */
+	typedef std::pair<std::string, T> Route;
+
+	/**
+	 * Gets the value for the given path, inserting a default constructed value if there is none.
+	 *
+	 * @param path	The literal path of the route.
+	 * @return	A reference to the value of the route.
+	 * 			Stays valid until the next route is inserted.
+	 */
+	T& operator[](const std::string &path) {
+		typename std::vector<Route>::iterator it = _lowerBound(path.c_str(),
+				path.length());
+		if (it == _routes.end() || it->first != path) {
+			it = _routes.insert(it, Route(path, T()));
+		}
+		return it->second;
+	}
+
+	/**
+	 * Gets the value of the route with exactly the given path.
+	 *
+	 * @param path	The path to look for. Doesn't have to be NUL terminated.
+	 * @param len	The length of the path.
+	 * @return	A pointer to the value of the route, or NULL if there is none.
+	 */
+	T* find(const char *path, const size_t len) {
+		typename std::vector<Route>::iterator it = _lowerBound(path, len);
+		if (it != _routes.end() && _compare(it->first, path, len) == 0) {
+			return &it->second;
+		}
+		return NULL;
+	}
+
+	/**
+	 * Gets the value of the route handling the given request path.
+	 * That is the route with exactly the given path,
+	 * or the longest route that is followed by a slash in the given path.
+	 *
+	 * Empty routes never match.
+	 *
+	 * @param path	The request path to handle. Doesn't have to be NUL terminated.
+	 * @param len	The length of the request path.
+	 * @return	A pointer to the value of the matching route, or NULL if there is none.
+	 */
+	T* match(const char *path, const size_t len) {
+		if (len == 0) {
+			return NULL;
+		}
+
+		T *value = find(path, len);
+		for (size_t i = len - 1; !value && i > 0; i--) {
+			if (path[i] == '/') {
+				value = find(path, i);
+			}
+		}
+		return value;
+	}
+
+	/**
+	 * Gets the number of routes in this table.
+	 *
+	 * @return	The number of routes.
+	 */
+	size_t size() const {
+		return _routes.size();
+	}
+
+	/**
+	 * Gets all routes of this table, sorted by path.
+	 *
+	 * @return	The routes of this table.
+	 */
+	const std::vector<Route>& getRoutes() const {
+		return _routes;
+	}
+
+private:
+	/**
+	 * The routes of this table, sorted by path.
+	 */
+	std::vector<Route> _routes;
+
+	/**
+	 * Compares a route path to the given request path, like strcmp.
+	 *
+	 * @param route	The path of the route.
+	 * @param path	The request path to compare it to.
+	 * @param len	The length of the request path.
+	 * @return	Less than zero if the route is sorted before the path,
+	 * 			zero if they are equal, and greater than zero otherwise.
+	 */
+	static int _compare(const std::string &route, const char *path,
+			const size_t len) {
+		const size_t min_len = route.length() < len ? route.length() : len;
+		const int cmp = memcmp(route.data(), path, min_len);
+		if (cmp != 0 || route.length() == len) {
+			return cmp;
+		}
+		return route.length() < len ? -1 : 1;
+	}
+
+	/**
+	 * Finds the first route whose path isn't sorted before the given path.
+	 *
+	 * @param path	The path to look for.
+	 * @param len	The length of the path.
+	 * @return	An iterator pointing to the first route not before the given path.
+	 */
+	typename std::vector<Route>::iterator _lowerBound(const char *path,
+			const size_t len) {
+		size_t first = 0;
+		size_t count = _routes.size();
+		while (count > 0) {
+			const size_t step = count / 2;
+			if (_compare(_routes[first + step].first, path, len) < 0) {
+				first += step + 1;
+				count -= step + 1;
+			} else {
+				count = step;
+			}
+		}
+		return _routes.begin() + first;
+	}
+};
+}
+
+#endif /* LIB_HTTP_UTILS_ROUTE_TABLE_H_ */
@@ -0,0 +1,115 @@
+/*
+ * compiled_template.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "compiled_template.h"
+#include <cstring>
+
+constexpr uint8_t http::CompiledTemplate::LITERAL;
+
+http::CompiledTemplate::CompiledTemplate(const uint8_t *start,
+		const uint8_t *end, const std::vector<std::string> &placeholders,
+		const char delimiter) {
+	const size_t placeholders_len =
+			placeholders.size() < LITERAL ? placeholders.size() : LITERAL;
+	const uint8_t *pos = start;
+	while (pos < end) {
+		const uint8_t *open = (const uint8_t*) memchr(pos, delimiter,
+				end - pos);
+		const uint8_t *close =
+				open ? (const uint8_t*) memchr(open + 1, delimiter,
+								end - open - 1) : NULL;
+		if (!close) {
+			_addLiteral(pos, end - pos);
+			break;
+		}
+
+		_addLiteral(pos, open - pos);
+		const size_t name_len = close - open - 1;
+		uint8_t id = LITERAL;
+		for (size_t i = 0; i < placeholders_len; i++) {
+			if (placeholders[i].size() == name_len
+					&& memcmp(placeholders[i].data(), open + 1, name_len) == 0) {
+				id = i;
+				break;
+			}
+		}
+
+		if (id == LITERAL) {
+			// Unknown placeholders are replaced with their name.
+			_addLiteral(open + 1, name_len);
+		} else {
+			_segments.push_back(Segment { NULL, 0, id });
+		}
+		pos = close + 1;
+	}
+	_segments.shrink_to_fit();
+}
+
+void http::CompiledTemplate::_addLiteral(const uint8_t *data,
+		const size_t len) {
+	if (len > 0) {
+		_segments.push_back(Segment { data, len, LITERAL });
+		_literal_len += len;
+	}
+}
+
+size_t http::CompiledTemplate::getLiteralLength() const {
+	return _literal_len;
+}
+
+size_t http::CompiledTemplate::getLength(
+		const std::vector<std::string> &values) const {
+	size_t len = _literal_len;
+	for (const Segment &segment : _segments) {
+		if (segment.placeholder != LITERAL
+				&& segment.placeholder < values.size()) {
+			len += values[segment.placeholder].size();
+		}
+	}
+	return len;
+}
+
+size_t http::CompiledTemplate::fill(const std::vector<std::string> &values,
+		uint8_t *buffer, const size_t max_len, size_t index) const {
+	size_t written = 0;
+	for (const Segment &segment : _segments) {
+		if (written >= max_len) {
+			break;
+		}
+
+		const uint8_t *data = segment.data;
+		size_t len = segment.len;
+		if (segment.placeholder != LITERAL) {
+			if (segment.placeholder >= values.size()) {
+				continue;
+			}
+			data = (const uint8_t*) values[segment.placeholder].data();
+			len = values[segment.placeholder].size();
+		}
+
+		// Skip the segments before the requested index.
+		if (index >= len) {
+			index -= len;
+			continue;
+		}
+
+		const size_t copy =
+				len - index < max_len - written ?
+						len - index : max_len - written;
+		memcpy(buffer + written, data + index, copy);
+		written += copy;
+		index = 0;
+	}
+	return written;
+}
+
+const std::vector<http::CompiledTemplate::Segment>& http::CompiledTemplate::getSegments() const {
+	return _segments;
+}
@@ -0,0 +1,320 @@
+/*
+ * http_utils.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "http_utils.h"
+
+namespace http {
+
+/**
+ * A function checking how specifically a list element of a header matches a candidate.
+ * Gets the list element, its length, and the candidate.
+ * Returns 0 if the element doesn't match the candidate, and a higher value the more specific the match is.
+ */
+typedef uint8_t (*match_func)(const char *element, const size_t len,
+		const char *candidate);
+
+/**
+ * Converts an ASCII character to lower case.
+ *
+ * @param c	The character to convert.
+ * @return	The lower case character.
+ */
+static inline char toLower(const char c) {
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+/**
+ * Checks whether the given character is optional whitespace, as defined by RFC 9110.
+ *
+ * @param c	The character to check.
+ * @return	True if the character is a space or horizontal tab.
+ */
+static inline bool isOWS(const char c) {
+	return c == ' ' || c == '\t';
+}
+
+/**
+ * Checks whether the given string with the given length matches the given NUL terminated string, ignoring case.
+ *
+ * @param str		The string to compare, which doesn't have to be NUL terminated.
+ * @param len		The length of the string to compare.
+ * @param expected	The NUL terminated string to compare it to.
+ * @return	True if both strings are equal, ignoring case.
+ */
+static bool equalsIgnoreCase(const char *str, const size_t len,
+		const char *expected) {
+	size_t i = 0;
+	for (; i < len; i++) {
+		if (expected[i] == 0 || toLower(str[i]) != toLower(expected[i])) {
+			return false;
+		}
+	}
+	return expected[i] == 0;
+}
+
+/**
+ * Checks how specifically a media range matches a media type.
+ *
+ * @param element	The media range from the Accept header.
+ * @param len		The length of the media range.
+ * @param candidate	The media type to check.
+ * @return	3 for an exact match, 2 for a subtype wildcard, 1 for a full wildcard, and 0 if it doesn't match.
+ */
+static uint8_t matchMediaType(const char *element, const size_t len,
+		const char *candidate) {
+	if ((len == 1 && element[0] == '*')
+			|| (len == 3 && element[0] == '*' && element[1] == '/'
+					&& element[2] == '*')) {
+		return 1;
+	}
+
+	if (len >= 2 && element[len - 2] == '/' && element[len - 1] == '*') {
+		// Check that the type matches, followed by the slash.
+		for (size_t i = 0; i < len - 1; i++) {
+			if (candidate[i] == 0 || toLower(element[i]) != toLower(candidate[i])) {
+				return 0;
+			}
+		}
+		return 2;
+	}
+
+	return equalsIgnoreCase(element, len, candidate) ? 3 : 0;
+}
+
+/**
+ * Checks how specifically a content coding matches a candidate coding.
+ *
+ * @param element	The content coding from the Accept-Encoding header.
+ * @param len		The length of the content coding.
+ * @param candidate	The content coding to check.
+ * @return	2 for an exact match, 1 for a wildcard, and 0 if it doesn't match.
+ */
+static uint8_t matchEncoding(const char *element, const size_t len,
+		const char *candidate) {
+	if (len == 1 && element[0] == '*') {
+		return 1;
+	}
+
+	if (equalsIgnoreCase(element, len, candidate)) {
+		return 2;
+	}
+
+	// RFC 9110 says x-gzip should be considered equivalent to gzip.
+	if (len == 6 && equalsIgnoreCase(element, len, "x-gzip")
+			&& equalsIgnoreCase(candidate, 4, "gzip") && candidate[4] == 0) {
+		return 2;
+	}
+	return 0;
+}
+
+int16_t parseQValue(const char *value, const size_t len) {
+	if (len == 0 || len > 5 || (value[0] != '0' && value[0] != '1')) {
+		return -1;
+	}
+	if (len > 1 && value[1] != '.') {
+		return -1;
+	}
+
+	int16_t qvalue = (value[0] - '0') * MAX_QVALUE;
+	int16_t factor = MAX_QVALUE / 10;
+	for (size_t i = 2; i < len; i++) {
+		if (value[i] < '0' || value[i] > '9') {
+			return -1;
+		}
+		qvalue += (value[i] - '0') * factor;
+		factor /= 10;
+	}
+	return qvalue > MAX_QVALUE ? -1 : qvalue;
+}
+
+/**
+ * Parses the given header in a single pass, and calculates the q-value of each candidate.
+ *
+ * @param header			The header value to parse, or NULL if the header is missing.
+ * @param candidates		The values the server can send.
+ * @param candidates_len	The number of candidates.
+ * 							Has to be at most MAX_NEGOTIATION_CANDIDATES.
+ * @param match				The function checking whether an element matches a candidate.
+ * @param encoding			Whether this negotiates a content coding, and identity is implicitly acceptable.
+ * @param qvalues			The array to write the q-value of each candidate to.
+ */
+static void parseQValues(const char *header, const char *const candidates[],
+		const size_t candidates_len, const match_func match,
+		const bool encoding, int16_t qvalues[]) {
+	if (header == NULL) {
+		for (size_t i = 0; i < candidates_len; i++) {
+			qvalues[i] = MAX_QVALUE;
+		}
+		return;
+	}
+
+	uint8_t specificity[MAX_NEGOTIATION_CANDIDATES];
+	for (size_t i = 0; i < candidates_len; i++) {
+		qvalues[i] = 0;
+		specificity[i] = 0;
+	}
+
+	const char *pos = header;
+	while (*pos) {
+		while (*pos == ',' || isOWS(*pos)) {
+			pos++;
+		}
+		if (!*pos) {
+			break;
+		}
+
+		const char *element = pos;
+		while (*pos && *pos != ',' && *pos != ';' && !isOWS(*pos)) {
+			pos++;
+		}
+		const size_t element_len = pos - element;
+
+		int16_t qvalue = MAX_QVALUE;
+		bool valid = true;
+		while (isOWS(*pos)) {
+			pos++;
+		}
+		while (*pos == ';') {
+			pos++;
+			while (isOWS(*pos)) {
+				pos++;
+			}
+
+			const char *name = pos;
+			while (*pos && *pos != '=' && *pos != ',' && *pos != ';'
+					&& !isOWS(*pos)) {
+				pos++;
+			}
+			const size_t name_len = pos - name;
+
+			const char *value = pos;
+			size_t value_len = 0;
+			if (*pos == '=') {
+				value = ++pos;
+				if (*pos == '"') {
+					// Skip quoted strings, since they may contain commas.
+					pos++;
+					while (*pos && *pos != '"') {
+						if (*pos == '\\' && pos[1]) {
+							pos++;
+						}
+						pos++;
+					}
+					if (*pos == '"') {
+						pos++;
+					} else {
+						valid = false;
+					}
+				} else {
+					while (*pos && *pos != ',' && *pos != ';' && !isOWS(*pos)) {
+						pos++;
+					}
+				}
+				value_len = pos - value;
+			}
+
+			if (name_len == 1 && (name[0] == 'q' || name[0] == 'Q')) {
+				qvalue = parseQValue(value, value_len);
+				if (qvalue < 0) {
+					valid = false;
+				}
+			}
+
+			while (isOWS(*pos)) {
+				pos++;
+			}
+		}
+
+		if (*pos && *pos != ',') {
+			// Skip the rest of an invalid element.
+			valid = false;
+			while (*pos && *pos != ',') {
+				pos++;
+			}
+		}
+
+		if (!valid || element_len == 0) {
+			continue;
+		}
+
+		for (size_t i = 0; i < candidates_len; i++) {
+			const uint8_t spec = match(element, element_len, candidates[i]);
+			if (spec > specificity[i]
+					|| (spec > 0 && spec == specificity[i]
+							&& qvalue > qvalues[i])) {
+				specificity[i] = spec;
+				qvalues[i] = qvalue;
+			}
+		}
+	}
+
+	// Identity is acceptable, unless explicitly excluded.
+	for (size_t i = 0; encoding && i < candidates_len; i++) {
+		if (specificity[i] == 0 && equalsIgnoreCase(candidates[i], 8, "identity")
+				&& candidates[i][8] == 0) {
+			qvalues[i] = MAX_QVALUE;
+		}
+	}
+}
+
+/**
+ * Parses the given header in a single pass, and selects the best candidate.
+ *
+ * @param header			The header value to parse, or NULL if the header is missing.
+ * @param candidates		The values the server can send, ordered by server preference.
+ * @param candidates_len	The number of candidates.
+ * @param match				The function checking whether an element matches a candidate.
+ * @param encoding			Whether this negotiates a content coding, and identity is implicitly acceptable.
+ * @return	The index of the best candidate, or -1 if none is acceptable.
+ */
+static int8_t negotiate(const char *header, const char *const candidates[],
+		size_t candidates_len, const match_func match, const bool encoding) {
+	if (candidates_len > MAX_NEGOTIATION_CANDIDATES) {
+		candidates_len = MAX_NEGOTIATION_CANDIDATES;
+	}
+	if (candidates_len == 0) {
+		return -1;
+	} else if (header == NULL) {
+		return 0;
+	}
+
+	int16_t qvalues[MAX_NEGOTIATION_CANDIDATES];
+	parseQValues(header, candidates, candidates_len, match, encoding, qvalues);
+
+	int8_t best = -1;
+	for (size_t i = 0; i < candidates_len; i++) {
+		if (qvalues[i] > 0 && (best < 0 || qvalues[i] > qvalues[best])) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+int8_t negotiateMediaType(const char *header, const char *const candidates[],
+		const size_t candidates_len) {
+	return negotiate(header, candidates, candidates_len, matchMediaType, false);
+}
+
+int8_t negotiateEncoding(const char *header, const char *const candidates[],
+		const size_t candidates_len) {
+	return negotiate(header, candidates, candidates_len, matchEncoding, true);
+}
+
+void getEncodingQValues(const char *header, const char *const candidates[],
+		const size_t candidates_len, int16_t qvalues[]) {
+	const size_t considered =
+			candidates_len > MAX_NEGOTIATION_CANDIDATES ?
+					MAX_NEGOTIATION_CANDIDATES : candidates_len;
+	parseQValues(header, candidates, considered, matchEncoding, true, qvalues);
+	for (size_t i = considered; i < candidates_len; i++) {
+		qvalues[i] = 0;
+	}
+}
+}
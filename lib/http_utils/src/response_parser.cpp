@@ -0,0 +1,383 @@
+/*
+ * response_parser.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "response_parser.h"
+#include <string.h>
+
+namespace http {
+
+constexpr size_t ResponseParser::LINE_BUFFER_SIZE;
+
+/**
+ * Converts an ASCII character to lower case.
+ *
+ * @param c	The character to convert.
+ * @return	The lower case character.
+ */
+static inline char toLower(const char c) {
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+/**
+ * Checks whether the given character is optional whitespace, as defined by RFC 9110.
+ *
+ * @param c	The character to check.
+ * @return	True if the character is a space or horizontal tab.
+ */
+static inline bool isOWS(const char c) {
+	return c == ' ' || c == '\t';
+}
+
+/**
+ * Checks whether the given string with the given length matches the given NUL terminated string, ignoring case.
+ *
+ * @param str		The string to compare, which doesn't have to be NUL terminated.
+ * @param len		The length of the string to compare.
+ * @param expected	The NUL terminated string to compare it to.
+ * @return	True if both strings are equal, ignoring case.
+ */
+static bool equalsIgnoreCase(const char *str, const size_t len,
+		const char *expected) {
+	size_t i = 0;
+	for (; i < len; i++) {
+		if (expected[i] == 0 || toLower(str[i]) != toLower(expected[i])) {
+			return false;
+		}
+	}
+	return expected[i] == 0;
+}
+
+/**
+ * Checks whether the given comma separated header value contains the given token, ignoring case.
+ *
+ * @param value		The header value, which doesn't have to be NUL terminated.
+ * @param len		The length of the header value.
+ * @param token		The token to look for.
+ * @param last_only	Whether only the last list element should be checked.
+ * @return	True if the list contains the token.
+ */
+static bool containsToken(const char *value, const size_t len,
+		const char *token, const bool last_only) {
+	size_t start = 0;
+	bool found = false;
+	while (start <= len) {
+		size_t end = start;
+		while (end < len && value[end] != ',') {
+			end++;
+		}
+
+		size_t elem_start = start;
+		size_t elem_end = end;
+		while (elem_start < elem_end && isOWS(value[elem_start])) {
+			elem_start++;
+		}
+		while (elem_end > elem_start && isOWS(value[elem_end - 1])) {
+			elem_end--;
+		}
+		// Empty list elements are allowed, and don't count as the last element.
+		if (elem_end > elem_start) {
+			found = equalsIgnoreCase(value + elem_start, elem_end - elem_start,
+					token);
+			if (found && !last_only) {
+				return true;
+			}
+		}
+		start = end + 1;
+	}
+	return found;
+}
+
+ResponseParser::ResponseParser() :
+		_header_callback(NULL), _header_callback_arg(NULL) {
+	reset();
+}
+
+void ResponseParser::reset() {
+	_state = State::STATUS_LINE;
+	_status_code = 0;
+	_keep_alive = false;
+	_has_transfer_encoding = false;
+	_chunked = false;
+	_has_content_length = false;
+	_remaining = 0;
+	_line_len = 0;
+	_line_truncated = false;
+}
+
+void ResponseParser::setHeaderCallback(const HeaderCallback callback,
+		void *arg) {
+	_header_callback = callback;
+	_header_callback_arg = arg;
+}
+
+size_t ResponseParser::parse(const uint8_t *data, const size_t len) {
+	size_t pos = 0;
+	while (pos < len) {
+		switch (_state) {
+		case State::DONE:
+		case State::FAILED:
+			return pos;
+		case State::BODY:
+		case State::CHUNK_DATA: {
+			// Body data isn't used, so it is skipped as a whole.
+			const size_t skip =
+					len - pos < _remaining ? len - pos : (size_t) _remaining;
+			pos += skip;
+			_remaining -= skip;
+			if (_remaining == 0) {
+				_state = _state == State::BODY ? State::DONE : State::CHUNK_DATA_END;
+			}
+			break;
+		}
+		case State::BODY_UNTIL_CLOSE:
+			return len;
+		default: {
+			const uint8_t *line_end = (const uint8_t*) memchr(data + pos, '\n',
+					len - pos);
+			const size_t end = line_end ? line_end - data : len;
+			const size_t copy =
+					end - pos < LINE_BUFFER_SIZE - _line_len ?
+							end - pos : LINE_BUFFER_SIZE - _line_len;
+			memcpy(_line + _line_len, data + pos, copy);
+			_line_len += copy;
+			if (copy < end - pos) {
+				_line_truncated = true;
+			}
+
+			pos = end;
+			if (line_end) {
+				pos++;
+				// The CR before the LF isn't part of the line.
+				if (_line_len > 0 && _line[_line_len - 1] == '\r') {
+					_line_len--;
+				}
+				handleLine();
+				_line_len = 0;
+				_line_truncated = false;
+			}
+			break;
+		}
+		}
+	}
+	return pos;
+}
+
+void ResponseParser::handleLine() {
+	switch (_state) {
+	case State::STATUS_LINE:
+		// Empty lines before the status line are ignored.
+		if (_line_len > 0) {
+			_state = parseStatusLine() ? State::HEADERS : State::FAILED;
+		}
+		break;
+	case State::HEADERS:
+		if (_line_len == 0) {
+			startBody();
+		} else if (!parseHeader()) {
+			_state = State::FAILED;
+		}
+		break;
+	case State::CHUNK_SIZE:
+		if (!parseChunkSize()) {
+			_state = State::FAILED;
+		} else if (_remaining == 0) {
+			_state = State::TRAILERS;
+		} else {
+			_state = State::CHUNK_DATA;
+		}
+		break;
+	case State::CHUNK_DATA_END:
+		_state = _line_len == 0 ? State::CHUNK_SIZE : State::FAILED;
+		break;
+	case State::TRAILERS:
+		// Trailer fields aren't used.
+		if (_line_len == 0) {
+			_state = State::DONE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool ResponseParser::parseStatusLine() {
+	// HTTP/1.x 200 OK
+	static constexpr char PREFIX[] = "HTTP/1.";
+	static constexpr size_t PREFIX_LEN = sizeof(PREFIX) - 1;
+	if (_line_len < PREFIX_LEN + 5 || memcmp(_line, PREFIX, PREFIX_LEN) != 0
+			|| _line[PREFIX_LEN] < '0' || _line[PREFIX_LEN] > '9'
+			|| _line[PREFIX_LEN + 1] != ' ') {
+		return false;
+	}
+
+	uint16_t code = 0;
+	for (size_t i = PREFIX_LEN + 2; i < PREFIX_LEN + 5; i++) {
+		if (_line[i] < '0' || _line[i] > '9') {
+			return false;
+		}
+		code = code * 10 + _line[i] - '0';
+	}
+	// The reason phrase is optional, but has to be separated by a space.
+	if ((_line_len > PREFIX_LEN + 5 && _line[PREFIX_LEN + 5] != ' ')
+			|| code < 100) {
+		return false;
+	}
+
+	_status_code = code;
+	// Persistent connections are the default since HTTP/1.1.
+	_keep_alive = _line[PREFIX_LEN] != '0';
+	return true;
+}
+
+bool ResponseParser::parseHeader() {
+	const char *colon = (const char*) memchr(_line, ':', _line_len);
+	if (!colon || colon == _line) {
+		// Unlike a truncated line, a header without a colon is invalid.
+		return _line_truncated;
+	}
+
+	const size_t name_len = colon - _line;
+	size_t value_start = name_len + 1;
+	size_t value_end = _line_len;
+	while (value_start < value_end && isOWS(_line[value_start])) {
+		value_start++;
+	}
+	while (value_end > value_start && isOWS(_line[value_end - 1])) {
+		value_end--;
+	}
+	const char *value = _line + value_start;
+	const size_t value_len = value_end - value_start;
+	if (_header_callback && !_line_truncated) {
+		_header_callback(_header_callback_arg, _line, name_len, value,
+				value_len);
+	}
+
+	if (equalsIgnoreCase(_line, name_len, "content-length")) {
+		if (_line_truncated || value_len == 0 || value_len > 15) {
+			return false;
+		}
+
+		uint64_t length = 0;
+		for (size_t i = 0; i < value_len; i++) {
+			if (value[i] < '0' || value[i] > '9') {
+				return false;
+			}
+			length = length * 10 + value[i] - '0';
+		}
+		// Multiple Content-Length headers are only valid if they are equal.
+		if (_has_content_length && length != _remaining) {
+			return false;
+		}
+		_has_content_length = true;
+		_remaining = length;
+	} else if (equalsIgnoreCase(_line, name_len, "transfer-encoding")) {
+		if (_line_truncated) {
+			return false;
+		}
+		_has_transfer_encoding = true;
+		_chunked = containsToken(value, value_len, "chunked", true);
+	} else if (equalsIgnoreCase(_line, name_len, "connection")) {
+		if (containsToken(value, value_len, "close", false)) {
+			_keep_alive = false;
+		} else if (containsToken(value, value_len, "keep-alive", false)) {
+			_keep_alive = true;
+		}
+	}
+	return true;
+}
+
+bool ResponseParser::parseChunkSize() {
+	uint64_t size = 0;
+	size_t i = 0;
+	for (; i < _line_len; i++) {
+		const char c = toLower(_line[i]);
+		uint8_t digit;
+		if (c >= '0' && c <= '9') {
+			digit = c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			digit = c - 'a' + 10;
+		} else {
+			break;
+		}
+
+		// Chunks larger than 2^60 bytes can't be sent to a microcontroller anyway.
+		if (i >= 15) {
+			return false;
+		}
+		size = size * 16 + digit;
+	}
+
+	// Chunk extensions are ignored.
+	if (i == 0 || (i < _line_len && _line[i] != ';' && !isOWS(_line[i]))) {
+		return false;
+	}
+	_remaining = size;
+	return true;
+}
+
+void ResponseParser::startBody() {
+	if (_status_code < 200) {
+		// Interim responses have no body, and are followed by the final response.
+		if (_status_code == 101) {
+			// Switching protocols means the connection can't be used for HTTP anymore.
+			_keep_alive = false;
+			_state = State::DONE;
+		} else {
+			reset();
+		}
+	} else if (_status_code == 204 || _status_code == 304) {
+		_state = State::DONE;
+	} else if (_has_transfer_encoding) {
+		// Transfer-Encoding overrides Content-Length, and without chunked the body ends with the connection.
+		if (_chunked) {
+			_state = State::CHUNK_SIZE;
+		} else {
+			_keep_alive = false;
+			_state = State::BODY_UNTIL_CLOSE;
+		}
+	} else if (_has_content_length) {
+		_state = _remaining == 0 ? State::DONE : State::BODY;
+	} else {
+		_keep_alive = false;
+		_state = State::BODY_UNTIL_CLOSE;
+	}
+}
+
+bool ResponseParser::finish() {
+	if (_state == State::BODY_UNTIL_CLOSE) {
+		_state = State::DONE;
+	} else if (_state != State::DONE) {
+		_state = State::FAILED;
+	}
+	_keep_alive = false;
+	return _state == State::DONE;
+}
+
+ResponseParser::State ResponseParser::getState() const {
+	return _state;
+}
+
+bool ResponseParser::done() const {
+	return _state == State::DONE;
+}
+
+bool ResponseParser::failed() const {
+	return _state == State::FAILED;
+}
+
+uint16_t ResponseParser::getStatusCode() const {
+	return _status_code;
+}
+
+bool ResponseParser::isKeepAlive() const {
+	return _keep_alive;
+}
+
+} /* namespace http */
@@ -0,0 +1,41 @@
+/*
+ * exposition_generator.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_EXPOSITION_GENERATOR_H_
+#define LIB_PROM_METRICS_EXPOSITION_GENERATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prom {
+/**
+ * The common interface of the resumable generators for each exposition format.
+ * Allows sending any format with the same response code.
+ */
+class ExpositionGenerator {
+public:
+	/**
+	 * Destroys this generator.
+	 */
+	virtual ~ExpositionGenerator() {
+	}
+
+	/**
+	 * Writes the next part of the exposition to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the whole exposition was written.
+	 */
+	virtual size_t fill(uint8_t *buffer, const size_t max_len) = 0;
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_EXPOSITION_GENERATOR_H_ */
@@ -0,0 +1,66 @@
+/*
+ * metric_filter.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_METRIC_FILTER_H_
+#define LIB_PROM_METRICS_METRIC_FILTER_H_
+
+#include "metric_registry.h"
+#include <string>
+#include <vector>
+
+namespace prom {
+/**
+ * A set of metric family names to include in an exposition, like the name[] parameters of a scrape.
+ * An empty filter includes every metric family.
+ *
+ * Metrics are filtered before their samples are rendered,
+ * so excluded metrics don't cost anything but a name comparison.
+ */
+class MetricFilter {
+public:
+	/**
+	 * The max number of names in a single filter.
+	 * Additional names are ignored, so a request can't use an arbitrary amount of memory.
+	 */
+	static constexpr size_t MAX_NAMES = 32;
+
+private:
+	/**
+	 * The names of the included metric families.
+	 */
+	std::vector<std::string> _names;
+
+public:
+	/**
+	 * Adds a metric family name to include.
+	 *
+	 * @param name	The full name of the metric family, like "esptherm_temperature_celsius".
+	 * @return	False if the filter already contains MAX_NAMES names.
+	 */
+	bool add(const char *name);
+
+	/**
+	 * Checks whether this filter includes every metric family.
+	 *
+	 * @return	True if no names were added.
+	 */
+	bool empty() const;
+
+	/**
+	 * Checks whether the given metric family should be included in the exposition.
+	 *
+	 * @param family	The description of the metric family.
+	 * @return	True if the family is included.
+	 */
+	bool matches(const MetricFamily &family) const;
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_METRIC_FILTER_H_ */
@@ -0,0 +1,441 @@
+/*
+ * metric_registry.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_METRIC_REGISTRY_H_
+#define LIB_PROM_METRICS_METRIC_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace prom {
+/**
+ * The type of a metric family.
+ */
+enum class MetricType : uint8_t {
+	COUNTER, GAUGE, INFO, HISTOGRAM
+};
+
+/**
+ * The compile time description of a metric family.
+ *
+ * Should be created using one of the PROM_*_FAMILY macros,
+ * which concatenate the metadata lines into string literals, so they don't have to be rendered at run time.
+ */
+struct MetricFamily {
+	/**
+	 * The full name of the metric family, including the namespace and unit.
+	 * Used as the name of its samples.
+	 */
+	const char *name;
+
+	/**
+	 * The type of the metric family.
+	 */
+	MetricType type;
+
+	/**
+	 * The HELP and TYPE lines of the metric family, for the Prometheus 0.0.4 text format.
+	 */
+	const char *metadata;
+
+	/**
+	 * The length of the Prometheus metadata lines.
+	 */
+	size_t metadata_len;
+
+	/**
+	 * The HELP, TYPE, and UNIT lines of the metric family, for the OpenMetrics text format.
+	 */
+	const char *openmetrics_metadata;
+
+	/**
+	 * The length of the OpenMetrics metadata lines.
+	 */
+	size_t openmetrics_metadata_len;
+};
+} /* namespace prom */
+
+/**
+ * PROM_METADATA_LINES is a helper macro creating the HELP and TYPE lines of a metric family as a string literal.
+ */
+#define PROM_METADATA_LINES(name, type, help) "# HELP " name " " help "\n# TYPE " name " " type "\n"
+
+/**
+ * PROM_UNIT_LINE is a helper macro creating the OpenMetrics UNIT line of a metric family as a string literal.
+ */
+#define PROM_UNIT_LINE(name, unit) "# UNIT " name " " unit "\n"
+
+/**
+ * PROM_METRIC_FAMILY is a helper macro creating a MetricFamily initializer from string literal metadata.
+ */
+#define PROM_METRIC_FAMILY(name, type, metadata, openmetrics_metadata) \
+	{ name, type, metadata, sizeof(metadata) - 1, openmetrics_metadata, sizeof(openmetrics_metadata) - 1 }
+
+/**
+ * PROM_COUNTER_FAMILY creates the description of a counter.
+ * The name should end with "_total".
+ */
+#define PROM_COUNTER_FAMILY(name, help) \
+	PROM_METRIC_FAMILY(name, prom::MetricType::COUNTER, \
+		PROM_METADATA_LINES(name, "counter", help), PROM_METADATA_LINES(name, "counter", help))
+
+/**
+ * PROM_GAUGE_FAMILY creates the description of a gauge without a unit.
+ */
+#define PROM_GAUGE_FAMILY(name, help) \
+	PROM_METRIC_FAMILY(name, prom::MetricType::GAUGE, \
+		PROM_METADATA_LINES(name, "gauge", help), PROM_METADATA_LINES(name, "gauge", help))
+
+/**
+ * PROM_GAUGE_FAMILY_WITH_UNIT creates the description of a gauge.
+ * The unit is appended to the name.
+ */
+#define PROM_GAUGE_FAMILY_WITH_UNIT(name, unit, help) \
+	PROM_METRIC_FAMILY(name "_" unit, prom::MetricType::GAUGE, \
+		PROM_METADATA_LINES(name "_" unit, "gauge", help), \
+		PROM_METADATA_LINES(name "_" unit, "gauge", help) PROM_UNIT_LINE(name "_" unit, unit))
+
+/**
+ * PROM_INFO_FAMILY creates the description of an info metric.
+ * Info metrics are written as gauges in the Prometheus format, since it has no info type.
+ */
+#define PROM_INFO_FAMILY(name, help) \
+	PROM_METRIC_FAMILY(name, prom::MetricType::INFO, \
+		PROM_METADATA_LINES(name, "gauge", help), PROM_METADATA_LINES(name, "info", help))
+
+/**
+ * PROM_HISTOGRAM_FAMILY_WITH_UNIT creates the description of a histogram.
+ * The unit is appended to the name.
+ */
+#define PROM_HISTOGRAM_FAMILY_WITH_UNIT(name, unit, help) \
+	PROM_METRIC_FAMILY(name "_" unit, prom::MetricType::HISTOGRAM, \
+		PROM_METADATA_LINES(name "_" unit, "histogram", help), \
+		PROM_METADATA_LINES(name "_" unit, "histogram", help) PROM_UNIT_LINE(name "_" unit, unit))
+
+namespace prom {
+class Registry;
+
+/**
+ * The position of a metrics writer in the samples of a single metric.
+ * Reset to all zeros before the first sample of each metric, except for the output options.
+ */
+struct SampleCursor {
+	/**
+	 * The size of the state storage, in bytes.
+	 */
+	static constexpr size_t STATE_SIZE = 160;
+
+	/**
+	 * The index of the next sample.
+	 * Metrics can use this for any other position, as long as zero means the first sample.
+	 */
+	size_t index;
+
+	/**
+	 * Whether the samples are written in the OpenMetrics text format.
+	 * Only affects the format of sample timestamps.
+	 */
+	bool openmetrics;
+
+	/**
+	 * Whether samples may have a timestamp.
+	 * False if the metrics are sent to a receiver rejecting timestamps, like the Prometheus pushgateway.
+	 */
+	bool timestamps;
+
+	/**
+	 * An identifier of the receiver of the samples, like the address of a scraper.
+	 * Metrics writing older samples the receiver missed use it to keep track of what each receiver already got.
+	 * Zero if the receiver only gets the current samples.
+	 */
+	uint32_t consumer;
+
+	/**
+	 * Whether only the older samples the receiver missed are written, without the current samples.
+	 * Metrics shouldn't consider these received, since the receiver may still reject them.
+	 */
+	bool missed_only;
+
+	/**
+	 * Storage for the values of a metric that have to be kept between two samples,
+	 * like a copy of the values of a histogram.
+	 */
+	typename std::aligned_storage<STATE_SIZE, alignof(uint64_t)>::type state;
+
+	/**
+	 * Gets the state storage as an object of the given type.
+	 * All bytes of the object are zero before the first sample.
+	 *
+	 * @tparam T	The type of the state. Has to be trivial, and fit the state storage.
+	 * @return	A reference to the state.
+	 */
+	template<typename T>
+	T& getState() {
+		static_assert(sizeof(T) <= STATE_SIZE, "The metric state is too large for the state storage.");
+		static_assert(std::is_trivial<T>::value, "The metric state has to be trivial.");
+		return *reinterpret_cast<T*>(&state);
+	}
+};
+
+/**
+ * A single registered metric, with a compile time description, and a way to write its samples.
+ *
+ * Metrics form an intrusive list in their registry, so registering a metric doesn't allocate memory.
+ * Metrics have to outlive the registry they are registered to.
+ */
+class Metric {
+private:
+	friend class Registry;
+
+	/**
+	 * The description of the metric family.
+	 */
+	const MetricFamily &_family;
+
+	/**
+	 * The next metric in the same registry.
+	 */
+	Metric *_next;
+
+	/**
+	 * The registry this metric was added to, or NULL.
+	 */
+	const Registry *_registry;
+
+public:
+	/**
+	 * Creates a new metric for the given metric family.
+	 *
+	 * @param family	The description of the metric family. Has to outlive the metric.
+	 */
+	explicit Metric(const MetricFamily &family);
+
+	/**
+	 * Destroys this metric.
+	 * Metrics can't be removed from a registry, so this should only happen after the registry was destroyed.
+	 */
+	virtual ~Metric();
+
+	/**
+	 * Gets the description of the metric family of this metric.
+	 *
+	 * @return	The metric family.
+	 */
+	const MetricFamily& getFamily() const;
+
+	/**
+	 * Gets the metric registered after this one.
+	 *
+	 * @return	The next metric, or NULL if this is the last one.
+	 */
+	const Metric* getNext() const;
+
+	/**
+	 * Writes the next sample line of this metric to the given buffer.
+	 *
+	 * @param buffer	The buffer to write the line to.
+	 * @param size		The size of the buffer. Output that doesn't fit is dropped.
+	 * @param cursor	The position in the samples of this metric. All zeros for the first sample.
+	 * @return	The length of the line, like snprintf, so it may be larger than size.
+	 * 			Zero if all samples were written.
+	 */
+	virtual size_t writeSample(char *buffer, const size_t size,
+			SampleCursor &cursor) const = 0;
+
+	/**
+	 * Checks whether this metric can write older samples a receiver missed.
+	 * Other metrics are skipped when only the missed samples are written.
+	 *
+	 * @return	True if this metric writes missed samples.
+	 */
+	virtual bool writesMissedSamples() const;
+};
+
+/**
+ * A gauge with a single sample, whose value is read when it is written.
+ */
+class Gauge: public Metric {
+private:
+	/**
+	 * The function reading the current value of the gauge.
+	 */
+	double (*const _read)();
+
+public:
+	/**
+	 * Creates a new gauge.
+	 *
+	 * @param family	The description of the gauge. Has to outlive the gauge.
+	 * @param read		The function reading the current value. May return NAN.
+	 */
+	Gauge(const MetricFamily &family, double (*read)());
+
+	size_t writeSample(char *buffer, const size_t size, SampleCursor &cursor) const
+			override;
+};
+
+/**
+ * A counter with a single sample, whose value is read when it is written.
+ */
+class Counter: public Metric {
+private:
+	/**
+	 * The function reading the current value of the counter.
+	 */
+	uint64_t (*const _read)();
+
+public:
+	/**
+	 * Creates a new counter.
+	 *
+	 * @param family	The description of the counter. Has to outlive the counter.
+	 * @param read		The function reading the current value.
+	 */
+	Counter(const MetricFamily &family, uint64_t (*read)());
+
+	size_t writeSample(char *buffer, const size_t size, SampleCursor &cursor) const
+			override;
+};
+
+/**
+ * An info metric with a single sample, which always has the value 1, and the info as labels.
+ */
+class Info: public Metric {
+private:
+	/**
+	 * The function writing the labels of the sample.
+	 */
+	size_t (*const _write_labels)(char *buffer, const size_t size);
+
+public:
+	/**
+	 * Creates a new info metric.
+	 *
+	 * @param family		The description of the info metric. Has to outlive the metric.
+	 * @param write_labels	A function writing the labels, without the braces, like snprintf.
+	 */
+	Info(const MetricFamily &family,
+			size_t (*write_labels)(char *buffer, const size_t size));
+
+	size_t writeSample(char *buffer, const size_t size, SampleCursor &cursor) const
+			override;
+};
+
+/**
+ * A metric whose samples are written by a function, for metric families with a variable number of samples.
+ */
+class Collector: public Metric {
+private:
+	/**
+	 * The function writing the samples.
+	 */
+	size_t (*const _write_sample)(char *buffer, const size_t size,
+			const MetricFamily &family, SampleCursor &cursor);
+
+	/**
+	 * Whether the write function can write older samples a receiver missed.
+	 */
+	const bool _writes_missed;
+
+public:
+	/**
+	 * Creates a new collector.
+	 *
+	 * @param family		The description of the metric family. Has to outlive the collector.
+	 * @param write_sample	The function writing the next sample, like Metric::writeSample.
+	 * @param writes_missed	Whether the write function can write older samples a receiver missed.
+	 * 						If true, it has to handle SampleCursor::missed_only.
+	 */
+	Collector(const MetricFamily &family,
+			size_t (*write_sample)(char *buffer, const size_t size,
+					const MetricFamily &family, SampleCursor &cursor),
+			const bool writes_missed = false);
+
+	size_t writeSample(char *buffer, const size_t size, SampleCursor &cursor) const
+			override;
+
+	bool writesMissedSamples() const override;
+};
+
+/**
+ * An ordered list of metrics, written in the order they were added.
+ *
+ * Metrics should be added at startup, before the registry is read.
+ */
+class Registry {
+private:
+	/**
+	 * The first registered metric.
+	 */
+	Metric *_first;
+
+	/**
+	 * The last registered metric.
+	 */
+	Metric *_last;
+
+public:
+	/**
+	 * Creates a new empty registry.
+	 */
+	constexpr Registry() :
+			_first(NULL), _last(NULL) {
+	}
+
+	/**
+	 * Adds the given metric to the end of this registry.
+	 * Metrics can only be added to a single registry, and only once.
+	 *
+	 * @param metric	The metric to add. Has to outlive the registry.
+	 * @return	True if the metric was added.
+	 */
+	bool add(Metric &metric);
+
+	/**
+	 * Gets the first registered metric.
+	 *
+	 * @return	The first metric, or NULL if the registry is empty.
+	 */
+	const Metric* getFirst() const;
+};
+
+/**
+ * Writes a sample line with the given name and value to the given buffer.
+ * The value is written with three decimal digits, or as NAN.
+ *
+ * @param buffer	The buffer to write to.
+ * @param size		The size of the buffer. Output that doesn't fit is dropped.
+ * @param name		The name of the sample.
+ * @param value		The value of the sample.
+ * @return	The length of the line, like snprintf.
+ */
+size_t writeSampleLine(char *buffer, const size_t size, const char *name,
+		const double value);
+
+/**
+ * Writes a sample line with the given name, value, and timestamp to the given buffer.
+ * The value is written with three decimal digits, or as NAN.
+ * The timestamp is written in milliseconds for the Prometheus text format,
+ * and in seconds with three decimal digits for OpenMetrics.
+ *
+ * @param buffer		The buffer to write to.
+ * @param size			The size of the buffer. Output that doesn't fit is dropped.
+ * @param name			The name of the sample.
+ * @param value			The value of the sample.
+ * @param timestamp		The time of the sample, in milliseconds since the unix epoch.
+ * @param openmetrics	Whether to write the timestamp in the OpenMetrics format.
+ * @return	The length of the line, like snprintf.
+ */
+size_t writeSampleLine(char *buffer, const size_t size, const char *name,
+		const double value, const int64_t timestamp, const bool openmetrics);
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_METRIC_REGISTRY_H_ */
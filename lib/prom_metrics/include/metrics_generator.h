@@ -0,0 +1,103 @@
+/*
+ * metrics_generator.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_METRICS_GENERATOR_H_
+#define LIB_PROM_METRICS_METRICS_GENERATOR_H_
+
+#include "exposition_generator.h"
+#include "metric_registry.h"
+#include "sample_iterator.h"
+
+namespace prom {
+/**
+ * A resumable generator for the text exposition of all metrics in a registry.
+ *
+ * The metadata lines of each metric family are copied directly from their compile time constants.
+ * Samples are rendered one line at a time, into the fixed size line buffer of a SampleIterator,
+ * and copied to the output buffer of each fill call.
+ * Its memory use is the same no matter how many metrics or samples there are.
+ */
+class MetricsGenerator: public ExpositionGenerator {
+public:
+	/**
+	 * The size of the buffer for a single rendered sample line.
+	 * Longer lines are skipped with an error.
+	 */
+	static constexpr size_t LINE_BUFFER_SIZE = SampleIterator::LINE_BUFFER_SIZE;
+
+private:
+	/**
+	 * The parts of the exposition of a single metric, and the end of the exposition.
+	 */
+	enum State : uint8_t {
+		METADATA, SAMPLES, END_OF_FILE, DONE
+	};
+
+	/**
+	 * Whether to generate OpenMetrics output, instead of the Prometheus 0.0.4 text format.
+	 */
+	const bool _openmetrics;
+
+	/**
+	 * The part of the exposition the next line belongs to.
+	 */
+	State _state;
+
+	/**
+	 * The iterator rendering the sample lines of each metric.
+	 */
+	SampleIterator _samples;
+
+	/**
+	 * The output that wasn't copied to an output buffer yet.
+	 */
+	const char *_pending;
+
+	/**
+	 * The number of pending bytes.
+	 */
+	size_t _pending_len;
+
+	/**
+	 * Renders the next part of the exposition, and sets it as the pending output.
+	 *
+	 * @return	False if the whole exposition was generated.
+	 */
+	bool next();
+
+public:
+	/**
+	 * Creates a new generator, starting at the start of the exposition.
+	 *
+	 * @param registry		The registry containing the metrics to write.
+	 * 						Metrics added after the generator reached the end of the registry are ignored.
+	 * @param openmetrics	Whether to generate OpenMetrics output. Default is Prometheus 0.0.4 output.
+	 * @param timestamps	Whether metrics may write samples with a timestamp.
+	 * 						Should be false if the receiver rejects timestamps, like the Prometheus pushgateway.
+	 * @param filter		The filter selecting the metrics to write. Default is all metrics.
+	 * @param consumer		The identifier of the receiver, like the address of a scraper.
+	 * 						Zero if it only gets the current samples, which is the default.
+	 */
+	MetricsGenerator(const Registry &registry, const bool openmetrics = false,
+			const bool timestamps = true, const MetricFilter &filter =
+					MetricFilter(), const uint32_t consumer = 0);
+
+	/**
+	 * Writes the next part of the exposition to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the whole exposition was written.
+	 */
+	size_t fill(uint8_t *buffer, const size_t max_len) override;
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_METRICS_GENERATOR_H_ */
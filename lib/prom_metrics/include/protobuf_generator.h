@@ -0,0 +1,132 @@
+/*
+ * protobuf_generator.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_PROTOBUF_GENERATOR_H_
+#define LIB_PROM_METRICS_PROTOBUF_GENERATOR_H_
+
+#include "exposition_generator.h"
+#include "metric_registry.h"
+#include "protobuf_writer.h"
+#include "sample_iterator.h"
+
+namespace prom {
+/**
+ * The content type of the delimited protobuf exposition format.
+ */
+static constexpr const char PROTOBUF_CONTENT_TYPE[] =
+		"application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited";
+
+/**
+ * A resumable generator for the delimited protobuf exposition of all metrics in a registry.
+ *
+ * The exposition is a sequence of length delimited io.prometheus.client.MetricFamily messages.
+ * Each message is created from the same sample lines as the text formats, parsed using parseSampleLine.
+ * The samples of a histogram have to be written as buckets, sum, and count, for each label set.
+ *
+ * Each message is written into a fixed size buffer before it is sent, since it starts with its length.
+ * A metric family that doesn't fit is split into multiple messages with the same name.
+ * A single metric that doesn't fit a message is skipped with an error.
+ */
+class ProtobufGenerator: public ExpositionGenerator {
+public:
+	/**
+	 * The size of the buffer for a single encoded Metric message.
+	 */
+	static constexpr size_t METRIC_BUFFER_SIZE = 512;
+
+	/**
+	 * The size of the buffer for a single encoded MetricFamily message.
+	 */
+	static constexpr size_t MESSAGE_BUFFER_SIZE = 1024;
+
+private:
+	/**
+	 * The iterator rendering the sample lines of each metric.
+	 */
+	SampleIterator _samples;
+
+	/**
+	 * The buffer for the current MetricFamily message.
+	 */
+	uint8_t _message[MESSAGE_BUFFER_SIZE];
+
+	/**
+	 * The buffer for the next Metric message, including its field tag.
+	 */
+	uint8_t _metric[METRIC_BUFFER_SIZE];
+
+	/**
+	 * The length of the Metric message that wasn't added to a MetricFamily message yet.
+	 * Zero if there is none.
+	 */
+	size_t _metric_len;
+
+	/**
+	 * The output that wasn't copied to an output buffer yet.
+	 */
+	const uint8_t *_pending;
+
+	/**
+	 * The number of pending bytes.
+	 */
+	size_t _pending_len;
+
+	/**
+	 * Writes the next MetricFamily message, and sets it as the pending output.
+	 *
+	 * @return	False if the whole exposition was generated.
+	 */
+	bool next();
+
+	/**
+	 * Encodes the next Metric message of the current metric into the metric buffer.
+	 * Sets the length of the metric buffer to zero if the samples were invalid, or didn't fit.
+	 *
+	 * @param family	The description of the current metric family.
+	 * @return	False if all samples of the current metric were encoded.
+	 */
+	bool encodeMetric(const MetricFamily &family);
+
+	/**
+	 * Encodes the next label set of the current histogram into the given writer.
+	 *
+	 * @param writer	The writer to write the Metric message to.
+	 * @param family	The description of the current metric family.
+	 * @return	False if all samples of the current metric were encoded.
+	 */
+	bool encodeHistogram(ProtobufWriter &writer, const MetricFamily &family);
+
+public:
+	/**
+	 * Creates a new generator, starting at the start of the exposition.
+	 *
+	 * @param registry		The registry containing the metrics to write.
+	 * 						Metrics added after the generator reached the end of the registry are ignored.
+	 * @param timestamps	Whether metrics may write samples with a timestamp.
+	 * @param filter		The filter selecting the metrics to write. Default is all metrics.
+	 * @param consumer		The identifier of the receiver, like the address of a scraper.
+	 * 						Zero if it only gets the current samples, which is the default.
+	 */
+	ProtobufGenerator(const Registry &registry, const bool timestamps = true,
+			const MetricFilter &filter = MetricFilter(), const uint32_t consumer =
+					0);
+
+	/**
+	 * Writes the next part of the exposition to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the whole exposition was written.
+	 */
+	size_t fill(uint8_t *buffer, const size_t max_len) override;
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_PROTOBUF_GENERATOR_H_ */
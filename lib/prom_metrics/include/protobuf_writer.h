@@ -0,0 +1,181 @@
+/*
+ * protobuf_writer.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_PROTOBUF_WRITER_H_
+#define LIB_PROM_METRICS_PROTOBUF_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prom {
+/**
+ * A minimal protocol buffers encoder, writing messages into a caller supplied buffer.
+ *
+ * Fields are written in the order they are added, with proto3 semantics,
+ * so fields with their default value have to be skipped by the caller if the output should be canonical.
+ *
+ * Nested messages are written in place.
+ * Their length is reserved before their content, and moved to the end of the reserved space once it is known.
+ * This means the whole message has to fit the buffer, but doesn't have to be serialized twice.
+ *
+ * Once something didn't fit the buffer, the writer stops writing, until it is reset to an earlier position.
+ */
+class ProtobufWriter {
+public:
+	/**
+	 * The wire types of protocol buffers fields.
+	 */
+	enum WireType : uint8_t {
+		VARINT = 0, FIXED64 = 1, LENGTH_DELIMITED = 2, FIXED32 = 5
+	};
+
+	/**
+	 * The number of bytes reserved for the length of a nested message.
+	 * Enough for messages of up to 2^35 bytes.
+	 */
+	static constexpr size_t LENGTH_RESERVATION = 5;
+
+private:
+	/**
+	 * The buffer to write to.
+	 */
+	uint8_t *const _buffer;
+
+	/**
+	 * The size of the buffer.
+	 */
+	const size_t _size;
+
+	/**
+	 * The number of bytes written to the buffer.
+	 */
+	size_t _len;
+
+	/**
+	 * Whether something didn't fit the buffer.
+	 */
+	bool _overflow;
+
+public:
+	/**
+	 * Creates a new writer, writing to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param size		The size of the buffer.
+	 */
+	ProtobufWriter(uint8_t *buffer, const size_t size);
+
+	/**
+	 * Writes a base 128 varint.
+	 *
+	 * @param value	The value to write.
+	 */
+	void writeVarint(uint64_t value);
+
+	/**
+	 * Writes the tag of a field.
+	 *
+	 * @param field	The field number.
+	 * @param type	The wire type of the field.
+	 */
+	void writeTag(const uint32_t field, const WireType type);
+
+	/**
+	 * Writes an integer field, as a varint.
+	 * Negative int64 values have to be cast to uint64_t, and use ten bytes.
+	 *
+	 * @param field	The field number.
+	 * @param value	The value of the field.
+	 */
+	void writeVarintField(const uint32_t field, const uint64_t value);
+
+	/**
+	 * Writes a double field.
+	 *
+	 * @param field	The field number.
+	 * @param value	The value of the field.
+	 */
+	void writeDoubleField(const uint32_t field, const double value);
+
+	/**
+	 * Writes a string or bytes field.
+	 *
+	 * @param field	The field number.
+	 * @param data	The content of the field.
+	 * @param len	The length of the content.
+	 */
+	void writeBytesField(const uint32_t field, const void *data,
+			const size_t len);
+
+	/**
+	 * Writes the given bytes as they are, if they fit the buffer.
+	 * Used for fields encoded by another writer.
+	 *
+	 * @param data	The bytes to write.
+	 * @param len	The number of bytes to write.
+	 */
+	void write(const void *data, const size_t len);
+
+	/**
+	 * Starts a nested message, whose fields are written until endMessage is called.
+	 *
+	 * @param field	The field number.
+	 * @return	The position to pass to endMessage.
+	 */
+	size_t beginMessage(const uint32_t field);
+
+	/**
+	 * Starts a length delimited message without a tag, like the messages of a delimited stream.
+	 *
+	 * @return	The position to pass to endMessage.
+	 */
+	size_t beginDelimited();
+
+	/**
+	 * Ends a nested message, by writing its length before its content.
+	 *
+	 * @param start	The position returned by beginMessage.
+	 */
+	void endMessage(const size_t start);
+
+	/**
+	 * Gets the number of bytes written.
+	 *
+	 * @return	The length of the written data.
+	 */
+	size_t getLength() const;
+
+	/**
+	 * Checks whether something didn't fit the buffer.
+	 * The written data is incomplete in that case.
+	 *
+	 * @return	True if the buffer was too small.
+	 */
+	bool overflowed() const;
+
+	/**
+	 * Drops everything written after the given length, and clears the overflow flag.
+	 * Can be used to drop a message that didn't fit the buffer.
+	 *
+	 * @param len	The length to reset to. Must not be within an unfinished nested message started before it.
+	 */
+	void truncate(const size_t len);
+
+	/**
+	 * Gets the number of bytes required to write the given value as a varint.
+	 *
+	 * @param value	The value to check.
+	 * @return	The length of the varint.
+	 */
+	static size_t varintLength(uint64_t value);
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_PROTOBUF_WRITER_H_ */
@@ -0,0 +1,65 @@
+/*
+ * remote_write.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_REMOTE_WRITE_H_
+#define LIB_PROM_METRICS_REMOTE_WRITE_H_
+
+#include "metric_registry.h"
+#include "protobuf_writer.h"
+
+namespace prom {
+/**
+ * A label added to every series of a remote write request, like the job and instance labels added by a scrape.
+ */
+struct RemoteWriteLabel {
+	/**
+	 * The name of the label.
+	 */
+	const char *name;
+
+	/**
+	 * The unescaped value of the label.
+	 */
+	const char *value;
+};
+
+/**
+ * The max number of labels of a single series, including the metric name and the external labels.
+ * Samples with more labels are dropped.
+ */
+static constexpr size_t REMOTE_WRITE_MAX_LABELS = 16;
+
+/**
+ * Writes the samples of all metrics in the given registry as a Prometheus remote write 1.0 WriteRequest.
+ *
+ * Each sample line is written as a TimeSeries with a single sample.
+ * The labels of each series are sorted by name, as required by the remote write specification.
+ * Samples without a timestamp get the given timestamp.
+ * Samples that don't fit the writer buffer are dropped, the ones written before them are kept.
+ * When only writing missed samples, the request ends before the first sample that doesn't fit instead,
+ * so the metrics can send the rest in the next request.
+ *
+ * @param writer		The writer to write the WriteRequest to.
+ * @param registry		The registry containing the metrics to write.
+ * @param labels		The labels to add to every series. Sample labels with the same name take precedence.
+ * @param label_count	The number of external labels.
+ * @param timestamp		The time to use for samples without a timestamp, in milliseconds since the unix epoch.
+ * @param dropped		The variable to add the number of dropped samples to.
+ * @param consumer		The identifier of the receiver, or zero if it only gets the current samples.
+ * @param missed_only	Whether to only write the older samples the receiver missed, without the current samples.
+ * @return	The number of written samples.
+ */
+size_t writeRemoteWriteRequest(ProtobufWriter &writer, const Registry &registry,
+		const RemoteWriteLabel *labels, const size_t label_count,
+		const int64_t timestamp, size_t &dropped, const uint32_t consumer = 0,
+		const bool missed_only = false);
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_REMOTE_WRITE_H_ */
@@ -0,0 +1,128 @@
+/*
+ * sample_iterator.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_SAMPLE_ITERATOR_H_
+#define LIB_PROM_METRICS_SAMPLE_ITERATOR_H_
+
+#include "metric_filter.h"
+#include "metric_registry.h"
+
+namespace prom {
+/**
+ * Iterates over the metrics of a registry, and renders the sample lines of each metric one at a time.
+ *
+ * This is the common base of all exposition formats.
+ * The text formats copy the sample lines directly, other formats parse them using parseSampleLine.
+ */
+class SampleIterator {
+public:
+	/**
+	 * The size of the buffer for a single rendered sample line.
+	 * Longer lines are skipped with an error.
+	 */
+	static constexpr size_t LINE_BUFFER_SIZE = 384;
+
+private:
+	/**
+	 * The metric the next sample line belongs to.
+	 */
+	const Metric *_metric;
+
+	/**
+	 * The position in the samples of the current metric.
+	 */
+	SampleCursor _cursor;
+
+	/**
+	 * Whether samples are written in the OpenMetrics format.
+	 */
+	const bool _openmetrics;
+
+	/**
+	 * Whether samples may be written with a timestamp.
+	 */
+	const bool _timestamps;
+
+	/**
+	 * The identifier of the receiver of the samples.
+	 */
+	const uint32_t _consumer;
+
+	/**
+	 * Whether only the samples the receiver missed are written.
+	 */
+	const bool _missed_only;
+
+	/**
+	 * The filter selecting the metrics to iterate over.
+	 */
+	const MetricFilter _filter;
+
+	/**
+	 * The buffer for the last rendered sample line.
+	 */
+	char _line[LINE_BUFFER_SIZE];
+
+	/**
+	 * Moves to the first sample of the given metric, or the first metric after it matching the filter.
+	 *
+	 * @param metric	The metric to move to. NULL for the end of the registry.
+	 */
+	void moveTo(const Metric *metric);
+
+public:
+	/**
+	 * Creates a new sample iterator, starting at the first sample of the first metric of the given registry.
+	 *
+	 * @param registry		The registry containing the metrics to iterate over.
+	 * @param openmetrics	Whether samples are written in the OpenMetrics format.
+	 * @param timestamps	Whether metrics may write samples with a timestamp.
+	 * @param filter		The filter selecting the metrics to iterate over.
+	 * 						Metrics not matching it are skipped without rendering any samples.
+	 * @param consumer		The identifier of the receiver of the samples, or zero if it only gets the current samples.
+	 * @param missed_only	Whether to only write the samples the receiver missed.
+	 * 						Metrics that don't write missed samples are skipped.
+	 */
+	SampleIterator(const Registry &registry, const bool openmetrics,
+			const bool timestamps, const MetricFilter &filter = MetricFilter(),
+			const uint32_t consumer = 0, const bool missed_only = false);
+
+	/**
+	 * Gets the metric whose samples are currently rendered.
+	 *
+	 * @return	The current metric, or NULL after the last metric.
+	 */
+	const Metric* getMetric() const;
+
+	/**
+	 * Moves to the first sample of the next metric.
+	 * Skips the remaining samples of the current metric.
+	 */
+	void nextMetric();
+
+	/**
+	 * Renders the next sample line of the current metric into the line buffer.
+	 * Skips lines that don't fit the line buffer.
+	 *
+	 * @return	The length of the line, or zero if all samples of the current metric were rendered.
+	 */
+	size_t nextSample();
+
+	/**
+	 * Gets the last rendered sample line.
+	 * The line ends with a line break, and is NUL terminated.
+	 *
+	 * @return	The line buffer.
+	 */
+	const char* getLine() const;
+};
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_SAMPLE_ITERATOR_H_ */
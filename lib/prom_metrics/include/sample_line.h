@@ -0,0 +1,118 @@
+/*
+ * sample_line.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROM_METRICS_SAMPLE_LINE_H_
+#define LIB_PROM_METRICS_SAMPLE_LINE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prom {
+/**
+ * The parts of a sample line in the Prometheus 0.0.4 text format.
+ * All strings point into the parsed line, and aren't NUL terminated.
+ */
+struct SampleLine {
+	/**
+	 * The name of the sample.
+	 */
+	const char *name;
+
+	/**
+	 * The length of the sample name.
+	 */
+	size_t name_len;
+
+	/**
+	 * The labels of the sample, without the braces, with escaped values.
+	 */
+	const char *labels;
+
+	/**
+	 * The length of the labels.
+	 */
+	size_t labels_len;
+
+	/**
+	 * The value of the sample.
+	 */
+	double value;
+
+	/**
+	 * Whether the sample has a timestamp.
+	 */
+	bool has_timestamp;
+
+	/**
+	 * The timestamp of the sample, in milliseconds since the unix epoch.
+	 */
+	int64_t timestamp;
+};
+
+/**
+ * A single label of a sample line.
+ * The strings point into the parsed line, and aren't NUL terminated.
+ */
+struct SampleLabel {
+	/**
+	 * The name of the label.
+	 */
+	const char *name;
+
+	/**
+	 * The length of the label name.
+	 */
+	size_t name_len;
+
+	/**
+	 * The escaped value of the label, without the quotes.
+	 */
+	const char *value;
+
+	/**
+	 * The length of the escaped label value.
+	 */
+	size_t value_len;
+};
+
+/**
+ * Parses a sample line written by a metric of this library, in the Prometheus 0.0.4 text format.
+ *
+ * @param line		The line to parse. Has to end with a line break.
+ * @param len		The length of the line, including the line break.
+ * @param sample	The sample to write the parsed parts to.
+ * @return	False if the line isn't a valid sample line.
+ */
+bool parseSampleLine(const char *line, const size_t len, SampleLine &sample);
+
+/**
+ * Parses the next label of the labels of a sample line.
+ *
+ * @param pos	The position to start parsing at. Set to the start of the next label.
+ * @param end	The end of the labels.
+ * @param label	The label to write the parsed parts to.
+ * @return	False if there are no more labels, or they are invalid.
+ */
+bool nextSampleLabel(const char *&pos, const char *end, SampleLabel &label);
+
+/**
+ * Unescapes a label value of a sample line.
+ * The escape sequences are \\\\, \\", and \\n.
+ *
+ * @param value	The escaped label value.
+ * @param len	The length of the escaped value.
+ * @param out	The buffer to write the unescaped value to, at least len bytes long.
+ * 				NULL to only calculate the unescaped length.
+ * @return	The length of the unescaped value.
+ */
+size_t unescapeLabelValue(const char *value, const size_t len, char *out);
+} /* namespace prom */
+
+#endif /* LIB_PROM_METRICS_SAMPLE_LINE_H_ */
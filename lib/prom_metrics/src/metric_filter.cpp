@@ -0,0 +1,43 @@
+/*
+ * metric_filter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "metric_filter.h"
+#include <cstring>
+
+namespace prom {
+
+constexpr size_t MetricFilter::MAX_NAMES;
+
+bool MetricFilter::add(const char *name) {
+	if (_names.size() >= MAX_NAMES) {
+		return false;
+	}
+	_names.push_back(name);
+	return true;
+}
+
+bool MetricFilter::empty() const {
+	return _names.empty();
+}
+
+bool MetricFilter::matches(const MetricFamily &family) const {
+	if (_names.empty()) {
+		return true;
+	}
+
+	for (const std::string &name : _names) {
+		if (strcmp(name.c_str(), family.name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} /* namespace prom */
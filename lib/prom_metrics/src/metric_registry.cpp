@@ -0,0 +1,175 @@
+/*
+ * metric_registry.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "metric_registry.h"
+#include <cmath>
+#include <cstdio>
+
+namespace prom {
+
+constexpr size_t SampleCursor::STATE_SIZE;
+
+/**
+ * Converts the given unsigned integer to a decimal string.
+ * Not all printf implementations support 64 bit integers, so they are converted manually.
+ *
+ * @param digits	The buffer to write the digits to.
+ * @param value		The value to convert.
+ * @return	A pointer to the first digit in the buffer.
+ */
+static const char* formatUnsigned(char (&digits)[21], uint64_t value) {
+	size_t pos = sizeof(digits) - 1;
+	digits[pos] = 0;
+	do {
+		digits[--pos] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	return digits + pos;
+}
+
+Metric::Metric(const MetricFamily &family) :
+		_family(family), _next(NULL), _registry(NULL) {
+
+}
+
+Metric::~Metric() {
+
+}
+
+const MetricFamily& Metric::getFamily() const {
+	return _family;
+}
+
+const Metric* Metric::getNext() const {
+	return _next;
+}
+
+bool Metric::writesMissedSamples() const {
+	return false;
+}
+
+Gauge::Gauge(const MetricFamily &family, double (*read)()) :
+		Metric(family), _read(read) {
+
+}
+
+size_t Gauge::writeSample(char *buffer, const size_t size,
+		SampleCursor &cursor) const {
+	if (cursor.index++ > 0) {
+		return 0;
+	}
+	return writeSampleLine(buffer, size, getFamily().name, _read());
+}
+
+Counter::Counter(const MetricFamily &family, uint64_t (*read)()) :
+		Metric(family), _read(read) {
+
+}
+
+size_t Counter::writeSample(char *buffer, const size_t size,
+		SampleCursor &cursor) const {
+	if (cursor.index++ > 0) {
+		return 0;
+	}
+	char digits[21];
+	return snprintf(buffer, size, "%s %s\n", getFamily().name,
+			formatUnsigned(digits, _read()));
+}
+
+Info::Info(const MetricFamily &family,
+		size_t (*write_labels)(char *buffer, const size_t size)) :
+		Metric(family), _write_labels(write_labels) {
+
+}
+
+size_t Info::writeSample(char *buffer, const size_t size,
+		SampleCursor &cursor) const {
+	if (cursor.index++ > 0) {
+		return 0;
+	}
+
+	size_t len = snprintf(buffer, size, "%s{", getFamily().name);
+	len += _write_labels(buffer + (len < size ? len : size),
+			len < size ? size - len : 0);
+	len += snprintf(buffer + (len < size ? len : size),
+			len < size ? size - len : 0, "} 1\n");
+	return len;
+}
+
+Collector::Collector(const MetricFamily &family,
+		size_t (*write_sample)(char *buffer, const size_t size,
+				const MetricFamily &family, SampleCursor &cursor),
+		const bool writes_missed) :
+		Metric(family), _write_sample(write_sample), _writes_missed(
+				writes_missed) {
+
+}
+
+size_t Collector::writeSample(char *buffer, const size_t size,
+		SampleCursor &cursor) const {
+	return _write_sample(buffer, size, getFamily(), cursor);
+}
+
+bool Collector::writesMissedSamples() const {
+	return _writes_missed;
+}
+
+bool Registry::add(Metric &metric) {
+	if (metric._registry) {
+		return false;
+	}
+
+	metric._registry = this;
+	if (_last) {
+		_last->_next = &metric;
+	} else {
+		_first = &metric;
+	}
+	_last = &metric;
+	return true;
+}
+
+const Metric* Registry::getFirst() const {
+	return _first;
+}
+
+size_t writeSampleLine(char *buffer, const size_t size, const char *name,
+		const double value) {
+	if (std::isnan(value)) {
+		return snprintf(buffer, size, "%s NAN\n", name);
+	}
+	return snprintf(buffer, size, "%s %.3f\n", name, value);
+}
+
+size_t writeSampleLine(char *buffer, const size_t size, const char *name,
+		const double value, const int64_t timestamp, const bool openmetrics) {
+	// Timestamps before the epoch can't be produced by a clock synchronized using SNTP.
+	const uint64_t millis = timestamp > 0 ? timestamp : 0;
+	char digits[21];
+	char suffix[28];
+	size_t suffix_len;
+	if (openmetrics) {
+		suffix_len = snprintf(suffix, sizeof(suffix), " %s.%03u\n",
+				formatUnsigned(digits, millis / 1000),
+				(unsigned int) (millis % 1000));
+	} else {
+		suffix_len = snprintf(suffix, sizeof(suffix), " %s\n",
+				formatUnsigned(digits, millis));
+	}
+
+	// The timestamp replaces the line break of the sample line without a timestamp.
+	const size_t len = writeSampleLine(buffer, size, name, value) - 1;
+	if (len < size) {
+		snprintf(buffer + len, size - len, "%s", suffix);
+	}
+	return len + suffix_len;
+}
+
+} /* namespace prom */
@@ -0,0 +1,90 @@
+/*
+ * metrics_generator.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "metrics_generator.h"
+#include <cstring>
+
+namespace prom {
+
+constexpr size_t MetricsGenerator::LINE_BUFFER_SIZE;
+
+MetricsGenerator::MetricsGenerator(const Registry &registry,
+		const bool openmetrics, const bool timestamps,
+		const MetricFilter &filter, const uint32_t consumer) :
+		_openmetrics(openmetrics), _state(END_OF_FILE), _samples(registry,
+				openmetrics, timestamps, filter, consumer), _pending(NULL), _pending_len(
+				0) {
+	if (_samples.getMetric()) {
+		_state = METADATA;
+	}
+}
+
+size_t MetricsGenerator::fill(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_pending_len == 0 && !next()) {
+			break;
+		}
+
+		const size_t len =
+				max_len - written < _pending_len ?
+						max_len - written : _pending_len;
+		memcpy(buffer + written, _pending, len);
+		written += len;
+		_pending += len;
+		_pending_len -= len;
+	}
+	return written;
+}
+
+bool MetricsGenerator::next() {
+	while (_state != DONE) {
+		switch (_state) {
+		case METADATA: {
+			const MetricFamily &family = _samples.getMetric()->getFamily();
+			_state = SAMPLES;
+			// The metadata lines are compile time constants, so they don't have to be copied to the line buffer.
+			if (_openmetrics) {
+				_pending = family.openmetrics_metadata;
+				_pending_len = family.openmetrics_metadata_len;
+			} else {
+				_pending = family.metadata;
+				_pending_len = family.metadata_len;
+			}
+			return true;
+		}
+		case SAMPLES: {
+			const size_t len = _samples.nextSample();
+			if (len == 0) {
+				_samples.nextMetric();
+				_state = _samples.getMetric() ? METADATA : END_OF_FILE;
+			} else {
+				_pending = _samples.getLine();
+				_pending_len = len;
+				return true;
+			}
+			break;
+		}
+		case END_OF_FILE:
+			_state = DONE;
+			if (_openmetrics) {
+				_pending = "# EOF\n";
+				_pending_len = 6;
+				return true;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+} /* namespace prom */
@@ -0,0 +1,313 @@
+/*
+ * protobuf_generator.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "protobuf_generator.h"
+#include "sample_line.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fallback_log.h>
+
+namespace prom {
+
+constexpr size_t ProtobufGenerator::METRIC_BUFFER_SIZE;
+constexpr size_t ProtobufGenerator::MESSAGE_BUFFER_SIZE;
+
+/**
+ * The field numbers of the io.prometheus.client messages.
+ */
+enum ExpositionField : uint32_t {
+	FAMILY_NAME = 1,
+	FAMILY_HELP = 2,
+	FAMILY_TYPE = 3,
+	FAMILY_METRIC = 4,
+	METRIC_LABEL = 1,
+	METRIC_GAUGE = 2,
+	METRIC_COUNTER = 3,
+	METRIC_TIMESTAMP_MS = 6,
+	METRIC_HISTOGRAM = 7,
+	LABEL_NAME = 1,
+	LABEL_VALUE = 2,
+	VALUE = 1,
+	HISTOGRAM_SAMPLE_COUNT = 1,
+	HISTOGRAM_SAMPLE_SUM = 2,
+	HISTOGRAM_BUCKET = 3,
+	BUCKET_CUMULATIVE_COUNT = 1,
+	BUCKET_UPPER_BOUND = 2
+};
+
+/**
+ * The values of the io.prometheus.client.MetricType enum.
+ */
+enum ExpositionType : uint64_t {
+	COUNTER = 0, GAUGE = 1, HISTOGRAM = 4
+};
+
+/**
+ * Writes the name, help, and type of a MetricFamily message.
+ * Info metrics are written as gauges, like in the Prometheus text format.
+ *
+ * @param writer	The writer to write the fields to.
+ * @param family	The description of the metric family.
+ */
+static void writeFamilyHeader(ProtobufWriter &writer,
+		const MetricFamily &family) {
+	const size_t name_len = strlen(family.name);
+	writer.writeBytesField(FAMILY_NAME, family.name, name_len);
+
+	// The metadata starts with "# HELP <name> <help>\n".
+	const char *help = family.metadata + 8 + name_len;
+	const char *help_end = (const char*) memchr(help, '\n',
+			family.metadata_len - (help - family.metadata));
+	writer.writeBytesField(FAMILY_HELP, help, help_end - help);
+
+	switch (family.type) {
+	case MetricType::COUNTER:
+		writer.writeVarintField(FAMILY_TYPE, COUNTER);
+		break;
+	case MetricType::HISTOGRAM:
+		writer.writeVarintField(FAMILY_TYPE, HISTOGRAM);
+		break;
+	default:
+		writer.writeVarintField(FAMILY_TYPE, GAUGE);
+		break;
+	}
+}
+
+/**
+ * Writes the labels of a sample line as LabelPair messages.
+ *
+ * @param writer	The writer to write the labels to.
+ * @param line		The sample line to write the labels of.
+ * @param skip_le	Whether to skip the le label of histogram buckets.
+ */
+static void writeLabels(ProtobufWriter &writer, const SampleLine &line,
+		const bool skip_le) {
+	const char *pos = line.labels;
+	const char *end = line.labels + line.labels_len;
+	SampleLabel label;
+	while (nextSampleLabel(pos, end, label)) {
+		if (skip_le && label.name_len == 2 && memcmp(label.name, "le", 2) == 0) {
+			continue;
+		}
+
+		const size_t start = writer.beginMessage(METRIC_LABEL);
+		writer.writeBytesField(LABEL_NAME, label.name, label.name_len);
+		char value[SampleIterator::LINE_BUFFER_SIZE];
+		writer.writeBytesField(LABEL_VALUE, value,
+				unescapeLabelValue(label.value, label.value_len, value));
+		writer.endMessage(start);
+	}
+}
+
+/**
+ * Checks whether the name of a sample is the family name with the given suffix.
+ *
+ * @param line		The sample line to check.
+ * @param family	The description of the metric family.
+ * @param suffix	The suffix to check for, like "_sum".
+ * @return	True if the sample name has the given suffix.
+ */
+static bool hasSuffix(const SampleLine &line, const MetricFamily &family,
+		const char *suffix) {
+	const size_t name_len = strlen(family.name);
+	const size_t suffix_len = strlen(suffix);
+	return line.name_len == name_len + suffix_len
+			&& memcmp(line.name + name_len, suffix, suffix_len) == 0;
+}
+
+ProtobufGenerator::ProtobufGenerator(const Registry &registry,
+		const bool timestamps, const MetricFilter &filter,
+		const uint32_t consumer) :
+		_samples(registry, false, timestamps, filter, consumer), _metric_len(0), _pending(
+				NULL), _pending_len(0) {
+}
+
+size_t ProtobufGenerator::fill(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_pending_len == 0 && !next()) {
+			break;
+		}
+
+		const size_t len =
+				max_len - written < _pending_len ?
+						max_len - written : _pending_len;
+		memcpy(buffer + written, _pending, len);
+		written += len;
+		_pending += len;
+		_pending_len -= len;
+	}
+	return written;
+}
+
+bool ProtobufGenerator::next() {
+	while (_samples.getMetric()) {
+		const MetricFamily &family = _samples.getMetric()->getFamily();
+		ProtobufWriter writer(_message, sizeof(_message));
+		const size_t start = writer.beginDelimited();
+		writeFamilyHeader(writer, family);
+		const size_t header_len = writer.getLength();
+		if (writer.overflowed()) {
+			log_e("The metadata of %s is too long.", family.name);
+			_metric_len = 0;
+			_samples.nextMetric();
+			continue;
+		}
+
+		bool family_done = false;
+		while (!family_done) {
+			if (_metric_len == 0) {
+				family_done = !encodeMetric(family);
+				continue;
+			}
+
+			const size_t before = writer.getLength();
+			writer.write(_metric, _metric_len);
+			if (!writer.overflowed()) {
+				_metric_len = 0;
+			} else if (before == header_len) {
+				writer.truncate(before);
+				log_e("A metric of %s is too large for a single message.",
+						family.name);
+				_metric_len = 0;
+			} else {
+				// The metric is added to the next message for the same family.
+				writer.truncate(before);
+				break;
+			}
+		}
+
+		if (family_done) {
+			_samples.nextMetric();
+		}
+
+		// Families without samples are skipped, since a MetricFamily message without metrics is useless.
+		if (writer.getLength() > header_len) {
+			writer.endMessage(start);
+			_pending = _message;
+			_pending_len = writer.getLength();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ProtobufGenerator::encodeMetric(const MetricFamily &family) {
+	ProtobufWriter writer(_metric, sizeof(_metric));
+	const size_t start = writer.beginMessage(FAMILY_METRIC);
+	if (family.type == MetricType::HISTOGRAM) {
+		if (!encodeHistogram(writer, family)) {
+			return false;
+		}
+	} else {
+		const size_t len = _samples.nextSample();
+		if (len == 0) {
+			return false;
+		}
+
+		SampleLine line;
+		if (!parseSampleLine(_samples.getLine(), len, line)) {
+			log_e("Failed to parse a sample line of %s.", family.name);
+			_metric_len = 0;
+			return true;
+		}
+
+		writeLabels(writer, line, false);
+		const size_t value = writer.beginMessage(
+				family.type == MetricType::COUNTER ?
+						METRIC_COUNTER : METRIC_GAUGE);
+		writer.writeDoubleField(VALUE, line.value);
+		writer.endMessage(value);
+		if (line.has_timestamp) {
+			writer.writeVarintField(METRIC_TIMESTAMP_MS,
+					(uint64_t) line.timestamp);
+		}
+	}
+	writer.endMessage(start);
+
+	if (writer.overflowed()) {
+		log_e("A metric of %s is too large for the metric buffer.",
+				family.name);
+		_metric_len = 0;
+	} else {
+		_metric_len = writer.getLength();
+	}
+	return true;
+}
+
+bool ProtobufGenerator::encodeHistogram(ProtobufWriter &writer,
+		const MetricFamily &family) {
+	bool started = false;
+	size_t histogram = 0;
+	bool has_timestamp = false;
+	int64_t timestamp = 0;
+	size_t len;
+	while ((len = _samples.nextSample()) > 0) {
+		SampleLine line;
+		if (!parseSampleLine(_samples.getLine(), len, line)) {
+			log_e("Failed to parse a sample line of %s.", family.name);
+			continue;
+		}
+
+		// The labels of the first sample, without le, are the labels of the whole label set.
+		if (!started) {
+			writeLabels(writer, line, true);
+			histogram = writer.beginMessage(METRIC_HISTOGRAM);
+			started = true;
+		}
+
+		if (hasSuffix(line, family, "_bucket")) {
+			const char *pos = line.labels;
+			SampleLabel label;
+			bool found = false;
+			while (!found
+					&& nextSampleLabel(pos, line.labels + line.labels_len, label)) {
+				found = label.name_len == 2 && memcmp(label.name, "le", 2) == 0;
+			}
+			if (!found) {
+				log_e("A bucket of %s has no le label.", family.name);
+				continue;
+			}
+
+			// The label value is followed by a quote, so strtod stops there.
+			const double upper_bound = strtod(label.value, NULL);
+			// The +Inf bucket is the sample count, so it isn't written separately.
+			if (!std::isinf(upper_bound)) {
+				const size_t bucket = writer.beginMessage(HISTOGRAM_BUCKET);
+				writer.writeVarintField(BUCKET_CUMULATIVE_COUNT,
+						(uint64_t) line.value);
+				writer.writeDoubleField(BUCKET_UPPER_BOUND, upper_bound);
+				writer.endMessage(bucket);
+			}
+		} else if (hasSuffix(line, family, "_sum")) {
+			writer.writeDoubleField(HISTOGRAM_SAMPLE_SUM, line.value);
+		} else if (hasSuffix(line, family, "_count")) {
+			writer.writeVarintField(HISTOGRAM_SAMPLE_COUNT,
+					(uint64_t) line.value);
+			has_timestamp = line.has_timestamp;
+			timestamp = line.timestamp;
+			// The count is the last sample of each label set.
+			break;
+		}
+	}
+
+	if (!started) {
+		return false;
+	}
+
+	writer.endMessage(histogram);
+	if (has_timestamp) {
+		writer.writeVarintField(METRIC_TIMESTAMP_MS, (uint64_t) timestamp);
+	}
+	return true;
+}
+
+} /* namespace prom */
@@ -0,0 +1,127 @@
+/*
+ * protobuf_writer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "protobuf_writer.h"
+#include <cstring>
+
+namespace prom {
+
+constexpr size_t ProtobufWriter::LENGTH_RESERVATION;
+
+ProtobufWriter::ProtobufWriter(uint8_t *buffer, const size_t size) :
+		_buffer(buffer), _size(size), _len(0), _overflow(false) {
+
+}
+
+void ProtobufWriter::write(const void *data, const size_t len) {
+	if (_overflow || _size - _len < len) {
+		_overflow = true;
+		return;
+	}
+	memcpy(_buffer + _len, data, len);
+	_len += len;
+}
+
+void ProtobufWriter::writeVarint(uint64_t value) {
+	uint8_t bytes[10];
+	size_t len = 0;
+	while (value >= 0x80) {
+		bytes[len++] = (uint8_t) value | 0x80;
+		value >>= 7;
+	}
+	bytes[len++] = (uint8_t) value;
+	write(bytes, len);
+}
+
+void ProtobufWriter::writeTag(const uint32_t field, const WireType type) {
+	writeVarint(((uint64_t) field << 3) | type);
+}
+
+void ProtobufWriter::writeVarintField(const uint32_t field,
+		const uint64_t value) {
+	writeTag(field, VARINT);
+	writeVarint(value);
+}
+
+void ProtobufWriter::writeDoubleField(const uint32_t field,
+		const double value) {
+	writeTag(field, FIXED64);
+	// Protocol buffers are little endian, regardless of the platform.
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint8_t bytes[8];
+	for (size_t i = 0; i < 8; i++) {
+		bytes[i] = (uint8_t) (bits >> (i * 8));
+	}
+	write(bytes, sizeof(bytes));
+}
+
+void ProtobufWriter::writeBytesField(const uint32_t field, const void *data,
+		const size_t len) {
+	writeTag(field, LENGTH_DELIMITED);
+	writeVarint(len);
+	write(data, len);
+}
+
+size_t ProtobufWriter::beginMessage(const uint32_t field) {
+	writeTag(field, LENGTH_DELIMITED);
+	return beginDelimited();
+}
+
+size_t ProtobufWriter::beginDelimited() {
+	const size_t start = _len;
+	if (_overflow || _size - _len < LENGTH_RESERVATION) {
+		_overflow = true;
+	} else {
+		_len += LENGTH_RESERVATION;
+	}
+	return start;
+}
+
+void ProtobufWriter::endMessage(const size_t start) {
+	if (_overflow) {
+		return;
+	}
+
+	// Replace the reserved space with the actual length, and move the content directly after it.
+	const size_t content_start = start + LENGTH_RESERVATION;
+	const size_t content_len = _len - content_start;
+	const size_t len_len = varintLength(content_len);
+	_len = start;
+	writeVarint(content_len);
+	memmove(_buffer + start + len_len, _buffer + content_start, content_len);
+	_len += content_len;
+}
+
+size_t ProtobufWriter::getLength() const {
+	return _len;
+}
+
+bool ProtobufWriter::overflowed() const {
+	return _overflow;
+}
+
+void ProtobufWriter::truncate(const size_t len) {
+	if (len < _len) {
+		_len = len;
+	}
+	_overflow = false;
+}
+
+size_t ProtobufWriter::varintLength(uint64_t value) {
+	size_t len = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		len++;
+	}
+	return len;
+}
+
+} /* namespace prom */
@@ -0,0 +1,212 @@
+/*
+ * remote_write.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "remote_write.h"
+#include "sample_iterator.h"
+#include "sample_line.h"
+#include <cstring>
+#include <fallback_log.h>
+
+namespace prom {
+
+/**
+ * The field numbers of the remote write messages.
+ */
+enum RemoteWriteField : uint32_t {
+	WRITE_REQUEST_TIMESERIES = 1,
+	TIMESERIES_LABELS = 1,
+	TIMESERIES_SAMPLES = 2,
+	LABEL_NAME = 1,
+	LABEL_VALUE = 2,
+	SAMPLE_VALUE = 1,
+	SAMPLE_TIMESTAMP = 2
+};
+
+/**
+ * A label of a single series, from the sample line or the external labels.
+ */
+struct SeriesLabel {
+	/**
+	 * The name of the label.
+	 */
+	const char *name;
+
+	/**
+	 * The length of the label name.
+	 */
+	size_t name_len;
+
+	/**
+	 * The value of the label.
+	 */
+	const char *value;
+
+	/**
+	 * The length of the label value.
+	 */
+	size_t value_len;
+
+	/**
+	 * Whether the value is escaped, like the label values of a sample line.
+	 */
+	bool escaped;
+};
+
+/**
+ * Compares the names of two labels, like strcmp.
+ *
+ * @param first		The first label.
+ * @param second	The second label.
+ * @return	A negative value if the first name is smaller, zero if they are equal, or a positive value.
+ */
+static int compareNames(const SeriesLabel &first, const SeriesLabel &second) {
+	const size_t len =
+			first.name_len < second.name_len ? first.name_len : second.name_len;
+	const int result = memcmp(first.name, second.name, len);
+	if (result != 0) {
+		return result;
+	}
+	return (int) first.name_len - (int) second.name_len;
+}
+
+/**
+ * Writes a single TimeSeries with a single sample.
+ *
+ * @param writer	The writer to write the series to.
+ * @param labels	The labels of the series, sorted by name.
+ * @param count		The number of labels.
+ * @param value		The value of the sample.
+ * @param timestamp	The timestamp of the sample, in milliseconds since the unix epoch.
+ */
+static void writeSeries(ProtobufWriter &writer, const SeriesLabel *labels,
+		const size_t count, const double value, const int64_t timestamp) {
+	const size_t series = writer.beginMessage(WRITE_REQUEST_TIMESERIES);
+	for (size_t i = 0; i < count; i++) {
+		const SeriesLabel &label = labels[i];
+		const size_t label_start = writer.beginMessage(TIMESERIES_LABELS);
+		writer.writeBytesField(LABEL_NAME, label.name, label.name_len);
+		// Fields with their default value are omitted, like by any other proto3 encoder.
+		if (label.value_len > 0) {
+			if (label.escaped) {
+				char value[SampleIterator::LINE_BUFFER_SIZE];
+				writer.writeBytesField(LABEL_VALUE, value,
+						unescapeLabelValue(label.value, label.value_len, value));
+			} else {
+				writer.writeBytesField(LABEL_VALUE, label.value,
+						label.value_len);
+			}
+		}
+		writer.endMessage(label_start);
+	}
+
+	const size_t sample = writer.beginMessage(TIMESERIES_SAMPLES);
+	uint64_t value_bits;
+	memcpy(&value_bits, &value, sizeof(value_bits));
+	if (value_bits != 0) {
+		writer.writeDoubleField(SAMPLE_VALUE, value);
+	}
+	if (timestamp != 0) {
+		writer.writeVarintField(SAMPLE_TIMESTAMP, (uint64_t) timestamp);
+	}
+	writer.endMessage(sample);
+	writer.endMessage(series);
+}
+
+size_t writeRemoteWriteRequest(ProtobufWriter &writer, const Registry &registry,
+		const RemoteWriteLabel *labels, const size_t label_count,
+		const int64_t timestamp, size_t &dropped, const uint32_t consumer,
+		const bool missed_only) {
+	size_t written = 0;
+	SeriesLabel series_labels[REMOTE_WRITE_MAX_LABELS];
+	SampleIterator samples(registry, false, true, MetricFilter(), consumer,
+			missed_only);
+	for (; samples.getMetric(); samples.nextMetric()) {
+		size_t len;
+		while ((len = samples.nextSample()) > 0) {
+			SampleLine line;
+			if (!parseSampleLine(samples.getLine(), len, line)) {
+				log_e("Failed to parse a sample line of %s.",
+						samples.getMetric()->getFamily().name);
+				dropped++;
+				continue;
+			}
+
+			size_t count = 0;
+			series_labels[count++] = { "__name__", 8, line.name,
+					line.name_len, false };
+			const char *pos = line.labels;
+			const char *labels_end = line.labels + line.labels_len;
+			SampleLabel label;
+			bool valid = true;
+			while (valid && nextSampleLabel(pos, labels_end, label)) {
+				if (count < REMOTE_WRITE_MAX_LABELS) {
+					series_labels[count++] = { label.name, label.name_len,
+							label.value, label.value_len, true };
+				} else {
+					valid = false;
+				}
+			}
+
+			const size_t sample_labels = count;
+			for (size_t i = 0; valid && i < label_count; i++) {
+				const SeriesLabel external = { labels[i].name, strlen(
+						labels[i].name), labels[i].value, strlen(
+						labels[i].value), false };
+				bool present = false;
+				for (size_t j = 0; j < sample_labels && !present; j++) {
+					present = compareNames(series_labels[j], external) == 0;
+				}
+				if (present) {
+					continue;
+				} else if (count < REMOTE_WRITE_MAX_LABELS) {
+					series_labels[count++] = external;
+				} else {
+					valid = false;
+				}
+			}
+
+			if (!valid) {
+				log_e("A sample of %s has more than %u labels.",
+						samples.getMetric()->getFamily().name,
+						(unsigned int) REMOTE_WRITE_MAX_LABELS);
+				dropped++;
+				continue;
+			}
+
+			// Series have few labels, so insertion sort is fast enough.
+			for (size_t i = 1; i < count; i++) {
+				const SeriesLabel current = series_labels[i];
+				size_t j = i;
+				for (; j > 0 && compareNames(series_labels[j - 1], current) > 0;
+						j--) {
+					series_labels[j] = series_labels[j - 1];
+				}
+				series_labels[j] = current;
+			}
+
+			const size_t start = writer.getLength();
+			writeSeries(writer, series_labels, count, line.value,
+					line.has_timestamp ? line.timestamp : timestamp);
+			if (writer.overflowed() && missed_only) {
+				// Ending the request here lets the metric send this sample, and the ones after it, in the next request.
+				writer.truncate(start);
+				return written;
+			} else if (writer.overflowed()) {
+				writer.truncate(start);
+				dropped++;
+			} else {
+				written++;
+			}
+		}
+	}
+	return written;
+}
+
+} /* namespace prom */
@@ -0,0 +1,71 @@
+/*
+ * sample_iterator.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "sample_iterator.h"
+#include <cstring>
+#include <fallback_log.h>
+
+namespace prom {
+
+constexpr size_t SampleIterator::LINE_BUFFER_SIZE;
+
+SampleIterator::SampleIterator(const Registry &registry,
+		const bool openmetrics, const bool timestamps,
+		const MetricFilter &filter, const uint32_t consumer,
+		const bool missed_only) :
+		_metric(NULL), _openmetrics(openmetrics), _timestamps(timestamps), _consumer(
+				consumer), _missed_only(missed_only), _filter(filter) {
+	_line[0] = 0;
+	moveTo(registry.getFirst());
+}
+
+const Metric* SampleIterator::getMetric() const {
+	return _metric;
+}
+
+void SampleIterator::nextMetric() {
+	if (_metric) {
+		moveTo(_metric->getNext());
+	}
+}
+
+size_t SampleIterator::nextSample() {
+	while (_metric) {
+		const size_t len = _metric->writeSample(_line, LINE_BUFFER_SIZE,
+				_cursor);
+		if (len < LINE_BUFFER_SIZE) {
+			return len;
+		}
+
+		log_e("Sample line of length %u for %s didn't fit the line buffer, skipping it.",
+				(unsigned int) len, _metric->getFamily().name);
+	}
+	return 0;
+}
+
+const char* SampleIterator::getLine() const {
+	return _line;
+}
+
+void SampleIterator::moveTo(const Metric *metric) {
+	while (metric
+			&& (!_filter.matches(metric->getFamily())
+					|| (_missed_only && !metric->writesMissedSamples()))) {
+		metric = metric->getNext();
+	}
+	_metric = metric;
+	memset(&_cursor, 0, sizeof(_cursor));
+	_cursor.openmetrics = _openmetrics;
+	_cursor.timestamps = _timestamps;
+	_cursor.consumer = _consumer;
+	_cursor.missed_only = _missed_only;
+}
+
+} /* namespace prom */
@@ -0,0 +1,156 @@
+/*
+ * sample_line.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "sample_line.h"
+#include <cstdlib>
+
+namespace prom {
+
+/**
+ * Finds the end of a quoted label value.
+ *
+ * @param pos	The first character after the opening quote.
+ * @param end	The end of the string to search.
+ * @return	A pointer to the closing quote, or NULL if there is none.
+ */
+static const char* findClosingQuote(const char *pos, const char *end) {
+	while (pos < end) {
+		if (*pos == '\\') {
+			pos += 2;
+		} else if (*pos == '"') {
+			return pos;
+		} else {
+			pos++;
+		}
+	}
+	return NULL;
+}
+
+bool parseSampleLine(const char *line, const size_t len, SampleLine &sample) {
+	const char *end = line + len;
+	if (len < 4 || end[-1] != '\n') {
+		return false;
+	}
+	// The line break terminates the value and timestamp.
+	end--;
+
+	const char *pos = line;
+	while (pos < end && *pos != '{' && *pos != ' ') {
+		pos++;
+	}
+	sample.name = line;
+	sample.name_len = pos - line;
+	if (sample.name_len == 0 || pos == end) {
+		return false;
+	}
+
+	sample.labels = pos;
+	sample.labels_len = 0;
+	if (*pos == '{') {
+		sample.labels = ++pos;
+		while (pos < end && *pos != '}') {
+			if (*pos == '"') {
+				pos = findClosingQuote(pos + 1, end);
+				if (!pos) {
+					return false;
+				}
+			}
+			pos++;
+		}
+		if (pos == end) {
+			return false;
+		}
+		sample.labels_len = pos - sample.labels;
+		pos++;
+	}
+
+	if (pos == end || *pos != ' ') {
+		return false;
+	}
+	pos++;
+
+	// The value is followed by a space or the line break, so strtod stops there.
+	char *value_end;
+	sample.value = strtod(pos, &value_end);
+	if (value_end == pos || (value_end != end && *value_end != ' ')) {
+		return false;
+	}
+	pos = value_end;
+
+	sample.has_timestamp = pos < end;
+	sample.timestamp = 0;
+	if (sample.has_timestamp) {
+		pos++;
+		const bool negative = pos < end && *pos == '-';
+		if (negative) {
+			pos++;
+		}
+		if (pos == end || end - pos > 18) {
+			return false;
+		}
+		for (; pos < end; pos++) {
+			if (*pos < '0' || *pos > '9') {
+				return false;
+			}
+			sample.timestamp = sample.timestamp * 10 + *pos - '0';
+		}
+		if (negative) {
+			sample.timestamp = -sample.timestamp;
+		}
+	}
+	return true;
+}
+
+bool nextSampleLabel(const char *&pos, const char *end, SampleLabel &label) {
+	while (pos < end && (*pos == ',' || *pos == ' ')) {
+		pos++;
+	}
+	if (pos >= end) {
+		return false;
+	}
+
+	label.name = pos;
+	while (pos < end && *pos != '=') {
+		pos++;
+	}
+	label.name_len = pos - label.name;
+	if (label.name_len == 0 || end - pos < 3 || pos[1] != '"') {
+		return false;
+	}
+
+	label.value = pos + 2;
+	const char *quote = findClosingQuote(label.value, end);
+	if (!quote) {
+		return false;
+	}
+	label.value_len = quote - label.value;
+	pos = quote + 1;
+	return true;
+}
+
+size_t unescapeLabelValue(const char *value, const size_t len, char *out) {
+	size_t out_len = 0;
+	for (size_t i = 0; i < len; i++) {
+		char c = value[i];
+		if (c == '\\' && i + 1 < len) {
+			c = value[++i];
+			if (c == 'n') {
+				c = '\n';
+			}
+		}
+		if (out) {
+			out[out_len] = c;
+		}
+		out_len++;
+	}
+	return out_len;
+}
+
+} /* namespace prom */
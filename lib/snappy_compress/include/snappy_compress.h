@@ -0,0 +1,52 @@
+/*
+ * snappy_compress.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_SNAPPY_COMPRESS_SNAPPY_COMPRESS_H_
+#define LIB_SNAPPY_COMPRESS_SNAPPY_COMPRESS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace snappy {
+/**
+ * The max number of input bytes compressed using the same hash table.
+ * Copies never reference data before the start of their fragment.
+ */
+static constexpr size_t FRAGMENT_SIZE = 65536;
+
+/**
+ * Calculates the max length of the compressed data for an input of the given length.
+ * This is the same bound as the one used by the reference implementation.
+ *
+ * @param len	The length of the uncompressed data.
+ * @return	The max compressed length.
+ */
+constexpr size_t maxCompressedLength(const size_t len) {
+	return 32 + len + len / 6;
+}
+
+/**
+ * Compresses the given data in the snappy block format.
+ *
+ * @param input			The data to compress.
+ * @param len			The length of the data.
+ * @param output		The buffer to write the compressed data to.
+ * 						Has to be at least maxCompressedLength(len) bytes large.
+ * @param table			The hash table used to find matches.
+ * 						Its contents are overwritten, it doesn't have to be initialized.
+ * @param table_bits	The base two logarithm of the number of hash table entries.
+ * 						Has to be between 8 and 16. More entries find more matches.
+ * @return	The length of the compressed data.
+ */
+size_t compress(const uint8_t *input, const size_t len, uint8_t *output,
+		uint16_t *table, const uint8_t table_bits);
+} /* namespace snappy */
+
+#endif /* LIB_SNAPPY_COMPRESS_SNAPPY_COMPRESS_H_ */
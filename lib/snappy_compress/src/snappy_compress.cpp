@@ -0,0 +1,197 @@
+/*
+ * snappy_compress.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "snappy_compress.h"
+#include <string.h>
+
+namespace snappy {
+
+/**
+ * The number of bytes at the end of a fragment that aren't searched for matches.
+ * This makes sure four bytes can always be read at the current position.
+ */
+static constexpr size_t INPUT_MARGIN = 15;
+
+/**
+ * The element type tags, stored in the lowest two bits of each tag byte.
+ */
+enum ElementType : uint8_t {
+	LITERAL = 0, COPY_1_BYTE_OFFSET = 1, COPY_2_BYTE_OFFSET = 2
+};
+
+/**
+ * Reads four bytes as a little endian integer.
+ *
+ * @param data	The bytes to read.
+ * @return	The read integer.
+ */
+static inline uint32_t load32(const uint8_t *data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+/**
+ * Calculates the hash table index for four bytes.
+ *
+ * @param bytes	The bytes to hash, as a little endian integer.
+ * @param shift	32 minus the number of hash table bits.
+ * @return	The hash table index.
+ */
+static inline uint32_t hash(const uint32_t bytes, const uint8_t shift) {
+	return (bytes * 0x1e35a7bd) >> shift;
+}
+
+/**
+ * Writes a literal element.
+ *
+ * @param output	The position to write the element to.
+ * @param literal	The bytes to write.
+ * @param len		The number of bytes to write. Has to be at least one.
+ * @return	The position after the element.
+ */
+static uint8_t* emitLiteral(uint8_t *output, const uint8_t *literal,
+		const size_t len) {
+	const size_t n = len - 1;
+	if (n < 60) {
+		*output++ = LITERAL | (n << 2);
+	} else {
+		// Longer lengths are written as one to four little endian bytes after the tag.
+		uint8_t bytes = 1;
+		while (bytes < 4 && (n >> (bytes * 8)) > 0) {
+			bytes++;
+		}
+		*output++ = LITERAL | ((59 + bytes) << 2);
+		for (uint8_t i = 0; i < bytes; i++) {
+			*output++ = (uint8_t) (n >> (i * 8));
+		}
+	}
+	memcpy(output, literal, len);
+	return output + len;
+}
+
+/**
+ * Writes a single copy element.
+ *
+ * @param output	The position to write the element to.
+ * @param offset	The distance to the copied bytes. Less than 65536.
+ * @param len		The number of bytes to copy. Between 4 and 64.
+ * @return	The position after the element.
+ */
+static uint8_t* emitCopyUpTo64(uint8_t *output, const size_t offset,
+		const size_t len) {
+	if (len < 12 && offset < 2048) {
+		*output++ = COPY_1_BYTE_OFFSET | ((len - 4) << 2) | ((offset >> 8) << 5);
+		*output++ = (uint8_t) offset;
+	} else {
+		*output++ = COPY_2_BYTE_OFFSET | ((len - 1) << 2);
+		*output++ = (uint8_t) offset;
+		*output++ = (uint8_t) (offset >> 8);
+	}
+	return output;
+}
+
+/**
+ * Writes the copy elements for a match of any length.
+ *
+ * @param output	The position to write the elements to.
+ * @param offset	The distance to the copied bytes. Less than 65536.
+ * @param len		The number of bytes to copy. At least 4.
+ * @return	The position after the elements.
+ */
+static uint8_t* emitCopy(uint8_t *output, const size_t offset, size_t len) {
+	while (len >= 68) {
+		output = emitCopyUpTo64(output, offset, 64);
+		len -= 64;
+	}
+	// Make sure the remaining length is at least 4.
+	if (len > 64) {
+		output = emitCopyUpTo64(output, offset, 60);
+		len -= 60;
+	}
+	return emitCopyUpTo64(output, offset, len);
+}
+
+/**
+ * Compresses a single fragment of at most FRAGMENT_SIZE bytes.
+ *
+ * @param input			The fragment to compress.
+ * @param len			The length of the fragment.
+ * @param output		The position to write the compressed fragment to.
+ * @param table			The hash table.
+ * @param table_bits	The base two logarithm of the hash table size.
+ * @return	The position after the compressed fragment.
+ */
+static uint8_t* compressFragment(const uint8_t *input, const size_t len,
+		uint8_t *output, uint16_t *table, const uint8_t table_bits) {
+	const uint8_t *const end = input + len;
+	const uint8_t *next_emit = input;
+	if (len >= INPUT_MARGIN) {
+		memset(table, 0, sizeof(uint16_t) << table_bits);
+		const uint8_t shift = 32 - table_bits;
+		const uint8_t *const ip_limit = end - INPUT_MARGIN;
+		const uint8_t *ip = input + 1;
+		// Incompressible data is skipped faster, the longer no match was found.
+		uint32_t skip = 32;
+		while (ip <= ip_limit) {
+			const uint32_t bytes = load32(ip);
+			const uint32_t index = hash(bytes, shift);
+			const uint8_t *candidate = input + table[index];
+			table[index] = ip - input;
+			if (load32(candidate) != bytes) {
+				ip += skip++ >> 5;
+				continue;
+			}
+
+			if (ip > next_emit) {
+				output = emitLiteral(output, next_emit, ip - next_emit);
+			}
+
+			size_t matched = 4;
+			while (ip + matched < end && candidate[matched] == ip[matched]) {
+				matched++;
+			}
+			output = emitCopy(output, ip - candidate, matched);
+			ip += matched;
+			next_emit = ip;
+			skip = 32;
+
+			// Hash the last matched position too, so the next repetition of the match can be found.
+			if (ip <= ip_limit) {
+				table[hash(load32(ip - 1), shift)] = ip - 1 - input;
+			}
+		}
+	}
+
+	if (next_emit < end) {
+		output = emitLiteral(output, next_emit, end - next_emit);
+	}
+	return output;
+}
+
+size_t compress(const uint8_t *input, const size_t len, uint8_t *output,
+		uint16_t *table, const uint8_t table_bits) {
+	uint8_t *pos = output;
+	// The compressed data starts with the uncompressed length as a varint.
+	size_t remaining = len;
+	while (remaining >= 0x80) {
+		*pos++ = (uint8_t) remaining | 0x80;
+		remaining >>= 7;
+	}
+	*pos++ = (uint8_t) remaining;
+
+	for (size_t start = 0; start < len; start += FRAGMENT_SIZE) {
+		const size_t fragment_len =
+				len - start < FRAGMENT_SIZE ? len - start : FRAGMENT_SIZE;
+		pos = compressFragment(input + start, fragment_len, pos, table,
+				table_bits);
+	}
+	return pos - output;
+}
+
+} /* namespace snappy */
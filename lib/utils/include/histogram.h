@@ -0,0 +1,131 @@
+/*
+ * histogram.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UTILS_HISTOGRAM_H_
+#define LIB_UTILS_HISTOGRAM_H_
+
+#include "task_shared.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+/**
+ * A histogram with fixed bucket bounds, counting the number of recorded values in each bucket.
+ *
+ * Recording a value is allocation-free, and lock-free except for the 64 bit sum, so it can be done from any task.
+ * Reading the histogram while values are being recorded may see a value in its bucket, but not yet in the sum.
+ *
+ * The counts are 32 bit counters, which wrap around on overflow.
+ * Prometheus handles this like a counter reset.
+ * The sum is a 64 bit counter, since a sum of microsecond durations would overflow 32 bits within hours.
+ *
+ * @tparam N	The number of bucket upper bounds, excluding the implicit +Inf bucket.
+ */
+template<size_t N>
+class Histogram {
+public:
+	/**
+	 * The number of buckets, including the +Inf bucket.
+	 */
+	static constexpr size_t BUCKETS = N + 1;
+
+	/**
+	 * Creates a new empty histogram with the given bucket upper bounds.
+	 *
+	 * @param bounds	The inclusive upper bound of each bucket, in ascending order.
+	 * 					Has to outlive the histogram.
+	 */
+	Histogram(const uint32_t (&bounds)[N]) :
+			_bounds(bounds) {
+		for (size_t i = 0; i < BUCKETS; i++) {
+			_buckets[i] = 0;
+		}
+		_sum = 0;
+	}
+
+	/**
+	 * Adds the given value to the first bucket whose upper bound is at least the value.
+	 *
+	 * @param value	The value to record.
+	 */
+	void record(const uint32_t value) {
+		size_t bucket = 0;
+		while (bucket < N && value > _bounds[bucket]) {
+			bucket++;
+		}
+		_buckets[bucket] += 1;
+		_sum += value;
+	}
+
+	/**
+	 * Gets the upper bound of the given bucket.
+	 *
+	 * @param bucket	The index of the bucket, which has to be less than N.
+	 * @return	The inclusive upper bound of the bucket.
+	 */
+	uint32_t getBound(const size_t bucket) const {
+		return _bounds[bucket];
+	}
+
+	/**
+	 * Gets the number of values recorded in the given bucket, and all buckets before it.
+	 *
+	 * @param bucket	The index of the bucket. N for the +Inf bucket.
+	 * @return	The cumulative count of the bucket.
+	 */
+	uint32_t getCumulativeCount(const size_t bucket) const {
+		uint32_t count = 0;
+		for (size_t i = 0; i <= bucket && i < BUCKETS; i++) {
+			count += _buckets[i];
+		}
+		return count;
+	}
+
+	/**
+	 * Gets the total number of recorded values.
+	 *
+	 * @return	The number of recorded values.
+	 */
+	uint32_t getCount() const {
+		return getCumulativeCount(N);
+	}
+
+	/**
+	 * Gets the sum of all recorded values.
+	 *
+	 * @return	The sum of all values.
+	 */
+	uint64_t getSum() const {
+		return _sum;
+	}
+
+private:
+	/**
+	 * The upper bound of each bucket, except the +Inf bucket.
+	 */
+	const uint32_t (&_bounds)[N];
+
+	/**
+	 * The number of values recorded in each bucket.
+	 * Not cumulative, to make recording a single atomic increment.
+	 */
+	counter_t _buckets[BUCKETS];
+
+	/**
+	 * The sum of all recorded values.
+	 */
+	shared_t<uint64_t> _sum;
+};
+
+template<size_t N>
+constexpr size_t Histogram<N>::BUCKETS;
+} /* namespace utils */
+
+#endif /* LIB_UTILS_HISTOGRAM_H_ */
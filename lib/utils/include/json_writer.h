@@ -0,0 +1,323 @@
+/*
+ * json_writer.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UTILS_JSON_WRITER_H_
+#define LIB_UTILS_JSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace utils {
+/**
+ * A streaming JSON writer, writing a document directly into a caller supplied buffer.
+ *
+ * The writer never allocates memory, and doesn't use iostreams to format numbers.
+ * Output beyond the end of the buffer is dropped, but still counted,
+ * so the full length of a document can be determined by writing it into an empty buffer.
+ *
+ * Output before the given offset is also dropped, so a document can be written in chunks,
+ * for example from an AsyncWebServer chunk filler, by writing it again for every chunk.
+ * This only works if the document doesn't change between the chunks.
+ *
+ * The buffer is not NUL terminated.
+ */
+class JsonWriter {
+public:
+	/**
+	 * The max nesting depth of objects and arrays.
+	 */
+	static constexpr uint8_t MAX_DEPTH = 32;
+
+	/**
+	 * The max number of digits after the decimal dot of a floating point value.
+	 */
+	static constexpr uint8_t MAX_DECIMAL_DIGITS = 9;
+
+	/**
+	 * Creates a new JSON writer writing to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to. Can be NULL if the size is 0.
+	 * @param size		The number of bytes that can be written to the buffer.
+	 * @param offset	The number of bytes of the document to skip before writing to the buffer.
+	 */
+	JsonWriter(char *buffer, const size_t size, const size_t offset = 0);
+
+	/**
+	 * Starts a new JSON object.
+	 *
+	 * @return	This writer.
+	 */
+	JsonWriter& beginObject();
+
+	/**
+	 * Ends the current JSON object.
+	 *
+	 * @return	This writer.
+	 */
+	JsonWriter& endObject();
+
+	/**
+	 * Starts a new JSON array.
+	 *
+	 * @return	This writer.
+	 */
+	JsonWriter& beginArray();
+
+	/**
+	 * Ends the current JSON array.
+	 *
+	 * @return	This writer.
+	 */
+	JsonWriter& endArray();
+
+	/**
+	 * Writes the key of the next member of the current object.
+	 *
+	 * @param name	The NUL terminated key to write. Will be escaped.
+	 * @return	This writer.
+	 */
+	JsonWriter& key(const char *name);
+
+	/**
+	 * Writes the key of the next member of the current object.
+	 *
+	 * @param name	The key to write. Will be escaped.
+	 * @param len	The length of the key.
+	 * @return	This writer.
+	 */
+	JsonWriter& key(const char *name, const size_t len);
+
+	/**
+	 * Writes a string value.
+	 *
+	 * @param str	The NUL terminated string to write. Will be escaped.
+	 * @return	This writer.
+	 */
+	JsonWriter& value(const char *str);
+
+	/**
+	 * Writes a string value.
+	 *
+	 * @param str	The string to write. Will be escaped.
+	 * @param len	The length of the string.
+	 * @return	This writer.
+	 */
+	JsonWriter& value(const char *str, const size_t len);
+
+	/**
+	 * Writes a floating point value, rounded to the given number of digits after the decimal dot.
+	 * Writes null for NAN and infinite values, since JSON can't represent them.
+	 *
+	 * @param number			The number to write.
+	 * @param decimal_digits	The number of digits after the decimal dot. At most MAX_DECIMAL_DIGITS.
+	 * @return	This writer.
+	 */
+	JsonWriter& value(const double number, const uint8_t decimal_digits);
+
+	/**
+	 * Writes a boolean value.
+	 *
+	 * @param boolean	The value to write.
+	 * @return	This writer.
+	 */
+	JsonWriter& value(const bool boolean);
+
+	/**
+	 * Writes a signed integer value.
+	 *
+	 * @tparam T		The integer type to write.
+	 * @param number	The number to write.
+	 * @return	This writer.
+	 */
+	template<typename T>
+	typename std::enable_if<
+			std::is_integral<T>::value && std::is_signed<T>::value,
+			JsonWriter&>::type value(const T number) {
+		return writeInteger(number < 0, number < 0 ?
+				-(uint64_t) number : (uint64_t) number);
+	}
+
+	/**
+	 * Writes an unsigned integer value.
+	 *
+	 * @tparam T		The integer type to write.
+	 * @param number	The number to write.
+	 * @return	This writer.
+	 */
+	template<typename T>
+	typename std::enable_if<
+			std::is_integral<T>::value && std::is_unsigned<T>::value
+					&& !std::is_same<T, bool>::value, JsonWriter&>::type value(
+			const T number) {
+		return writeInteger(false, number);
+	}
+
+	/**
+	 * Writes a null value.
+	 *
+	 * @return	This writer.
+	 */
+	JsonWriter& null();
+
+	/**
+	 * Writes an already formatted JSON value as is.
+	 *
+	 * @param json	The JSON value to write. Isn't checked or escaped.
+	 * @param len	The length of the value.
+	 * @return	This writer.
+	 */
+	JsonWriter& raw(const char *json, const size_t len);
+
+	/**
+	 * Gets the length of the document written so far, including the skipped and dropped output.
+	 *
+	 * @return	The total length of the document.
+	 */
+	size_t length() const;
+
+	/**
+	 * Gets the number of bytes written to the buffer.
+	 *
+	 * @return	The number of bytes written to the buffer.
+	 */
+	size_t written() const;
+
+	/**
+	 * Checks whether some of the document after the offset didn't fit in the buffer.
+	 *
+	 * @return	True if output was dropped because the buffer was full.
+	 */
+	bool overflowed() const;
+
+	/**
+	 * Checks whether the writer was used incorrectly.
+	 * For example by writing a value without a key in an object,
+	 * ending a container that wasn't started, or exceeding the max depth.
+	 *
+	 * @return	True if the document is invalid.
+	 */
+	bool hasError() const;
+
+	/**
+	 * Checks whether the document is complete, meaning a top level value was written,
+	 * all containers were closed, and no error occurred.
+	 *
+	 * @return	True if the document is a complete JSON value.
+	 */
+	bool isComplete() const;
+
+private:
+	/**
+	 * The buffer to write to.
+	 */
+	char *const _buffer;
+
+	/**
+	 * The size of the buffer.
+	 */
+	const size_t _size;
+
+	/**
+	 * The number of bytes of the document to skip.
+	 */
+	const size_t _offset;
+
+	/**
+	 * The total length of the document written so far.
+	 */
+	size_t _length;
+
+	/**
+	 * A bit for each nesting level, set if a value was already written at that level.
+	 * Bit 0 is the top level.
+	 */
+	uint64_t _has_value;
+
+	/**
+	 * A bit for each nesting level, set if the container at that level is an object.
+	 */
+	uint64_t _is_object;
+
+	/**
+	 * The current nesting depth. 0 at the top level.
+	 */
+	uint8_t _depth;
+
+	/**
+	 * Whether a key was written, that still needs its value.
+	 */
+	bool _after_key;
+
+	/**
+	 * Whether the writer was used incorrectly.
+	 */
+	bool _error;
+
+	/**
+	 * Checks whether a value can be written at the current position, and writes the separator before it.
+	 *
+	 * @return	True if the value can be written.
+	 */
+	bool beginValue();
+
+	/**
+	 * Ends the current container, if it is of the given type.
+	 *
+	 * @param object	Whether the container to end is an object.
+	 * @param end		The character ending the container.
+	 * @return	This writer.
+	 */
+	JsonWriter& endContainer(const bool object, const char end);
+
+	/**
+	 * Writes an integer value.
+	 *
+	 * @param negative	Whether the value is negative.
+	 * @param magnitude	The absolute value of the integer.
+	 * @return	This writer.
+	 */
+	JsonWriter& writeInteger(const bool negative, const uint64_t magnitude);
+
+	/**
+	 * Writes the decimal digits of the given number, without a sign.
+	 *
+	 * @param number	The number to write.
+	 * @param min_len	The min number of digits to write, padded with leading zeros.
+	 */
+	void writeDigits(uint64_t number, const uint8_t min_len);
+
+	/**
+	 * Writes the given string, in quotes, escaping the characters that need to be escaped.
+	 *
+	 * @param str	The string to write.
+	 * @param len	The length of the string.
+	 */
+	void writeString(const char *str, const size_t len);
+
+	/**
+	 * Writes the given bytes to the buffer, skipping the part before the offset,
+	 * and dropping the part that doesn't fit.
+	 *
+	 * @param data	The bytes to write.
+	 * @param len	The number of bytes to write.
+	 */
+	void write(const char *data, const size_t len);
+
+	/**
+	 * Writes a single character to the buffer.
+	 *
+	 * @param c	The character to write.
+	 */
+	void write(const char c);
+};
+} /* namespace utils */
+
+#endif /* LIB_UTILS_JSON_WRITER_H_ */
@@ -0,0 +1,130 @@
+/*
+ * ring_buffer.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UTILS_RING_BUFFER_H_
+#define LIB_UTILS_RING_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+/**
+ * A fixed size buffer keeping the last N added entries, overwriting the oldest entry when it is full.
+ *
+ * Every added entry gets a sequence number, which is one higher than that of the entry before it.
+ * Readers can remember the sequence number of the next entry they need,
+ * and find out which of the entries after it were overwritten in the meantime.
+ *
+ * Not thread-safe, the owner has to synchronize access if necessary.
+ *
+ * @tparam T	The type of the entries. Has to be copy assignable.
+ * @tparam N	The max number of entries kept.
+ */
+template<typename T, size_t N>
+class RingBuffer {
+public:
+	static_assert(N > 0, "A ring buffer has to be able to keep at least one entry.");
+
+	/**
+	 * The max number of entries kept.
+	 */
+	static constexpr size_t CAPACITY = N;
+
+	/**
+	 * Creates a new empty ring buffer.
+	 */
+	RingBuffer() :
+			_end(0) {
+	}
+
+	/**
+	 * Adds an entry after the newest entry, overwriting the oldest entry if the buffer is full.
+	 *
+	 * @param entry	The entry to add.
+	 * @return	The sequence number of the added entry.
+	 */
+	uint32_t push(const T &entry) {
+		_entries[_end % N] = entry;
+		return _end++;
+	}
+
+	/**
+	 * Gets the sequence number of the oldest entry still kept.
+	 *
+	 * @return	The sequence number of the oldest entry, or end() if the buffer is empty.
+	 */
+	uint32_t begin() const {
+		return _end > N ? _end - N : 0;
+	}
+
+	/**
+	 * Gets the sequence number the next added entry will get.
+	 *
+	 * @return	The sequence number after the newest entry.
+	 */
+	uint32_t end() const {
+		return _end;
+	}
+
+	/**
+	 * Gets the number of entries currently kept.
+	 *
+	 * @return	The number of entries.
+	 */
+	size_t size() const {
+		return _end - begin();
+	}
+
+	/**
+	 * Checks whether the buffer contains no entries.
+	 *
+	 * @return	True if nothing was added yet.
+	 */
+	bool empty() const {
+		return _end == 0;
+	}
+
+	/**
+	 * Gets the entry with the given sequence number.
+	 *
+	 * @param seq	The sequence number of the entry to get.
+	 * 				Has to be in the range [begin(), end()).
+	 * @return	A reference to the entry, which is overwritten once N more entries were added.
+	 */
+	const T& get(const uint32_t seq) const {
+		return _entries[seq % N];
+	}
+
+	/**
+	 * Gets the newest entry.
+	 *
+	 * @return	The newest entry. Only valid if the buffer isn't empty.
+	 */
+	const T& back() const {
+		return get(_end - 1);
+	}
+
+private:
+	/**
+	 * The storage for the entries, indexed by their sequence number modulo N.
+	 */
+	T _entries[N];
+
+	/**
+	 * The sequence number of the next added entry, which is the total number of added entries.
+	 */
+	uint32_t _end;
+};
+
+template<typename T, size_t N>
+constexpr size_t RingBuffer<T, N>::CAPACITY;
+} /* namespace utils */
+
+#endif /* LIB_UTILS_RING_BUFFER_H_ */
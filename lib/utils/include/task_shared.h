@@ -0,0 +1,72 @@
+/*
+ * task_shared.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ *
+ * This file contains the types and macros for values shared between tasks.
+ *
+ * On the ESP32 requests are handled on the async tcp task, while the main loop runs on another task.
+ * So values modified by both have to be atomic, or protected by a mutex.
+ * The ESP8266 handles requests on the main thread, so plain values are used there, and locking does nothing.
+ */
+
+#ifndef LIB_UTILS_TASK_SHARED_H_
+#define LIB_UTILS_TASK_SHARED_H_
+
+#include <cstdint>
+#ifndef ESP8266
+#include <atomic>
+#include <mutex>
+#endif
+
+namespace utils {
+#ifdef ESP8266
+/**
+ * A value that can be modified from multiple tasks.
+ *
+ * @tparam T	The type of the value.
+ */
+template<typename T>
+using shared_t = T;
+
+/**
+ * A mutex protecting state shared between tasks.
+ */
+struct task_mutex {
+};
+
+/**
+ * Locks the given task mutex until the end of the current scope.
+ */
+#define LOCK_TASK_MUTEX(mutex)
+#else
+/**
+ * A value that can be modified from multiple tasks.
+ *
+ * @tparam T	The type of the value.
+ */
+template<typename T>
+using shared_t = std::atomic<T>;
+
+/**
+ * A mutex protecting state shared between tasks.
+ */
+typedef std::mutex task_mutex;
+
+/**
+ * Locks the given task mutex until the end of the current scope.
+ */
+#define LOCK_TASK_MUTEX(mutex) std::lock_guard<utils::task_mutex> task_lock(mutex)
+#endif
+
+/**
+ * A 32 bit counter that can be modified from multiple tasks.
+ */
+typedef shared_t<uint32_t> counter_t;
+} /* namespace utils */
+
+#endif /* LIB_UTILS_TASK_SHARED_H_ */
@@ -170,6 +170,17 @@ std::string float_to_string(const float measurement,
  * @return	The newly created string.
  */
 std::string timespan_to_string(const int64_t time_ms);
+
+/**
+ * Writes the given timespan to the given buffer, without allocating memory.
+ *
+ * Uses the same format as `timespan_to_string`, and writes "Unknown" if the value is negative.
+ *
+ * @param time_ms	The timespan to write.
+ * @param buffer	The buffer to write the NUL terminated string to.
+ * @return	The length of the written string, excluding the NUL terminator.
+ */
+size_t timespan_to_chars(const int64_t time_ms, char (&buffer)[13]);
 } /* namespace utils */
 
 #endif /* SRC_UTILS_H_ */
@@ -0,0 +1,335 @@
+/*
+ * json_writer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "json_writer.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace utils {
+
+constexpr uint8_t JsonWriter::MAX_DEPTH;
+constexpr uint8_t JsonWriter::MAX_DECIMAL_DIGITS;
+
+/**
+ * The powers of ten used to scale floating point values, up to 10^MAX_DECIMAL_DIGITS.
+ */
+static const uint32_t POWERS_OF_TEN[] = { 1, 10, 100, 1000, 10000, 100000,
+		1000000, 10000000, 100000000, 1000000000 };
+
+/**
+ * Scaled floating point values at least this large are formatted using snprintf,
+ * since they can't be rounded to a 64 bit integer.
+ */
+static const double MAX_SCALED_VALUE = 1e18;
+
+/**
+ * The hex digits used for unicode escape sequences.
+ */
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(char *buffer, const size_t size, const size_t offset) :
+		_buffer(buffer), _size(buffer ? size : 0), _offset(offset), _length(0), _has_value(
+				0), _is_object(0), _depth(0), _after_key(false), _error(false) {
+
+}
+
+JsonWriter& JsonWriter::beginObject() {
+	if (!beginValue()) {
+		return *this;
+	}
+
+	if (_depth >= MAX_DEPTH) {
+		_error = true;
+		return *this;
+	}
+
+	write('{');
+	_depth++;
+	_has_value &= ~(1ull << _depth);
+	_is_object |= 1ull << _depth;
+	return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+	return endContainer(true, '}');
+}
+
+JsonWriter& JsonWriter::beginArray() {
+	if (!beginValue()) {
+		return *this;
+	}
+
+	if (_depth >= MAX_DEPTH) {
+		_error = true;
+		return *this;
+	}
+
+	write('[');
+	_depth++;
+	_has_value &= ~(1ull << _depth);
+	_is_object &= ~(1ull << _depth);
+	return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+	return endContainer(false, ']');
+}
+
+JsonWriter& JsonWriter::key(const char *name) {
+	return key(name, strlen(name));
+}
+
+JsonWriter& JsonWriter::key(const char *name, const size_t len) {
+	if (_depth == 0 || !(_is_object & (1ull << _depth)) || _after_key) {
+		_error = true;
+		return *this;
+	}
+
+	if (_has_value & (1ull << _depth)) {
+		write(',');
+	}
+	writeString(name, len);
+	write(':');
+	_after_key = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const char *str) {
+	return value(str, strlen(str));
+}
+
+JsonWriter& JsonWriter::value(const char *str, const size_t len) {
+	if (beginValue()) {
+		writeString(str, len);
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const double number,
+		const uint8_t decimal_digits) {
+	if (!std::isfinite(number)) {
+		return null();
+	}
+
+	if (decimal_digits > MAX_DECIMAL_DIGITS) {
+		_error = true;
+		return *this;
+	}
+
+	if (!beginValue()) {
+		return *this;
+	}
+
+	const uint32_t scale = POWERS_OF_TEN[decimal_digits];
+	const double scaled = std::round(std::fabs(number) * scale);
+	if (scaled >= MAX_SCALED_VALUE) {
+		// Too large to be rounded using integers, so precision doesn't matter much anymore.
+		char buffer[32];
+		const int len = snprintf(buffer, sizeof(buffer), "%.17g", number);
+		write(buffer, len);
+		return *this;
+	}
+
+	const uint64_t integer = (uint64_t) scaled;
+	// Values rounded to zero are written without a minus sign.
+	if (number < 0 && integer > 0) {
+		write('-');
+	}
+	writeDigits(integer / scale, 1);
+	if (decimal_digits > 0) {
+		write('.');
+		writeDigits(integer % scale, decimal_digits);
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const bool boolean) {
+	if (beginValue()) {
+		if (boolean) {
+			write("true", 4);
+		} else {
+			write("false", 5);
+		}
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+	if (beginValue()) {
+		write("null", 4);
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::raw(const char *json, const size_t len) {
+	if (beginValue()) {
+		write(json, len);
+	}
+	return *this;
+}
+
+size_t JsonWriter::length() const {
+	return _length;
+}
+
+size_t JsonWriter::written() const {
+	if (_length <= _offset) {
+		return 0;
+	} else if (_length - _offset > _size) {
+		return _size;
+	} else {
+		return _length - _offset;
+	}
+}
+
+bool JsonWriter::overflowed() const {
+	return _length > _offset && _length - _offset > _size;
+}
+
+bool JsonWriter::hasError() const {
+	return _error;
+}
+
+bool JsonWriter::isComplete() const {
+	return !_error && _depth == 0 && (_has_value & 1);
+}
+
+bool JsonWriter::beginValue() {
+	if (_error) {
+		return false;
+	}
+
+	if (_depth > 0 && (_is_object & (1ull << _depth))) {
+		// Values in objects have to follow a key, which already wrote the separator.
+		if (!_after_key) {
+			_error = true;
+			return false;
+		}
+	} else if (_has_value & (1ull << _depth)) {
+		if (_depth == 0) {
+			// A document can only have a single top level value.
+			_error = true;
+			return false;
+		}
+		write(',');
+	}
+
+	_after_key = false;
+	_has_value |= 1ull << _depth;
+	return true;
+}
+
+JsonWriter& JsonWriter::endContainer(const bool object, const char end) {
+	if (_depth == 0 || _after_key
+			|| (bool) (_is_object & (1ull << _depth)) != object) {
+		_error = true;
+		return *this;
+	}
+
+	write(end);
+	_depth--;
+	return *this;
+}
+
+JsonWriter& JsonWriter::writeInteger(const bool negative,
+		const uint64_t magnitude) {
+	if (beginValue()) {
+		if (negative) {
+			write('-');
+		}
+		writeDigits(magnitude, 1);
+	}
+	return *this;
+}
+
+void JsonWriter::writeDigits(uint64_t number, const uint8_t min_len) {
+	// UINT64_MAX has 20 digits.
+	char digits[20];
+	uint8_t len = 0;
+	while (number > 0 || len < min_len) {
+		digits[sizeof(digits) - ++len] = '0' + number % 10;
+		number /= 10;
+	}
+	write(digits + sizeof(digits) - len, len);
+}
+
+void JsonWriter::writeString(const char *str, const size_t len) {
+	write('"');
+	size_t start = 0;
+	for (size_t i = 0; i < len; i++) {
+		const unsigned char c = str[i];
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		write(str + start, i - start);
+		start = i + 1;
+		switch (c) {
+		case '"':
+			write("\\\"", 2);
+			break;
+		case '\\':
+			write("\\\\", 2);
+			break;
+		case '\b':
+			write("\\b", 2);
+			break;
+		case '\f':
+			write("\\f", 2);
+			break;
+		case '\n':
+			write("\\n", 2);
+			break;
+		case '\r':
+			write("\\r", 2);
+			break;
+		case '\t':
+			write("\\t", 2);
+			break;
+		default:
+			const char escape[] = { '\\', 'u', '0', '0', HEX_DIGITS[c >> 4],
+					HEX_DIGITS[c & 0xF] };
+			write(escape, sizeof(escape));
+			break;
+		}
+	}
+	write(str + start, len - start);
+	write('"');
+}
+
+void JsonWriter::write(const char *data, const size_t len) {
+	size_t skip = 0;
+	if (_length < _offset) {
+		skip = _offset - _length;
+		if (skip > len) {
+			skip = len;
+		}
+	}
+
+	const size_t pos = _length + skip - _offset;
+	if (pos < _size) {
+		size_t copy = len - skip;
+		if (copy > _size - pos) {
+			copy = _size - pos;
+		}
+		memcpy(_buffer + pos, data + skip, copy);
+	}
+	_length += len;
+}
+
+void JsonWriter::write(const char c) {
+	if (_length >= _offset && _length - _offset < _size) {
+		_buffer[_length - _offset] = c;
+	}
+	_length++;
+}
+
+} /* namespace utils */
@@ -11,6 +11,8 @@
 #include "utils.h"
 #include <iomanip>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
 
 namespace utils {
@@ -48,21 +50,22 @@ std::string float_to_string(const float measurement,
 }
 
 std::string timespan_to_string(const int64_t time_ms) {
+	char buffer[13];
+	const size_t len = timespan_to_chars(time_ms, buffer);
+	return std::string(buffer, len);
+}
+
+size_t timespan_to_chars(const int64_t time_ms, char (&buffer)[13]) {
 	if (time_ms < 0) {
-		return "Unknown";
+		strcpy(buffer, "Unknown");
+		return 7;
 	}
 
-	// TODO check whether snprintf is significantly faster.
-	std::ostringstream stream;
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 3600000 % 24 << ':';
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 60000 % 60 << ':';
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 1000 % 60 << '.';
-	stream << std::internal << std::setfill('0') << std::setw(3);
-	stream << time_ms % 1000;
-	return stream.str();
+	return snprintf(buffer, sizeof(buffer), "%02u:%02u:%02u.%03u",
+			(unsigned int) (time_ms / 3600000 % 24),
+			(unsigned int) (time_ms / 60000 % 60),
+			(unsigned int) (time_ms / 1000 % 60),
+			(unsigned int) (time_ms % 1000));
 }
 
 } /* namespace utils */
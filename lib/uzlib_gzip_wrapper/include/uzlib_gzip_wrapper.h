@@ -11,8 +11,14 @@
 #ifndef SRC_HTML_UZLIB_GZIP_WRAPPER_H_
 #define SRC_HTML_UZLIB_GZIP_WRAPPER_H_
 
+// The deflate functions from defl_static.h aren't declared with C linkage by uzlib.h.
+extern "C" {
 #include <uzlib.h>
+}
 #include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <task_shared.h>
 
 namespace gzip {
 
@@ -21,16 +27,180 @@ namespace gzip {
  */
 void init();
 
+/**
+ * A fixed size pool of preallocated decompression dicts.
+ *
+ * Allocating all dicts once at startup avoids fragmenting the heap with short lived window sized allocations.
+ * Acquiring and releasing dicts is lock free, and can be done from any task.
+ */
+class uzlib_dict_pool {
+public:
+	/**
+	 * The max number of dicts a single pool can hold.
+	 */
+	static constexpr uint8_t MAX_DICTS = 32;
+
+private:
+	/**
+	 * The memory block containing all the dicts of this pool.
+	 */
+	uint8_t *dicts;
+
+	/**
+	 * The number of dicts in this pool.
+	 */
+	const uint8_t count;
+
+	/**
+	 * The size of a single dict, in bytes.
+	 */
+	const uint16_t dict_size;
+
+	/**
+	 * A bitmask containing a set bit for each dict that is currently in use.
+	 */
+	utils::counter_t used;
+
+	/**
+	 * The number of times a dict was requested while all dicts were in use.
+	 */
+	utils::counter_t failures;
+
+public:
+	/**
+	 * Creates a new dict pool, and allocates all of its dicts.
+	 *
+	 * @param count	The number of dicts to allocate. At most MAX_DICTS.
+	 * @param wsize	The window size the dicts will be used for.
+	 * 				Each dict is pow(2, -wsize) bytes large.
+	 * 				The range of valid values is from -8 to -15.
+	 * 				Values outside of this range will be clamped to this range.
+	 */
+	uzlib_dict_pool(const uint8_t count, int8_t wsize);
+
+	/**
+	 * Destroys this pool, and frees all of its dicts.
+	 * All dicts have to be released before the pool is destroyed.
+	 */
+	~uzlib_dict_pool();
+
+	/**
+	 * Gets a currently unused dict from this pool.
+	 *
+	 * @return	The dict, or NULL if all dicts are in use.
+	 */
+	uint8_t* acquire();
+
+	/**
+	 * Returns a dict that was acquired from this pool to it.
+	 *
+	 * @param dict	The dict to release. Has to be a dict from this pool.
+	 */
+	void release(const uint8_t *dict);
+
+	/**
+	 * Checks whether the given dict belongs to this pool.
+	 *
+	 * @param dict	The dict to check.
+	 * @return	True if the given dict is part of this pool.
+	 */
+	bool contains(const uint8_t *dict) const;
+
+	/**
+	 * Gets the number of dicts in this pool.
+	 * This is 0 if allocating the dicts failed.
+	 *
+	 * @return	The number of dicts.
+	 */
+	uint8_t getSize() const;
+
+	/**
+	 * Gets the size of a single dict of this pool.
+	 *
+	 * @return	The dict size in bytes.
+	 */
+	uint16_t getDictSize() const;
+
+	/**
+	 * Gets the number of dicts that are currently in use.
+	 *
+	 * @return	The number of acquired dicts.
+	 */
+	uint8_t getInUse() const;
+
+	/**
+	 * Gets the number of times a dict was requested while all dicts were in use.
+	 *
+	 * @return	The number of failed dict requests.
+	 */
+	uint32_t getFailures() const;
+};
+
 /**
  * A wrapper to help with storing the data associated with decompressing a gzip file using uzlib.
  * Can currently only handle the entire compressed file being accessible as a single pointer block.
  */
 class uzlib_ungzip_wrapper {
+public:
+	/**
+	 * The type of the callback used to read compressed data in chunks.
+	 *
+	 * The callback has to set the given pointer to the next chunk of the gzip file, and return its length.
+	 * The chunk has to stay valid until the next call of the callback, or the destruction of the wrapper.
+	 * Returning 0 signals the end of the gzip file.
+	 *
+	 * Unlike the C callback, this callback has to return the entire gzip file, including its last four bytes.
+	 */
+	typedef std::function<size_t(const uint8_t **chunk)> source_t;
+
 private:
+	/**
+	 * The uzlib data store, with a pointer back to the wrapper using it.
+	 * Used to find the wrapper in the uzlib read callback.
+	 */
+	struct wrapped_uncomp: public uzlib_uncomp {
+		/**
+		 * The wrapper this data store belongs to.
+		 */
+		uzlib_ungzip_wrapper *wrapper;
+	};
+
 	/**
 	 * The internal data store used by uzlib.
 	 */
-	uzlib_uncomp *decomp;
+	wrapped_uncomp *decomp;
+
+	/**
+	 * The chunk source to read compressed data from.
+	 * Empty if this wrapper doesn't use a chunk source.
+	 */
+	source_t source;
+
+	/**
+	 * The part of the last chunk that wasn't handed to uzlib yet.
+	 */
+	const uint8_t *pending = NULL;
+
+	/**
+	 * The number of bytes in the pending chunk part.
+	 */
+	size_t pending_len = 0;
+
+	/**
+	 * The last up to four bytes read from the source.
+	 * These are held back, since uzlib can't detect the end of the file if it gets the uncompressed size.
+	 */
+	uint8_t held[4];
+
+	/**
+	 * The number of held back bytes.
+	 */
+	uint8_t held_len = 0;
+
+	/**
+	 * A buffer for previously held back bytes that turned out not to be part of the gzip trailer.
+	 */
+	uint8_t staging[4];
 
 	/**
 	 * The number of already decompressed bytes.
@@ -48,6 +218,28 @@ private:
 	 */
 	int16_t dcbuf = -1;
 
+	/**
+	 * The pool the decompression dict was acquired from.
+	 * NULL if the dict was allocated by this wrapper.
+	 */
+	uzlib_dict_pool *pool = NULL;
+
+	/**
+	 * Acquires or allocates the decompression dict, and initializes uzlib.
+	 *
+	 * @param wsize	The clamped window size to use.
+	 */
+	void initDict(const int8_t wsize);
+
+	/**
+	 * The uzlib read callback used for chunk sources.
+	 * Hands uzlib entire chunks, except for the last four bytes of the gzip file.
+	 *
+	 * @param uncomp	The uzlib data store to read data for.
+	 * @return	The first byte of the next chunk, or -1 if the file end was reached.
+	 */
+	static int readChunk(uzlib_uncomp *uncomp);
+
 public:
 	/**
 	 * Creates a new gzip wrapper to decompress the gzip file in the given memory block.
@@ -63,9 +255,41 @@ public:
 	 * 					A pow(2, -wsize) byte buffer is allocated for decompression.
 	 * 					The range of valid values is from -8 to -15.
 	 * 					Values outside of this range will be clamped to this range.
+	 * @param pool		The pool to get the decompression dict from.
+	 * 					Use NULL to allocate the dict on the heap instead.
+	 * 					The dicts of the pool have to be at least pow(2, -wsize) bytes large.
 	 */
 	uzlib_ungzip_wrapper(const uint8_t *cmp_start, const uint8_t *cmp_end,
-			int8_t wsize);
+			int8_t wsize, uzlib_dict_pool *pool = NULL);
+
+	/**
+	 * Creates a new gzip wrapper to decompress the gzip file in the given memory block, starting at the given offset.
+	 *
+	 * Starts decompressing at the last inflate checkpoint at or before the given offset,
+	 * and skips the remaining bytes up to the offset.
+	 * A checkpoint is a pair of an uncompressed offset, and the offset of the deflate block
+	 * starting at this position in the compressed file.
+	 * The compressor has to have done a full flush before each checkpoint,
+	 * so that no back reference crosses it.
+	 *
+	 * The crc32 of the file is only checked when starting at the beginning of the file.
+	 * If no decompression dict could be acquired, nothing is skipped, and hasDict returns false.
+	 *
+	 * @param cmp_start			A pointer to the first byte of the gzip file.
+	 * @param cmp_end			A pointer to the first byte after the gzip file.
+	 * @param checkpoints		The inflate checkpoints of the file, sorted by uncompressed offset.
+	 * 							May be NULL, to decompress from the start of the file.
+	 * @param checkpoints_len	The number of inflate checkpoints.
+	 * @param offset			The uncompressed offset to start decompressing at.
+	 * @param wsize				The window size used for decompression.
+	 * 							Has to be at least as much as the window size used for compression.
+	 * 							The range of valid values is from -8 to -15.
+	 * @param pool				The pool to get the decompression dict from.
+	 * 							Use NULL to allocate the dict on the heap instead.
+	 */
+	uzlib_ungzip_wrapper(const uint8_t *cmp_start, const uint8_t *cmp_end,
+			const uint32_t checkpoints[][2], const size_t checkpoints_len,
+			const size_t offset, int8_t wsize, uzlib_dict_pool *pool = NULL);
 
 	/**
 	 * Creates a new gzip wrapper to decompress a gzip file from a callback.
@@ -90,14 +314,51 @@ public:
 	 * 					A pow(2, -wsize) byte buffer is allocated for decompression.
 	 * 					The range of valid values is from -8 to -15.
 	 * 					Values outside of this range will be clamped to this range.
+	 * @param pool		The pool to get the decompression dict from.
+	 * 					Use NULL to allocate the dict on the heap instead.
+	 * 					The dicts of the pool have to be at least pow(2, -wsize) bytes large.
 	 */
-	uzlib_ungzip_wrapper(int (*callback)(uzlib_uncomp*), int8_t wsize);
+	uzlib_ungzip_wrapper(int (*callback)(uzlib_uncomp*), int8_t wsize,
+			uzlib_dict_pool *pool = NULL);
 
 	/**
-	 * Destroys this gzip wrapper, and removes its internal memory buffer.
+	 * Creates a new gzip wrapper to decompress a gzip file read in chunks from a function object.
+	 *
+	 * This allows decompressing a file from a filesystem, a network stream, or any other source
+	 * without a callback call per byte, and without holding the entire file in memory.
+	 * Chunks may have any size, and don't have to be aligned to anything.
+	 *
+	 * The source is first called by this constructor, to read the gzip header.
+	 *
+	 * With this constructor the uncompressed size is only available once the file is read in its entirety.
+	 *
+	 * @param source	The function to get the chunks of the compressed file from.
+	 * @param wsize		The window size used for decompression.
+	 * 					Has to be at least as much as the window size used for compression.
+	 * 					A pow(2, -wsize) byte buffer is allocated for decompression.
+	 * 					The range of valid values is from -8 to -15.
+	 * 					Values outside of this range will be clamped to this range.
+	 * @param pool		The pool to get the decompression dict from.
+	 * 					Use NULL to allocate the dict on the heap instead.
+	 * 					The dicts of the pool have to be at least pow(2, -wsize) bytes large.
+	 */
+	uzlib_ungzip_wrapper(source_t source, int8_t wsize,
+			uzlib_dict_pool *pool = NULL);
+
+	/**
+	 * Destroys this gzip wrapper, and removes or releases its internal memory buffer.
 	 */
 	~uzlib_ungzip_wrapper();
 
+	/**
+	 * Checks whether this wrapper got a decompression dict.
+	 *
+	 * Decompression without a dict only works for some small files.
+	 *
+	 * @return	Whether a decompression dict is available.
+	 */
+	bool hasDict() const;
+
 	/**
 	 * Decompresses the next segment of the gzip file to the given memory buffer.
 	 *
@@ -110,6 +371,15 @@ public:
 	 */
 	size_t decompress(uint8_t *buf, const size_t buf_size);
 
+	/**
+	 * Decompresses and discards the given number of bytes.
+	 *
+	 * @param len	The number of bytes to skip.
+	 * @return	The number of bytes that were skipped.
+	 * 			Less than len if the end of the file was reached.
+	 */
+	size_t skip(const size_t len);
+
 	/**
 	 * Gets the uncompressed size of the file to be decompressed, if available.
 	 *
@@ -136,6 +406,234 @@ public:
 	bool done() const;
 };
 
+/**
+ * A wrapper to help with storing the data associated with gzip compressing data using uzlib.
+ * Compresses into caller provided buffers, without ever having to hold the entire input or output in memory.
+ *
+ * Uses a simple greedy LZ77 matcher with a fixed size window and hash table,
+ * and the static huffman encoder of uzlib.
+ * This produces a single final static huffman deflate block.
+ */
+class uzlib_gzip_wrapper {
+public:
+	/**
+	 * The type of the callback used to read the data to compress.
+	 *
+	 * The callback gets a buffer to write to, and the max number of bytes to write.
+	 * It has to return the number of bytes written to the buffer.
+	 * Returning 0 signals the end of the input data.
+	 */
+	typedef std::function<size_t(uint8_t *buf, const size_t max_len)> source_t;
+
+	/**
+	 * The shortest match that will be encoded as a back reference.
+	 */
+	static constexpr uint16_t MIN_MATCH = 3;
+
+	/**
+	 * The longest match that can be encoded as a single back reference.
+	 */
+	static constexpr uint16_t MAX_MATCH = 258;
+
+	/**
+	 * The size of the internal buffer for compressed data not yet written to a caller buffer.
+	 */
+	static constexpr uint16_t OUTBUF_SIZE = 64;
+
+	/**
+	 * The max number of bytes a single huffman encoded literal or match, plus the pending bits, can take up.
+	 * Symbols are only encoded if there is at least this much free space in the output buffer.
+	 */
+	static constexpr uint16_t OUTBUF_MARGIN = 8;
+
+	/**
+	 * The size of the gzip header written by this compressor.
+	 */
+	static constexpr uint8_t GZIP_HEADER_SIZE = 10;
+
+	/**
+	 * The size of the gzip trailer, containing the crc32 and uncompressed size.
+	 */
+	static constexpr uint8_t GZIP_TRAILER_SIZE = 8;
+
+private:
+	/**
+	 * The callback to read the data to compress from.
+	 */
+	source_t source;
+
+	/**
+	 * The size of the back reference window, in bytes.
+	 */
+	const uint16_t dict_size;
+
+	/**
+	 * The total size of the input buffer.
+	 * Contains up to dict_size bytes of history, plus the lookahead.
+	 */
+	const uint32_t window_size;
+
+	/**
+	 * The number of bits used for the hash table index.
+	 */
+	const uint8_t hash_bits;
+
+	/**
+	 * The buffer containing the history and the not yet compressed input data.
+	 */
+	uint8_t *window = NULL;
+
+	/**
+	 * The hash table mapping a hash of the next MIN_MATCH bytes to the last window position they were seen at.
+	 * Entries aren't trusted, every candidate match is verified against the window.
+	 */
+	uint16_t *hash_table = NULL;
+
+	/**
+	 * The uzlib output buffer used by the huffman encoder.
+	 */
+	Outbuf out;
+
+	/**
+	 * The index of the first byte in the output buffer that wasn't written to a caller buffer yet.
+	 */
+	uint16_t out_index = 0;
+
+	/**
+	 * The position of the next byte to compress in the window.
+	 */
+	uint32_t pos = 0;
+
+	/**
+	 * The number of valid bytes in the window.
+	 */
+	uint32_t avail = 0;
+
+	/**
+	 * The crc32 of the data read so far, in the uzlib format.
+	 */
+	uint32_t crc = ~0;
+
+	/**
+	 * The number of uncompressed bytes read from the source.
+	 */
+	uint32_t read = 0;
+
+	/**
+	 * The number of compressed bytes written to caller buffers.
+	 */
+	uint32_t written = 0;
+
+	/**
+	 * Whether the source signaled the end of the input data.
+	 */
+	bool input_done = false;
+
+	/**
+	 * Whether the deflate block end and the gzip trailer were written to the output buffer.
+	 */
+	bool finished = false;
+
+	/**
+	 * Reads data from the source until there are at least MAX_MATCH bytes of lookahead,
+	 * or the input ended.
+	 * Moves the window if required.
+	 */
+	void fill();
+
+	/**
+	 * Calculates the hash table index for the MIN_MATCH bytes at the given window position.
+	 *
+	 * @param p	The window position to hash.
+	 * @return	The hash table index.
+	 */
+	uint16_t hash(const uint32_t p) const;
+
+	/**
+	 * Encodes the next literal or match, and updates the hash table.
+	 */
+	void encodeNext();
+
+	/**
+	 * Writes the end of the deflate block, and the gzip trailer to the output buffer.
+	 */
+	void finish();
+
+public:
+	/**
+	 * Creates a new gzip compressor reading its input from the given memory block.
+	 *
+	 * The memory block has to stay valid until compression is done.
+	 *
+	 * @param uncmp_start	A pointer to the first byte of the data to compress.
+	 * @param uncmp_end		A pointer to the first byte after the data to compress.
+	 * @param wsize			The window size used for compression.
+	 * 						Decompression requires a window at least this large.
+	 * 						A pow(2, -wsize) byte history is kept in memory,
+	 * 						in addition to a lookahead of the same size, but at least 516 bytes.
+	 * 						The range of valid values is from -8 to -15.
+	 * 						Values outside of this range will be clamped to this range.
+	 */
+	uzlib_gzip_wrapper(const uint8_t *uncmp_start, const uint8_t *uncmp_end,
+			int8_t wsize);
+
+	/**
+	 * Creates a new gzip compressor reading its input from a callback.
+	 *
+	 * This allows compressing generated data, without ever holding all of it in memory.
+	 *
+	 * @param source	The callback to read the data to compress from.
+	 * @param wsize		The window size used for compression.
+	 * 					Decompression requires a window at least this large.
+	 * 					A pow(2, -wsize) byte history is kept in memory,
+	 * 					in addition to a lookahead of the same size, but at least 516 bytes.
+	 * 					The range of valid values is from -8 to -15.
+	 * 					Values outside of this range will be clamped to this range.
+	 */
+	uzlib_gzip_wrapper(source_t source, int8_t wsize);
+
+	/**
+	 * Destroys this gzip compressor, and frees its internal buffers.
+	 */
+	~uzlib_gzip_wrapper();
+
+	/**
+	 * Compresses the next segment of the input to the given memory buffer.
+	 *
+	 * Reads as much input as required to fill the buffer.
+	 * Fills the given buffer completely, unless the compressed file ends.
+	 *
+	 * @param buf		The memory buffer to write to.
+	 * @param buf_size	The max number of bytes to write to the buffer.
+	 * @return	The number of bytes written to the buffer.
+	 * 			0 if the compression is done, or failed.
+	 */
+	size_t compress(uint8_t *buf, const size_t buf_size);
+
+	/**
+	 * Gets the number of bytes read from the input so far.
+	 *
+	 * @return	The number of already read uncompressed bytes.
+	 */
+	uint32_t getUncompressed() const;
+
+	/**
+	 * Gets the number of compressed bytes written to caller buffers so far.
+	 *
+	 * @return	The number of already written compressed bytes.
+	 */
+	uint32_t getCompressed() const;
+
+	/**
+	 * Checks whether the entire gzip file was written to caller buffers.
+	 *
+	 * Also returns true if compression failed, because the internal buffers could not be allocated.
+	 *
+	 * @return	Whether the compression is done.
+	 */
+	bool done() const;
+};
+
 } /* namespace gzip */
 
 #endif /* SRC_HTML_UZLIB_GZIP_WRAPPER_H_ */
@@ -12,7 +12,9 @@
 #ifdef ARDUINO
 #include <Arduino.h>
 #endif
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <fallback_log.h>
 
 namespace gzip {
@@ -21,8 +23,110 @@ void init() {
 	uzlib_init();
 }
 
+/**
+ * Clamps the given window size to the range supported by deflate, and logs an error if it was out of range.
+ *
+ * @param wsize	The window size to clamp.
+ * @return	The clamped window size.
+ */
+static int8_t clamp_wsize(const int8_t wsize) {
+	if (wsize > -8) {
+		log_e("Window size out of range.");
+		return -8;
+	} else if (wsize < -15) {
+		log_e("Window size out of range.");
+		return -15;
+	}
+	return wsize;
+}
+
+uzlib_dict_pool::uzlib_dict_pool(const uint8_t count, int8_t wsize) :
+		count(count > MAX_DICTS ? MAX_DICTS : count), dict_size(
+				1 << -clamp_wsize(wsize)), used(0), failures(0) {
+	if (count > MAX_DICTS) {
+		log_e("Dict pool size out of range.");
+	}
+
+	dicts = (uint8_t*) malloc((size_t) this->count * dict_size);
+	if (!dicts && this->count > 0) {
+		log_e("Failed to allocate decompression dict pool.");
+	}
+}
+
+uzlib_dict_pool::~uzlib_dict_pool() {
+	if (used != 0) {
+		log_e("Destroying dict pool with dicts in use.");
+	}
+	free(dicts);
+}
+
+uint8_t* uzlib_dict_pool::acquire() {
+	if (dicts) {
+#ifdef ESP8266
+		for (uint8_t i = 0; i < count; i++) {
+			if (!(used & (1U << i))) {
+				used |= 1U << i;
+				return dicts + (size_t) i * dict_size;
+			}
+		}
+#else
+		uint32_t current = used.load();
+		uint8_t i = 0;
+		while (i < count) {
+			if (current & (1U << i)) {
+				i++;
+			} else if (used.compare_exchange_weak(current,
+					current | (1U << i))) {
+				return dicts + (size_t) i * dict_size;
+			} else {
+				// Another task changed the mask, check again using the updated mask.
+				i = 0;
+			}
+		}
+#endif
+	}
+
+	failures++;
+	return NULL;
+}
+
+void uzlib_dict_pool::release(const uint8_t *dict) {
+	if (!contains(dict)) {
+		return;
+	}
+
+	const uint8_t index = (dict - dicts) / dict_size;
+	used &= ~(1U << index);
+}
+
+bool uzlib_dict_pool::contains(const uint8_t *dict) const {
+	return dicts && dict >= dicts && dict < dicts + (size_t) count * dict_size;
+}
+
+uint8_t uzlib_dict_pool::getSize() const {
+	return dicts ? count : 0;
+}
+
+uint16_t uzlib_dict_pool::getDictSize() const {
+	return dict_size;
+}
+
+uint8_t uzlib_dict_pool::getInUse() const {
+	const uint32_t mask = used;
+	uint8_t in_use = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		in_use += (mask >> i) & 1;
+	}
+	return in_use;
+}
+
+uint32_t uzlib_dict_pool::getFailures() const {
+	return failures;
+}
+
 uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(const uint8_t *cmp_start,
-		const uint8_t *cmp_end, int8_t wsize) {
+		const uint8_t *cmp_end, int8_t wsize, uzlib_dict_pool *pool) :
+		pool(pool) {
 	if (wsize > -8) {
 		log_e("Window size out of range.");
 		wsize = -8;
@@ -31,37 +135,70 @@ uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(const uint8_t *cmp_start,
 		wsize = -15;
 	}
 
-	void *dict = NULL;
 	if (cmp_end < cmp_start + 29) {
 		log_e("Compressed buffer too small.");
 		log_i("A gzip compressed 0 byte file is 29 bytes in size.");
 		log_i("The given file was %d bytes.", cmp_end - cmp_start);
+		decomp = new wrapped_uncomp;
+		decomp->wrapper = this;
+		uzlib_uncompress_init(decomp, NULL, pow(2, -wsize));
 	} else {
-		dict = malloc(pow(2, -wsize));
-
 		// Read uncompressed size from compressed file.
 		dlen = cmp_end[-1];
 		dlen = 256 * dlen + cmp_end[-2];
 		dlen = 256 * dlen + cmp_end[-3];
 		dlen = 256 * dlen + cmp_end[-4];
 
+		initDict(wsize);
 	}
 
-	decomp = new uzlib_uncomp;
-	// Try anyways, since small files can be decompressed without one.
-	if (dict == NULL) {
-		log_e("Failed to allocate decompression dict.");
-	}
-
-	uzlib_uncompress_init(decomp, dict, pow(2, -wsize));
 	decomp->source = cmp_start;
 	decomp->source_limit = cmp_end - 4 >= cmp_start ? cmp_end - 4 : cmp_start;
 	decomp->source_read_cb = NULL;
 	uzlib_gzip_parse_header(decomp);
 }
 
+uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(const uint8_t *cmp_start,
+		const uint8_t *cmp_end, const uint32_t checkpoints[][2],
+		const size_t checkpoints_len, const size_t offset, int8_t wsize,
+		uzlib_dict_pool *pool) :
+		uzlib_ungzip_wrapper(cmp_start, cmp_end, wsize, pool) {
+	// Skipping writes to a small buffer, so back references without a dict would read before it.
+	if (!hasDict()) {
+		return;
+	}
+
+	// Find the last checkpoint at or before the offset.
+	const uint32_t (*checkpoint)[2] = std::upper_bound(checkpoints,
+			checkpoints + checkpoints_len, offset,
+			[](const size_t off, const uint32_t (&cp)[2]) -> bool {
+				return off < cp[0];
+			});
+
+	// Starting at the first checkpoint is the same as starting at the file start.
+	if (checkpoint > checkpoints && checkpoint[-1][0] > 0) {
+		checkpoint--;
+		// Skip the crc32 and the uncompressed size in the trailer.
+		if (cmp_end - cmp_start < 8
+				|| (*checkpoint)[1] >= (size_t) (cmp_end - cmp_start - 8)) {
+			log_e("Checkpoint out of range.");
+		} else {
+			decomp->source = cmp_start + (*checkpoint)[1];
+			decomp->source_limit = cmp_end - 8;
+			// The crc32 can't be checked without the data before the checkpoint.
+			decomp->checksum_type = TINF_CHKSUM_NONE;
+			index = (*checkpoint)[0];
+		}
+	}
+
+	if (offset > index && skip(offset - index) < offset - index) {
+		log_w("Offset is after the file end.");
+	}
+}
+
 uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(int (*callback)(uzlib_uncomp*),
-		int8_t wsize) {
+		int8_t wsize, uzlib_dict_pool *pool) :
+		pool(pool) {
 	if (wsize > -8) {
 		log_e("Window size out of range.");
 		wsize = -8;
@@ -70,25 +207,109 @@ uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(int (*callback)(uzlib_uncomp*),
 		wsize = -15;
 	}
 
-	decomp = new uzlib_uncomp;
-	void *dict = malloc(pow(2, -wsize));
-	// Try anyways, since small files can be decompressed without one.
-	if (!dict) {
-		log_e("Failed to allocate decompression dict.");
-	}
-
-	uzlib_uncompress_init(decomp, dict, pow(2, -wsize));
+	initDict(wsize);
 	decomp->source = NULL;
 	decomp->source_limit = NULL;
 	decomp->source_read_cb = callback;
 	uzlib_gzip_parse_header(decomp);
 }
 
+uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(source_t source, int8_t wsize,
+		uzlib_dict_pool *pool) :
+		source(source), pool(pool) {
+	initDict(clamp_wsize(wsize));
+	decomp->source = NULL;
+	decomp->source_limit = NULL;
+	decomp->source_read_cb = readChunk;
+	uzlib_gzip_parse_header(decomp);
+}
+
 uzlib_ungzip_wrapper::~uzlib_ungzip_wrapper() {
-	free(decomp->dict_ring);
+	if (pool) {
+		pool->release((uint8_t*) decomp->dict_ring);
+	} else {
+		free(decomp->dict_ring);
+	}
 	delete decomp;
 }
 
+void uzlib_ungzip_wrapper::initDict(const int8_t wsize) {
+	decomp = new wrapped_uncomp;
+	decomp->wrapper = this;
+	size_t dict_size = pow(2, -wsize);
+	void *dict = NULL;
+	if (pool) {
+		if (pool->getDictSize() < dict_size) {
+			log_e("Dict pool dicts are too small for window size %d.", wsize);
+		} else {
+			dict = pool->acquire();
+			dict_size = pool->getDictSize();
+			if (!dict) {
+				log_w("No free decompression dict in pool.");
+			}
+		}
+	} else {
+		dict = malloc(dict_size);
+		if (!dict) {
+			log_e("Failed to allocate decompression dict.");
+		}
+	}
+
+	// Try anyways, since small files can be decompressed without one.
+	uzlib_uncompress_init(decomp, dict, dict_size);
+}
+
+int uzlib_ungzip_wrapper::readChunk(uzlib_uncomp *uncomp) {
+	uzlib_ungzip_wrapper *wrapper = static_cast<wrapped_uncomp*>(uncomp)->wrapper;
+	if (wrapper->pending_len > 0) {
+		uncomp->source = wrapper->pending + 1;
+		uncomp->source_limit = wrapper->pending + wrapper->pending_len;
+		wrapper->pending_len = 0;
+		return wrapper->pending[0];
+	}
+
+	const uint8_t *chunk = NULL;
+	size_t chunk_len = 0;
+	while (wrapper->source && (chunk_len = wrapper->source(&chunk)) > 0) {
+		if (wrapper->held_len + chunk_len <= 4) {
+			memcpy(wrapper->held + wrapper->held_len, chunk, chunk_len);
+			wrapper->held_len += chunk_len;
+			continue;
+		}
+
+		// The number of held back bytes that turned out not to be part of the trailer.
+		const uint8_t released = std::min<size_t>(wrapper->held_len,
+				wrapper->held_len + chunk_len - 4);
+		memcpy(wrapper->staging, wrapper->held, released);
+		if (chunk_len >= 4) {
+			wrapper->pending = chunk;
+			wrapper->pending_len = chunk_len - 4;
+			memcpy(wrapper->held, chunk + chunk_len - 4, 4);
+		} else {
+			memmove(wrapper->held, wrapper->held + released,
+					wrapper->held_len - released);
+			memcpy(wrapper->held + wrapper->held_len - released, chunk,
+					chunk_len);
+		}
+		wrapper->held_len = 4;
+
+		if (released > 0) {
+			uncomp->source = wrapper->staging + 1;
+			uncomp->source_limit = wrapper->staging + released;
+			return wrapper->staging[0];
+		} else {
+			return readChunk(uncomp);
+		}
+	}
+
+	// The held back bytes are the uncompressed size from the gzip trailer.
+	// Drop the source, to make sure it isn't called again after signaling the file end.
+	wrapper->source = source_t();
+	uncomp->source = NULL;
+	uncomp->source_limit = NULL;
+	return -1;
+}
+
 size_t uzlib_ungzip_wrapper::decompress(uint8_t *buf, const size_t buf_size) {
 	if (decomp->eof) {
 		return 0;
@@ -102,7 +323,10 @@ size_t uzlib_ungzip_wrapper::decompress(uint8_t *buf, const size_t buf_size) {
 	}
 
 	int res = uzlib_uncompress_chksum(decomp);
-	if (res != TINF_OK && res != TINF_DONE) {
+	if (res == TINF_DONE) {
+		// Without checksum uzlib doesn't read past the last block, so it doesn't detect the file end.
+		decomp->eof = true;
+	} else if (res != TINF_OK) {
 		log_e("Decompress failed with error %d.", res);
 	}
 
@@ -115,7 +339,9 @@ size_t uzlib_ungzip_wrapper::decompress(uint8_t *buf, const size_t buf_size) {
 		res = uzlib_uncompress_chksum(decomp);
 		if (res == TINF_OK) {
 			dcbuf = dbuf;
-		} else if (res != TINF_DONE) {
+		} else if (res == TINF_DONE) {
+			decomp->eof = true;
+		} else {
 			log_e("Decompress failed with error %d.", res);
 		}
 	}
@@ -127,6 +353,20 @@ size_t uzlib_ungzip_wrapper::decompress(uint8_t *buf, const size_t buf_size) {
 	return read;
 }
 
+size_t uzlib_ungzip_wrapper::skip(const size_t len) {
+	uint8_t buf[128];
+	size_t skipped = 0;
+	while (skipped < len && !done()) {
+		const size_t read = decompress(buf,
+				std::min<size_t>(len - skipped, sizeof(buf)));
+		if (read == 0) {
+			break;
+		}
+		skipped += read;
+	}
+	return skipped;
+}
+
 int32_t uzlib_ungzip_wrapper::getDecompressedSize() const {
 	return dlen;
 }
@@ -139,4 +379,203 @@ bool uzlib_ungzip_wrapper::done() const {
 	return decomp->eof;
 }
 
+bool uzlib_ungzip_wrapper::hasDict() const {
+	return decomp->dict_ring != NULL;
+}
+
+/**
+ * Calculates the number of hash table index bits to use for the given window size.
+ * Uses half as many hash table entries as the window has bytes, but at least 256 and at most 4096.
+ *
+ * @param dict_size	The size of the compression window in bytes.
+ * @return	The number of hash table index bits.
+ */
+static uint8_t calc_hash_bits(const uint16_t dict_size) {
+	uint8_t bits = 0;
+	while ((1U << (bits + 2)) <= dict_size) {
+		bits++;
+	}
+	return std::min<uint8_t>(std::max<uint8_t>(bits, 8), 12);
+}
+
+uzlib_gzip_wrapper::uzlib_gzip_wrapper(const uint8_t *uncmp_start,
+		const uint8_t *uncmp_end, int8_t wsize) :
+		uzlib_gzip_wrapper(
+				[uncmp_start, uncmp_end](uint8_t *buf,
+						const size_t max_len) mutable -> size_t {
+					const size_t len = std::min(max_len,
+							(size_t) (uncmp_end - uncmp_start));
+					if (len > 0) {
+						memcpy(buf, uncmp_start, len);
+						uncmp_start += len;
+					}
+					return len;
+				}, wsize) {
+}
+
+uzlib_gzip_wrapper::uzlib_gzip_wrapper(source_t source, int8_t wsize) :
+		source(source), dict_size(1 << -clamp_wsize(wsize)), window_size(
+				dict_size
+						+ std::max<uint32_t>(dict_size, MAX_MATCH * 2)), hash_bits(
+				calc_hash_bits(dict_size)) {
+	window = (uint8_t*) malloc(window_size);
+	hash_table = (uint16_t*) calloc(1 << hash_bits, sizeof(uint16_t));
+	out.outbuf = (unsigned char*) malloc(OUTBUF_SIZE);
+	out.outsize = OUTBUF_SIZE;
+	out.outlen = 0;
+	out.outbits = 0;
+	out.noutbits = 0;
+	out.comp_disabled = 0;
+
+	if (!window || !hash_table || !out.outbuf) {
+		log_e("Failed to allocate compression buffers.");
+		free(window);
+		window = NULL;
+		free(hash_table);
+		hash_table = NULL;
+		free(out.outbuf);
+		out.outbuf = NULL;
+		return;
+	}
+
+	// ID1, ID2, CM = deflate, FLG, MTIME(4 bytes), XFL, OS = unknown.
+	const uint8_t header[GZIP_HEADER_SIZE] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0,
+			0xFF };
+	memcpy(out.outbuf, header, GZIP_HEADER_SIZE);
+	out.outlen = GZIP_HEADER_SIZE;
+	zlib_start_block(&out);
+}
+
+uzlib_gzip_wrapper::~uzlib_gzip_wrapper() {
+	free(window);
+	free(hash_table);
+	free(out.outbuf);
+}
+
+void uzlib_gzip_wrapper::fill() {
+	while (!input_done && avail - pos < MAX_MATCH) {
+		if (avail == window_size) {
+			// Keep dict_size bytes of history, and move everything else to the start.
+			const uint32_t shift = pos - dict_size;
+			memmove(window, window + shift, avail - shift);
+			avail -= shift;
+			pos -= shift;
+			for (uint32_t i = 0; i < (uint32_t) (1 << hash_bits); i++) {
+				hash_table[i] = hash_table[i] >= shift ? hash_table[i] - shift : 0;
+			}
+		}
+
+		const size_t len = source(window + avail, window_size - avail);
+		if (len == 0) {
+			input_done = true;
+		} else {
+			crc = uzlib_crc32(window + avail, len, crc);
+			avail += len;
+			read += len;
+		}
+	}
+}
+
+uint16_t uzlib_gzip_wrapper::hash(const uint32_t p) const {
+	const uint32_t h = ((uint32_t) window[p] << 16)
+			| ((uint32_t) window[p + 1] << 8) | window[p + 2];
+	return ((h * 2654435761U) >> (32 - hash_bits));
+}
+
+void uzlib_gzip_wrapper::encodeNext() {
+	const uint32_t lookahead = std::min<uint32_t>(avail - pos, MAX_MATCH);
+	uint32_t match_len = 0;
+	uint32_t match_dist = 0;
+	if (lookahead >= MIN_MATCH) {
+		const uint16_t h = hash(pos);
+		const uint32_t candidate = hash_table[h];
+		hash_table[h] = pos;
+		if (candidate < pos && pos - candidate <= dict_size) {
+			while (match_len < lookahead
+					&& window[candidate + match_len] == window[pos + match_len]) {
+				match_len++;
+			}
+			match_dist = pos - candidate;
+		}
+	}
+
+	if (match_len >= MIN_MATCH) {
+		zlib_match(&out, match_dist, match_len);
+		// Insert the skipped positions, to allow later matches to refer to them.
+		for (uint32_t i = 1; i < match_len && pos + i + MIN_MATCH <= avail;
+				i++) {
+			hash_table[hash(pos + i)] = pos + i;
+		}
+		pos += match_len;
+	} else {
+		zlib_literal(&out, window[pos]);
+		pos++;
+	}
+}
+
+void uzlib_gzip_wrapper::finish() {
+	zlib_finish_block(&out);
+	// zlib_finish_block flushes all meaningful bits, the rest is padding.
+	out.outbits = 0;
+	out.noutbits = 0;
+
+	const uint32_t crc32 = ~crc;
+	for (uint8_t i = 0; i < 4; i++) {
+		out.outbuf[out.outlen++] = (crc32 >> (i * 8)) & 0xFF;
+	}
+	for (uint8_t i = 0; i < 4; i++) {
+		out.outbuf[out.outlen++] = (read >> (i * 8)) & 0xFF;
+	}
+	finished = true;
+}
+
+size_t uzlib_gzip_wrapper::compress(uint8_t *buf, const size_t buf_size) {
+	if (!window) {
+		return 0;
+	}
+
+	size_t buf_written = 0;
+	while (buf_written < buf_size) {
+		if (out_index < out.outlen) {
+			const size_t len = std::min<size_t>(buf_size - buf_written,
+					out.outlen - out_index);
+			memcpy(buf + buf_written, out.outbuf + out_index, len);
+			out_index += len;
+			buf_written += len;
+			continue;
+		} else if (finished) {
+			break;
+		}
+
+		out.outlen = 0;
+		out_index = 0;
+		while (out.outlen + OUTBUF_MARGIN <= out.outsize) {
+			fill();
+			if (pos >= avail) {
+				// The trailer needs up to GZIP_TRAILER_SIZE + 2 bytes, which the margin doesn't guarantee.
+				if (out.outlen + GZIP_TRAILER_SIZE + 2 <= out.outsize) {
+					finish();
+				}
+				break;
+			}
+			encodeNext();
+		}
+	}
+
+	written += buf_written;
+	return buf_written;
+}
+
+uint32_t uzlib_gzip_wrapper::getUncompressed() const {
+	return read;
+}
+
+uint32_t uzlib_gzip_wrapper::getCompressed() const {
+	return written;
+}
+
+bool uzlib_gzip_wrapper::done() const {
+	return !window || (finished && out_index >= out.outlen);
+}
+
 } /* namespace gzip */
@@ -4,6 +4,7 @@ from enum import Enum
 import os
 from os import path
 import sys
+import zlib
 
 from gzip_compressing_stream import GzipCompressingStream
 
@@ -35,6 +36,22 @@ separator_chars = [ '(', ')', '[', ']', '{', '}', '<', '>', ':', ';', ',', '+',
 # This requires a pow(2, -gzip_windowsize) byte buffer on the esp.
 gzip_windowsize = -10
 
+# The number of uncompressed bytes between two inflate checkpoints.
+# A checkpoint is a full flush, after which the esp can start decompressing without the previous data.
+# Used to answer HTTP range requests without decompressing the file from the start.
+# Smaller intervals make range requests faster, but compress slightly worse.
+gzip_checkpoint_interval = 4096
+
+# The zlib strategies to try when deflate compressing a file.
+# The deflate variant is compressed with each of them, and the smallest result is kept.
+deflate_strategies = [ zlib.Z_DEFAULT_STRATEGY, zlib.Z_FILTERED, zlib.Z_RLE, zlib.Z_HUFFMAN_ONLY ]
+
+# The path of the header file containing the inflate checkpoints of the compressed files.
+checkpoint_header_path = path.join(env.subst('$PROJECT_SRC_DIR'), 'generated', 'web_file_checkpoints.h') # type: ignore[name-defined]
+
+# The inflate checkpoints of the compressed files, by compressed filename.
+checkpoints = {}
+
 MinifyMode = Enum('MinifyMode', [ 'Default', 'HTML', 'CSS', 'JavaScript' ])
 
 
@@ -146,15 +163,154 @@ def gzip_file(input, output):
         The path of the input file to compress.
     output: str
         The target path to write the compressed file to.
+
+    Returns
+    -------
+    list
+        A list of (uncompressed offset, compressed offset) tuples, one for each inflate checkpoint.
     """
 
-    with open(input, 'rb') as src, GzipCompressingStream(filename=output, compresslevel=9, wsize=gzip_windowsize) as dst:
+    with open(input, 'rb') as src, GzipCompressingStream(filename=output, compresslevel=9, wsize=gzip_windowsize, checkpoint_interval=gzip_checkpoint_interval) as dst:
         for chunk in iter(lambda: src.read(4096), b""):
             dst.write(chunk)
 
+    return dst.checkpoints
+
+
+def deflate_data(data):
+    """Compresses the given data to a zlib stream, as used by the deflate content coding.
+
+    Uses the max compression level, window size, and memory level, and tries all the deflate_strategies.
+    This variant is only ever decompressed by the client, so it doesn't have to fit the esp window size.
+
+    Parameters
+    ----------
+    data: bytes
+        The data to compress.
+
+    Returns
+    -------
+    bytes
+        The smallest zlib stream generated for the given data.
+    """
+
+    best = None
+    for strategy in deflate_strategies:
+        compress = zlib.compressobj(9, zlib.DEFLATED, 15, 9, strategy)
+        compressed = compress.compress(data) + compress.flush()
+        if best is None or len(compressed) < len(best):
+            best = compressed
+
+    return best
+
+
+def write_variants(input, filename, gzip_size, data_dir):
+    """Writes the deflate compressed and the uncompressed variant of a gzip compressed file.
+
+    The uncompressed variant is only written if it is smaller than the gzip file.
+    The deflate variant is only written if it is smaller than both other variants.
+    Otherwise an empty file is written instead, since every variant has to exist to be embedded.
+    Empty files don't use any flash space, and make the web server use the other variants.
+
+    Parameters
+    ----------
+    input: str
+        The path of the uncompressed input file.
+    filename: str
+        The name of the input file, used for the output files.
+    gzip_size: int
+        The size of the gzip compressed file.
+    data_dir: str
+        The data directory to write the variants to.
+    """
+
+    with open(input, 'rb') as src:
+        data = src.read()
+
+    identity_dir = path.join(data_dir, "identity")
+    if not path.exists(identity_dir):
+        os.mkdir(identity_dir)
+
+    identity_size = len(data)
+    with open(path.join(identity_dir, filename), 'wb') as dst:
+        if identity_size < gzip_size:
+            dst.write(data)
+        else:
+            identity_size = None
+
+    deflate_dir = path.join(data_dir, "deflate")
+    if not path.exists(deflate_dir):
+        os.mkdir(deflate_dir)
+
+    deflated = deflate_data(data)
+    with open(path.join(deflate_dir, filename + ".zz"), 'wb') as dst:
+        if len(deflated) < gzip_size and (identity_size is None or len(deflated) < identity_size):
+            dst.write(deflated)
+
+
+def generate_checkpoint_header(checkpoints):
+    """Generates the header file containing the inflate checkpoints of the compressed files.
+
+    Each checkpoint is an array of two numbers.
+    The first is the offset in the uncompressed file, the second the offset of the next deflate block in the compressed file.
+
+    Parameters
+    ----------
+    checkpoints: dict
+        The compressed filenames and their checkpoints.
+    """
+
+    print("Generating " + path.relpath(checkpoint_header_path, env.subst("$PROJECT_ROOT"))) # type: ignore[name-defined]
+
+    with open(checkpoint_header_path, 'w') as header:
+        header.write(
+"""/*
+ * web_file_checkpoints.h
+ *
+ * **Warning:** This file is automatically generated, and should not be edited manually.
+ *
+ * This file contains the inflate checkpoints of the gzip compressed static files sent by the web server.
+ *
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_
+#define SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+""")
+
+        for file, file_checkpoints in checkpoints.items():
+            id = file.upper()
+            for c in ['.', '-', '/', ' ']:
+                id = id.replace(c, '_')
+
+            header.write(
+f"""/**
+ * The inflate checkpoints of the file "{file}".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+""")
+            entries = ", ".join(f"{{ {u}, {c} }}" for u, c in file_checkpoints)
+            header.write(f"static constexpr const uint32_t {id}_CHECKPOINTS[][2] = {{ {entries} }};")
+            header.write(os.linesep + os.linesep)
+            header.write(
+f"""/**
+ * The number of inflate checkpoints of the file "{file}".
+ */
+""")
+            header.write(f"static constexpr const size_t {id}_CHECKPOINTS_LEN = {len(file_checkpoints)};")
+            header.write(os.linesep + os.linesep)
+
+        header.write("#endif /* SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_ */" + os.linesep)
+
 
 def compress_file(input, text):
     """Compresses the input file to data/gzip/filename.
+    Also writes the variants for the other content codings to data/deflate and data/identity.
     
     If text is True the file will first by copied to data.
     If run as a release build it will also me minifyed during this step.
@@ -214,7 +370,9 @@ def compress_file(input, text):
         os.mkdir(gzip_dir)
 
     if do_gzip:
-        gzip_file(input, path.join(gzip_dir, filename + ".gz"))
+        gzip_output = path.join(gzip_dir, filename + ".gz")
+        checkpoints[filename + ".gz"] = gzip_file(input, gzip_output)
+        write_variants(input, filename, path.getsize(gzip_output), data_dir)
 
 
 for file in input_text_files:
@@ -227,3 +385,5 @@ for file in input_text_files:
 for file in input_binary_files:
     filename = path.basename(file) + ".gz"
     compress_file(file, False)
+
+generate_checkpoint_header(checkpoints)
@@ -20,7 +20,12 @@ static_types: Final[List[str]] = ['.gz', '.png', '.ico', '.html', '.css', '.js']
 static_dir: Final[str] = 'data'
 
 # A list of files that would be considered static, but should not have their hashes calculated.
-static_file_blacklist: Final[List[str]] = [path.join('data', 'index.html'), path.join('data', 'error.html')]
+# The templated main page is hashed, since its hash is combined with the measurement generation for its entity tag.
+static_file_blacklist: Final[List[str]] = [path.join('data', 'error.html')]
+
+# Subdirectories of the static directory, whose files should not have their hashes calculated.
+# These contain the other encodings of the files in data/gzip, which use the hash of the gzip file.
+static_subdir_blacklist: Final[List[str]] = [path.join('data', 'deflate'), path.join('data', 'identity')]
 
 # The path of the header file to generated.
 hash_header_path: Final[str] = path.join(env.subst('$PROJECT_SRC_DIR'), 'generated', 'web_file_hashes.h')  # type: ignore[name-defined]
@@ -116,11 +121,13 @@ def main() -> int:
 
     static_path_abs: Final[str] = path.abspath(static_dir)
     static_path_blacklist_abs: Final[List[str]] = [path.abspath(path.join(env.subst('$PROJECT_DIR'), file.strip())) for file in static_file_blacklist]  # type: ignore[name-defined]
+    static_subdir_blacklist_abs: Final[List[str]] = [path.abspath(path.join(env.subst('$PROJECT_DIR'), dir)) + os.sep for dir in static_subdir_blacklist]  # type: ignore[name-defined]
 
     files: List[str] = env.GetProjectOption('board_build.embed_files', '').splitlines()  # type: ignore[name-defined]
     files.extend(env.GetProjectOption('board_build.embed_txtfiles', '').splitlines())  # type: ignore[name-defined]
     files = [path.abspath(path.join(env.subst('$PROJECT_DIR'), file.strip())) for file in files if file.strip()]  # type: ignore[name-defined]
     files = [file for file in files if file.startswith(path.abspath(static_dir)) and path.splitext(file)[1] in static_types and file not in static_path_blacklist_abs]
+    files = [file for file in files if not any(file.startswith(dir) for dir in static_subdir_blacklist_abs)]
 
     hashes = hash_files(files)
     generate_hash_header(hashes)
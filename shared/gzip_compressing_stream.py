@@ -27,7 +27,9 @@ class GzipCompressingStream(io.RawIOBase):
 
     size = 0
 
-    def __init__(self, filename, compresslevel=9, wsize=-10):
+    compressed_size = 0
+
+    def __init__(self, filename, compresslevel=9, wsize=-10, checkpoint_interval=0):
         """Constructor for the GzipCompressingStream class.
 
         Opens the file represented by filename if it ends with .gz,
@@ -46,6 +48,10 @@ class GzipCompressingStream(io.RawIOBase):
             Valid values are from -8 to -15.
         wsize: int
             The zlib window size to use. See zlib docs.
+        checkpoint_interval: int
+            The number of uncompressed bytes between two inflate checkpoints.
+            Each checkpoint is a full flush, after which decompression can start without the previous data.
+            Zero disables checkpoints.
         """
 
         if wsize > -8 or wsize < -15:
@@ -62,9 +68,25 @@ class GzipCompressingStream(io.RawIOBase):
 
         self.crc = zlib.crc32(b'')
         self.compress = zlib.compressobj(compresslevel, zlib.DEFLATED, wsize, zlib.DEF_MEM_LEVEL, 0)
+        self.checkpoint_interval = checkpoint_interval
 
         self._write_gzip_header(filename, compresslevel)
 
+        # The start of the deflate stream is always a valid checkpoint.
+        self.checkpoints = [(0, self.compressed_size)]
+
+    def _write_compressed(self, data):
+        """Writes the given bytes to the output file, and updates the compressed size.
+
+        Parameters
+        ----------
+        data: bytes
+            The data to write.
+        """
+
+        self.fileobj.write(data)
+        self.compressed_size += len(data)
+
     def _write_gzip_header(self, filename, compresslevel=9):
         """Writes a gzip file header to the output file of this stream.
 
@@ -77,7 +99,7 @@ class GzipCompressingStream(io.RawIOBase):
             The gzip compression level used.
         """
 
-        self.fileobj.write(b'\x1f\x8b\x08')  # magic numbers + deflate compression
+        self._write_compressed(b'\x1f\x8b\x08')  # magic numbers + deflate compression
         try:
             # filename should always end with .gz
             filename = os.path.basename(filename)[:-3]
@@ -89,23 +111,23 @@ class GzipCompressingStream(io.RawIOBase):
             filename = None
 
         if filename:
-            self.fileobj.write(b'\x08')
+            self._write_compressed(b'\x08')
         else:
-            self.fileobj.write(b'\x00')
+            self._write_compressed(b'\x00')
 
-        self.fileobj.write(b'\x00\x00\x00\x00')  # don't write last modified time
+        self._write_compressed(b'\x00\x00\x00\x00')  # don't write last modified time
 
         if compresslevel == 9:
-            self.fileobj.write(b'\x02')
+            self._write_compressed(b'\x02')
         elif compresslevel == 1:
-            self.fileobj.write(b'\x04')
+            self._write_compressed(b'\x04')
         else:
-            self.fileobj.write(b'\x00')
+            self._write_compressed(b'\x00')
 
-        self.fileobj.write(b'\xff')  # unknown os
+        self._write_compressed(b'\xff')  # unknown os
 
         if filename:
-            self.fileobj.write(filename + b'\x00')
+            self._write_compressed(filename + b'\x00')
 
     def write(self, data):
         """Compresses the given data and writes it to the output file.
@@ -134,10 +156,21 @@ class GzipCompressingStream(io.RawIOBase):
             raise ValueError("Can only write bytes, bytearray, or str")
 
         length = len(data)
-        if length > 0:
-            self.fileobj.write(self.compress.compress(data))
-            self.size += length
-            self.crc = zlib.crc32(data, self.crc)
+        offset = 0
+        while offset < length:
+            part = data[offset:]
+            if self.checkpoint_interval > 0:
+                if self.size > 0 and self.size % self.checkpoint_interval == 0:
+                    # Only add a checkpoint once there is more data, to avoid a useless checkpoint at the end.
+                    self._write_compressed(self.compress.flush(zlib.Z_FULL_FLUSH))
+                    self.checkpoints.append((self.size, self.compressed_size))
+
+                part = part[:self.checkpoint_interval - self.size % self.checkpoint_interval]
+
+            self._write_compressed(self.compress.compress(part))
+            self.size += len(part)
+            self.crc = zlib.crc32(part, self.crc)
+            offset += len(part)
 
         return length
 
@@ -150,13 +183,13 @@ class GzipCompressingStream(io.RawIOBase):
         if self.closed:
             return
 
+        self._write_compressed(self.compress.flush())
+        self._write_compressed(struct.pack("<L", self.crc))
+        self._write_compressed(struct.pack("<L", self.size & 0xffffffff))
+
         fileobj = self.fileobj
         self.fileobj = None
 
-        fileobj.write(self.compress.flush())
-        fileobj.write(struct.pack("<L", self.crc))
-        fileobj.write(struct.pack("<L", self.size & 0xffffffff))
-
         if fileobj != sys.stdout.buffer:
             fileobj.close()
 
@@ -166,7 +199,7 @@ class GzipCompressingStream(io.RawIOBase):
         Can degrade compression and should only be called if necessary.
         """
 
-        self.fileobj.write(self.compress.flush(zlib.Z_SYNC_FLUSH))
+        self._write_compressed(self.compress.flush(zlib.Z_SYNC_FLUSH))
         self.fileobj.flush()
 
     @property
@@ -213,6 +246,10 @@ def main():
         default=-10, help="The deflate window size to use.")
     parser.add_argument('-c', "--compression-level", dest="clevel", metavar='LEVEL',
         type=int, default=9, help="The level of compression to use. 1 is fastest, 9 is best.")
+    parser.add_argument("--checkpoint-interval", dest="cinterval", metavar='BYTES', type=int,
+        default=0, help="The number of uncompressed bytes between two full flush checkpoints. 0 to disable.")
+    parser.add_argument("--checkpoint-file", dest="cfile", metavar='FILE', default=None,
+        help="A file to write the checkpoints to. One line per checkpoint, containing the uncompressed and compressed offset.")
     parser.add_argument("args", nargs="*", default=["-"], metavar='FILE',
         help="A file to compress. Use '-' to read from standard input and write to standard output.")
     args = parser.parse_args()
@@ -234,7 +271,7 @@ def main():
                     traceback.print_exc()
                     return 1
 
-        fout = GzipCompressingStream(arg, args.clevel, args.wsize)
+        fout = GzipCompressingStream(arg, args.clevel, args.wsize, args.cinterval)
         while True:
             chunk = fin.read(128 * 1024)
             if not chunk:
@@ -245,6 +282,11 @@ def main():
         if fin != sys.stdin.buffer:
             fin.close()
 
+        if args.cfile:
+            with open(args.cfile, 'w') as cfile:
+                for uncompressed, compressed in fout.checkpoints:
+                    cfile.write(f"{uncompressed} {compressed}\n")
+
     return 0
 
 
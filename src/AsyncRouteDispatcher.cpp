@@ -0,0 +1,54 @@
+/*
+ * AsyncRouteDispatcher.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "AsyncRouteDispatcher.h"
+#if ENABLE_WEB_SERVER == 1
+#include <fallback_log.h>
+
+web::AsyncRouteDispatcher::AsyncRouteDispatcher(
+		http::RouteTable<AsyncTrackingFallbackWebHandler*> &routes) :
+		_routes(routes) {
+
+}
+
+web::AsyncRouteDispatcher::~AsyncRouteDispatcher() {
+
+}
+
+web::AsyncTrackingFallbackWebHandler* web::AsyncRouteDispatcher::_getHandler(
+		AsyncWebServerRequest *request) const {
+	const String &url = request->url();
+	AsyncTrackingFallbackWebHandler *const *handler = _routes.match(
+			url.c_str(), url.length());
+	return handler ? *handler : NULL;
+}
+
+bool web::AsyncRouteDispatcher::canHandle(AsyncWebServerRequest *request) {
+	if (_getHandler(request)) {
+		request->addInterestingHeader("ANY");
+		return true;
+	}
+	return false;
+}
+
+void web::AsyncRouteDispatcher::handleRequest(AsyncWebServerRequest *request) {
+	AsyncTrackingFallbackWebHandler *handler = _getHandler(request);
+	if (handler) {
+		handler->handleRequest(request);
+	} else {
+		log_w("No handler for uri \"%s\" found.", request->url().c_str());
+		request->send(500);
+	}
+}
+
+bool web::AsyncRouteDispatcher::isRequestHandlerTrivial() {
+	return false;
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
@@ -0,0 +1,84 @@
+/*
+ * AsyncRouteDispatcher.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_ASYNCROUTEDISPATCHER_H_
+#define SRC_ASYNCROUTEDISPATCHER_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include "webhandler.h"
+#include <route_table.h>
+
+namespace web {
+/**
+ * A single web handler dispatching requests to the handler registered for their uri.
+ *
+ * Replaces adding one handler per uri to the web server,
+ * which made the web server check the uri of every handler for each request.
+ * The handlers are looked up in a sorted route table instead.
+ *
+ * A handler also handles all uris below its uri, unless a handler for a longer uri matches.
+ */
+class AsyncRouteDispatcher: public AsyncWebHandler {
+protected:
+	/**
+	 * The route table containing the handler for each uri.
+	 */
+	http::RouteTable<AsyncTrackingFallbackWebHandler*> &_routes;
+
+	/**
+	 * Gets the handler for the uri of the given request.
+	 *
+	 * @param request	The request to get the handler for.
+	 * @return	The handler for the request, or NULL if there is none.
+	 */
+	virtual AsyncTrackingFallbackWebHandler* _getHandler(
+			AsyncWebServerRequest *request) const;
+
+public:
+	/**
+	 * Creates a new AsyncRouteDispatcher using the given route table.
+	 *
+	 * @param routes	The route table to get the handlers from.
+	 * 					Routes can still be added after the dispatcher was added to the web server.
+	 */
+	AsyncRouteDispatcher(http::RouteTable<AsyncTrackingFallbackWebHandler*> &routes);
+
+	/**
+	 * Destroys this dispatcher.
+	 * Doesn't destroy the handlers in its route table.
+	 */
+	virtual ~AsyncRouteDispatcher();
+
+	/**
+	 * The function checking whether a handler for the uri of the given request was registered.
+	 *
+	 * @param request	The request to check.
+	 * @return	True if this dispatcher can handle the given request.
+	 */
+	virtual bool canHandle(AsyncWebServerRequest *request) override;
+
+	/**
+	 * Passes the given request to the handler registered for its uri.
+	 *
+	 * @param request	The request to handle.
+	 */
+	virtual void handleRequest(AsyncWebServerRequest *request) override;
+
+	/**
+	 * Checks whether this request handler is trivial, meaning post requests don't need to be parsed.
+	 *
+	 * @return	True if this handler is trivial.
+	 */
+	virtual bool isRequestHandlerTrivial() override;
+};
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_ASYNCROUTEDISPATCHER_H_ */
@@ -10,19 +10,55 @@
 
 #include "AsyncTrackingFallbackWebHandler.h"
 #if ENABLE_WEB_SERVER == 1
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_PUSH == 1
-#include "prometheus.h"
-#endif
 #include <utils.h>
 #include <fallback_log.h>
 #ifdef ESP8266
 #include <fallback_timer.h>
 #endif
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+constexpr size_t web::RequestCounters::METHODS;
+constexpr size_t web::RequestCounters::STATUS_CLASSES;
+
+web::RequestCounters::RequestCounters() {
+	for (size_t method = 0; method < METHODS; method++) {
+		for (size_t status_class = 0; status_class < STATUS_CLASSES;
+				status_class++) {
+			_counts[method][status_class] = 0;
+		}
+	}
+}
+
+void web::RequestCounters::increment(const WebRequestMethod method,
+		const uint16_t status) {
+	size_t status_class = status / 100;
+	if (status_class < 1 || status_class > STATUS_CLASSES) {
+		status_class = STATUS_CLASSES;
+	}
+	const size_t method_idx = utils::get_msb(method);
+	if (method_idx < METHODS) {
+		_counts[method_idx][status_class - 1] += 1;
+	}
+}
+
+void web::RequestCounters::snapshot(Snapshot &snapshot) const {
+	for (size_t method = 0; method < METHODS; method++) {
+		for (size_t status_class = 0; status_class < STATUS_CLASSES;
+				status_class++) {
+			snapshot.counts[method][status_class] =
+					_counts[method][status_class];
+		}
+	}
+}
+#endif
+
 web::AsyncTrackingFallbackWebHandler::AsyncTrackingFallbackWebHandler(
 		const String &uri, HTTPFallbackRequestHandler fallback) :
 		_uri(uri), _fallbackHandler(fallback), _handlers(
 				utils::get_msb(HTTP_ANY) + 1) {
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	_durations.resize(_handlers.size());
+#endif
 
 }
 
@@ -36,10 +72,16 @@ web::HTTPRequestHandler web::AsyncTrackingFallbackWebHandler::_getHandler(
 }
 
 void web::AsyncTrackingFallbackWebHandler::setHandler(
-		const WebRequestMethodComposite methods, HTTPRequestHandler handler) {
+		const WebRequestMethodComposite methods, HTTPRequestHandler handler,
+		const bool record_durations) {
 	for (size_t i = 0; i < _handlers.size(); i++) {
 		if (methods & (1 << i)) {
 			_handlers[i] = handler;
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+			if (record_durations && !_durations[i]) {
+				_durations[i].reset(new RequestDurations());
+			}
+#endif
 		}
 	}
 }
@@ -58,12 +100,32 @@ WebRequestMethodComposite web::AsyncTrackingFallbackWebHandler::getHandledMethod
 	return methods;
 }
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+const web::RequestCounters& web::AsyncTrackingFallbackWebHandler::getCounters() const {
+	return _counters;
+}
+#endif
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+const web::RequestDurations* web::AsyncTrackingFallbackWebHandler::getDurations(
+		const WebRequestMethod method) const {
+	return _durations[utils::get_msb((WebRequestMethodComposite) method)].get();
+}
+
+const web::RequestDurations& web::AsyncTrackingFallbackWebHandler::getFallbackDurations() const {
+	return _fallbackDurations;
+}
+#endif
+
 bool web::AsyncTrackingFallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
 	if (!_uri.length()) {
 		return false;
 	}
 
-	if (_uri == request->url() || request->url().startsWith(_uri + '/')) {
+	const String &url = request->url();
+	if (url == _uri
+			|| (url.length() > _uri.length() && url.startsWith(_uri)
+					&& url[_uri.length()] == '/')) {
 		request->addInterestingHeader("ANY");
 		return true;
 	}
@@ -85,13 +147,24 @@ void web::AsyncTrackingFallbackWebHandler::handleRequest(AsyncWebServerRequest *
 				"The handler for uri \"%s\" didn't have a handler for request type %s, and didn't have a fallback handler.",
 				_uri.c_str(), request->methodToString());
 	}
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-	prom::http_requests_total[request->url()][ {
-			(WebRequestMethod) request->method(), response.status_code }]++;
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	_counters.increment((WebRequestMethod) request->method(),
+			response.status_code);
 #endif
 	const uint64_t mid = (uint64_t) esp_timer_get_time();
 	request->send(response.response);
 	const uint64_t end = (uint64_t) esp_timer_get_time();
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	RequestDurations *durations = NULL;
+	if (handler) {
+		durations = _durations[utils::get_msb(request->method())].get();
+	}
+	if (!durations) {
+		durations = &_fallbackDurations;
+	}
+	durations->handler.record(mid - start);
+	durations->send.record(end - mid);
+#endif
 	log_d("Handling a request to \"%s\" took %lluus + %lluus.",
 			request->url().c_str(), (mid - start), (end - mid));
 }
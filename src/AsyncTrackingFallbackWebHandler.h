@@ -14,8 +14,112 @@
 #include "config.h"
 #if ENABLE_WEB_SERVER == 1
 #include "webhandler.h"
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <task_shared.h>
+#endif
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+#include <histogram.h>
+#include <memory>
+#endif
 
 namespace web {
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * A fixed size table counting the requests for a single path, by request method and response status class.
+ *
+ * Incrementing a counter is a single lock-free atomic increment, so it can be done from the async tcp task,
+ * while the metrics are generated on another task.
+ * The counters are 32 bit, and wrap around on overflow, which prometheus handles like a counter reset.
+ */
+class RequestCounters {
+public:
+	/**
+	 * The number of request methods, one for each bit in HTTP_ANY.
+	 */
+	static constexpr size_t METHODS = 7;
+
+	/**
+	 * The number of response status classes, 1xx to 5xx.
+	 */
+	static constexpr size_t STATUS_CLASSES = 5;
+
+	/**
+	 * A copy of all counters of a table, taken at one point in time.
+	 */
+	struct Snapshot {
+		/**
+		 * The copied counters, indexed by the index of the method bit and the status class minus one.
+		 */
+		uint32_t counts[METHODS][STATUS_CLASSES];
+	};
+
+	/**
+	 * Creates a new counter table with all counters set to zero.
+	 */
+	RequestCounters();
+
+	/**
+	 * Increments the counter for the given request method and response status code.
+	 * Status codes outside of the 1xx to 5xx range are counted as 5xx.
+	 *
+	 * @param method	The method of the handled request.
+	 * @param status	The status code of the response.
+	 */
+	void increment(const WebRequestMethod method, const uint16_t status);
+
+	/**
+	 * Copies all counters to the given snapshot.
+	 * Each counter is read atomically, so no copied value is torn or decreasing,
+	 * and the snapshot can't change while it is formatted.
+	 *
+	 * @param snapshot	The snapshot to write the counters to.
+	 */
+	void snapshot(Snapshot &snapshot) const;
+
+private:
+	/**
+	 * The counters, indexed by the index of the method bit and the status class minus one.
+	 */
+	utils::counter_t _counts[METHODS][STATUS_CLASSES];
+};
+#endif
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+/**
+ * The upper bounds of the request duration histogram buckets, in microseconds.
+ */
+static constexpr uint32_t REQUEST_DURATION_BOUNDS[] = { 100, 250, 500, 1000,
+		2500, 5000, 10000, 25000, 50000, 100000, 250000 };
+
+/**
+ * The histogram type used to record request durations in microseconds.
+ */
+typedef utils::Histogram<
+		sizeof(REQUEST_DURATION_BOUNDS) / sizeof(REQUEST_DURATION_BOUNDS[0])> RequestDurationHistogram;
+
+/**
+ * The durations of the requests handled for a single path and request method.
+ */
+struct RequestDurations {
+	/**
+	 * The time spent in the request handler, creating the response.
+	 */
+	RequestDurationHistogram handler;
+
+	/**
+	 * The time spent passing the response to the web server, which starts sending it.
+	 */
+	RequestDurationHistogram send;
+
+	/**
+	 * Creates two empty request duration histograms.
+	 */
+	RequestDurations() :
+			handler(REQUEST_DURATION_BOUNDS), send(REQUEST_DURATION_BOUNDS) {
+	}
+};
+#endif
+
 /**
  * A web handler that can handle multiple request methods.
  * Also has a fallback for request types without a set handler.
@@ -44,6 +148,26 @@ protected:
 	 */
 	std::vector<HTTPRequestHandler> _handlers;
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	/**
+	 * The number of requests handled for this uri, by method and status class.
+	 */
+	RequestCounters _counters;
+#endif
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	/**
+	 * The request durations for each request method with a set handler.
+	 * Allocated when setting a handler, so recording a request never allocates memory.
+	 */
+	std::vector<std::unique_ptr<RequestDurations>> _durations;
+
+	/**
+	 * The request durations for all requests handled by the fallback handler.
+	 */
+	RequestDurations _fallbackDurations;
+#endif
+
 	/**
 	 * Gets the request handler for a given request method.
 	 * Returns an empty function object if no handler was set for the given method.
@@ -72,10 +196,13 @@ public:
 	 * Sets the handler to be used for the given request methods.
 	 * Replaces the current handler, if one was already set.
 	 *
-	 * @param methods	The methods for which to use the given handler.
-	 * @param handler	The request handler to use for the given methods.
+	 * @param methods			The methods for which to use the given handler.
+	 * @param handler			The request handler to use for the given methods.
+	 * @param record_durations	Whether to allocate separate request duration histograms for these methods.
+	 * 							If false, their durations are recorded in the fallback histograms.
 	 */
-	virtual void setHandler(const WebRequestMethodComposite methods, HTTPRequestHandler handler);
+	virtual void setHandler(const WebRequestMethodComposite methods,
+			HTTPRequestHandler handler, const bool record_durations = true);
 
 	/**
 	 * Sets the handler to be used for request methods for which no handler was set.
@@ -91,6 +218,34 @@ public:
 	 */
 	virtual WebRequestMethodComposite getHandledMethods() const;
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	/**
+	 * Gets the counters of the requests handled for this uri.
+	 *
+	 * @return	The request counters of this handler.
+	 */
+	virtual const RequestCounters& getCounters() const;
+#endif
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	/**
+	 * Gets the recorded durations of the requests with the given method.
+	 *
+	 * @param method	The HTTP request method to get the durations for.
+	 * @return	The request durations, or NULL if no handler recording durations was set for the method.
+	 */
+	virtual const RequestDurations* getDurations(
+			const WebRequestMethod method) const;
+
+	/**
+	 * Gets the recorded durations of the requests handled by the fallback handler,
+	 * and of those whose handler doesn't record separate durations.
+	 *
+	 * @return	The fallback request durations.
+	 */
+	virtual const RequestDurations& getFallbackDurations() const;
+#endif
+
 	/**
 	 * The function checking whether this handler can handle the given request.
 	 *
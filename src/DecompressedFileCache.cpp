@@ -0,0 +1,142 @@
+/*
+ * DecompressedFileCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "DecompressedFileCache.h"
+#if ENABLE_WEB_SERVER == 1
+#include "webhandler.h"
+#include <uzlib_gzip_wrapper.h>
+#include <fallback_log.h>
+
+web::DecompressedFileCache::DecompressedFileCache(const size_t budget) :
+		_budget(budget) {
+
+}
+
+uint8_t* web::DecompressedFileCache::_allocate(const size_t size) {
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+	if (psramFound()) {
+		return (uint8_t*) ps_malloc(size);
+	}
+#endif
+	return (uint8_t*) malloc(size);
+}
+
+size_t web::DecompressedFileCache::_getFreeMemory() {
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+	if (psramFound()) {
+		return ESP.getFreePsram();
+	}
+#endif
+	return ESP.getFreeHeap();
+}
+
+void web::DecompressedFileCache::_evictLast() {
+	_size -= _entries.back().size;
+	_entries.pop_back();
+	_evictions++;
+}
+
+std::shared_ptr<const uint8_t> web::DecompressedFileCache::get(
+		const uint8_t *start, const uint8_t *end, size_t &size, bool &no_dict) {
+	no_dict = false;
+	// Check the uncompressed size from the gzip trailer, before acquiring a decompression dict.
+	uint32_t dlen = 0;
+	if (end - start >= 29) {
+		dlen = end[-4] | (end[-3] << 8) | (end[-2] << 16)
+				| ((uint32_t) end[-1] << 24);
+	}
+
+	{
+		LOCK_TASK_MUTEX(_mutex);
+		for (std::list<Entry>::iterator it = _entries.begin();
+				it != _entries.end(); it++) {
+			if (it->key == start) {
+				_hits++;
+				_entries.splice(_entries.begin(), _entries, it);
+				size = it->size;
+				return it->data;
+			}
+		}
+
+		if (dlen == 0 || dlen > _budget) {
+			_misses++;
+			return std::shared_ptr<const uint8_t>();
+		}
+	}
+
+	gzip::uzlib_ungzip_wrapper decomp(start, end, GZIP_DECOMP_WINDOW_SIZE,
+			&decomp_dict_pool);
+	if (!decomp.hasDict()) {
+		// Streaming the file would require a dict too, so the request fails either way.
+		no_dict = true;
+		return std::shared_ptr<const uint8_t>();
+	}
+
+	{
+		LOCK_TASK_MUTEX(_mutex);
+		_misses++;
+	}
+
+	uint8_t *buffer = _allocate(dlen);
+	if (!buffer) {
+		log_w("Failed to allocate %u bytes for decompressed file cache.",
+				(unsigned int) dlen);
+		return std::shared_ptr<const uint8_t>();
+	}
+
+	if (decomp.decompress(buffer, dlen) != dlen || !decomp.done()) {
+		log_e("Failed to decompress file for cache.");
+		free(buffer);
+		return std::shared_ptr<const uint8_t>();
+	}
+
+	std::shared_ptr<const uint8_t> data(buffer, free);
+	size = dlen;
+
+	LOCK_TASK_MUTEX(_mutex);
+	// Another request may have cached the same file in the meantime.
+	for (const Entry &entry : _entries) {
+		if (entry.key == start) {
+			return data;
+		}
+	}
+
+	while (_size + dlen > _budget && !_entries.empty()) {
+		_evictLast();
+	}
+	_entries.push_front(Entry { start, data, dlen });
+	_size += dlen;
+	return data;
+}
+
+void web::DecompressedFileCache::trim(const size_t min_free_heap) {
+	LOCK_TASK_MUTEX(_mutex);
+	while (!_entries.empty() && _getFreeMemory() < min_free_heap) {
+		log_i("Low free memory, evicting decompressed file from cache.");
+		_evictLast();
+	}
+}
+
+uint64_t web::DecompressedFileCache::getHits() const {
+	return _hits;
+}
+
+uint64_t web::DecompressedFileCache::getMisses() const {
+	return _misses;
+}
+
+uint64_t web::DecompressedFileCache::getEvictions() const {
+	return _evictions;
+}
+
+size_t web::DecompressedFileCache::getSize() const {
+	return _size;
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
@@ -0,0 +1,177 @@
+/*
+ * DecompressedFileCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_DECOMPRESSEDFILECACHE_H_
+#define SRC_DECOMPRESSEDFILECACHE_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include <list>
+#include <memory>
+#include <task_shared.h>
+
+namespace web {
+/**
+ * A least recently used cache for decompressed static files.
+ * Used to avoid inflating the same gzip compressed file again for every client that doesn't accept gzip.
+ *
+ * The cached files are identified by the pointer to the start of their compressed version.
+ * Cached files are stored in PSRAM, if available.
+ *
+ * Returned buffers stay valid until the last reference to them is dropped,
+ * even if they were evicted from the cache in the meantime.
+ */
+class DecompressedFileCache {
+private:
+	/**
+	 * A single decompressed file in the cache.
+	 */
+	struct Entry {
+		/**
+		 * A pointer to the first byte of the compressed file this is the decompressed version of.
+		 */
+		const uint8_t *key;
+
+		/**
+		 * The buffer containing the decompressed file.
+		 */
+		std::shared_ptr<const uint8_t> data;
+
+		/**
+		 * The size of the decompressed file, in bytes.
+		 */
+		size_t size;
+	};
+
+	/**
+	 * The max number of bytes of decompressed files to keep in the cache.
+	 */
+	const size_t _budget;
+
+	/**
+	 * The cached files, with the most recently used file at the front.
+	 */
+	std::list<Entry> _entries;
+
+	/**
+	 * The total size of all cached files, in bytes.
+	 */
+	size_t _size = 0;
+
+	/**
+	 * The number of requests that could be answered from the cache.
+	 */
+	uint64_t _hits = 0;
+
+	/**
+	 * The number of requests for a file that wasn't in the cache.
+	 */
+	uint64_t _misses = 0;
+
+	/**
+	 * The number of files removed from the cache, to make space or because of low free heap.
+	 */
+	uint64_t _evictions = 0;
+
+	/**
+	 * The mutex protecting the cache, since requests are handled on the async tcp task.
+	 */
+	utils::task_mutex _mutex;
+
+	/**
+	 * Removes the least recently used file from the cache.
+	 * The caller has to hold the mutex.
+	 */
+	void _evictLast();
+
+	/**
+	 * Allocates a buffer for a decompressed file.
+	 * Uses PSRAM if available, and the regular heap otherwise.
+	 *
+	 * @param size	The number of bytes to allocate.
+	 * @return	The allocated buffer, or NULL if the allocation failed.
+	 */
+	static uint8_t* _allocate(const size_t size);
+
+	/**
+	 * Gets the number of free bytes in the memory the cached files are allocated in.
+	 * This is the free PSRAM if available, and the free heap otherwise.
+	 *
+	 * @return	The number of free bytes.
+	 */
+	static size_t _getFreeMemory();
+
+public:
+	/**
+	 * Creates a new decompressed file cache.
+	 *
+	 * @param budget	The max number of bytes of decompressed files to keep in the cache.
+	 * 					A budget of 0 disables the cache.
+	 */
+	DecompressedFileCache(const size_t budget);
+
+	/**
+	 * Gets the decompressed version of the given gzip compressed file.
+	 * Decompresses and caches the file, if it isn't cached yet.
+	 *
+	 * Files larger than the cache budget aren't cached.
+	 * Returns an empty pointer in that case, or if decompression failed.
+	 *
+	 * @param start		A pointer to the first byte of the compressed file.
+	 * @param end		A pointer to the first byte after the compressed file.
+	 * @param size		A reference to write the decompressed size to.
+	 * @param no_dict	Set to true if the file wasn't cached, and there was no free decompression dict.
+	 * 					Such requests aren't counted as cache misses.
+	 * @return	The decompressed file, or an empty pointer.
+	 */
+	std::shared_ptr<const uint8_t> get(const uint8_t *start, const uint8_t *end,
+			size_t &size, bool &no_dict);
+
+	/**
+	 * Removes the least recently used files from the cache,
+	 * until the free memory is at least the given number of bytes, or the cache is empty.
+	 * If the files are stored in PSRAM, the free PSRAM is checked, since evicting them doesn't free any heap.
+	 *
+	 * @param min_free_heap	The min number of free bytes.
+	 */
+	void trim(const size_t min_free_heap);
+
+	/**
+	 * Gets the number of requests that could be answered from the cache.
+	 *
+	 * @return	The number of cache hits.
+	 */
+	uint64_t getHits() const;
+
+	/**
+	 * Gets the number of requests for a file that wasn't in the cache.
+	 *
+	 * @return	The number of cache misses.
+	 */
+	uint64_t getMisses() const;
+
+	/**
+	 * Gets the number of files removed from the cache.
+	 *
+	 * @return	The number of cache evictions.
+	 */
+	uint64_t getEvictions() const;
+
+	/**
+	 * Gets the total size of all cached files.
+	 *
+	 * @return	The current cache size, in bytes.
+	 */
+	size_t getSize() const;
+};
+}
+
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_DECOMPRESSEDFILECACHE_H_ */
@@ -0,0 +1,138 @@
+/*
+ * MeasurementBacklog.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "MeasurementBacklog.h"
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+
+sensors::MeasurementBacklog::MeasurementBacklog() :
+		_uses(0) {
+	for (size_t i = 0; i < MEASUREMENT_BACKLOG_CONSUMERS; i++) {
+		_consumers[i] = { 0, 0, 0, 0, 0, 0, -1 };
+	}
+}
+
+bool sensors::MeasurementBacklog::record(const BacklogEntry &entry) {
+	LOCK_TASK_MUTEX(_mutex);
+	if (!_entries.empty() && _entries.back().time >= entry.time) {
+		return false;
+	}
+	_entries.push(entry);
+	return true;
+}
+
+uint32_t sensors::MeasurementBacklog::begin() {
+	LOCK_TASK_MUTEX(_mutex);
+	return _entries.begin();
+}
+
+uint32_t sensors::MeasurementBacklog::end() {
+	LOCK_TASK_MUTEX(_mutex);
+	return _entries.end();
+}
+
+bool sensors::MeasurementBacklog::get(const uint32_t seq, BacklogEntry &entry) {
+	LOCK_TASK_MUTEX(_mutex);
+	if (seq < _entries.begin() || seq >= _entries.end()) {
+		return false;
+	}
+	entry = _entries.get(seq);
+	return true;
+}
+
+uint32_t sensors::MeasurementBacklog::getReceived(const uint32_t consumer,
+		const bool humidity, int64_t &exported) {
+	LOCK_TASK_MUTEX(_mutex);
+	BacklogConsumer *position = getConsumer(consumer, true);
+	position->last_use = ++_uses;
+	exported = position->exported;
+	const uint32_t received =
+			humidity ? position->humidity : position->temperature;
+	return received > _entries.begin() ? received : _entries.begin();
+}
+
+void sensors::MeasurementBacklog::setReceived(const uint32_t consumer,
+		const bool humidity, const uint32_t end, const int64_t time) {
+	LOCK_TASK_MUTEX(_mutex);
+	BacklogConsumer *position = getConsumer(consumer, false);
+	if (!position) {
+		return;
+	}
+
+	uint32_t &received = humidity ? position->humidity : position->temperature;
+	if (end > received) {
+		received = end;
+	}
+	if (time > position->exported) {
+		position->exported = time;
+	}
+}
+
+void sensors::MeasurementBacklog::setPending(const uint32_t consumer,
+		const bool humidity, const uint32_t end) {
+	LOCK_TASK_MUTEX(_mutex);
+	BacklogConsumer *position = getConsumer(consumer, false);
+	if (position) {
+		(humidity ? position->pending_humidity : position->pending_temperature) =
+				end;
+	}
+}
+
+void sensors::MeasurementBacklog::confirmPending(const uint32_t consumer) {
+	LOCK_TASK_MUTEX(_mutex);
+	BacklogConsumer *position = getConsumer(consumer, false);
+	if (!position) {
+		return;
+	}
+
+	if (position->pending_temperature > position->temperature) {
+		position->temperature = position->pending_temperature;
+	}
+	if (position->pending_humidity > position->humidity) {
+		position->humidity = position->pending_humidity;
+	}
+}
+
+bool sensors::MeasurementBacklog::isMissed(const int64_t since) {
+	LOCK_TASK_MUTEX(_mutex);
+	bool known = false;
+	for (size_t i = 0; i < MEASUREMENT_BACKLOG_CONSUMERS; i++) {
+		if (_consumers[i].id == 0) {
+			continue;
+		}
+
+		known = true;
+		if (_consumers[i].exported < since) {
+			return true;
+		}
+	}
+	// Measurements made before the first consumer connected are missed by it.
+	return !known;
+}
+
+sensors::BacklogConsumer* sensors::MeasurementBacklog::getConsumer(
+		const uint32_t consumer, const bool add) {
+	BacklogConsumer *oldest = &_consumers[0];
+	for (size_t i = 0; i < MEASUREMENT_BACKLOG_CONSUMERS; i++) {
+		if (_consumers[i].id == consumer) {
+			return &_consumers[i];
+		} else if (_consumers[i].last_use < oldest->last_use) {
+			oldest = &_consumers[i];
+		}
+	}
+
+	if (!add) {
+		return NULL;
+	}
+
+	// The positions are checked against the start of the backlog when they are used.
+	*oldest = { consumer, 0, 0, 0, 0, 0, -1 };
+	return oldest;
+}
+#endif /* ENABLE_MEASUREMENT_BACKLOG == 1 */
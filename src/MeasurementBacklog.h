@@ -0,0 +1,216 @@
+/*
+ * MeasurementBacklog.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_MEASUREMENTBACKLOG_H_
+#define SRC_MEASUREMENTBACKLOG_H_
+
+#include "config.h"
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+#include <ring_buffer.h>
+#include <task_shared.h>
+
+namespace sensors {
+/**
+ * A single measurement kept in the backlog.
+ */
+struct BacklogEntry {
+	/**
+	 * The time the measurement was made, in milliseconds since the boot.
+	 */
+	int64_t time;
+
+	/**
+	 * The measured temperature, or NAN.
+	 */
+	float temperature;
+
+	/**
+	 * The measured humidity, or NAN.
+	 */
+	float humidity;
+};
+
+/**
+ * The position of a single receiver of the metrics in the backlog.
+ */
+struct BacklogConsumer {
+	/**
+	 * The identifier of the consumer, or zero if this slot is unused.
+	 */
+	uint32_t id;
+
+	/**
+	 * The value of the use counter of the backlog when this consumer last got measurements.
+	 */
+	uint32_t last_use;
+
+	/**
+	 * The sequence number of the first measurement whose temperature the consumer didn't get yet.
+	 */
+	uint32_t temperature;
+
+	/**
+	 * The sequence number of the first measurement whose humidity the consumer didn't get yet.
+	 */
+	uint32_t humidity;
+
+	/**
+	 * The sequence number after the last temperature sent to the consumer, which it didn't accept yet.
+	 */
+	uint32_t pending_temperature;
+
+	/**
+	 * The sequence number after the last humidity sent to the consumer, which it didn't accept yet.
+	 */
+	uint32_t pending_humidity;
+
+	/**
+	 * The time of the newest measurement the consumer got with a timestamp, in milliseconds since the boot.
+	 * -1 if it didn't get one yet.
+	 */
+	int64_t exported;
+};
+
+/**
+ * A fixed size backlog of measurements that weren't sent anywhere yet.
+ *
+ * Measurements are stored with the time since the boot, since the clock may not be synchronized yet when they are made.
+ * They are converted to unix timestamps when they are written, using the offset of the synchronized clock.
+ *
+ * Each consumer, like a scraper or a remote write receiver, keeps its own position in the backlog.
+ * So one of them getting the measurements doesn't remove them for the others.
+ */
+class MeasurementBacklog {
+private:
+	/**
+	 * The kept measurements, oldest first.
+	 */
+	utils::RingBuffer<BacklogEntry, MEASUREMENT_BACKLOG_SIZE> _entries;
+
+	/**
+	 * The positions of the known consumers.
+	 */
+	BacklogConsumer _consumers[MEASUREMENT_BACKLOG_CONSUMERS];
+
+	/**
+	 * A counter incremented each time a consumer gets measurements, to find the least recently used consumer.
+	 */
+	uint32_t _uses;
+
+	/**
+	 * The mutex protecting the entries, since the metrics are written on the async tcp task.
+	 */
+	utils::task_mutex _mutex;
+	/**
+	 * Gets the position of the consumer with the given id.
+	 * Has to be called with the mutex locked.
+	 *
+	 * @param consumer	The id of the consumer.
+	 * @param add		Whether to replace the least recently used consumer, if the consumer isn't known.
+	 * @return	The position of the consumer, or NULL if it isn't known and wasn't added.
+	 */
+	BacklogConsumer* getConsumer(const uint32_t consumer, const bool add);
+
+public:
+	/**
+	 * Creates a new empty backlog without any known consumers.
+	 */
+	MeasurementBacklog();
+
+	/**
+	 * Adds a measurement to the backlog, overwriting the oldest one if it is full.
+	 * Measurements that aren't newer than the newest kept measurement are ignored.
+	 *
+	 * @param entry	The measurement to add.
+	 * @return	True if the measurement was added.
+	 */
+	bool record(const BacklogEntry &entry);
+
+	/**
+	 * Gets the sequence number of the oldest kept measurement.
+	 *
+	 * @return	The sequence number of the oldest measurement.
+	 */
+	uint32_t begin();
+
+	/**
+	 * Gets the sequence number the next recorded measurement will get.
+	 *
+	 * @return	The sequence number after the newest measurement.
+	 */
+	uint32_t end();
+
+	/**
+	 * Copies the measurement with the given sequence number.
+	 *
+	 * @param seq	The sequence number of the measurement.
+	 * @param entry	The entry to copy the measurement to.
+	 * @return	False if the measurement wasn't recorded yet, or was already overwritten.
+	 */
+	bool get(const uint32_t seq, BacklogEntry &entry);
+
+	/**
+	 * Gets the sequence number of the first measurement the given consumer didn't get yet.
+	 * Unknown consumers replace the least recently used one, and didn't get any of the kept measurements yet.
+	 *
+	 * @param consumer	The id of the consumer. Has to be non-zero.
+	 * @param humidity	True to get the position for the humidity, false for the temperature.
+	 * @param exported	Set to the time of the newest measurement the consumer got with a timestamp,
+	 * 					in milliseconds since the boot, or -1.
+	 * @return	The sequence number of the first measurement the consumer didn't get.
+	 */
+	uint32_t getReceived(const uint32_t consumer, const bool humidity,
+			int64_t &exported);
+
+	/**
+	 * Marks the measurements before the given sequence number as received by the given consumer.
+	 * Does nothing if the consumer was forgotten in the meantime.
+	 *
+	 * @param consumer	The id of the consumer.
+	 * @param humidity	True to set the position for the humidity, false for the temperature.
+	 * @param end		The sequence number after the last received measurement.
+	 * @param time		The time of the current measurement the consumer got, in milliseconds since the boot.
+	 * 					-1 if it got the current measurement without a timestamp.
+	 */
+	void setReceived(const uint32_t consumer, const bool humidity,
+			const uint32_t end, const int64_t time);
+
+	/**
+	 * Sets the measurements before the given sequence number as sent to the given consumer,
+	 * without marking them as received until the consumer accepted them.
+	 * Does nothing if the consumer was forgotten in the meantime.
+	 *
+	 * @param consumer	The id of the consumer.
+	 * @param humidity	True to set the position for the humidity, false for the temperature.
+	 * @param end		The sequence number after the last sent measurement.
+	 */
+	void setPending(const uint32_t consumer, const bool humidity,
+			const uint32_t end);
+
+	/**
+	 * Marks the measurements last sent to the given consumer as received.
+	 * Does nothing if the consumer was forgotten in the meantime.
+	 *
+	 * @param consumer	The id of the consumer.
+	 */
+	void confirmPending(const uint32_t consumer);
+
+	/**
+	 * Checks whether any known consumer didn't get a measurement made since the given time.
+	 *
+	 * @param since	The time in milliseconds since the boot.
+	 * @return	True if a consumer missed the measurements since then, or if there are no known consumers.
+	 */
+	bool isMissed(const int64_t since);
+};
+} /* namespace sensors */
+
+#endif /* ENABLE_MEASUREMENT_BACKLOG == 1 */
+#endif /* SRC_MEASUREMENTBACKLOG_H_ */
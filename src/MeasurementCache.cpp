@@ -0,0 +1,31 @@
+/*
+ * MeasurementCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "MeasurementCache.h"
+#include "sensor_handler.h"
+
+std::shared_ptr<const std::string> sensors::MeasurementCache::get(
+		const std::function<std::string()> &render) {
+	// Get the generation before rendering, so a measurement finishing in between only causes another render.
+	const uint32_t generation = SENSOR_HANDLER.getGeneration();
+	{
+		LOCK_TASK_MUTEX(_mutex);
+		if (_value && _generation == generation) {
+			return _value;
+		}
+	}
+
+	std::shared_ptr<const std::string> value = std::make_shared<std::string>(
+			render());
+	LOCK_TASK_MUTEX(_mutex);
+	_value = value;
+	_generation = generation;
+	return value;
+}
@@ -0,0 +1,59 @@
+/*
+ * MeasurementCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_MEASUREMENTCACHE_H_
+#define SRC_MEASUREMENTCACHE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <task_shared.h>
+
+namespace sensors {
+/**
+ * A cache for a single string rendered from the sensor measurements.
+ *
+ * The string is rendered again when the measurement generation of the sensor handler changes,
+ * and reused by every request until then.
+ *
+ * Returned strings stay valid until the last reference to them is dropped,
+ * even if the cache was updated in the meantime.
+ */
+class MeasurementCache {
+private:
+	/**
+	 * The cached string, or an empty pointer if nothing was rendered yet.
+	 */
+	std::shared_ptr<const std::string> _value;
+
+	/**
+	 * The measurement generation the cached string was rendered for.
+	 */
+	uint32_t _generation = 0;
+
+	/**
+	 * The mutex protecting the cache, since requests are handled on the async tcp task.
+	 */
+	utils::task_mutex _mutex;
+public:
+	/**
+	 * Gets the cached string, or renders it if the measurement generation changed.
+	 *
+	 * The render function is called without holding the cache lock.
+	 *
+	 * @param render	The function rendering the string from the current measurements.
+	 * @return	The string for the current measurement generation.
+	 */
+	std::shared_ptr<const std::string> get(
+			const std::function<std::string()> &render);
+};
+} /* namespace sensors */
+
+#endif /* SRC_MEASUREMENTCACHE_H_ */
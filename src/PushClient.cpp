@@ -0,0 +1,262 @@
+/*
+ * PushClient.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "PushClient.h"
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#ifdef ESP8266
+#include <fallback_timer.h>
+#endif
+#include <strings.h>
+#include <fallback_log.h>
+
+prom::PushClient::PushClient(const char *name, const char *host,
+		const uint16_t port, const uint32_t interval,
+		const uint32_t min_backoff, const uint32_t max_backoff) :
+		_name(name), _host(host), _port(port), _interval(interval), _min_backoff(
+				min_backoff), _max_backoff(max_backoff), _client(NULL), _in_flight(
+				false), _body_written(false), _start(0), _next(0), _backoff(
+				min_backoff), _retry_after(0), _successes(0), _failures(0) {
+	_parser.setHeaderCallback(handleRetryAfterHeader, &_retry_after);
+}
+
+prom::PushClient::~PushClient() {
+	{
+		// The request hooks of the subclass can't be called anymore, so the disconnect callback has to do nothing.
+		LOCK_TASK_MUTEX(_mutex);
+		_in_flight = false;
+	}
+	close();
+}
+
+void prom::PushClient::loop() {
+	AsyncClient *timed_out = NULL;
+	{
+		LOCK_TASK_MUTEX(_mutex);
+		if (_client && !_client->connected() && !_client->connecting()) {
+			// Closed clients are deleted here, since deleting them in their own callbacks isn't safe.
+			delete _client;
+			_client = NULL;
+		}
+
+		const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+		if (_in_flight) {
+			if (now - _start >= _interval / 4 * 3) {
+				log_e("The %s didn't respond in time.", _name);
+				finish(false, false, 0);
+				timed_out = _client;
+			}
+		} else if (now >= _next) {
+			if (!prepareRequest()) {
+				_next = now + 1000;
+			} else {
+				_in_flight = true;
+				_start = now;
+				if (_client) {
+					// Reuse the connection of the last request.
+					sendRequest(_client);
+				} else {
+					connect();
+				}
+			}
+		}
+	}
+
+	// The request was already finished, so the disconnect callback won't do anything.
+	if (timed_out) {
+		closeClient(timed_out);
+	}
+}
+
+bool prom::PushClient::isInFlight() {
+	LOCK_TASK_MUTEX(_mutex);
+	return _in_flight;
+}
+
+void prom::PushClient::close() {
+	// Only loop and close modify the client, and both run on the main task.
+	if (_client) {
+		closeClient(_client);
+		delete _client;
+		_client = NULL;
+	}
+}
+
+uint32_t prom::PushClient::getSuccesses() const {
+	return _successes;
+}
+
+uint32_t prom::PushClient::getFailures() const {
+	return _failures;
+}
+
+void prom::PushClient::connect() {
+	_client = new AsyncClient();
+	if (!_client) {
+		log_e("Failed to allocate Async TCP Client!");
+		finish(false, false, 0);
+		return;
+	}
+
+	// The ack timeout is in milliseconds.
+	_client->setAckTimeout(_interval / 4 * 3);
+	_client->onError([](void *arg, AsyncClient *cli, int error) {
+		PushClient *push_client = (PushClient*) arg;
+		bool close = false;
+		{
+			LOCK_TASK_MUTEX(push_client->_mutex);
+			log_e("Connection to the %s failed with error %d!", push_client->_name, error);
+			if (push_client->_in_flight) {
+				close = push_client->finish(false, false, 0);
+			}
+		}
+
+		if (close) {
+			closeClient(cli);
+		}
+	}, this);
+
+	_client->onDisconnect([](void *arg, AsyncClient *cli) {
+		PushClient *push_client = (PushClient*) arg;
+		LOCK_TASK_MUTEX(push_client->_mutex);
+		// The server may close an idle connection at any time.
+		if (push_client->_in_flight) {
+			// A response without a length ends when the connection is closed.
+			if (push_client->_parser.finish()) {
+				push_client->handleResponse(false);
+			} else {
+				log_e("Connection to the %s was closed while reading or writing.", push_client->_name);
+				push_client->finish(false, false, 0);
+			}
+		}
+	}, this);
+
+	_client->onData([](void *arg, AsyncClient *cli, void *data, size_t len) {
+		PushClient *push_client = (PushClient*) arg;
+		bool close = false;
+		{
+			LOCK_TASK_MUTEX(push_client->_mutex);
+			if (!push_client->_in_flight) {
+				log_w("Received %u unexpected bytes from the %s.", (unsigned int) len, push_client->_name);
+				close = true;
+			} else {
+				const size_t parsed = push_client->_parser.parse((const uint8_t*) data, len);
+				if (push_client->_parser.failed()) {
+					log_e("Received an invalid response from the %s.", push_client->_name);
+					close = push_client->finish(false, false, 0);
+				} else if (push_client->_parser.done()) {
+					if (parsed < len) {
+						log_w("Received %u unexpected bytes after the response from the %s.",
+								(unsigned int) (len - parsed), push_client->_name);
+					}
+					// The next response can't be parsed correctly after unexpected data.
+					close = push_client->handleResponse(parsed == len);
+				}
+			}
+		}
+
+		if (close) {
+			closeClient(cli);
+		}
+	}, this);
+
+	// Write the rest of the body whenever the server acknowledged some of it.
+	_client->onAck([](void *arg, AsyncClient *cli, size_t len, uint32_t time) {
+		PushClient *push_client = (PushClient*) arg;
+		LOCK_TASK_MUTEX(push_client->_mutex);
+		if (push_client->_in_flight && !push_client->_body_written) {
+			push_client->_body_written = push_client->writeRequestBody(cli);
+			cli->send();
+		}
+	}, this);
+
+	_client->onConnect([](void *arg, AsyncClient *cli) {
+		PushClient *push_client = (PushClient*) arg;
+		LOCK_TASK_MUTEX(push_client->_mutex);
+		if (push_client->_in_flight) {
+			push_client->sendRequest(cli);
+		}
+	}, this);
+
+	if (!_client->connect(_host, _port)) {
+		log_e("Connecting to the %s failed!", _name);
+		if (_in_flight) {
+			finish(false, false, 0);
+		}
+	}
+}
+
+void prom::PushClient::sendRequest(AsyncClient *client) {
+	_parser.reset();
+	_retry_after = 0;
+	// The request head and the start of the body are sent in a single segment.
+	writeRequestHead(client);
+	_body_written = writeRequestBody(client);
+	client->send();
+}
+
+bool prom::PushClient::handleResponse(const bool reusable) {
+	const uint16_t status_code = _parser.getStatusCode();
+	const bool keep_alive = reusable && _parser.isKeepAlive();
+	const bool success = status_code >= 200 && status_code < 300;
+	if (!success) {
+		log_w("Received http status code %u from the %s.",
+				(unsigned int) status_code, _name);
+	}
+	return finish(success, keep_alive, status_code);
+}
+
+bool prom::PushClient::finish(const bool success, const bool keep_alive,
+		const uint16_t status_code) {
+	_in_flight = false;
+	const bool next_now = finishRequest(success, status_code);
+
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	if (success) {
+		_successes++;
+		_next = next_now ? now : _start + _interval;
+		_backoff = _min_backoff;
+	} else {
+		_failures++;
+		// Retry-After is limited to the max backoff, so a misconfigured server can't stop requests for days.
+		const uint32_t delay = max(_backoff, min(_retry_after, _max_backoff));
+		log_i("Retrying request to the %s in %ums.", _name, (unsigned int) delay);
+		_next = now + delay;
+		_backoff = min(_backoff * 2, _max_backoff);
+	}
+
+	// If the request body wasn't sent completely, the rest would be interpreted as the next request.
+	return !keep_alive || !_body_written;
+}
+
+void prom::PushClient::closeClient(AsyncClient *client) {
+	if (client->connected() || client->connecting()) {
+		client->close(true);
+	}
+}
+
+void prom::PushClient::handleRetryAfterHeader(void *arg, const char *name,
+		const size_t name_len, const char *value, const size_t value_len) {
+	if (name_len != 11 || strncasecmp(name, "Retry-After", name_len) != 0
+			|| value_len == 0) {
+		return;
+	}
+
+	uint64_t seconds = 0;
+	for (size_t i = 0; i < value_len; i++) {
+		// HTTP dates would require a synchronized clock, so they are ignored.
+		if (value[i] < '0' || value[i] > '9') {
+			return;
+		}
+		seconds = min(seconds * 10 + value[i] - '0',
+				(uint64_t) UINT32_MAX / 1000);
+	}
+	*(uint32_t*) arg = seconds * 1000;
+}
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
@@ -0,0 +1,275 @@
+/*
+ * PushClient.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_PUSHCLIENT_H_
+#define SRC_PUSHCLIENT_H_
+
+#include "config.h"
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#ifdef ESP32
+#include <AsyncTCP.h>
+#elif defined(ESP8266)
+#include <ESPAsyncTCP.h>
+#endif
+#include <response_parser.h>
+#include <task_shared.h>
+
+namespace prom {
+/**
+ * A HTTP client periodically sending a request to a single server, and keeping the connection open between requests.
+ *
+ * Requests are started by loop on the main task, while the responses are handled on the async tcp task.
+ * So the state of the client is protected by a mutex, which is locked while calling any of the request hooks.
+ * Failed requests are retried with an exponentially increasing delay, or the delay requested by the server.
+ */
+class PushClient {
+private:
+	/**
+	 * The name of the server, for log messages.
+	 */
+	const char *_name;
+
+	/**
+	 * The host name or IP address of the server.
+	 */
+	const char *_host;
+
+	/**
+	 * The port of the server.
+	 */
+	const uint16_t _port;
+
+	/**
+	 * The time between two successful requests, in milliseconds.
+	 */
+	const uint32_t _interval;
+
+	/**
+	 * The delay before retrying after the first failed request, in milliseconds.
+	 */
+	const uint32_t _min_backoff;
+
+	/**
+	 * The max delay before retrying after a failed request, in milliseconds.
+	 */
+	const uint32_t _max_backoff;
+
+	/**
+	 * The connection to the server, if there is one.
+	 * Only created and deleted by loop.
+	 */
+	AsyncClient *_client;
+
+	/**
+	 * The parser reading the response to the current request.
+	 */
+	http::ResponseParser _parser;
+
+	/**
+	 * Whether a request was started, and didn't succeed or fail yet.
+	 */
+	bool _in_flight;
+
+	/**
+	 * Whether the whole body of the current request was added to the send buffer.
+	 */
+	bool _body_written;
+
+	/**
+	 * The time the current or last request was started, in milliseconds since the boot.
+	 */
+	uint64_t _start;
+
+	/**
+	 * The earliest time the next request can be started, in milliseconds since the boot.
+	 */
+	uint64_t _next;
+
+	/**
+	 * The time to wait before retrying if the next request fails, in milliseconds.
+	 */
+	uint32_t _backoff;
+
+	/**
+	 * The delay requested by the Retry-After header of the last response, in milliseconds.
+	 * Zero if the response didn't have one.
+	 */
+	uint32_t _retry_after;
+
+	/**
+	 * The number of successful requests since the last boot.
+	 */
+	utils::counter_t _successes;
+
+	/**
+	 * The number of failed requests since the last boot.
+	 */
+	utils::counter_t _failures;
+
+	/**
+	 * The mutex protecting the state of the current request.
+	 */
+	utils::task_mutex _mutex;
+
+public:
+	/**
+	 * Creates a new push client.
+	 * The name and host have to stay valid for as long as the client exists.
+	 *
+	 * @param name			The name of the server, for log messages.
+	 * @param host			The host name or IP address of the server.
+	 * @param port			The port of the server.
+	 * @param interval		The time between two successful requests, in milliseconds.
+	 * 						Requests taking longer than three quarters of it are aborted.
+	 * @param min_backoff	The delay before retrying after the first failed request, in milliseconds.
+	 * @param max_backoff	The max delay before retrying after a failed request, in milliseconds.
+	 * 						Also limits the delay requested by the server.
+	 */
+	PushClient(const char *name, const char *host, const uint16_t port,
+			const uint32_t interval, const uint32_t min_backoff,
+			const uint32_t max_backoff);
+
+	/**
+	 * Closes the connection to the server, if there is one.
+	 */
+	virtual ~PushClient();
+
+	/**
+	 * Starts the next request if it is due, and aborts the current request if it timed out.
+	 * Reuses the connection of the last request if possible, and connects to the server otherwise.
+	 * Has to be called regularly from the main task.
+	 */
+	void loop();
+
+	/**
+	 * Checks whether a request was started, and didn't succeed or fail yet.
+	 *
+	 * @return	Whether there is a request in flight.
+	 */
+	bool isInFlight();
+
+	/**
+	 * Closes and deletes the connection to the server, if there is one.
+	 * Has to be called from the main task, and can't be called from a request hook.
+	 */
+	void close();
+
+	/**
+	 * Gets the number of requests the server accepted since the last boot.
+	 *
+	 * @return	The number of successful requests.
+	 */
+	uint32_t getSuccesses() const;
+
+	/**
+	 * Gets the number of failed requests since the last boot.
+	 *
+	 * @return	The number of failed requests.
+	 */
+	uint32_t getFailures() const;
+
+protected:
+	/**
+	 * Prepares the next request, before it is started.
+	 * Called from loop, so on the main task.
+	 *
+	 * @return	False if there is nothing to send yet. Checked again a second later.
+	 */
+	virtual bool prepareRequest() = 0;
+
+	/**
+	 * Writes the head of the current request to the given client.
+	 * May also reset the state of the request body, since it is called once for each attempt.
+	 *
+	 * @param client	The client to write the request head to.
+	 */
+	virtual void writeRequestHead(AsyncClient *client) = 0;
+
+	/**
+	 * Writes as much of the current request body as fits in the send buffer of the given client.
+	 * Called again whenever the server acknowledged some of the sent data, until it returns true.
+	 *
+	 * @param client	The client to write the request body to.
+	 * @return	True once the whole body was written.
+	 */
+	virtual bool writeRequestBody(AsyncClient *client) = 0;
+
+	/**
+	 * Called when the current request succeeded or failed, before the next request is scheduled.
+	 * Can be called from either task.
+	 *
+	 * @param success		Whether the server accepted the request.
+	 * @param status_code	The status code of the response, or zero if there was none.
+	 * @return	True to start the next request right away, instead of waiting for the interval.
+	 * 			Ignored if the request failed.
+	 */
+	virtual bool finishRequest(const bool success, const uint16_t status_code) = 0;
+
+private:
+	/**
+	 * Creates a new client, and connects it to the server.
+	 * Has to be called with the mutex locked.
+	 */
+	void connect();
+
+	/**
+	 * Sends the current request, using the given connected client.
+	 * Has to be called with the mutex locked.
+	 *
+	 * @param client	The client to send the request with.
+	 */
+	void sendRequest(AsyncClient *client);
+
+	/**
+	 * Handles the complete response to the current request.
+	 * Has to be called with the mutex locked.
+	 *
+	 * @param reusable	False if the connection can't be used for another request, regardless of the response.
+	 * @return	True if the connection has to be closed.
+	 */
+	bool handleResponse(const bool reusable);
+
+	/**
+	 * Finishes the current request, updates the request counters, and schedules the next request.
+	 * Has to be called with the mutex locked.
+	 *
+	 * @param success		Whether the server accepted the request.
+	 * @param keep_alive	Whether the server keeps the connection open for the next request.
+	 * @param status_code	The status code of the response, or zero if there was none.
+	 * @return	True if the connection has to be closed.
+	 */
+	bool finish(const bool success, const bool keep_alive,
+			const uint16_t status_code);
+
+	/**
+	 * Closes the given client, if it is connected.
+	 * Can't be called with the mutex locked, since closing the client calls its disconnect callback.
+	 *
+	 * @param client	The client to close.
+	 */
+	static void closeClient(AsyncClient *client);
+
+	/**
+	 * A response header callback storing the delay requested by a Retry-After header.
+	 * Only Retry-After headers containing a number of seconds are supported.
+	 *
+	 * @param arg		A pointer to the uint32_t to store the delay in milliseconds in.
+	 * @param name		The name of the header.
+	 * @param name_len	The length of the header name.
+	 * @param value		The value of the header.
+	 * @param value_len	The length of the header value.
+	 */
+	static void handleRetryAfterHeader(void *arg, const char *name,
+			const size_t name_len, const char *value, const size_t value_len);
+};
+} /* namespace prom */
+
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
+#endif /* SRC_PUSHCLIENT_H_ */
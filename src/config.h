@@ -111,6 +111,31 @@ static constexpr uint16_t WEB_SERVER_PORT = 80;
 // The range of valid values is -8 to -15.
 // Default is -10.
 static constexpr int8_t GZIP_DECOMP_WINDOW_SIZE = -10;
+// The number of gzip decompression dicts to preallocate at startup.
+// Each dict is pow(2, -GZIP_DECOMP_WINDOW_SIZE) bytes large, and is used by one response at a time.
+// Requests requiring decompression while all dicts are in use get a 503 Service Unavailable response.
+// The max value is 32.
+// Default is 3.
+static constexpr uint8_t GZIP_DECOMP_DICT_POOL_SIZE = 3;
+// The max number of bytes of decompressed static files to keep in RAM, for clients that don't accept gzip.
+// Files are stored in PSRAM instead, if available.
+// Files larger than this are decompressed for each request.
+// Set to 0 to disable the cache.
+// Default is 8192.
+static constexpr size_t DECOMPRESSED_CACHE_SIZE = 8192;
+// The window size parameter used to gzip compress /data.json, for clients accepting gzip.
+// The window size used is pow(2, the absolute of the window size parameter).
+// Compressing a response requires a buffer of twice the window size, but at least window size + 516 bytes,
+// and a hash table of up to 8KiB on the esp.
+// The range of valid values is -8 to -15.
+// Set to 0 to always send the uncompressed json.
+// Default is -8.
+static constexpr int8_t JSON_GZIP_WINDOW_SIZE = -8;
+// The min free heap in bytes.
+// If the free heap drops below this, decompressed static files are removed from the cache.
+// If the files are stored in PSRAM, the free PSRAM is checked instead.
+// Default is 16384.
+static constexpr size_t DECOMPRESSED_CACHE_MIN_FREE_HEAP = 16384;
 // Whether or not a Content-Security-Policy should be sent with html pages.
 // This prevents scripts from other sources from being loaded, but can make debugging and addons harder/less reliable.
 // Set to 0 to disable.
@@ -125,6 +150,21 @@ static constexpr int8_t GZIP_DECOMP_WINDOW_SIZE = -10;
 #ifndef ENABLE_TIMINGS_API
 #define ENABLE_TIMINGS_API 1
 #endif
+// Whether the /events Server-Sent Events stream should be enabled.
+// This stream pushes new measurements to the web interface, instead of it polling /data.json every second.
+// Set to 0 to disable.
+// Default is 1.
+#ifndef ENABLE_EVENT_STREAM
+#define ENABLE_EVENT_STREAM 1
+#endif
+// The max number of clients that can be connected to the event stream at the same time.
+// Additional clients get a 503 Service Unavailable response, and fall back to polling.
+// Default is 4.
+static constexpr uint8_t EVENT_STREAM_MAX_CLIENTS = 4;
+// The min free heap in bytes required to accept new event stream clients, or to push new measurements.
+// Measurements that couldn't be pushed are sent once the free heap is above this again.
+// Default is 20480.
+static constexpr size_t EVENT_STREAM_MIN_FREE_HEAP = 20480;
 
 // Web server automatic config.
 #if SERVER_HEADER_APPEND_HARDWARE != 1
@@ -187,10 +227,21 @@ static constexpr uint8_t SENSOR_PIN = 5;
 #warning Prometheus scrape support requires the web server to be enabled.
 #endif
 #endif
+// The window size parameter used to gzip compress the metrics page, for clients accepting gzip.
+// The window size used is pow(2, the absolute of the window size parameter).
+// Compressing a response requires a buffer of twice the window size, but at least window size + 516 bytes,
+// and a hash table of up to 8KiB on the esp.
+// The range of valid values is -8 to -15.
+// Set to 0 to always send the uncompressed metrics page.
+// Default is -10.
+static constexpr int8_t METRICS_GZIP_WINDOW_SIZE = -10;
 // The namespace to be used as a prefix for most prometheus metrics.
 // Will by default also be used as the pushgateway namespace.
 // The default namespace is "esptherm".
-static constexpr const char PROMETHEUS_NAMESPACE[] = "esptherm";
+// This is a string literal macro, so it can be part of the compile time metric metadata.
+#ifndef PROMETHEUS_NAMESPACE
+#define PROMETHEUS_NAMESPACE "esptherm"
+#endif
 // The length of the prometheus namespace string.
 static constexpr size_t PROMETHEUS_NAMESPACE_LEN = utils::strlen(PROMETHEUS_NAMESPACE);
 // Whether the esp should automatically push measurements to a prometheus-pushgateway.
@@ -211,6 +262,14 @@ static constexpr uint16_t PROMETHEUS_PUSH_PORT = 9091;
 // Ignored in deep sleep mode.
 // Prometheus default scrape interval is every 30 seconds.
 static constexpr uint16_t PROMETHEUS_PUSH_INTERVAL = 30;
+// The time to wait before retrying a failed push, in milliseconds.
+// Doubled after each consecutive failure, up to PROMETHEUS_PUSH_MAX_BACKOFF.
+// Ignored in deep sleep mode.
+// Default is 1000.
+static constexpr uint32_t PROMETHEUS_PUSH_MIN_BACKOFF = 1000;
+// The max time to wait before retrying a failed push, in milliseconds.
+// Default is 300000, or five minutes.
+static constexpr uint32_t PROMETHEUS_PUSH_MAX_BACKOFF = 300000;
 // The name of the job to use for the prometheus metrics when pushing.
 // Leave empty to use the hostname of this device.
 // The default is to use the device hostname.
@@ -229,6 +288,117 @@ static constexpr const char PROMETHEUS_PUSH_NAMESPACE[] = "";
 // The length of the prometheus pushgateway namespace string.
 static constexpr size_t PROMETHEUS_PUSH_NAMESPACE_LEN = utils::strlen(PROMETHEUS_PUSH_NAMESPACE);
 #endif
+// Whether the esp should automatically send its metrics to a prometheus remote write receiver.
+// This is done through snappy compressed protobuf HTTP post requests at fixed intervals.
+// Unlike the pushgateway, the receiver keeps every sample, including the measurement backlog.
+// Every sample needs a timestamp, so nothing is sent until the clock was synchronized using SNTP.
+// Not supported in deep sleep mode.
+// Set to 1 to enable and to 0 to disable.
+#ifndef ENABLE_PROMETHEUS_REMOTE_WRITE
+#define ENABLE_PROMETHEUS_REMOTE_WRITE 0
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#if ENABLE_DEEP_SLEEP_MODE == 1
+#undef ENABLE_PROMETHEUS_REMOTE_WRITE
+#define ENABLE_PROMETHEUS_REMOTE_WRITE 0
+#warning Prometheus remote write isn't supported in deep sleep mode.
+#endif
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+// The address of the remote write receiver to send the metrics to.
+// Can be an IP address, a hostname, or a domain name.
+static constexpr const char PROMETHEUS_REMOTE_WRITE_ADDR[] = "192.168.2.203";
+// The port of the remote write receiver.
+// The default prometheus port is 9090.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_PORT = 9090;
+// The path of the remote write endpoint of the receiver.
+// Prometheus uses "/api/v1/write" if started with "--web.enable-remote-write-receiver".
+static constexpr const char PROMETHEUS_REMOTE_WRITE_PATH[] = "/api/v1/write";
+// The time between two remote write requests.
+// Specified in seconds.
+// Default is 30.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_INTERVAL = 30;
+// The time to wait before retrying a failed remote write request, in milliseconds.
+// Doubled after each consecutive failure, up to PROMETHEUS_REMOTE_WRITE_MAX_BACKOFF.
+// Default is 1000.
+static constexpr uint32_t PROMETHEUS_REMOTE_WRITE_MIN_BACKOFF = 1000;
+// The max time to wait before retrying a failed remote write request, in milliseconds.
+// Default is 300000, or five minutes.
+static constexpr uint32_t PROMETHEUS_REMOTE_WRITE_MAX_BACKOFF = 300000;
+// The size of the buffer the uncompressed request body is written to.
+// Samples that don't fit are dropped, and counted in a metric.
+// A second buffer about 1.2 times this size is used for the compressed request body.
+// Default is 8192.
+static constexpr size_t PROMETHEUS_REMOTE_WRITE_BUFFER_SIZE = 8192;
+// The base two logarithm of the number of entries in the hash table used for the snappy compression.
+// Each entry uses two bytes of RAM.
+// Larger tables find more repetitions, so the request body gets smaller.
+// The range of valid values is 8 to 16.
+// Default is 10.
+static constexpr uint8_t PROMETHEUS_REMOTE_WRITE_HASH_BITS = 10;
+// The value of the job label added to all remote written samples.
+// Leave empty to use the hostname of this device.
+static constexpr const char PROMETHEUS_REMOTE_WRITE_JOB[] = "";
+// The length of the remote write job label value.
+static constexpr size_t PROMETHEUS_REMOTE_WRITE_JOB_LEN = utils::strlen(PROMETHEUS_REMOTE_WRITE_JOB);
+// The value of the instance label added to all remote written samples.
+// Leave empty to use the device IP.
+static constexpr const char PROMETHEUS_REMOTE_WRITE_INSTANCE[] = "";
+// The length of the remote write instance label value.
+static constexpr size_t PROMETHEUS_REMOTE_WRITE_INSTANCE_LEN = utils::strlen(PROMETHEUS_REMOTE_WRITE_INSTANCE);
+#endif
+// Whether to record HTTP request duration histograms for each path and request method.
+// Each path uses about 120 bytes of RAM for each request method it handles.
+// Set to 1 to enable and to 0 to disable.
+#ifndef ENABLE_HTTP_REQUEST_DURATION_METRICS
+#define ENABLE_HTTP_REQUEST_DURATION_METRICS 1
+#endif
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+#if ENABLE_WEB_SERVER != 1 || (ENABLE_PROMETHEUS_PUSH != 1 && ENABLE_PROMETHEUS_SCRAPE_SUPPORT != 1 && ENABLE_PROMETHEUS_REMOTE_WRITE != 1)
+#undef ENABLE_HTTP_REQUEST_DURATION_METRICS
+#define ENABLE_HTTP_REQUEST_DURATION_METRICS 0
+#endif
+#endif
+// Whether to keep measurements made while the metrics weren't scraped or remote written, for example because the WiFi was down.
+// The kept measurements are added to the next scrape of each scraper and the next remote write request,
+// with the time they were measured as their timestamp.
+// The current measurements are also scraped with their measurement time as their timestamp.
+// The pushgateway rejects samples with timestamps, so pushed metrics never contain either.
+// Measurements older than the last exported sample aren't kept, since Prometheus rejects out-of-order samples.
+// The time is synchronized using SNTP, samples are written without a timestamp until that succeeded.
+// So enabling this makes the esp contact the NTP server, and changes the scraped samples to have timestamps.
+// Set to 1 to enable and to 0 to disable.
+#ifndef ENABLE_MEASUREMENT_BACKLOG
+#define ENABLE_MEASUREMENT_BACKLOG 0
+#endif
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT != 1 && ENABLE_PROMETHEUS_REMOTE_WRITE != 1
+#undef ENABLE_MEASUREMENT_BACKLOG
+#define ENABLE_MEASUREMENT_BACKLOG 0
+#endif
+#endif
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+// The max number of missed measurements to keep.
+// When the backlog is full, the oldest measurement is overwritten.
+// Each measurement uses 16 bytes of RAM.
+// Default is 180, which is three hours with the default interval.
+static constexpr size_t MEASUREMENT_BACKLOG_SIZE = 180;
+// The time between two measurements added to the backlog, if a consumer didn't get the metrics in the meantime.
+// Specified in seconds.
+// Default is 60.
+static constexpr uint16_t MEASUREMENT_BACKLOG_INTERVAL = 60;
+// The max number of scrapers and remote write receivers that are tracked separately.
+// Each of them gets every kept measurement once, scrapers are identified by their IP address.
+// When more of them get the metrics, the one that didn't get them for the longest time is forgotten.
+// Each uses 32 bytes of RAM.
+// Default is 4.
+static constexpr uint8_t MEASUREMENT_BACKLOG_CONSUMERS = 4;
+#endif
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+// The NTP server to get the current time from, for the sample timestamps.
+// The default is "pool.ntp.org".
+static constexpr const char NTP_SERVER[] = "pool.ntp.org";
+#endif
 
 // MQTT options
 // Whether or not to enable the MQTT client.
@@ -250,6 +420,7 @@ static constexpr uint16_t MQTT_BROKER_PORT = 1883;
 static constexpr uint16_t MQTT_PUBLISH_INTERVAL = 15;
 // The namespace of the measurement topics.
 // The MQTT topics published are structured like this: "namespace/measurement value".
+// All measurements are also published together, as a json object, to "namespace/state".
 // Also used as the name to open the MQTT connection.
 // Leave empty to use the device hostname.
 static constexpr const char MQTT_TOPIC_NAMESPACE[] = "";
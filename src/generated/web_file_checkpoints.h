@@ -0,0 +1,84 @@
+/*
+ * web_file_checkpoints.h
+ *
+ * **Warning:** This file is automatically generated, and should not be edited manually.
+ *
+ * This file contains the inflate checkpoints of the gzip compressed static files sent by the web server.
+ *
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_
+#define SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The inflate checkpoints of the file "main.css.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t MAIN_CSS_GZ_CHECKPOINTS[][2] = { { 0, 19 } };
+
+/**
+ * The number of inflate checkpoints of the file "main.css.gz".
+ */
+static constexpr const size_t MAIN_CSS_GZ_CHECKPOINTS_LEN = 1;
+
+/**
+ * The inflate checkpoints of the file "index.js.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t INDEX_JS_GZ_CHECKPOINTS[][2] = { { 0, 19 } };
+
+/**
+ * The number of inflate checkpoints of the file "index.js.gz".
+ */
+static constexpr const size_t INDEX_JS_GZ_CHECKPOINTS_LEN = 1;
+
+/**
+ * The inflate checkpoints of the file "manifest.json.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t MANIFEST_JSON_GZ_CHECKPOINTS[][2] = { { 0, 24 } };
+
+/**
+ * The number of inflate checkpoints of the file "manifest.json.gz".
+ */
+static constexpr const size_t MANIFEST_JSON_GZ_CHECKPOINTS_LEN = 1;
+
+/**
+ * The inflate checkpoints of the file "favicon.svg.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t FAVICON_SVG_GZ_CHECKPOINTS[][2] = { { 0, 22 } };
+
+/**
+ * The number of inflate checkpoints of the file "favicon.svg.gz".
+ */
+static constexpr const size_t FAVICON_SVG_GZ_CHECKPOINTS_LEN = 1;
+
+/**
+ * The inflate checkpoints of the file "favicon.ico.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t FAVICON_ICO_GZ_CHECKPOINTS[][2] = { { 0, 22 }, { 4096, 500 } };
+
+/**
+ * The number of inflate checkpoints of the file "favicon.ico.gz".
+ */
+static constexpr const size_t FAVICON_ICO_GZ_CHECKPOINTS_LEN = 2;
+
+/**
+ * The inflate checkpoints of the file "favicon.png.gz".
+ * Each entry is an uncompressed offset, and the compressed offset to start decompressing from for it.
+ */
+static constexpr const uint32_t FAVICON_PNG_GZ_CHECKPOINTS[][2] = { { 0, 22 }, { 4096, 4115 } };
+
+/**
+ * The number of inflate checkpoints of the file "favicon.png.gz".
+ */
+static constexpr const size_t FAVICON_PNG_GZ_CHECKPOINTS_LEN = 2;
+
+#endif /* SRC_GENERATED_WEB_FILE_CHECKPOINTS_H_ */
@@ -20,7 +20,7 @@ static constexpr const char MAIN_CSS_GZ_HASH[] = "3006e855a816651111ee82e92bcf6e
 /**
  * The md5 hash of the file "index.js.gz".
  */
-static constexpr const char INDEX_JS_GZ_HASH[] = "b7d1cc7b510da0eb5044b08fd49f6d7a";
+static constexpr const char INDEX_JS_GZ_HASH[] = "3d80cfebda60c7e1c664de3b82999b20";
 
 /**
  * The md5 hash of the file "manifest.json.gz".
@@ -30,16 +30,21 @@ static constexpr const char MANIFEST_JSON_GZ_HASH[] = "0f2bc88509c2e5fa90582f041
 /**
  * The md5 hash of the file "favicon.ico.gz".
  */
-static constexpr const char FAVICON_ICO_GZ_HASH[] = "31fc8a37562605f1d0b3c919dffa4e96";
+static constexpr const char FAVICON_ICO_GZ_HASH[] = "c1166bf6074e19e0742274059a0d9a48";
 
 /**
  * The md5 hash of the file "favicon.png.gz".
  */
-static constexpr const char FAVICON_PNG_GZ_HASH[] = "f18756d0d8dbb95f5493d805443fa023";
+static constexpr const char FAVICON_PNG_GZ_HASH[] = "97a0426fbd14d146694b396b08da78ca";
 
 /**
  * The md5 hash of the file "favicon.svg.gz".
  */
 static constexpr const char FAVICON_SVG_GZ_HASH[] = "de3746021c5d6d082e271941e00f7dbc";
 
+/**
+ * The md5 hash of the file "index.html".
+ */
+static constexpr const char INDEX_HTML_HASH[] = "4014730db6f0184826449a59e1b0a95b";
+
 #endif /* SRC_GENERATED_WEB_FILE_HASHES_H_ */
@@ -3,6 +3,8 @@ var humidity_element
 var time_element
 var update_interval
 var timer_interval
+var event_source
+var json_etag
 var json_time
 var update_time
 
@@ -12,7 +14,21 @@ var update_time
  * The function to be called when the page finished loading, to initialize this script.
  */
 function init() {
-	update_interval = window.setInterval(update, 1000)
+	if (typeof (EventSource) == 'function') {
+		event_source = new EventSource('events')
+		event_source.addEventListener('measurement', (event) => {
+			setMeasurements(JSON.parse(event.data))
+		})
+		event_source.addEventListener('error', () => {
+			// A closed event source means the ESP rejected the connection.
+			if (event_source.readyState == EventSource.CLOSED) {
+				console.warn('Event stream unavailable, falling back to polling.')
+				startPolling()
+			}
+		})
+	} else {
+		startPolling()
+	}
 	timer_interval = window.setInterval(timer, 1000)
 	temp_element = document.getElementById('temp')
 	humidity_element = document.getElementById('humid')
@@ -21,13 +37,41 @@ function init() {
 	update_time = Date.now()
 }
 
+/**
+ * Starts polling new measurements from the ESP every second.
+ * 
+ * Used if Server-Sent Events aren't supported, or the ESP rejected the event stream.
+ */
+function startPolling() {
+	if (update_interval == undefined) {
+		update_interval = window.setInterval(update, 1000)
+	}
+}
+
+/**
+ * Updates the page to show the given measurements.
+ * 
+ * @param {object} data The json object received from the ESP.
+ */
+function setMeasurements(data) {
+	temp_element.innerText = data.temperature
+	humidity_element.innerText = data.humidity
+	time_element.innerText = time_element.dateTime = data.time
+	json_time = parseTimeString(data.time)
+	update_time = Date.now()
+}
+
 /**
  * The update function downloading new data from the ESP.
  * 
  * This function fetches new measurements from the ESP and updates the page.
  */
 function update() {
-	var options = { method: 'GET' }
+	// Send the entity tag manually, so that unchanged measurements result in a 304 response instead of a cached body.
+	var options = { method: 'GET', cache: 'no-store', headers: {} }
+	if (json_etag != undefined) {
+		options.headers['If-None-Match'] = json_etag
+	}
 	var timeout
 	if (typeof (AbortController) == 'function') {
 		const abort = new AbortController();
@@ -40,13 +84,15 @@ function update() {
 			if (timeout != undefined) {
 				clearTimeout(timeout)
 			}
+			if (res.status == 304) {
+				return null
+			}
+			json_etag = res.headers.get('ETag')
 			return res.json()
 		}).then((out) => {
-			temp_element.innerText = out.temperature
-			humidity_element.innerText = out.humidity
-			time_element.innerText = time_element.dateTime = out.time
-			json_time = parseTimeString(out.time)
-			update_time = Date.now()
+			if (out != null) {
+				setMeasurements(out)
+			}
 		}).catch((err) => {
 			if (timeout != undefined) {
 				clearTimeout(timeout)
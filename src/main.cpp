@@ -35,6 +35,7 @@ void setup() {
 	Serial.begin(115200);
 
 	sensors::SENSOR_HANDLER.begin();
+	sensors::registerMetrics();
 
 	setupWiFi();
 #if ENABLE_ARDUINO_OTA == 1
@@ -240,6 +241,7 @@ void loop() {
 				log_w("Failed to get new measurements from sensor.");
 			}
 		}
+		sensors::recordMissedMeasurements();
 
 		if (loop_iterations % 20 == 0
 				&& sensors::SENSOR_HANDLER.getTimeSinceMeasurement() < 10000) {
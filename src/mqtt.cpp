@@ -11,14 +11,60 @@
 #include "mqtt.h"
 #include "main.h"
 #include "sensor_handler.h"
+#include <json_writer.h>
 #include <iomanip>
 #include <sstream>
+#if ENABLE_MQTT_PUBLISH == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1)
+#include "prometheus.h"
+#endif
 
 #if ENABLE_MQTT_PUBLISH == 1
 AsyncMqttClient mqtt::mqttClient;
 #if ENABLE_DEEP_SLEEP_MODE != 1
 uint64_t mqtt::last_publish = 0;
 #endif
+
+/**
+ * The number of times all measurements were published since the last boot.
+ */
+static uint32_t publishes = 0;
+
+/**
+ * The number of times publishing the measurements failed since the last boot.
+ */
+static uint32_t publish_failures = 0;
+
+// In deep sleep mode every boot publishes once, so the counters would always be zero.
+#if (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1) && ENABLE_DEEP_SLEEP_MODE != 1
+/**
+ * The description of the successful publish counter.
+ */
+static constexpr prom::MetricFamily PUBLISHES_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_mqtt_publishes_total",
+		"The number of times all measurements were published to the MQTT broker.");
+
+/**
+ * The successful publish counter.
+ */
+static prom::Counter publishes_metric(PUBLISHES_FAMILY, []() -> uint64_t {
+	return publishes;
+});
+
+/**
+ * The description of the failed publish counter.
+ */
+static constexpr prom::MetricFamily PUBLISH_FAILURES_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_mqtt_publish_failures_total",
+				"The number of times publishing a measurement to the MQTT broker failed.");
+
+/**
+ * The failed publish counter.
+ */
+static prom::Counter publish_failures_metric(PUBLISH_FAILURES_FAMILY,
+		[]() -> uint64_t {
+			return publish_failures;
+		});
+#endif
 #endif
 
 void mqtt::setup() {
@@ -33,6 +79,11 @@ void mqtt::setup() {
 #if MQTT_PUBLISH_ANONYMOUS != 1
 	mqttClient.setCredentials(MQTT_USER, MQTT_PASS);
 #endif
+
+#if (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1) && ENABLE_DEEP_SLEEP_MODE != 1
+	prom::registry.add(publishes_metric);
+	prom::registry.add(publish_failures_metric);
+#endif
 #endif
 }
 
@@ -70,12 +121,19 @@ void mqtt::publishMeasurements() {
 				ns = HOSTNAME;
 			}
 
+			const float temperature =
+					sensors::SENSOR_HANDLER.supportsTemperature() ?
+							sensors::SENSOR_HANDLER.getTemperature() : NAN;
+			const float humidity =
+					sensors::SENSOR_HANDLER.supportsHumidity() ?
+							sensors::SENSOR_HANDLER.getHumidity() : NAN;
+
 			std::ostringstream converter;
 			if (sensors::SENSOR_HANDLER.supportsTemperature()) {
-				converter << std::setprecision(3)
-						<< sensors::SENSOR_HANDLER.getTemperature();
+				converter << std::setprecision(3) << temperature;
 				if (!mqttClient.publish((ns + "/temperature").c_str(), 0, true,
 						converter.str().c_str())) {
+					publish_failures++;
 					log_w("Failed to publish temperature.");
 					return;
 				}
@@ -85,16 +143,41 @@ void mqtt::publishMeasurements() {
 			converter.clear();
 
 			if (sensors::SENSOR_HANDLER.supportsHumidity()) {
-				converter << std::setprecision(3)
-						<< sensors::SENSOR_HANDLER.getHumidity();
+				converter << std::setprecision(3) << humidity;
 
 				if (!mqttClient.publish((ns + "/humidity").c_str(), 0, true,
 						converter.str().c_str())) {
+					publish_failures++;
 					log_w("Failed to publish humidity.");
 					return;
 				}
 			}
 
+			// Publish all measurements as a single json object, for clients that want them together.
+			// Unknown values are written as null.
+			char json[MQTT_STATE_JSON_MAX_LEN + 1];
+			utils::JsonWriter writer(json, MQTT_STATE_JSON_MAX_LEN);
+			writer.beginObject();
+			if (sensors::SENSOR_HANDLER.supportsTemperature()) {
+				writer.key("temperature").value(temperature, 2);
+			}
+			if (sensors::SENSOR_HANDLER.supportsHumidity()) {
+				writer.key("humidity").value(humidity, 2);
+			}
+			writer.endObject();
+			if (writer.overflowed()) {
+				log_e("MQTT state json of length %u didn't fit its buffer.",
+						(unsigned int) writer.length());
+			}
+			json[writer.written()] = 0;
+
+			if (!mqttClient.publish((ns + "/state").c_str(), 0, true, json)) {
+				publish_failures++;
+				log_w("Failed to publish state.");
+				return;
+			}
+			publishes++;
+
 #if ENABLE_DEEP_SLEEP_MODE == 1
 			std::shared_ptr<bool> connected = std::make_shared<bool>(true);
 
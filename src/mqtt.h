@@ -21,6 +21,11 @@
  */
 namespace mqtt {
 #if ENABLE_MQTT_PUBLISH == 1
+/**
+ * The max length of the json object published to the state topic, excluding the NUL terminator.
+ */
+static constexpr size_t MQTT_STATE_JSON_MAX_LEN = 63;
+
 extern AsyncMqttClient mqttClient;
 #if ENABLE_DEEP_SLEEP_MODE != 1
 extern uint64_t last_publish;
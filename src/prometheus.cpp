@@ -9,27 +9,476 @@
  */
 
 #include "prometheus.h"
-#if ENABLE_DEEP_SLEEP_MODE == 1 || ENABLE_PROMETHEUS_PUSH == 1
+#if ENABLE_DEEP_SLEEP_MODE == 1 || ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 #include "main.h"
 #endif
-#include "sensor_handler.h"
+#if ENABLE_WEB_SERVER == 1
+#include "webhandler.h"
+#endif
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include "PushClient.h"
+#endif
 #include "generated/esptherm_version.h"
-#include <iomanip>
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <sys/time.h>
+#ifdef ESP8266
+#include <fallback_timer.h>
+#endif
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include "sensor_handler.h"
+#include <snappy_compress.h>
+#endif
+#include <cmath>
 #include <sstream>
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <task_shared.h>
+#endif
+#include <http_utils.h>
 #include <fallback_log.h>
 
-#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1)
-std::map<String, std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> prom::http_requests_total;
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+prom::Registry prom::registry;
 #endif
 #if ENABLE_PROMETHEUS_PUSH == 1 && ENABLE_DEEP_SLEEP_MODE != 1
 uint64_t prom::last_push = 0;
 #endif
 #if ENABLE_PROMETHEUS_PUSH == 1
-AsyncClient *prom::tcpClient = NULL;
-std::string prom::push_url;
+std::string prom::push_request_head;
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+std::string prom::remote_write_request_head;
+prom::RemoteWriteLabel prom::remote_write_labels[2];
+#endif
+
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#ifdef ESP32
+/**
+ * The description of the heap usage metric.
+ */
+static constexpr prom::MetricFamily HEAP_FAMILY = PROM_GAUGE_FAMILY_WITH_UNIT(
+		"process_heap", "bytes", "The amount of heap used on the ESP in bytes.");
+
+/**
+ * The heap usage metric.
+ * From what I could find this seems to be impossible on a ESP8266.
+ */
+static prom::Gauge heap_metric(HEAP_FAMILY, []() -> double {
+	return ESP.getHeapSize() - ESP.getFreeHeap();
+});
+#endif
+
+/**
+ * The description of the build info metric.
+ */
+static constexpr prom::MetricFamily BUILD_INFO_FAMILY = PROM_INFO_FAMILY(
+		PROMETHEUS_NAMESPACE "_build_info",
+		"A constant 1 with compile time information as labels.");
+
+/**
+ * The build info metric.
+ */
+static prom::Info build_info_metric(BUILD_INFO_FAMILY,
+		[](char *buffer, const size_t size) -> size_t {
+#if defined(ESP32) || defined(ESP8266)
+			const char *SDK_VERSION = ESP.getSdkVersion();
+#else
+			const char *SDK_VERSION = "unknown";
+#endif
+			return snprintf(buffer, size,
+					"esptherm_commit=\"%s\",mcu_type=\"%s\",arduino_version=\"%s\",sdk_version=\"%s\",cpp_std_version=\"%s\"",
+					ESPTHERM_COMMIT, prom::MCU_TYPE, prom::ARDUINO_VERSION,
+					SDK_VERSION, prom::CPP_VERSION);
+		});
+#endif
+
+#if ENABLE_PROMETHEUS_PUSH == 1
+/**
+ * The client pushing the metrics to the pushgateway, using chunked transfer encoding.
+ */
+class MetricsPushClient: public prom::PushClient {
+private:
+	/**
+	 * The generator writing the body of the current push request, if there is one.
+	 */
+	std::unique_ptr<prom::MetricsGenerator> _generator;
+
+public:
+	/**
+	 * Creates the pushgateway client.
+	 */
+	MetricsPushClient() :
+			PushClient("pushgateway", PROMETHEUS_PUSH_ADDR,
+					PROMETHEUS_PUSH_PORT, PROMETHEUS_PUSH_INTERVAL * 1000,
+					PROMETHEUS_PUSH_MIN_BACKOFF, PROMETHEUS_PUSH_MAX_BACKOFF) {
+	}
+
+protected:
+	virtual bool prepareRequest() override {
+		return true;
+	}
+
+	virtual void writeRequestHead(AsyncClient *client) override {
+		client->add(prom::push_request_head.c_str(),
+				prom::push_request_head.length());
+		// The pushgateway rejects samples with timestamps.
+		_generator.reset(
+				new prom::MetricsGenerator(prom::registry, false, false));
+	}
+
+	virtual bool writeRequestBody(AsyncClient *client) override {
+		// Each chunk starts with its length as three hex digits and a line break, and ends with a line break.
+		// So chunks can't be larger than 0xFFF bytes.
+		static constexpr size_t CHUNK_OVERHEAD = 7;
+		char chunk[256 + CHUNK_OVERHEAD];
+		while (_generator && client->space() > CHUNK_OVERHEAD) {
+			const size_t max_len = min(client->space() - CHUNK_OVERHEAD,
+					sizeof(chunk) - CHUNK_OVERHEAD);
+			const size_t len = _generator->fill((uint8_t*) chunk + 5, max_len);
+			if (len == 0) {
+				// The last chunk is always five bytes long.
+				client->add("0\r\n\r\n", 5);
+				_generator.reset();
+				break;
+			}
+
+			snprintf(chunk, 6, "%03x\r", (unsigned int) len);
+			chunk[4] = '\n';
+			chunk[len + 5] = '\r';
+			chunk[len + 6] = '\n';
+			client->add(chunk, len + CHUNK_OVERHEAD);
+		}
+		return !_generator;
+	}
+
+	virtual bool finishRequest(const bool success, const uint16_t status_code)
+			override {
+		_generator.reset();
+#if ENABLE_DEEP_SLEEP_MODE != 1
+		if (success) {
+			const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+			if (now - prom::last_push >= (PROMETHEUS_PUSH_INTERVAL + 10) * 1000) {
+				log_i("Successfully pushed again after %lums.",
+						(unsigned long) (now - prom::last_push));
+			}
+			prom::last_push = now;
+		}
+#endif
+		return false;
+	}
+};
+
+/**
+ * The connection to the pushgateway.
+ * Kept open between pushes, unless the pushgateway closes it.
+ */
+static MetricsPushClient push_client;
+
+// In deep sleep mode every boot pushes once, so the counters would always be zero.
+#if ENABLE_DEEP_SLEEP_MODE != 1
+
+/**
+ * The description of the successful push counter.
+ */
+static constexpr prom::MetricFamily PUSH_SUCCESSES_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_prometheus_pushes_total",
+		"The number of metrics pushes accepted by the pushgateway.");
+
+/**
+ * The successful push counter.
+ */
+static prom::Counter push_successes_metric(PUSH_SUCCESSES_FAMILY,
+		[]() -> uint64_t {
+			return push_client.getSuccesses();
+		});
+
+/**
+ * The description of the failed push counter.
+ */
+static constexpr prom::MetricFamily PUSH_FAILURES_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_prometheus_push_failures_total",
+		"The number of metrics pushes that failed or were rejected by the pushgateway.");
+
+/**
+ * The failed push counter.
+ */
+static prom::Counter push_failures_metric(PUSH_FAILURES_FAMILY,
+		[]() -> uint64_t {
+			return push_client.getFailures();
+		});
+#endif
+#endif
+
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The earliest unix time, in seconds, that is considered a synchronized clock.
+ * The clock starts at zero on boot, so anything before this can't be the real time.
+ */
+static constexpr time_t MIN_SYNCHRONIZED_TIME = 1700000000;
+#endif
+
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The buffer the uncompressed WriteRequest is written to.
+ */
+static uint8_t remote_write_buffer[PROMETHEUS_REMOTE_WRITE_BUFFER_SIZE];
+
+/**
+ * The snappy compressed body of the current remote write request.
+ * Kept until the receiver accepted or rejected it, so failed requests can be retried.
+ */
+static uint8_t remote_write_body[snappy::maxCompressedLength(
+		PROMETHEUS_REMOTE_WRITE_BUFFER_SIZE)];
+
+/**
+ * The hash table used to compress the remote write request body.
+ */
+static uint16_t remote_write_hash_table[1 << PROMETHEUS_REMOTE_WRITE_HASH_BITS];
+
+/**
+ * The length of the current remote write request body.
+ * Zero if there is no body waiting to be sent.
+ */
+static size_t remote_write_body_len = 0;
+
+/**
+ * The number of samples in the current remote write request body.
+ */
+static size_t remote_write_body_samples = 0;
+
+/**
+ * Whether the current remote write request body only contains samples the receiver missed.
+ */
+static bool remote_write_body_missed = false;
+
+/**
+ * The number of samples that were never accepted by the receiver since the last boot.
+ * Either because they didn't fit in the request buffer, or because the receiver rejected them.
+ */
+static utils::shared_t<uint64_t> remote_write_dropped_samples(0);
+
+/**
+ * The client sending the remote write requests to the receiver.
+ */
+class RemoteWriteClient: public prom::PushClient {
+private:
+	/**
+	 * The number of bytes of the current request body that were added to the send buffer.
+	 */
+	size_t _body_sent;
+
+public:
+	/**
+	 * Creates the remote write receiver client.
+	 */
+	RemoteWriteClient() :
+			PushClient("remote write receiver", PROMETHEUS_REMOTE_WRITE_ADDR,
+					PROMETHEUS_REMOTE_WRITE_PORT,
+					PROMETHEUS_REMOTE_WRITE_INTERVAL * 1000,
+					PROMETHEUS_REMOTE_WRITE_MIN_BACKOFF,
+					PROMETHEUS_REMOTE_WRITE_MAX_BACKOFF), _body_sent(0) {
+	}
+
+protected:
+	virtual bool prepareRequest() override {
+		// A failed request is retried with the same body, so its samples aren't lost.
+		return remote_write_body_len > 0 || prom::buildRemoteWriteBody();
+	}
+
+	virtual void writeRequestHead(AsyncClient *client) override {
+		client->add(prom::remote_write_request_head.c_str(),
+				prom::remote_write_request_head.length());
+		char length[40];
+		const size_t length_len = snprintf(length, sizeof(length),
+				"Content-Length: %u\r\n\r\n",
+				(unsigned int) remote_write_body_len);
+		client->add(length, length_len);
+		_body_sent = 0;
+	}
+
+	virtual bool writeRequestBody(AsyncClient *client) override {
+		while (_body_sent < remote_write_body_len && client->space() > 0) {
+			const size_t len = min(client->space(),
+					remote_write_body_len - _body_sent);
+			client->add((const char*) remote_write_body + _body_sent, len);
+			_body_sent += len;
+		}
+		return _body_sent == remote_write_body_len;
+	}
+
+	virtual bool finishRequest(const bool success, const uint16_t status_code)
+			override {
+		if (success) {
+			remote_write_body_len = 0;
+			// The rest of the missed samples, and the current samples, are sent right away.
+			if (remote_write_body_missed) {
+				sensors::confirmMissedMeasurements(prom::REMOTE_WRITE_CONSUMER);
+				return true;
+			}
+		} else if (status_code != 0 && status_code < 500 && status_code != 429) {
+			// Client errors other than 429 mean the receiver will never accept this body, so it isn't retried.
+			log_e("The remote write receiver rejected %u samples.",
+					(unsigned int) remote_write_body_samples);
+			remote_write_dropped_samples += remote_write_body_samples;
+			if (remote_write_body_missed) {
+				sensors::confirmMissedMeasurements(prom::REMOTE_WRITE_CONSUMER);
+			}
+			remote_write_body_len = 0;
+		}
+		return false;
+	}
+};
+
+/**
+ * The connection to the remote write receiver.
+ * Kept open between requests, unless the receiver closes it.
+ */
+static RemoteWriteClient remote_write_client;
+
+/**
+ * The description of the successful remote write counter.
+ */
+static constexpr prom::MetricFamily REMOTE_WRITES_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_prometheus_remote_writes_total",
+		"The number of remote write requests accepted by the receiver.");
+
+/**
+ * The successful remote write counter.
+ */
+static prom::Counter remote_writes_metric(REMOTE_WRITES_FAMILY,
+		[]() -> uint64_t {
+			return remote_write_client.getSuccesses();
+		});
+
+/**
+ * The description of the failed remote write counter.
+ */
+static constexpr prom::MetricFamily REMOTE_WRITE_FAILURES_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_prometheus_remote_write_failures_total",
+				"The number of remote write requests that failed or were rejected by the receiver.");
+
+/**
+ * The failed remote write counter.
+ */
+static prom::Counter remote_write_failures_metric(REMOTE_WRITE_FAILURES_FAMILY,
+		[]() -> uint64_t {
+			return remote_write_client.getFailures();
+		});
+
+/**
+ * The description of the dropped sample counter.
+ */
+static constexpr prom::MetricFamily REMOTE_WRITE_DROPPED_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_prometheus_remote_write_dropped_samples_total",
+				"The number of samples that didn't fit in a remote write request, or were rejected by the receiver.");
+
+/**
+ * The dropped sample counter.
+ */
+static prom::Counter remote_write_dropped_metric(REMOTE_WRITE_DROPPED_FAMILY,
+		[]() -> uint64_t {
+			return remote_write_dropped_samples;
+		});
+#endif
+
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+/**
+ * The statistics of the gzip compressed metrics responses.
+ */
+static web::CompressionStats metrics_gzip_stats;
+
+/**
+ * The description of the compression input size counter.
+ */
+static constexpr prom::MetricFamily METRICS_GZIP_INPUT_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_metrics_gzip_input_bytes_total",
+				"The total uncompressed size of all gzip compressed metrics responses.");
+
+/**
+ * The compression input size counter.
+ */
+static prom::Counter metrics_gzip_input_metric(METRICS_GZIP_INPUT_FAMILY,
+		[]() -> uint64_t {
+			return metrics_gzip_stats.input_bytes;
+		});
+
+/**
+ * The description of the compression output size counter.
+ */
+static constexpr prom::MetricFamily METRICS_GZIP_OUTPUT_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_metrics_gzip_output_bytes_total",
+				"The total compressed size of all gzip compressed metrics responses.");
+
+/**
+ * The compression output size counter.
+ */
+static prom::Counter metrics_gzip_output_metric(METRICS_GZIP_OUTPUT_FAMILY,
+		[]() -> uint64_t {
+			return metrics_gzip_stats.output_bytes;
+		});
+
+/**
+ * The description of the compression ratio gauge.
+ */
+static constexpr prom::MetricFamily METRICS_GZIP_RATIO_FAMILY =
+		PROM_GAUGE_FAMILY(PROMETHEUS_NAMESPACE "_metrics_gzip_compression_ratio",
+				"The uncompressed size divided by the compressed size of the last gzip compressed metrics response.");
+
+/**
+ * The compression ratio gauge.
+ */
+static prom::Gauge metrics_gzip_ratio_metric(METRICS_GZIP_RATIO_FAMILY,
+		[]() -> double {
+			return metrics_gzip_stats.ratio;
+		});
+
+/**
+ * The description of the compression time counter.
+ */
+static constexpr prom::MetricFamily METRICS_GZIP_TIME_FAMILY =
+		PROM_COUNTER_FAMILY(PROMETHEUS_NAMESPACE "_metrics_gzip_compression_seconds_total",
+				"The total time spent generating and compressing gzip compressed metrics responses.");
+
+/**
+ * The compression time counter.
+ * Written as a collector, since the time has to be written with microsecond precision.
+ */
+static prom::Collector metrics_gzip_time_metric(METRICS_GZIP_TIME_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			if (cursor.index++ > 0) {
+				return 0;
+			}
+			return snprintf(buffer, size, "%s %.6f\n", family.name,
+					metrics_gzip_stats.time_micros / 1000000.0);
+		});
 #endif
 
 void prom::setup() {
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#ifdef ESP32
+	registry.add(heap_metric);
+#endif
+	registry.add(build_info_metric);
+#endif
+#if ENABLE_PROMETHEUS_PUSH == 1 && ENABLE_DEEP_SLEEP_MODE != 1
+	registry.add(push_successes_metric);
+	registry.add(push_failures_metric);
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	registry.add(remote_writes_metric);
+	registry.add(remote_write_failures_metric);
+	registry.add(remote_write_dropped_metric);
+#endif
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+	if (METRICS_GZIP_WINDOW_SIZE != 0) {
+		registry.add(metrics_gzip_input_metric);
+		registry.add(metrics_gzip_output_metric);
+		registry.add(metrics_gzip_ratio_metric);
+		registry.add(metrics_gzip_time_metric);
+	}
+#endif
+
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 	web::registerRequestHandler("/metrics", HTTP_GET, handleMetrics);
 #endif
@@ -39,12 +488,20 @@ void prom::loop() {
 #if ENABLE_PROMETHEUS_PUSH == 1
 	pushMetrics();
 #endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	remoteWrite();
+#endif
 }
 
 void prom::connect() {
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	// The clock is required for the timestamps of the measurements, and can only be synchronized with a WiFi connection.
+	configTime(0, 0, NTP_SERVER);
+#endif
 #if ENABLE_PROMETHEUS_PUSH == 1
+	// The request head is the same for every push, so it is only created once per WiFi connection.
 	std::ostringstream stream;
-	stream << "/metrics/job/";
+	stream << "POST /metrics/job/";
 	if (PROMETHEUS_PUSH_JOB_LEN > 0) {
 		stream << PROMETHEUS_PUSH_JOB;
 	} else {
@@ -62,304 +519,183 @@ void prom::connect() {
 	} else {
 		stream << PROMETHEUS_NAMESPACE;
 	}
-
-	push_url = stream.str();
-#endif
-}
-
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-String prom::getMetrics(const bool openmetrics) {
-#if ENABLE_WEB_SERVER == 1
-	// First determine the sum of all called path lengths.
-	size_t uri_len_sum = 0;
-	for (const std::pair<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> &uri_stats : http_requests_total) {
-		uri_len_sum += uri_stats.first.length();
+	stream << " HTTP/1.1\r\nHost: " << PROMETHEUS_PUSH_ADDR;
+	if (PROMETHEUS_PUSH_PORT != 80) {
+		stream << ':' << PROMETHEUS_PUSH_PORT;
 	}
+	stream << "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+	// The body is sent while it is generated, so its length isn't known in advance.
+	stream << "Transfer-Encoding: chunked\r\n";
+#if ENABLE_DEEP_SLEEP_MODE == 1
+	// The connection can't be reused after the deep sleep.
+	stream << "Connection: close\r\n";
 #endif
+	stream << "\r\n";
 
-#if defined(ESP32) || defined(ESP8266)
-	const char *SDK_VERSION = ESP.getSdkVersion();
-#else
-	const char *SDK_VERSION = "unknown";
-#endif
-	const size_t SDK_VERSION_LEN = strlen(SDK_VERSION);
-
-	// The temperature should never be more than three digits before and after the dot.
-	const size_t temp_max_len = 99 + 43 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? 45 + PROMETHEUS_NAMESPACE_LEN : 0) + 38;
-	// The relative humidity should be three digits before and after the dot at most.
-	const size_t humidity_max_len = 94 + 40 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? 42 + PROMETHEUS_NAMESPACE_LEN : 0) + 35;
-#ifdef ESP32
-	// A 32 bit unsigned int has 10 digits at most, plus four characters because of the way the number will be formatted.
-	const size_t heap_max_len = 71 + 32 + (openmetrics ? 32 : 0) + 34;
-#else
-	const size_t heap_max_len = 0;
-#endif
-	// Assume that the hash is always seven characters long.
-	const size_t build_info_max_len = 73 + 25 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? -1 : 0) + 104 + MCU_TYPE_LEN + ARDUINO_VERSION_LEN + SDK_VERSION_LEN + CPP_VERSION_LEN;
-#if ENABLE_WEB_SERVER == 1
-	// An integer is assumed to be at most 20 digits, plus four characters because of the way they are formatted.
-	const size_t web_requests_total_max_len = 86 + 36
-			+ PROMETHEUS_NAMESPACE_LEN * 2
-			+ (83 + PROMETHEUS_NAMESPACE_LEN) * getRequestCounts()
-			+ uri_len_sum;
-#else
-	const size_t web_requests_total_max_len = 0;
+	push_request_head = stream.str();
 #endif
-	const size_t eof_max_len = (openmetrics ? 5 : 0);
-
-	// The added lengths of all the lines.
-	const size_t max_len = temp_max_len + humidity_max_len + heap_max_len
-			+ build_info_max_len + web_requests_total_max_len + eof_max_len;
-
-	char *buffer = new char[max_len + 1];
-
-	// Write sensor metrics.
-	size_t len = writeMetric(buffer, PROMETHEUS_NAMESPACE,
-			"external_temperature", "celsius",
-			"The current measured external temperature in degrees celsius.",
-			"gauge", (double) sensors::SENSOR_HANDLER.getTemperature(),
-			openmetrics);
-	len += writeMetric(buffer + len, PROMETHEUS_NAMESPACE, "external_humidity",
-			"percent",
-			"The current measured external relative humidity in percent.",
-			"gauge", (double) sensors::SENSOR_HANDLER.getHumidity(),
-			openmetrics);
-
-	// From what I could find this seems to be impossible on a ESP8266.
-#ifdef ESP32
-	const uint64_t used_heap = ESP.getHeapSize() - ESP.getFreeHeap();
-	len += writeMetric(buffer + len, "process", "heap", "bytes",
-			"The amount of heap used on the ESP in bytes.", "gauge",
-			(double) used_heap, openmetrics);
-#endif
-
-	len += writeMetricMetadataLine(buffer + len, "HELP", PROMETHEUS_NAMESPACE,
-			"build_info", "",
-			"A constant 1 with compile time information as labels.");
-	if (openmetrics) {
-		len += writeMetricMetadataLine(buffer + len, "TYPE",
-				PROMETHEUS_NAMESPACE, "build_info", "", "info");
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	static std::string job;
+	static std::string instance;
+	job = PROMETHEUS_REMOTE_WRITE_JOB_LEN > 0 ? PROMETHEUS_REMOTE_WRITE_JOB : HOSTNAME;
+	if (PROMETHEUS_REMOTE_WRITE_INSTANCE_LEN > 0) {
+		instance = PROMETHEUS_REMOTE_WRITE_INSTANCE;
 	} else {
-		len += writeMetricMetadataLine(buffer + len, "TYPE",
-				PROMETHEUS_NAMESPACE, "build_info", "", "gauge");
-	}
-	strcpy(buffer + len, PROMETHEUS_NAMESPACE);
-	len += PROMETHEUS_NAMESPACE_LEN;
-	strcpy(buffer + len, "_build_info{esptherm_commit=\"");
-	len += 29;
-	strcpy(buffer + len, ESPTHERM_COMMIT);
-	len += 7;
-	strcpy(buffer + len, "\",mcu_type=\"");
-	len += 12;
-	strcpy(buffer + len, MCU_TYPE);
-	len += MCU_TYPE_LEN;
-	strcpy(buffer + len, "\",arduino_version=\"");
-	len += 19;
-	strcpy(buffer + len, ARDUINO_VERSION);
-	len += ARDUINO_VERSION_LEN;
-	strcpy(buffer + len, "\",sdk_version=\"");
-	len += 15;
-	strcpy(buffer + len, SDK_VERSION);
-	len += SDK_VERSION_LEN;
-	strcpy(buffer + len, "\",cpp_std_version=\"");
-	len += 19;
-	strcpy(buffer + len, CPP_VERSION);
-	len += CPP_VERSION_LEN;
-	strcpy(buffer + len, "\"} 1\n");
-	len += 5;
-
-#if ENABLE_WEB_SERVER == 1
-	// Write web server statistics.
-	len += writeMetricMetadataLine(buffer + len, "HELP", PROMETHEUS_NAMESPACE,
-			"http_requests_total", "",
-			"The total number of HTTP requests handled by this server.");
-	len += writeMetricMetadataLine(buffer + len, "TYPE", PROMETHEUS_NAMESPACE,
-			"http_requests_total", "", "counter");
-
-	for (std::map<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>>::const_iterator uri_stats =
-			http_requests_total.cbegin();
-			uri_stats != http_requests_total.cend(); uri_stats++) {
-		for (std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>::const_iterator response_stats =
-				uri_stats->second.cbegin();
-				response_stats != uri_stats->second.cend(); response_stats++) {
-			strncpy(buffer + len, PROMETHEUS_NAMESPACE,
-					min(max_len - len, PROMETHEUS_NAMESPACE_LEN));
-			len += PROMETHEUS_NAMESPACE_LEN;
-			strncpy(buffer + len, "_http_requests_total{method=\"",
-					min(max_len - len, (size_t) 29));
-			len += 29;
-			switch (response_stats->first.first) {
-			case HTTP_GET:
-				strncpy(buffer + len, "get", min(max_len - len, (size_t) 3));
-				len += 3;
-				break;
-			case HTTP_POST:
-				strncpy(buffer + len, "post", min(max_len - len, (size_t) 4));
-				len += 4;
-				break;
-			case HTTP_PUT:
-				strncpy(buffer + len, "put", min(max_len - len, (size_t) 3));
-				len += 3;
-				break;
-			case HTTP_PATCH:
-				strncpy(buffer + len, "patch", min(max_len - len, (size_t) 5));
-				len += 5;
-				break;
-			case HTTP_DELETE:
-				strncpy(buffer + len, "delete", min(max_len - len, (size_t) 6));
-				len += 6;
-				break;
-			case HTTP_HEAD:
-				strncpy(buffer + len, "head", min(max_len - len, (size_t) 4));
-				len += 4;
-				break;
-			case HTTP_OPTIONS:
-				strncpy(buffer + len, "options",
-						min(max_len - len, (size_t) 7));
-				len += 7;
-				break;
-			default:
-				strncpy(buffer + len, "unknown",
-						min(max_len - len, (size_t) 7));
-				len += 7;
-				log_e("Unknown request method %u for uri \"%s\" in stats map.",
-						response_stats->first.first, uri_stats->first.c_str());
-				break;
-			}
-
-			len += snprintf(buffer + len, max_len - len,
-					"\",code=\"%u\",path=\"%s\"} %.3f\n",
-					response_stats->first.second, uri_stats->first.c_str(),
-					(double) response_stats->second);
-			if (len >= max_len) {
-				log_e("Metrics generation buffer overflow.");
-				break;
-			}
-		}
+		instance = localhost.toString().c_str();
 	}
-#endif /* ENABLE_WEB_SERVER == 1 */
-	if (openmetrics) {
-		strncpy(buffer + len, "# EOF\n", min(max_len - len, (size_t) 7));
-		len += 6;
+	remote_write_labels[0] = { "job", job.c_str() };
+	remote_write_labels[1] = { "instance", instance.c_str() };
+
+	std::ostringstream remote_write_stream;
+	remote_write_stream << "POST " << PROMETHEUS_REMOTE_WRITE_PATH
+			<< " HTTP/1.1\r\nHost: " << PROMETHEUS_REMOTE_WRITE_ADDR;
+	if (PROMETHEUS_REMOTE_WRITE_PORT != 80) {
+		remote_write_stream << ':' << PROMETHEUS_REMOTE_WRITE_PORT;
 	}
+	remote_write_stream << "\r\nUser-Agent: esp-wifi-thermometer/" << ESPTHERM_COMMIT;
+	remote_write_stream << "\r\nContent-Type: application/x-protobuf\r\n";
+	remote_write_stream << "Content-Encoding: snappy\r\n";
+	remote_write_stream << "X-Prometheus-Remote-Write-Version: 0.1.0\r\n";
 
-	String metrics = buffer;
-	delete[] buffer;
-	return metrics;
+	remote_write_request_head = remote_write_stream.str();
+#endif
 }
 
-template<size_t ns_l, size_t nm_l, size_t u_l, size_t dc_l, size_t tp_l>
-size_t prom::writeMetric(char *buffer, const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&metric_description)[dc_l], const char (&metric_type)[tp_l],
-		const double value, const bool openmetrics) {
-	size_t written = writeMetricMetadataLine(buffer, "HELP", metric_namespace,
-			metric_name, metric_unit, metric_description);
-	written += writeMetricMetadataLine(buffer + written, "TYPE",
-			metric_namespace, metric_name, metric_unit, metric_type);
-	if (openmetrics) {
-		written += writeMetricMetadataLine(buffer + written, "UNIT",
-				metric_namespace, metric_name, metric_unit, metric_unit);
-	}
-
-	if (ns_l > 1) {
-		strcpy(buffer + written, metric_namespace);
-		written += ns_l - 1;
-		buffer[written++] = '_';
-	}
-	strcpy(buffer + written, metric_name);
-	written += nm_l - 1;
-	if (u_l > 1) {
-		buffer[written++] = '_';
-		strcpy(buffer + written, metric_unit);
-		written += u_l - 1;
-	}
-
-	if (!std::isnan(value)) {
-		written += sprintf(buffer + written, " %.3f\n", value);
-	} else {
-		strcpy(buffer + written, " NAN\n");
-		written += 5;
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+bool prom::getUnixTimeOffset(int64_t &offset) {
+	timeval now;
+	gettimeofday(&now, NULL);
+	const int64_t uptime = esp_timer_get_time() / 1000;
+	if (now.tv_sec < MIN_SYNCHRONIZED_TIME) {
+		return false;
 	}
-	buffer[written] = 0;
-
-	return written;
-}
 
-template<size_t fnm_l, size_t ns_l, size_t nm_l, size_t u_l, size_t vl_l>
-size_t prom::writeMetricMetadataLine(char *buffer,
-		const char (&field_name)[fnm_l], const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&value)[vl_l]) {
-	size_t written = 0;
-	buffer[written++] = '#';
-	buffer[written++] = ' ';
-	strcpy(buffer + written, field_name);
-	written += fnm_l - 1;
-	buffer[written++] = ' ';
-
-	if (ns_l > 1) {
-		strcpy(buffer + written, metric_namespace);
-		written += ns_l - 1;
-		buffer[written++] = '_';
-	}
-	strcpy(buffer + written, metric_name);
-	written += nm_l - 1;
-	if (u_l > 1) {
-		buffer[written++] = '_';
-		strcpy(buffer + written, metric_unit);
-		written += u_l - 1;
-	}
-
-	buffer[written++] = ' ';
-	strcpy(buffer + written, value);
-	written += vl_l - 1;
-	buffer[written++] = '\n';
-	buffer[written] = 0;
-
-	return written;
+	offset = (int64_t) now.tv_sec * 1000 + now.tv_usec / 1000 - uptime;
+	return true;
 }
+#endif
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 #if ENABLE_WEB_SERVER == 1
-size_t prom::getRequestCounts() {
-	size_t count = 0;
-	for (const std::pair<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> &uri_stats : http_requests_total) {
-		count += uri_stats.second.size();
+const char* prom::getMethodName(const WebRequestMethod method) {
+	switch (method) {
+	case HTTP_GET:
+		return "get";
+	case HTTP_POST:
+		return "post";
+	case HTTP_PUT:
+		return "put";
+	case HTTP_PATCH:
+		return "patch";
+	case HTTP_DELETE:
+		return "delete";
+	case HTTP_HEAD:
+		return "head";
+	case HTTP_OPTIONS:
+		return "options";
+	default:
+		return "unknown";
 	}
-	return count;
 }
 #endif
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 web::ResponseData prom::handleMetrics(AsyncWebServerRequest *request) {
-	const bool openmetrics = request->hasHeader("Accept")
-			&& web::csvHeaderContains(request->header("Accept").c_str(),
-					"application/openmetrics-text");
-
-	if (openmetrics) {
+	// Prefer the plain text format if the client accepts multiple formats equally.
+	static const char *const media_types[] = { "text/plain",
+			"application/openmetrics-text", "application/vnd.google.protobuf" };
+	const int8_t format =
+			request->hasHeader("Accept") ?
+					http::negotiateMediaType(request->header("Accept").c_str(),
+							media_types, 3) :
+					0;
+	const bool openmetrics = format == 1;
+	const bool protobuf = format == 2;
+
+	if (protobuf) {
+		log_d("Client accepts protobuf.");
+	} else if (openmetrics) {
 		log_d("Client accepts openmetrics.");
 	} else {
 		log_d("Client doesn't accept openmetrics.");
 	}
 
-	const String metrics = getMetrics(openmetrics);
-	AsyncWebServerResponse *response =
-			request->beginResponse(200,
-					(openmetrics ?
-							"application/openmetrics-text; version=1.0.0; charset=utf-8" :
-							"text/plain; version=0.0.4; charset=utf-8"),
-					metrics);
+	// Clients without an Accept-Encoding header get the uncompressed metrics.
+	static const char *const encodings[] = { "gzip", "identity" };
+	const bool compress = METRICS_GZIP_WINDOW_SIZE != 0
+			&& request->hasHeader("Accept-Encoding")
+			&& http::negotiateEncoding(
+					request->header("Accept-Encoding").c_str(), encodings, 2)
+					== 0;
+
+	// Like the Prometheus federation endpoint, name[] parameters select the metric families to write.
+	MetricFilter filter;
+	for (size_t i = 0; i < request->params(); i++) {
+		const AsyncWebParameter *param = request->getParam(i);
+		if (param->isPost() || param->isFile() || param->name() != "name[]") {
+			continue;
+		}
+
+		if (!filter.add(param->value().c_str())) {
+			log_w("Ignoring metric names after the first %u.",
+					(unsigned int) MetricFilter::MAX_NAMES);
+			break;
+		}
+	}
+
+	// Scrapers are identified by their address, so each of them gets the measurements it missed.
+	const uint32_t consumer = request->client()->remoteIP();
+	std::shared_ptr<ExpositionGenerator> generator;
+	if (protobuf) {
+		generator = std::make_shared<ProtobufGenerator>(registry, true, filter,
+				consumer);
+	} else {
+		generator = std::make_shared<MetricsGenerator>(registry, openmetrics,
+				true, filter, consumer);
+	}
+	std::shared_ptr<gzip::uzlib_gzip_wrapper> comp;
+	if (compress) {
+		// The exposition is compressed while it is generated, so only the compression window is kept in memory.
+		comp = std::make_shared<gzip::uzlib_gzip_wrapper>(
+				[generator](uint8_t *buf, const size_t max_len) -> size_t {
+					return generator->fill(buf, max_len);
+				}, METRICS_GZIP_WINDOW_SIZE);
+		// A new compressor is only done if its buffers couldn't be allocated.
+		if (comp->done()) {
+			log_w("Failed to allocate metrics compression buffers, sending uncompressed metrics.");
+			comp.reset();
+		}
+	}
+
+	const char *content_type = "text/plain; version=0.0.4; charset=utf-8";
+	if (protobuf) {
+		content_type = PROTOBUF_CONTENT_TYPE;
+	} else if (openmetrics) {
+		content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+	}
+	AsyncWebServerResponse *response;
+	if (comp) {
+		response = request->beginChunkedResponse(content_type,
+				std::bind(web::compressingResponseFiller, comp,
+						&metrics_gzip_stats, _1, _2, _3));
+		response->addHeader("Content-Encoding", "gzip");
+	} else {
+		response = request->beginChunkedResponse(content_type,
+				std::bind(metricsResponseFiller, generator, _1, _2, _3));
+	}
 	response->addHeader("Cache-Control", web::CACHE_CONTROL_NOCACHE);
-	response->addHeader("Vary", "Accept");
-	return web::ResponseData(response, metrics.length(), 200);
+	response->addHeader("Vary", "Accept, Accept-Encoding");
+	// The length of the metrics isn't known before they are sent.
+	return web::ResponseData(response, 0, 200);
 }
+
+size_t prom::metricsResponseFiller(
+		const std::shared_ptr<ExpositionGenerator> generator, uint8_t *buffer,
+		const size_t max_len, const size_t index) {
+	return generator->fill(buffer, max_len);
+}
+
 #endif
 
 #if ENABLE_PROMETHEUS_PUSH == 1
@@ -369,116 +705,63 @@ void prom::pushMetrics() {
 		return;
 	}
 
-	if (tcpClient) { // Don't try pushing if tcpClient isn't NULL.
-		if (tcpClient->connected() || tcpClient->connecting()) {
-			tcpClient->close(true);
-		}
-		delay(20);
-		return;
+	push_client.loop();
+
+#if ENABLE_DEEP_SLEEP_MODE == 1
+	while (push_client.isInFlight()) {
+		delay(10);
+		push_client.loop();
 	}
 
-#if ENABLE_DEEP_SLEEP_MODE != 1
-	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (now - last_push >= PROMETHEUS_PUSH_INTERVAL * 1000) {
+	push_client.close();
 #endif
-		tcpClient = new AsyncClient();
+}
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
 
-		if (!tcpClient) {
-			log_e("Failed to allocate Async TCP Client!");
-			return;
-		}
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+void prom::remoteWrite() {
+	if (!WiFi.isConnected()) {
+		return;
+	}
 
-		tcpClient->setAckTimeout(PROMETHEUS_PUSH_INTERVAL * 0.75);
-		tcpClient->setRxTimeout(PROMETHEUS_PUSH_INTERVAL * 0.75);
-		tcpClient->onError([](void *arg, AsyncClient *cli, int error) {
-			log_e("Connecting to the metrics server failed!");
-			log_e("Connection Error: %d", error);
-			if (tcpClient != NULL) {
-				tcpClient = NULL;
-				delete cli;
-			}
-		}, NULL);
-
-		tcpClient->onConnect([](void *arg, AsyncClient *cli) {
-
-			cli->onDisconnect([](void *arg, AsyncClient *c) {
-				if (tcpClient != NULL) {
-					tcpClient = NULL;
-					log_e("Connection to prometheus pushgateway server was closed while reading or writing.");
-					delete c;
-				}
-			}, NULL);
-
-			std::shared_ptr<size_t> read = std::make_shared<size_t>(0);
-			cli->onData([read](void *arg, AsyncClient *c, void *data, size_t len) mutable {
-				uint8_t *d = (uint8_t*) data;
-
-				for (size_t i = 0; i < len; i++) {
-					if (*read > 8 && isDigit(d[i]) && len > i + 2) {
-						char status_code[4] { 0 };
-						for (uint8_t j = 0; j < 3; j++) {
-							status_code[j] = d[i + j];
-						}
-
-						uint32_t code = atoi(status_code);
-						if (code == 200) {
-#if ENABLE_DEEP_SLEEP_MODE != 1
-							const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-
-							if (now - last_push >= (PROMETHEUS_PUSH_INTERVAL + 10) * 1000) {
-								log_i("Successfully pushed again after %lums.", now - last_push);
-							}
-
-							last_push = now;
-#endif
-						} else {
-							log_w("Received http status code %d when trying to push metrics.", code);
-						}
-
-						if (tcpClient != NULL) {
-							tcpClient = NULL;
-							if (c->connected()) {
-								c->close(true);
-							}
-							delete c;
-						}
-						return;
-					}
-					(*read)++;
-				}
-			}, NULL);
-
-			cli->write("POST ");
-			cli->write(push_url.c_str());
-			cli->write(" HTTP/1.0\r\nHost: ");
-			cli->write(PROMETHEUS_PUSH_ADDR);
-			cli->write("\r\n");
-			String metrics = getMetrics();
-			cli->write("Content-Type: application/x-www-form-urlencoded\r\n");
-			cli->write("Content-Length: ");
-			std::ostringstream converter;
-			converter << metrics.length();
-			cli->write(converter.str().c_str());
-			cli->write("\r\n\r\n");
-			cli->write(metrics.c_str());
-			cli->write("\r\n\r\n");
-		}, NULL);
-
-		if (!tcpClient->connect(PROMETHEUS_PUSH_ADDR, PROMETHEUS_PUSH_PORT)) {
-			log_e("Connecting to the metrics server failed!");
-			if (tcpClient != NULL) {
-				AsyncClient *cli = tcpClient;
-				tcpClient = NULL;
-				delete cli;
-			}
-		}
+	remote_write_client.loop();
+}
 
-#if ENABLE_DEEP_SLEEP_MODE == 1
-		while (tcpClient != NULL) {
-			delay(10);
-		}
-#else
+bool prom::buildRemoteWriteBody() {
+	int64_t offset;
+	if (!getUnixTimeOffset(offset)) {
+		log_d("Waiting for the clock to be synchronized before the first remote write.");
+		return false;
 	}
-#endif
+
+	// Samples without their own timestamp get the time the request was created.
+	const int64_t timestamp = offset + esp_timer_get_time() / 1000;
+	ProtobufWriter writer(remote_write_buffer, sizeof(remote_write_buffer));
+	size_t dropped = 0;
+	// Missed samples get their own requests, so the current samples aren't dropped if the receiver rejects them.
+	remote_write_body_missed = true;
+	remote_write_body_samples = writeRemoteWriteRequest(writer, registry,
+			remote_write_labels, 2, timestamp, dropped, REMOTE_WRITE_CONSUMER,
+			true);
+	if (remote_write_body_samples == 0) {
+		// Missed samples that can't be sent are skipped, rather than checked again before each request.
+		sensors::confirmMissedMeasurements(REMOTE_WRITE_CONSUMER);
+		remote_write_body_missed = false;
+		remote_write_body_samples = writeRemoteWriteRequest(writer, registry,
+				remote_write_labels, 2, timestamp, dropped);
+	}
+	if (dropped > 0) {
+		log_w("Dropped %u samples that didn't fit in the remote write request.",
+				(unsigned int) dropped);
+		remote_write_dropped_samples += dropped;
+	}
+	if (remote_write_body_samples == 0) {
+		return false;
+	}
+
+	remote_write_body_len = snappy::compress(remote_write_buffer,
+			writer.getLength(), remote_write_body, remote_write_hash_table,
+			PROMETHEUS_REMOTE_WRITE_HASH_BITS);
+	return true;
 }
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
+#endif /* ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
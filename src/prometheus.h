@@ -12,42 +12,60 @@
 #define SRC_PROMETHEUS_H_
 
 #include "config.h"
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1)
 #include "webhandler.h"
 #endif
-#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1)
-#include <map>
-#endif
-#if ENABLE_PROMETHEUS_PUSH == 1
-#ifdef ESP32
-#include <AsyncTCP.h>
-#elif defined(ESP8266)
-#include <ESPAsyncTCP.h>
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <metric_registry.h>
+#include <metrics_generator.h>
+#include <memory>
 #endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <remote_write.h>
 #endif
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 #include <ESPAsyncWebServer.h>
+#include <protobuf_generator.h>
 #endif
 
 /**
  * This header, and the source file with the same name, contain everything for the prometheus integration.
  */
 namespace prom {
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-#if ENABLE_WEB_SERVER == 1
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 /**
- * A map used to track the number of http requests handled by this esp.
- * The format is "URI -> (Method, Response Code) -> Count".
+ * The registry containing the metrics of all modules.
+ * Each module adds its own metrics in its setup function.
  */
-extern std::map<String,
-		std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> http_requests_total;
-#endif
+extern Registry registry;
 #if ENABLE_PROMETHEUS_PUSH == 1
 #if ENABLE_DEEP_SLEEP_MODE != 1
 extern uint64_t last_push;
 #endif
-extern AsyncClient *tcpClient;
-extern std::string push_url;
+/**
+ * The request line and headers of each push request.
+ * Created when a WiFi connection is established, since it can contain the IP address.
+ */
+extern std::string push_request_head;
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The consumer identifier of the remote write receiver, for metrics keeping track of what it already got.
+ * Scrapers are identified by their IPv4 address, which can't be the broadcast address.
+ */
+static constexpr uint32_t REMOTE_WRITE_CONSUMER = UINT32_MAX;
+
+/**
+ * The request line and headers of each remote write request, except the content length.
+ * Created when a WiFi connection is established, like the push request head.
+ */
+extern std::string remote_write_request_head;
+
+/**
+ * The job and instance labels added to every remote written sample.
+ * Created when a WiFi connection is established, since the instance can be the IP address.
+ */
+extern RemoteWriteLabel remote_write_labels[2];
 #endif
 
 /**
@@ -61,11 +79,6 @@ static constexpr const char MCU_TYPE[] = "esp8266";
 static constexpr const char MCU_TYPE[] = "unknown";
 #endif
 
-/**
- * The length of the microcontroller type string(MCU_TYPE).
- */
-static constexpr const size_t MCU_TYPE_LEN = utils::strlen(MCU_TYPE);
-
 /**
  * The version of the arduino implementation used on the microcontroller.
  */
@@ -81,11 +94,6 @@ static const char *ARDUINO_VERSION =
 				UNSIGNED_TO_STRING(esp8266::coreVersionRevision()));
 #endif
 
-/**
- * The length of the arduino version string.
- */
-static const size_t ARDUINO_VERSION_LEN = utils::strlen(ARDUINO_VERSION);
-
 /**
  * CPP_VER is a helper macro to get the C++ version number component for the C++ standard version string.
  */
@@ -106,12 +114,7 @@ static const char *CPP_VERSION =
 #else
 		strcat(strcat(new char[6] { 0 }, "c++"), CPP_VER);
 #endif
-
-/**
- * The length of the C++ standard version used to compile this program.
- */
-static const size_t CPP_VERSION_LEN = utils::strlen(CPP_VERSION);
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
 /**
  * Initializes the prometheus integration.
@@ -128,92 +131,84 @@ void loop();
  */
 void connect();
 
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-/**
- * Creates a string containing the metrics for prometheus.
- *
- * @param openmetrics	Whether to generate OpenMetrics compliant output. Default is Prometheus 0.0.4 output.
- * @return	A string containing all the metrics for a prometheus server.
- */
-String getMetrics(const bool openmetrics = false);
-
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#if ENABLE_WEB_SERVER == 1
 /**
- * Writes a metric entry constructed from the given values to the given buffer.
- * All the string arguments have to be compile time constant character arrays, **NOT POINTERS**!
- * This function does write a NUL byte after the text it writes, but this byte isn't considered for the return value.
+ * Gets the lower case name of the given request method, for use as a label value.
  *
- * @tparam ns_l	The length of the metric namespace.
- * @tparam nm_l	The length of the metric name, without the unit and namespace part.
- * @tparam u_l	The length of the unit string.
- * @tparam dc_l	The length of the metric description.
- * @tparam tp_l	The length of the metric type.
- * @param buffer				The character buffer to write to.
- * @param metric_namespace		The name of the metric namespace to use.
- * @param metric_name			The name of the metric to write without the namespace and unit components.
- * @param metric_unit			The unit of the metric to write. May be empty.
- * @param metric_description	The description text for the metric.
- * @param metric_type			The metric type to write to the buffer.
- * @param value					The current value of the given metric.
- * @param openmetrics			Whether to use the OpenMetrics spec, instead of the default prometheus one.
- * @return	The number of bytes written to the output buffer.
+ * @param method	The request method to get the name of.
+ * @return	The name of the request method, or "unknown" for unknown methods.
  */
-template<size_t ns_l, size_t nm_l, size_t u_l, size_t dc_l, size_t tp_l>
-size_t writeMetric(char *buffer, const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&metric_description)[dc_l], const char (&metric_type)[tp_l],
-		const double value, const bool openmetrics = false);
-
-/**
- * Writes a metric metadata line constructed from the given strings to the given buffer.
- * All the string arguments have to be compile time constant character arrays, **NOT POINTERS**!
- * This function does write a NUL byte after the text it writes, but this byte isn't considered for the return value.
- *
- * @tparam fnm_l	The length of the metadata field name.
- * @tparam ns_l		The length of the metric namespace.
- * @tparam nm_l		The length of the metric name, without the unit and namespace part.
- * @tparam u_l		The length of the unit string.
- * @tparam vl_l		The length of the value string.
- * @param buffer				The character buffer to write to.
- * @param field_name			The name of the metric metadata field. Has to be in CAPS.
- * @param metric_namespace		The name of the metric namespace to use.
- * @param metric_name			The name of the metric to write without the namespace and unit components.
- * @param metric_unit			The unit of the metric to write. May be empty.
- * @param value					The value string to write to the output buffer.
- * @return	The number of characters that were written to the output buffer.
- */
-template<size_t fnm_l, size_t ns_l, size_t nm_l, size_t u_l, size_t vl_l>
-size_t writeMetricMetadataLine(char *buffer, const char (&field_name)[fnm_l],
-		const char (&metric_namespace)[ns_l], const char (&metric_name)[nm_l],
-		const char (&metric_unit)[u_l], const char (&value)[vl_l]);
+const char* getMethodName(const WebRequestMethod method);
+#endif
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
-#if ENABLE_WEB_SERVER == 1
+#if ENABLE_MEASUREMENT_BACKLOG == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 /**
- * Checks the total number of request counts.
+ * Gets the difference between the unix time and the time since the boot, in milliseconds.
  *
- * Used to generate the metrics page.
- *
- * @return	The total number of metrics counts.
+ * @param offset	The variable to write the offset to.
+ * @return	False if the clock wasn't synchronized yet.
  */
-size_t getRequestCounts();
+bool getUnixTimeOffset(int64_t &offset);
 #endif
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
 
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 /**
  * The callback method to respond to a HTTP get request for the metrics page.
+ * The metrics are sent in the Prometheus text, OpenMetrics text, or delimited protobuf format,
+ * depending on the Accept header of the request.
+ * The metrics are sent using chunked transfer encoding, generated while sending them.
+ * If the client accepts gzip, they are also compressed while sending them.
+ * If the request has name[] query parameters, only the metric families with those names are written.
  *
  * @param request	The request to respond to.
  * @return	The HTTP status code of the response.
  */
 web::ResponseData handleMetrics(AsyncWebServerRequest *request);
+
+/**
+ * An AwsResponseFiller writing the metrics exposition from an exposition generator.
+ *
+ * @param generator	The generator to write the metrics from.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already written for this response.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t metricsResponseFiller(const std::shared_ptr<ExpositionGenerator> generator,
+		uint8_t *buffer, const size_t max_len, const size_t index);
 #endif
 
 #if ENABLE_PROMETHEUS_PUSH == 1
 /**
  * This method pushes the prometheus metrics to the configured prometheus pushgateway server.
+ *
+ * Reuses the connection of the last push if possible, and connects to the pushgateway otherwise.
+ * Failed pushes are retried with an exponentially increasing delay.
  */
 void pushMetrics();
 #endif
+
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * Sends the metrics to the configured remote write receiver.
+ *
+ * Reuses the connection of the last request if possible, and connects to the receiver otherwise.
+ * Failed requests are retried with the same body, and an exponentially increasing delay.
+ */
+void remoteWrite();
+
+/**
+ * Writes a new remote write request body, and compresses it.
+ * The samples the receiver missed are sent in their own requests, before the current samples.
+ * Current samples that don't fit in the request buffer are dropped,
+ * missed samples that don't fit are sent in the next request.
+ *
+ * @return	False if the clock isn't synchronized yet, or there is nothing to send.
+ */
+bool buildRemoteWriteBody();
+#endif
 }
 
 #endif /* SRC_PROMETHEUS_H_ */
@@ -19,6 +19,13 @@
 #ifdef ESP8266
 #include <fallback_timer.h>
 #endif
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include "prometheus.h"
+#endif
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+#include "MeasurementBacklog.h"
+#include <cmath>
+#endif
 
 namespace sensors {
 
@@ -87,6 +94,10 @@ uint16_t SensorHandler::getMinInterval() const {
 	return MIN_INTERVAL;
 }
 
+uint32_t SensorHandler::getGeneration() {
+	return _generation;
+}
+
 #if SENSOR_TYPE == SENSOR_TYPE_DHT
 DHTHandler dht_handler(SENSOR_PIN, DHT_TYPE);
 SensorHandler &SENSOR_HANDLER = dht_handler;
@@ -95,4 +106,239 @@ DallasHandler dallas_handler(SENSOR_PIN, DALLAS_INDEX);
 SensorHandler &SENSOR_HANDLER = dallas_handler;
 #endif
 
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+/**
+ * The measurements made while the metrics weren't scraped.
+ */
+static MeasurementBacklog backlog;
+
+/**
+ * The state of a measurement metric between two samples.
+ */
+struct MeasurementSampleState {
+	/**
+	 * The sequence number of the next backlog measurement to write.
+	 */
+	uint32_t next;
+
+	/**
+	 * The sequence number after the last backlog measurement to write.
+	 */
+	uint32_t end;
+
+	/**
+	 * The difference between the unix time and the time since the boot, in milliseconds.
+	 */
+	int64_t offset;
+
+	/**
+	 * The time of the current measurement, in milliseconds since the boot, or -1 if there is none.
+	 */
+	int64_t current_time;
+
+	/**
+	 * The time of the newest measurement the receiver already got with a timestamp, in milliseconds since the boot.
+	 */
+	int64_t exported;
+
+	/**
+	 * Whether the samples are written with a timestamp.
+	 */
+	bool timestamped;
+};
+
+/**
+ * Writes the next sample of the temperature or humidity metric.
+ *
+ * If the clock is synchronized, and the receiver accepts timestamps,
+ * the measurements the receiver missed are written first, oldest first, followed by the current measurement.
+ * If only the missed measurements are written, they are only marked as received once they were confirmed.
+ * All of them are written with the time they were measured as their timestamp.
+ * Otherwise only the current measurement is written, without a timestamp.
+ *
+ * @param buffer	The buffer to write the sample line to.
+ * @param size		The size of the buffer.
+ * @param family	The description of the metric.
+ * @param cursor	The position in the samples of the metric.
+ * @param humidity	True to write the humidity, false to write the temperature.
+ * @return	The length of the sample line, or zero if all samples were written.
+ */
+static size_t writeMeasurementSample(char *buffer, const size_t size,
+		const prom::MetricFamily &family, prom::SampleCursor &cursor,
+		const bool humidity) {
+	MeasurementSampleState &state = cursor.getState<MeasurementSampleState>();
+	// Index 0 is the first call, 1 while writing the backlog, and 2 after the current measurement.
+	if (cursor.index == 0) {
+		cursor.index = 1;
+		const int64_t now = esp_timer_get_time() / 1000;
+		const int64_t since = SENSOR_HANDLER.getTimeSinceMeasurement();
+		state.current_time = since < 0 ? -1 : now - since;
+		state.timestamped = cursor.timestamps
+				&& prom::getUnixTimeOffset(state.offset);
+		// Receivers without an identifier only get the current measurement.
+		if (state.timestamped && cursor.consumer != 0) {
+			state.next = backlog.getReceived(cursor.consumer, humidity,
+					state.exported);
+			state.end = backlog.end();
+		}
+	}
+
+	while (state.next < state.end) {
+		BacklogEntry entry;
+		if (!backlog.get(state.next++, entry)) {
+			continue;
+		}
+
+		const float value = humidity ? entry.humidity : entry.temperature;
+		// The last missed measurement may still be the current one, which is written below.
+		// After a sensor failure the last valid measurement can be older than the samples the receiver already got.
+		// Receivers reject samples older than the ones they already have, so those are skipped.
+		if (std::isnan(value) || entry.time >= state.current_time
+				|| entry.time <= state.exported) {
+			continue;
+		}
+		// If the request ends before this measurement, the next one starts with it.
+		if (cursor.missed_only) {
+			backlog.setPending(cursor.consumer, humidity, state.next - 1);
+		}
+		return prom::writeSampleLine(buffer, size, family.name, value,
+				entry.time + state.offset, cursor.openmetrics);
+	}
+
+	if (cursor.index++ > 1) {
+		return 0;
+	}
+
+	// The receiver may still reject the missed measurements, so they are only marked as received once it confirmed them.
+	if (cursor.missed_only) {
+		if (state.timestamped && cursor.consumer != 0) {
+			backlog.setPending(cursor.consumer, humidity, state.end);
+		}
+		return 0;
+	}
+
+	const double value =
+			humidity ?
+					SENSOR_HANDLER.getHumidity() :
+					SENSOR_HANDLER.getTemperature();
+	if (!state.timestamped) {
+		return prom::writeSampleLine(buffer, size, family.name, value);
+	}
+
+	if (cursor.consumer != 0) {
+		backlog.setReceived(cursor.consumer, humidity, state.end,
+				state.current_time);
+	}
+	if (state.current_time < 0) {
+		return prom::writeSampleLine(buffer, size, family.name, value);
+	}
+	return prom::writeSampleLine(buffer, size, family.name, value,
+			state.current_time + state.offset, cursor.openmetrics);
+}
+#endif
+
+/**
+ * The description of the temperature metric.
+ */
+static constexpr prom::MetricFamily TEMPERATURE_FAMILY =
+		PROM_GAUGE_FAMILY_WITH_UNIT(PROMETHEUS_NAMESPACE "_external_temperature",
+				"celsius",
+				"The current measured external temperature in degrees celsius.");
+
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+/**
+ * The temperature metric.
+ * Also writes the missed temperature measurements, with their timestamp.
+ */
+static prom::Collector temperature_metric(TEMPERATURE_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			return writeMeasurementSample(buffer, size, family, cursor, false);
+		}, true);
+#else
+/**
+ * The temperature metric.
+ */
+static prom::Gauge temperature_metric(TEMPERATURE_FAMILY, []() -> double {
+	return SENSOR_HANDLER.getTemperature();
+});
+#endif
+
+/**
+ * The description of the humidity metric.
+ */
+static constexpr prom::MetricFamily HUMIDITY_FAMILY =
+		PROM_GAUGE_FAMILY_WITH_UNIT(PROMETHEUS_NAMESPACE "_external_humidity",
+				"percent",
+				"The current measured external relative humidity in percent.");
+
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+/**
+ * The humidity metric.
+ * Also writes the missed humidity measurements, with their timestamp.
+ */
+static prom::Collector humidity_metric(HUMIDITY_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			return writeMeasurementSample(buffer, size, family, cursor, true);
+		}, true);
+#else
+/**
+ * The humidity metric.
+ */
+static prom::Gauge humidity_metric(HUMIDITY_FAMILY, []() -> double {
+	return SENSOR_HANDLER.getHumidity();
+});
+#endif
+#endif
+
+void registerMetrics() {
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	if (SENSOR_HANDLER.supportsTemperature()) {
+		prom::registry.add(temperature_metric);
+	}
+	if (SENSOR_HANDLER.supportsHumidity()) {
+		prom::registry.add(humidity_metric);
+	}
+#endif
+}
+
+void recordMissedMeasurements() {
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+	static int64_t last_check = 0;
+	const int64_t now = esp_timer_get_time() / 1000;
+	if (now - last_check < MEASUREMENT_BACKLOG_INTERVAL * 1000) {
+		return;
+	}
+
+	const int64_t previous_check = last_check;
+	last_check = now;
+	// Each consumer only gets the kept measurements it missed, so one being offline is enough to keep them.
+	if (!backlog.isMissed(previous_check)) {
+		return;
+	}
+
+	const int64_t since = SENSOR_HANDLER.getTimeSinceValidMeasurement();
+	if (since < 0) {
+		return;
+	}
+
+	const BacklogEntry entry = { now - since,
+			SENSOR_HANDLER.supportsTemperature() ?
+					SENSOR_HANDLER.getLastTemperature() : NAN,
+			SENSOR_HANDLER.supportsHumidity() ?
+					SENSOR_HANDLER.getLastHumidity() : NAN };
+	if (backlog.record(entry)) {
+		log_d("Added the measurement from %lldms ago to the backlog.", since);
+	}
+#endif
+}
+
+void confirmMissedMeasurements(const uint32_t consumer) {
+#if ENABLE_MEASUREMENT_BACKLOG == 1
+	backlog.confirmPending(consumer);
+#endif
+}
+
 } /* namespace sensors */
@@ -44,6 +44,11 @@ protected:
 	 * The system time of the last successful measurement request in milliseconds.
 	 */
 	volatile int64_t _last_valid_request = -1;
+
+	/**
+	 * The measurement generation, incremented every time a measurement finishes or fails.
+	 */
+	volatile uint32_t _generation = 0;
 public:
 	/**
 	 * Creates a new SensorHandler and initializes the minimum interval to be used.
@@ -241,10 +246,43 @@ public:
 	 * @return	The min time between measurements in ms.
 	 */
 	virtual uint16_t getMinInterval() const;
+
+	/**
+	 * Gets the current measurement generation.
+	 *
+	 * The generation is incremented every time a measurement finishes or fails.
+	 * Values derived from the measurements can be cached until the generation changes.
+	 * Note that the time since the last measurement changes regardless.
+	 *
+	 * @return	The current measurement generation.
+	 */
+	virtual uint32_t getGeneration();
 };
 
 extern SensorHandler &SENSOR_HANDLER;
 
+/**
+ * Adds the metrics for the measurements supported by the sensor to the prometheus registry.
+ * Does nothing if the prometheus integration is disabled.
+ */
+void registerMetrics();
+
+/**
+ * Adds the last valid measurement to the measurement backlog, if a known consumer didn't get the metrics for a while.
+ * Should be called every loop iteration.
+ * Does nothing if the measurement backlog is disabled.
+ */
+void recordMissedMeasurements();
+
+/**
+ * Marks the missed measurements last sent to the given consumer as received, once it accepted them.
+ * Only required for metrics written with only the missed samples, which aren't marked as received when written.
+ * Does nothing if the measurement backlog is disabled.
+ *
+ * @param consumer	The id of the consumer that accepted the measurements.
+ */
+void confirmMissedMeasurements(const uint32_t consumer);
+
 }
 
 #endif /* SRC_SENSOR_HANDLER_H_ */
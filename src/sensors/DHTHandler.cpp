@@ -35,6 +35,7 @@ bool DHTHandler::requestMeasurement() {
 		_last_request = now;
 		if (!_dht.read(false)) {
 			_temperature = _humidity = NAN;
+			_generation++;
 			log_w("Failed to read data from dht.");
 			return false;
 		}
@@ -42,6 +43,7 @@ bool DHTHandler::requestMeasurement() {
 		_temperature = _dht.readTemperature(false);
 		_humidity = _dht.readHumidity(false);
 		_last_finished_request = _last_request;
+		_generation++;
 
 		// Measurements are considered to be either entirely valid, or entirely invalid.
 		if (!std::isnan(_temperature) && !std::isnan(_humidity)) {
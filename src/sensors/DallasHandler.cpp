@@ -88,6 +88,7 @@ float DallasHandler::getTemperature() {
 			log_w("Failed to get address for sensor %u.", SENSOR_INDEX);
 			_temperature = NAN;
 			_last_finished_request = _last_request;
+			_generation++;
 			return _temperature;
 		}
 
@@ -109,6 +110,7 @@ float DallasHandler::getTemperature() {
 		}
 
 		_last_finished_request = _last_request;
+		_generation++;
 
 		if (!std::isnan(_temperature)) {
 			_last_valid_temperature = _temperature;
@@ -140,4 +142,10 @@ float DallasHandler::getLastHumidity() {
 	return NAN;
 }
 
+uint32_t DallasHandler::getGeneration() {
+	// Read the finished measurement first, if it wasn't read yet.
+	getTemperature();
+	return _generation;
+}
+
 } /* namespace sensors */
@@ -78,6 +78,7 @@ public:
 	virtual bool supportsHumidity() const override;
 	virtual float getHumidity() override;
 	virtual float getLastHumidity() override;
+	virtual uint32_t getGeneration() override;
 };
 
 } /* namespace sensors */
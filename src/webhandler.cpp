@@ -10,18 +10,24 @@
 
 #include "webhandler.h"
 #if ENABLE_WEB_SERVER == 1
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_PUSH == 1
-#include "prometheus.h"
-#endif
 #include "sensor_handler.h"
 #include "generated/web_file_hashes.h"
+#include "generated/web_file_checkpoints.h"
 #include "AsyncHeadOnlyResponse.h"
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include "prometheus.h"
+#endif
 #ifdef ESP32
 #include <ESPmDNS.h>
 #elif defined(ESP8266)
 #include <ESP8266mDNS.h>
 #endif
 #include <fallback_log.h>
+#include <http_utils.h>
+#include <json_writer.h>
+#include <utils.h>
+#include <climits>
+#include <cinttypes>
 #if ENABLE_TIMINGS_API == 1 && defined(ESP8266)
 #include <fallback_timer.h>
 #endif
@@ -29,7 +35,28 @@
 
 #if ENABLE_WEB_SERVER == 1
 AsyncWebServer web::server(WEB_SERVER_PORT);
-std::map<String, web::AsyncTrackingFallbackWebHandler*> web::handlers;
+http::RouteTable<web::AsyncTrackingFallbackWebHandler*> web::handlers;
+web::AsyncRouteDispatcher web::dispatcher(handlers);
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+web::RequestCounters web::not_found_counters;
+#endif
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+web::RequestDurations web::not_found_durations;
+#endif
+web::DecompressedFileCache web::decompressed_cache(DECOMPRESSED_CACHE_SIZE);
+gzip::uzlib_dict_pool web::decomp_dict_pool(GZIP_DECOMP_DICT_POOL_SIZE,
+		GZIP_DECOMP_WINDOW_SIZE);
+sensors::MeasurementCache web::temperature_cache;
+sensors::MeasurementCache web::humidity_cache;
+const std::shared_ptr<const http::CompiledTemplate> web::error_template =
+		std::make_shared<http::CompiledTemplate>(ERROR_HTML_START,
+				ERROR_HTML_END - 1, std::vector<std::string> { "TITLE",
+						"ERROR", "DETAILS" }, TEMPLATE_CHAR);
+uint32_t web::etag_boot_id = 0;
+#if ENABLE_EVENT_STREAM == 1
+AsyncEventSource web::events("/events");
+uint32_t web::events_generation = 0;
+#endif
 
 web::ResponseData::ResponseData(AsyncWebServerResponse *response,
 		size_t content_len, uint16_t status_code) :
@@ -37,10 +64,397 @@ web::ResponseData::ResponseData(AsyncWebServerResponse *response,
 				status_code) {
 
 }
+
+web::CompressionStats::CompressionStats() :
+		input_bytes(0), output_bytes(0), time_micros(0), ratio(NAN) {
+
+}
+#endif
+
+#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1)
+/**
+ * The labels of the response status classes of the request counters.
+ */
+static const char *const STATUS_CLASS_NAMES[] = { "1xx", "2xx", "3xx", "4xx",
+		"5xx" };
+
+/**
+ * The position in the request counters kept between two samples.
+ * The index of the sample cursor is the index of the route.
+ * The index after the last route contains the counters of all unknown paths.
+ */
+struct RequestCountersState {
+	/**
+	 * The index of the next request method in the current route.
+	 */
+	uint8_t method;
+
+	/**
+	 * The index of the next status class in the current method.
+	 */
+	uint8_t status_class;
+
+	/**
+	 * The copied counters of the current route.
+	 */
+	web::RequestCounters::Snapshot counts;
+};
+
+/**
+ * Writes the next non-zero request counter sample, moving to the next route when the current one is done.
+ *
+ * @param buffer	The buffer to write the sample to.
+ * @param size		The size of the buffer.
+ * @param family	The description of the request counters.
+ * @param cursor	The position in the request counters.
+ * @return	The length of the sample line, or zero if all counters were written.
+ */
+static size_t writeRequestCountersSample(char *buffer, const size_t size,
+		const prom::MetricFamily &family, prom::SampleCursor &cursor) {
+	const std::vector<
+			http::RouteTable<web::AsyncTrackingFallbackWebHandler*>::Route> &routes =
+			web::handlers.getRoutes();
+	RequestCountersState &state = cursor.getState<RequestCountersState>();
+	while (cursor.index <= routes.size()) {
+		if (state.method == 0 && state.status_class == 0) {
+			// Copy the counters first, so they can't change while they are written.
+			if (cursor.index < routes.size()) {
+				routes[cursor.index].second->getCounters().snapshot(
+						state.counts);
+			} else {
+				web::not_found_counters.snapshot(state.counts);
+			}
+		}
+
+		while (state.method < web::RequestCounters::METHODS) {
+			const uint8_t method = state.method;
+			const uint8_t status_class = state.status_class++;
+			if (state.status_class >= web::RequestCounters::STATUS_CLASSES) {
+				state.status_class = 0;
+				state.method++;
+			}
+
+			const uint32_t count = state.counts.counts[method][status_class];
+			if (count > 0) {
+				return snprintf(buffer, size,
+						"%s{method=\"%s\",code=\"%s\",path=\"%s\"} %u\n",
+						family.name,
+						prom::getMethodName((WebRequestMethod) (1 << method)),
+						STATUS_CLASS_NAMES[status_class],
+						cursor.index < routes.size() ?
+								routes[cursor.index].first.c_str() : "unknown",
+						(unsigned int) count);
+			}
+		}
+
+		cursor.index++;
+		state.method = 0;
+		state.status_class = 0;
+	}
+	return 0;
+}
+
+/**
+ * The description of the request counters.
+ */
+static constexpr prom::MetricFamily REQUESTS_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_http_requests_total",
+		"The total number of HTTP requests handled by this server.");
+
+/**
+ * The request counters of all routes.
+ */
+static prom::Collector requests_metric(REQUESTS_FAMILY,
+		writeRequestCountersSample);
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+/**
+ * The labels of the request phases of the request duration histograms.
+ */
+static const char *const PHASE_NAMES[] = { "handler", "send" };
+
+/**
+ * The position in the request duration histograms kept between two samples.
+ * The index of the sample cursor is the index of the route.
+ * The index after the last route is the one for unknown paths.
+ */
+struct RequestDurationsState {
+	/**
+	 * The index of the request method of the current histogram.
+	 * The index after the last method is the one of the fallback handler.
+	 */
+	uint8_t method;
+
+	/**
+	 * The index of the request phase of the current histogram.
+	 */
+	uint8_t phase;
+
+	/**
+	 * The index of the next line of the current histogram.
+	 * The histogram buckets are followed by the sum and the count.
+	 */
+	uint8_t line;
+
+	/**
+	 * The copied cumulative bucket counts of the current histogram.
+	 * The last bucket is the +Inf bucket, which is also the count.
+	 */
+	uint32_t buckets[web::RequestDurationHistogram::BUCKETS];
+
+	/**
+	 * The copied sum of the current histogram.
+	 */
+	uint64_t sum;
+};
+
+/**
+ * Gets the request durations for the given route and method.
+ *
+ * @param route		The index of the route. The index after the last route is the one for unknown paths.
+ * @param method	The index of the request method. The index after the last method is the fallback handler.
+ * @return	The request durations, or NULL if nothing should be written for them.
+ */
+static const web::RequestDurations* getRequestDurations(const size_t route,
+		const uint8_t method) {
+	const std::vector<
+			http::RouteTable<web::AsyncTrackingFallbackWebHandler*>::Route> &routes =
+			web::handlers.getRoutes();
+	const web::RequestDurations *durations = NULL;
+	if (route == routes.size()) {
+		// Unknown paths only have a single histogram pair, written as the fallback handler.
+		durations = &web::not_found_durations;
+	} else if (method < web::RequestCounters::METHODS) {
+		durations = routes[route].second->getDurations(
+				(WebRequestMethod) (1 << method));
+	} else {
+		durations = &routes[route].second->getFallbackDurations();
+	}
+
+	// Histograms are only written once they recorded a request.
+	if (!durations || durations->handler.getCount() == 0) {
+		return NULL;
+	}
+	return durations;
+}
+
+/**
+ * Writes the next line of the current request duration histogram,
+ * moving to the next histogram when the current one is done.
+ *
+ * @param buffer	The buffer to write the sample to.
+ * @param size		The size of the buffer.
+ * @param family	The description of the request duration histograms.
+ * @param cursor	The position in the request duration histograms.
+ * @return	The length of the sample line, or zero if all histograms were written.
+ */
+static size_t writeRequestDurationsSample(char *buffer, const size_t size,
+		const prom::MetricFamily &family, prom::SampleCursor &cursor) {
+	const std::vector<
+			http::RouteTable<web::AsyncTrackingFallbackWebHandler*>::Route> &routes =
+			web::handlers.getRoutes();
+	RequestDurationsState &state = cursor.getState<RequestDurationsState>();
+	while (cursor.index <= routes.size()) {
+		const web::RequestDurations *durations = getRequestDurations(
+				cursor.index, state.method);
+		if (!durations) {
+			if (++state.method > web::RequestCounters::METHODS
+					|| cursor.index == routes.size()) {
+				cursor.index++;
+				state.method = 0;
+			}
+			continue;
+		}
+
+		const web::RequestDurationHistogram &histogram =
+				state.phase == 0 ? durations->handler : durations->send;
+		if (state.line == 0) {
+			// Copy the histogram first, so its buckets and count always match.
+			for (size_t i = 0; i < web::RequestDurationHistogram::BUCKETS; i++) {
+				state.buckets[i] = histogram.getCumulativeCount(i);
+			}
+			state.sum = histogram.getSum();
+		}
+
+		const char *method =
+				state.method < web::RequestCounters::METHODS
+						&& cursor.index < routes.size() ?
+						prom::getMethodName(
+								(WebRequestMethod) (1 << state.method)) :
+						"other";
+		const char *path =
+				cursor.index < routes.size() ?
+						routes[cursor.index].first.c_str() : "unknown";
+		const char *phase = PHASE_NAMES[state.phase];
+		const uint8_t line = state.line++;
+		if (state.line >= web::RequestDurationHistogram::BUCKETS + 2) {
+			state.line = 0;
+			if (++state.phase >= 2) {
+				state.phase = 0;
+				if (++state.method > web::RequestCounters::METHODS
+						|| cursor.index == routes.size()) {
+					cursor.index++;
+					state.method = 0;
+				}
+			}
+		}
+
+		if (line < web::RequestDurationHistogram::BUCKETS - 1) {
+			return snprintf(buffer, size,
+					"%s_bucket{method=\"%s\",path=\"%s\",phase=\"%s\",le=\"%g\"} %u\n",
+					family.name, method, path, phase,
+					histogram.getBound(line) / 1000000.0,
+					(unsigned int) state.buckets[line]);
+		} else if (line == web::RequestDurationHistogram::BUCKETS - 1) {
+			return snprintf(buffer, size,
+					"%s_bucket{method=\"%s\",path=\"%s\",phase=\"%s\",le=\"+Inf\"} %u\n",
+					family.name, method, path, phase,
+					(unsigned int) state.buckets[line]);
+		} else if (line == web::RequestDurationHistogram::BUCKETS) {
+			return snprintf(buffer, size,
+					"%s_sum{method=\"%s\",path=\"%s\",phase=\"%s\"} %.6f\n",
+					family.name, method, path, phase, state.sum / 1000000.0);
+		} else {
+			return snprintf(buffer, size,
+					"%s_count{method=\"%s\",path=\"%s\",phase=\"%s\"} %u\n",
+					family.name, method, path, phase,
+					(unsigned int) state.buckets[web::RequestDurationHistogram::BUCKETS
+							- 1]);
+		}
+	}
+	return 0;
+}
+
+/**
+ * The description of the request duration histograms.
+ */
+static constexpr prom::MetricFamily REQUEST_DURATIONS_FAMILY =
+		PROM_HISTOGRAM_FAMILY_WITH_UNIT(
+				PROMETHEUS_NAMESPACE "_http_request_duration", "seconds",
+				"The time spent handling HTTP requests, by request phase.");
+
+/**
+ * The request duration histograms of all routes.
+ */
+static prom::Collector request_durations_metric(REQUEST_DURATIONS_FAMILY,
+		writeRequestDurationsSample);
+#endif
+
+/**
+ * The description of the decompressed cache hit counter.
+ */
+static constexpr prom::MetricFamily CACHE_HITS_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_decompressed_cache_hits_total",
+		"The number of requests answered from the decompressed static file cache.");
+
+/**
+ * The decompressed cache hit counter.
+ */
+static prom::Counter cache_hits_metric(CACHE_HITS_FAMILY, []() -> uint64_t {
+	return web::decompressed_cache.getHits();
+});
+
+/**
+ * The description of the decompressed cache miss counter.
+ */
+static constexpr prom::MetricFamily CACHE_MISSES_FAMILY = PROM_COUNTER_FAMILY(
+		PROMETHEUS_NAMESPACE "_decompressed_cache_misses_total",
+		"The number of requests for files not in the decompressed static file cache.");
+
+/**
+ * The decompressed cache miss counter.
+ */
+static prom::Counter cache_misses_metric(CACHE_MISSES_FAMILY,
+		[]() -> uint64_t {
+			return web::decompressed_cache.getMisses();
+		});
+
+/**
+ * The description of the decompressed cache eviction counter.
+ */
+static constexpr prom::MetricFamily CACHE_EVICTIONS_FAMILY =
+		PROM_COUNTER_FAMILY(
+				PROMETHEUS_NAMESPACE "_decompressed_cache_evictions_total",
+				"The number of files removed from the decompressed static file cache.");
+
+/**
+ * The decompressed cache eviction counter.
+ */
+static prom::Counter cache_evictions_metric(CACHE_EVICTIONS_FAMILY,
+		[]() -> uint64_t {
+			return web::decompressed_cache.getEvictions();
+		});
+
+/**
+ * The description of the decompressed cache size gauge.
+ */
+static constexpr prom::MetricFamily CACHE_SIZE_FAMILY =
+		PROM_GAUGE_FAMILY_WITH_UNIT(
+				PROMETHEUS_NAMESPACE "_decompressed_cache_size", "bytes",
+				"The total size of all files in the decompressed static file cache.");
+
+/**
+ * The decompressed cache size gauge.
+ */
+static prom::Gauge cache_size_metric(CACHE_SIZE_FAMILY, []() -> double {
+	return web::decompressed_cache.getSize();
+});
+
+/**
+ * The description of the gzip dict pool size gauge.
+ */
+static constexpr prom::MetricFamily DICT_POOL_SIZE_FAMILY = PROM_GAUGE_FAMILY(
+		PROMETHEUS_NAMESPACE "_gzip_dict_pool_dicts",
+		"The total number of preallocated gzip decompression dicts.");
+
+/**
+ * The gzip dict pool size gauge.
+ */
+static prom::Gauge dict_pool_size_metric(DICT_POOL_SIZE_FAMILY,
+		[]() -> double {
+			return web::decomp_dict_pool.getSize();
+		});
+
+/**
+ * The description of the gauge for the gzip dicts in use.
+ */
+static constexpr prom::MetricFamily DICT_POOL_IN_USE_FAMILY =
+		PROM_GAUGE_FAMILY(PROMETHEUS_NAMESPACE "_gzip_dict_pool_dicts_in_use",
+				"The number of gzip decompression dicts currently in use.");
+
+/**
+ * The gauge for the gzip dicts in use.
+ */
+static prom::Gauge dict_pool_in_use_metric(DICT_POOL_IN_USE_FAMILY,
+		[]() -> double {
+			return web::decomp_dict_pool.getInUse();
+		});
+
+/**
+ * The description of the gzip dict pool exhaustion counter.
+ */
+static constexpr prom::MetricFamily DICT_POOL_EXHAUSTED_FAMILY =
+		PROM_COUNTER_FAMILY(
+				PROMETHEUS_NAMESPACE "_gzip_dict_pool_exhausted_total",
+				"The number of times a gzip decompression dict was requested while all dicts were in use.");
+
+/**
+ * The gzip dict pool exhaustion counter.
+ */
+static prom::Counter dict_pool_exhausted_metric(DICT_POOL_EXHAUSTED_FAMILY,
+		[]() -> uint64_t {
+			return web::decomp_dict_pool.getFailures();
+		});
 #endif
 
 void web::setup() {
 #if ENABLE_WEB_SERVER == 1
+#ifdef ESP32
+	etag_boot_id = esp_random();
+#elif defined(ESP8266)
+	etag_boot_id = ESP.random();
+#endif
+
 	std::map<String, std::function<std::string()>> index_replacements = { {
 			"TEMP", std::bind(&sensors::SensorHandler::getLastTemperatureString,
 					&sensors::SENSOR_HANDLER) }, { "HUMID", std::bind(
@@ -51,33 +465,62 @@ void web::setup() {
 
 	registerRedirect("/", "/index.html");
 	registerReplacingStaticHandler("/index.html", "text/html", INDEX_HTML_START,
-			INDEX_HTML_END - 1, index_replacements);
+			INDEX_HTML_END - 1, index_replacements, INDEX_HTML_HASH);
 
-	registerCompressedStaticHandler("/main.css", "text/css", MAIN_CSS_START,
-			MAIN_CSS_END, MAIN_CSS_GZ_HASH);
+	registerCompressedStaticHandler("/main.css", "text/css",
+			{ MAIN_CSS_START, MAIN_CSS_END, MAIN_CSS_DEFLATE_START,
+					MAIN_CSS_DEFLATE_END, MAIN_CSS_IDENTITY_START,
+					MAIN_CSS_IDENTITY_END, MAIN_CSS_GZ_CHECKPOINTS,
+					MAIN_CSS_GZ_CHECKPOINTS_LEN }, MAIN_CSS_GZ_HASH);
 	registerCompressedStaticHandler("/index.js", "text/javascript",
-			INDEX_JS_START, INDEX_JS_END, INDEX_JS_GZ_HASH);
+			{ INDEX_JS_START, INDEX_JS_END, INDEX_JS_DEFLATE_START,
+					INDEX_JS_DEFLATE_END, INDEX_JS_IDENTITY_START,
+					INDEX_JS_IDENTITY_END, INDEX_JS_GZ_CHECKPOINTS,
+					INDEX_JS_GZ_CHECKPOINTS_LEN }, INDEX_JS_GZ_HASH);
 	registerCompressedStaticHandler("/manifest.json", "application/json",
-			MANIFEST_JSON_START, MANIFEST_JSON_END, MANIFEST_JSON_GZ_HASH);
+			{ MANIFEST_JSON_START, MANIFEST_JSON_END, MANIFEST_JSON_DEFLATE_START,
+					MANIFEST_JSON_DEFLATE_END, MANIFEST_JSON_IDENTITY_START,
+					MANIFEST_JSON_IDENTITY_END, MANIFEST_JSON_GZ_CHECKPOINTS,
+					MANIFEST_JSON_GZ_CHECKPOINTS_LEN }, MANIFEST_JSON_GZ_HASH);
 
 	registerRequestHandler("/temperature", HTTP_GET,
 			[](AsyncWebServerRequest *request) -> ResponseData {
-				const std::string temp =
-						sensors::SENSOR_HANDLER.getTemperatureString();
+				const std::string etag = getMeasurementETag();
+				if (hasCurrentETag(request, etag.c_str())) {
+					return notModifiedHandler("text/plain", etag.c_str(),
+							request);
+				}
+
+				const std::shared_ptr<const std::string> temp =
+						temperature_cache.get(
+								std::bind(
+										&sensors::SensorHandler::getTemperatureString,
+										&sensors::SENSOR_HANDLER));
 				AsyncWebServerResponse *response = request->beginResponse(200,
-						"text/plain", temp.c_str());
-				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
-				return ResponseData(response, temp.length(), 200);
+						"text/plain", temp->c_str());
+				response->addHeader("ETag", etag.c_str());
+				response->addHeader("Cache-Control", CACHE_CONTROL_CACHE);
+				return ResponseData(response, temp->length(), 200);
 			});
 
 	registerRequestHandler("/humidity", HTTP_GET,
 			[](AsyncWebServerRequest *request) -> ResponseData {
-				const std::string humidity =
-						sensors::SENSOR_HANDLER.getHumidityString();
+				const std::string etag = getMeasurementETag();
+				if (hasCurrentETag(request, etag.c_str())) {
+					return notModifiedHandler("text/plain", etag.c_str(),
+							request);
+				}
+
+				const std::shared_ptr<const std::string> humidity =
+						humidity_cache.get(
+								std::bind(
+										&sensors::SensorHandler::getHumidityString,
+										&sensors::SENSOR_HANDLER));
 				AsyncWebServerResponse *response = request->beginResponse(200,
-						"text/plain", humidity.c_str());
-				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
-				return ResponseData(response, humidity.length(), 200);
+						"text/plain", humidity->c_str());
+				response->addHeader("ETag", etag.c_str());
+				response->addHeader("Cache-Control", CACHE_CONTROL_CACHE);
+				return ResponseData(response, humidity->length(), 200);
 			});
 
 #if ENABLE_TIMINGS_API == 1
@@ -121,17 +564,67 @@ void web::setup() {
 
 	registerRequestHandler("/data.json", HTTP_GET, getJson);
 
+#if ENABLE_EVENT_STREAM == 1
+	events.setFilter(eventStreamFilter);
+	events.onConnect([](AsyncEventSourceClient *client) {
+		// Reconnecting clients send the id of the last event they received.
+		const uint32_t id = getEventId(
+				sensors::SENSOR_HANDLER.getGeneration());
+		if (client->lastId() != id) {
+			char json[MEASUREMENT_JSON_MAX_LEN + 1];
+			writeMeasurementJson(json);
+			client->send(json, "measurement", id);
+		}
+	});
+	server.addHandler(&events);
+
+	// Handles the clients rejected by the event stream filter.
+	registerRequestHandler("/events", HTTP_GET,
+			[](AsyncWebServerRequest *request) -> ResponseData {
+				log_i("Rejecting event stream client, sending 503 response.");
+				AsyncWebServerResponse *response = request->beginResponse(503);
+				response->addHeader("Retry-After", "10");
+				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+				return ResponseData(response, 0, 503);
+			});
+#endif
+
 	registerCompressedStaticHandler("/favicon.ico", "image/x-icon",
-			FAVICON_ICO_GZ_START, FAVICON_ICO_GZ_END, FAVICON_ICO_GZ_HASH);
+			{ FAVICON_ICO_GZ_START, FAVICON_ICO_GZ_END, FAVICON_ICO_DEFLATE_START,
+					FAVICON_ICO_DEFLATE_END, FAVICON_ICO_IDENTITY_START,
+					FAVICON_ICO_IDENTITY_END, FAVICON_ICO_GZ_CHECKPOINTS,
+					FAVICON_ICO_GZ_CHECKPOINTS_LEN }, FAVICON_ICO_GZ_HASH);
 	registerCompressedStaticHandler("/favicon.png", "image/png",
-			FAVICON_PNG_GZ_START, FAVICON_PNG_GZ_END, FAVICON_PNG_GZ_HASH);
+			{ FAVICON_PNG_GZ_START, FAVICON_PNG_GZ_END, FAVICON_PNG_DEFLATE_START,
+					FAVICON_PNG_DEFLATE_END, FAVICON_PNG_IDENTITY_START,
+					FAVICON_PNG_IDENTITY_END, FAVICON_PNG_GZ_CHECKPOINTS,
+					FAVICON_PNG_GZ_CHECKPOINTS_LEN }, FAVICON_PNG_GZ_HASH);
 	registerCompressedStaticHandler("/favicon.svg", "image/svg+xml",
-			FAVICON_SVG_GZ_START, FAVICON_SVG_GZ_END, FAVICON_SVG_GZ_HASH);
+			{ FAVICON_SVG_GZ_START, FAVICON_SVG_GZ_END, FAVICON_SVG_DEFLATE_START,
+					FAVICON_SVG_DEFLATE_END, FAVICON_SVG_IDENTITY_START,
+					FAVICON_SVG_IDENTITY_END, FAVICON_SVG_GZ_CHECKPOINTS,
+					FAVICON_SVG_GZ_CHECKPOINTS_LEN }, FAVICON_SVG_GZ_HASH);
 
 	// An OPTIONS request to * is supposed to return server-wide support.
 	registerRequestHandler("*", HTTP_OPTIONS,
 			std::bind(optionsHandler, HTTP_GET | HTTP_HEAD | HTTP_OPTIONS,
-					std::placeholders::_1));
+					std::placeholders::_1), false);
+
+	// Added after the event stream, so the event stream gets to check its requests first.
+	server.addHandler(&dispatcher);
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	prom::registry.add(requests_metric);
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	prom::registry.add(request_durations_metric);
+#endif
+	prom::registry.add(cache_hits_metric);
+	prom::registry.add(cache_misses_metric);
+	prom::registry.add(cache_evictions_metric);
+	prom::registry.add(cache_size_metric);
+	prom::registry.add(dict_pool_size_metric);
+	prom::registry.add(dict_pool_in_use_metric);
+	prom::registry.add(dict_pool_exhausted_metric);
+#endif
 
 	server.onNotFound(notFoundHandler);
 
@@ -150,7 +643,12 @@ void web::setup() {
 }
 
 void web::loop() {
-
+#if ENABLE_WEB_SERVER == 1
+	decompressed_cache.trim(DECOMPRESSED_CACHE_MIN_FREE_HEAP);
+#if ENABLE_EVENT_STREAM == 1
+	pushMeasurementEvent();
+#endif
+#endif
 }
 
 void web::connect() {
@@ -187,113 +685,271 @@ bool web::csvHeaderContains(const char *header, const char *value) {
 	}
 }
 
+uint16_t web::parseRangeHeader(const char *header, const size_t size,
+		size_t &first, size_t &last) {
+	if (strncmp(header, "bytes=", 6) != 0) {
+		return 200;
+	}
+
+	const char *pos = header + 6;
+	while (*pos == ' ') {
+		pos++;
+	}
+
+	// Multiple ranges would require a multipart response, so they are ignored.
+	if (strchr(pos, ',') != NULL) {
+		return 200;
+	}
+
+	char *num_end = NULL;
+	if (*pos == '-') {
+		// A suffix range, requesting the last n bytes.
+		if (!isdigit(pos[1])) {
+			return 200;
+		}
+		const unsigned long long suffix = strtoull(pos + 1, &num_end, 10);
+		while (*num_end == ' ') {
+			num_end++;
+		}
+		if (*num_end != 0) {
+			return 200;
+		}
+		if (suffix == 0 || size == 0) {
+			return 416;
+		}
+		first = suffix >= size ? 0 : size - suffix;
+		last = size - 1;
+		return 206;
+	}
+
+	if (!isdigit(*pos)) {
+		return 200;
+	}
+	const unsigned long long range_first = strtoull(pos, &num_end, 10);
+	if (*num_end != '-') {
+		return 200;
+	}
+	pos = num_end + 1;
+	unsigned long long range_last = ULLONG_MAX;
+	if (isdigit(*pos)) {
+		range_last = strtoull(pos, &num_end, 10);
+		if (range_last < range_first) {
+			return 200;
+		}
+	} else {
+		num_end = (char*) pos;
+	}
+	while (*num_end == ' ') {
+		num_end++;
+	}
+	if (*num_end != 0) {
+		return 200;
+	}
+
+	if (range_first >= size) {
+		return 416;
+	}
+	first = range_first;
+	last = range_last >= size ? size - 1 : range_last;
+	return 206;
+}
+
 web::ResponseData web::getJson(AsyncWebServerRequest *request) {
-	// TODO format time from int64_t using snprintf
-	const std::string time_string =
-			sensors::SENSOR_HANDLER.getTimeSinceValidMeasurementString();
-	// Valid values will never be longer than "Unknown".
-	const size_t max_len = 62 + time_string.length();
-	char *buffer = new char[max_len + 1];
-	buffer[0] = 0;
-
-	strcpy(buffer, "{\"temperature\": ");
-	size_t len = 16;
+	static const char *const encodings[] = { "gzip", "identity" };
+	const bool compress = JSON_GZIP_WINDOW_SIZE != 0
+			&& request->hasHeader("Accept-Encoding")
+			&& http::negotiateEncoding(
+					request->header("Accept-Encoding").c_str(), encodings, 2)
+					== 0;
+
+	// The time since the last measurement isn't part of the entity tag, since clients can calculate it themselves.
+	std::string etag = getMeasurementETag();
+	if (compress) {
+		// Like for static files, each content coding has its own entity tag.
+		etag.insert(etag.size() - 1, "-gzip");
+	}
+	if (hasCurrentETag(request, etag.c_str())) {
+		ResponseData response = notModifiedHandler("application/json",
+				etag.c_str(), request);
+		response.response->addHeader("Vary", "Accept-Encoding");
+		return response;
+	}
+
+	char json[MEASUREMENT_JSON_MAX_LEN + 1];
+	size_t len = writeMeasurementJson(json);
+	AsyncWebServerResponse *response = NULL;
+	if (compress) {
+		using namespace std::placeholders;
+		// The json is copied into the source, since it is compressed after this handler returned.
+		const std::string data(json, len);
+		size_t index = 0;
+		std::shared_ptr<gzip::uzlib_gzip_wrapper> comp = std::make_shared<
+				gzip::uzlib_gzip_wrapper>(
+				[data, index](uint8_t *buf, const size_t max_len) mutable -> size_t {
+					const size_t read = min(max_len, data.size() - index);
+					memcpy(buf, data.data() + index, read);
+					index += read;
+					return read;
+				}, JSON_GZIP_WINDOW_SIZE);
+		// A new compressor is only done if its buffers couldn't be allocated.
+		if (comp->done()) {
+			log_w("Failed to allocate json compression buffers, sending uncompressed json.");
+			etag = getMeasurementETag();
+		} else {
+			response = request->beginChunkedResponse("application/json",
+					std::bind(compressingResponseFiller, comp,
+							(CompressionStats*) NULL, _1, _2, _3));
+			response->addHeader("Content-Encoding", "gzip");
+			// The length of the compressed json isn't known before it is sent.
+			len = 0;
+		}
+	}
+
+	if (!response) {
+		response = request->beginResponse(200, "application/json", json);
+	}
+	response->addHeader("ETag", etag.c_str());
+	response->addHeader("Cache-Control", CACHE_CONTROL_CACHE);
+	response->addHeader("Vary", "Accept-Encoding");
+	return ResponseData(response, len, 200);
+}
+
+size_t web::writeMeasurementJson(
+		char (&buffer)[MEASUREMENT_JSON_MAX_LEN + 1]) {
+	utils::JsonWriter writer(buffer, MEASUREMENT_JSON_MAX_LEN);
+	writer.beginObject();
+
+	writer.key("temperature");
 	const float temperature = sensors::SENSOR_HANDLER.getLastTemperature();
 	if (std::isnan(temperature)) {
-		strcpy(buffer + len, "\"Unknown\"");
-		len += 9;
+		writer.value("Unknown");
 	} else {
-		len += snprintf(buffer + len, max_len - len, "%.2f", temperature);
+		writer.value(temperature, 2);
 	}
 
-	strcpy(buffer + len, ", \"humidity\": ");
-	len += 14;
+	writer.key("humidity");
 	const float humidity = sensors::SENSOR_HANDLER.getLastHumidity();
 	if (std::isnan(humidity)) {
-		strcpy(buffer + len, "\"Unknown\"");
-		len += 9;
+		writer.value("Unknown");
 	} else {
-		len += snprintf(buffer + len, max_len - len, "%.2f", humidity);
+		writer.value(humidity, 2);
 	}
-	len += snprintf(buffer + len, max_len - len, ", \"time\": \"%s\"}",
-			time_string.c_str());
 
-	AsyncWebServerResponse *response = request->beginResponse(200,
-			"application/json", buffer);
-	delete[] buffer;
-	response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
-	return ResponseData(response, len, 200);
+	char time_string[13];
+	const size_t time_len = utils::timespan_to_chars(
+			sensors::SENSOR_HANDLER.getTimeSinceValidMeasurement(),
+			time_string);
+	writer.key("time").value(time_string, time_len);
+	writer.endObject();
+
+	if (writer.overflowed()) {
+		log_e("Measurement json of length %u didn't fit its buffer.",
+				(unsigned int) writer.length());
+	}
+	buffer[writer.written()] = 0;
+	return writer.written();
 }
 
+std::string web::getMeasurementETag(const char *prefix) {
+	// Quotes, up to 32 prefix chars, two dashes, two 32 bit hex numbers, and the NUL byte.
+	char etag[53];
+	const uint32_t generation = sensors::SENSOR_HANDLER.getGeneration();
+	if (prefix != NULL) {
+		snprintf(etag, sizeof(etag), "\"%.32s-%08" PRIx32 "-%" PRIx32 "\"",
+				prefix, etag_boot_id, generation);
+	} else {
+		snprintf(etag, sizeof(etag), "\"%08" PRIx32 "-%" PRIx32 "\"",
+				etag_boot_id, generation);
+	}
+	return etag;
+}
+
+bool web::hasCurrentETag(AsyncWebServerRequest *request, const char *etag) {
+	return request->hasHeader("If-None-Match")
+			&& csvHeaderContains(request->header("If-None-Match").c_str(),
+					etag);
+}
+
+#if ENABLE_EVENT_STREAM == 1
+bool web::eventStreamFilter(AsyncWebServerRequest *request) {
+	// Filters are checked for every request, before the uri.
+	if (request->url() != "/events") {
+		return true;
+	} else if (events.count() >= EVENT_STREAM_MAX_CLIENTS) {
+		log_d("Max number of event stream clients reached.");
+		return false;
+	} else if (ESP.getFreeHeap() < EVENT_STREAM_MIN_FREE_HEAP) {
+		log_d("Free heap too low for a new event stream client.");
+		return false;
+	}
+	return true;
+}
+
+uint32_t web::getEventId(const uint32_t generation) {
+	const uint32_t id = etag_boot_id + generation;
+	return id != 0 ? id : 1;
+}
+
+void web::pushMeasurementEvent() {
+	const uint32_t generation = sensors::SENSOR_HANDLER.getGeneration();
+	if (generation == events_generation) {
+		return;
+	}
+
+	if (events.count() > 0) {
+		if (ESP.getFreeHeap() < EVENT_STREAM_MIN_FREE_HEAP) {
+			return;
+		}
+		char json[MEASUREMENT_JSON_MAX_LEN + 1];
+		writeMeasurementJson(json);
+		events.send(json, "measurement", getEventId(generation));
+	}
+	events_generation = generation;
+}
+#endif
+
 size_t web::decompressingResponseFiller(
 		const std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp,
 		uint8_t *buffer, const size_t max_len, const size_t index) {
 	return decomp->decompress(buffer, max_len);
 }
 
-size_t web::replacingResponseFiller(
-		const std::map<String, String> &replacements,
-		std::shared_ptr<int64_t> offset, const uint8_t *start,
-		const uint8_t *end, uint8_t *buffer, const size_t max_len,
-		const size_t index) {
-	const uint8_t *idx = start + index + *offset;
-	const uint8_t *template_start = (uint8_t*) memchr(idx, TEMPLATE_CHAR,
-			end - idx);
-	// No replacing necessary.
-	if (!template_start
-			|| (size_t) (template_start - start) > max_len + index + *offset) {
-		// Fill free space with null bytes, if necessary.
-		if ((size_t) (end - idx) < max_len) {
-			memcpy(buffer, idx, end - idx);
-			memset(buffer + (end - idx), 0, max_len - (end - idx));
-			return max_len;
-		} else {
-			memcpy(buffer, idx, max_len);
-			return max_len;
-		}
-	} else {
-		size_t written = 0;
-		while (template_start && template_start - idx + written < max_len) {
-			memcpy(buffer + written, idx, template_start - idx);
-			written += template_start - idx;
-			const uint8_t *template_end = (uint8_t*) memchr(template_start + 1,
-					TEMPLATE_CHAR, end - template_start - 1);
-			if (!template_end) {
-				break;
-			}
-
-			uint8_t *buf = new uint8_t[template_end - template_start];
-			memcpy(buf, template_start + 1, template_end - template_start - 1);
-			buf[template_end - template_start - 1] = 0;
-			String replacement = String((char*) buf);
-			std::map<String, String>::const_iterator it = replacements.find(
-					replacement);
-			if (it != replacements.end()) {
-				replacement = it->second;
-			}
-			if (replacement.length() > max_len - written) {
-				return written > 0 ? written : RESPONSE_TRY_AGAIN;
-			}
+size_t web::sharedBufferResponseFiller(
+		const std::shared_ptr<const uint8_t> data, const size_t size,
+		uint8_t *buffer, const size_t max_len, const size_t index) {
+	const size_t len = min(max_len, size - index);
+	memcpy(buffer, data.get() + index, len);
+	return len;
+}
 
-			memcpy(buffer + written, replacement.c_str(), replacement.length());
-			written += replacement.length();
-			*offset += template_end - template_start + 1 - replacement.length();
-			delete[] buf;
-			idx = template_end + 1;
-			template_start = (uint8_t*) memchr(idx, TEMPLATE_CHAR, end - idx);
-		}
+size_t web::compressingResponseFiller(
+		const std::shared_ptr<gzip::uzlib_gzip_wrapper> comp,
+		CompressionStats *stats, uint8_t *buffer, const size_t max_len,
+		const size_t index) {
+	if (comp->done()) {
+		return 0;
+	}
 
-		// Fill free space with null bytes, if necessary.
-		if ((size_t) (end - idx) < max_len - written) {
-			memcpy(buffer + written, idx, end - idx);
-			memset(buffer + written + (end - idx), 0,
-					max_len - written - (end - idx));
-			return max_len;
-		} else {
-			memcpy(buffer + written, idx, max_len - written);
-			return max_len;
+	// Each call only compresses as much as fits in the buffer, so a response never blocks the web server for long.
+	const uint32_t start = micros();
+	const size_t len = comp->compress(buffer, max_len);
+	if (stats) {
+		stats->time_micros += (uint32_t) (micros() - start);
+		if (comp->done()) {
+			stats->input_bytes += comp->getUncompressed();
+			stats->output_bytes += comp->getCompressed();
+			stats->ratio = comp->getUncompressed()
+					/ (double) comp->getCompressed();
 		}
 	}
+	return len;
+}
+
+size_t web::replacingResponseFiller(
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		const std::shared_ptr<const std::vector<std::string>> values,
+		uint8_t *buffer, const size_t max_len, const size_t index) {
+	return tmpl->fill(*values, buffer, max_len, index);
 }
 
 size_t web::dummyResponseFiller(const uint8_t *buffer, const size_t max_len,
@@ -311,25 +967,28 @@ web::ResponseData web::defaultHeadRequestHandlerWrapper(
 
 void web::notFoundHandler(AsyncWebServerRequest *request) {
 	const size_t start = micros();
-	const std::map<String, String> replacements { { "TITLE",
-			"Error 404 Not Found" }, { "ERROR",
-			"The requested file can not be found on this server!" }, {
-			"DETAILS", "The page <code>" + request->url()
-					+ "</code> couldn't be found." } };
-	ResponseData response = replacingRequestHandler(replacements, 404,
-			"text/html", (uint8_t*) ERROR_HTML_START,
-			(uint8_t*) ERROR_HTML_END - 1, request);
+	// The values for the TITLE, ERROR, and DETAILS placeholders.
+	std::vector<std::string> values { "Error 404 Not Found",
+			"The requested file can not be found on this server!",
+			std::string("The page <code>") + request->url().c_str()
+					+ "</code> couldn't be found." };
+	ResponseData response = replacingRequestHandler(std::move(values), 404,
+			"text/html", error_template, request);
 	if (request->method() == HTTP_HEAD) {
 		response.response = new AsyncHeadOnlyResponse(response.response,
 				response.status_code);
 	}
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-	prom::http_requests_total[request->url()][ {
-			(WebRequestMethod) request->method(), response.status_code }]++;
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	not_found_counters.increment((WebRequestMethod) request->method(),
+			response.status_code);
 #endif
 	const size_t mid = micros();
 	request->send(response.response);
 	const size_t end = micros();
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+	not_found_durations.handler.record(mid - start);
+	not_found_durations.send.record(end - mid);
+#endif
 	log_i("A client tried to access the not existing file \"%s\".",
 			request->url().c_str());
 	log_d("Handling a request to \"%s\" took %luus + %luus.",
@@ -376,16 +1035,16 @@ web::ResponseData web::invalidMethodHandler(
 			validStr += valid[i];
 		}
 
-		std::map<String, String> replacements { { "TITLE",
-				"Error 405 Method Not Allowed" }, { "ERROR",
-				"The page cannot handle " + String(request->methodToString())
-						+ " requests!" }, { "DETAILS", "The page <code>"
-				+ request->url() + "</code> can handle the request methods "
-				+ validStr + "." } };
+		// The values for the TITLE, ERROR, and DETAILS placeholders.
+		std::vector<std::string> values { "Error 405 Method Not Allowed",
+				std::string("The page cannot handle ")
+						+ request->methodToString() + " requests!",
+				std::string("The page <code>") + request->url().c_str()
+						+ "</code> can handle the request methods "
+						+ validStr.c_str() + "." };
 
-		ResponseData response = replacingRequestHandler(replacements, 405,
-				"text/html", (uint8_t*) ERROR_HTML_START,
-				(uint8_t*) ERROR_HTML_END - 1, request);
+		ResponseData response = replacingRequestHandler(std::move(values), 405,
+				"text/html", error_template, request);
 		if (request->method() == HTTP_HEAD) {
 			response.response = new AsyncHeadOnlyResponse(response.response,
 					405);
@@ -482,29 +1141,70 @@ web::ResponseData web::staticHandler(const uint16_t status_code,
 }
 
 web::ResponseData web::compressedStaticHandler(const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const String &content_type, const StaticFileVariants &file,
 		AsyncWebServerRequest *request, const char *etag) {
-	const bool accepts_gzip = request->hasHeader("Accept-Encoding")
-			&& csvHeaderContains(request->header("Accept-Encoding").c_str(),
-					"gzip");
+	// The variants, ordered by preference if multiple have the same size.
+	static const char *const encodings[] = { "identity", "gzip", "deflate" };
+	static const char *const etag_suffixes[] = { "", "-gzip", "-deflate" };
+	const uint8_t *const starts[] = { file.identity_start, file.gzip_start,
+			file.deflate_start };
+	const uint8_t *const ends[] = { file.identity_end, file.gzip_end,
+			file.deflate_end };
+
+	// The size of each variant, with the uncompressed size being read from the gzip trailer if it isn't stored.
+	size_t sizes[] = { (size_t) (file.identity_end - file.identity_start),
+			(size_t) (file.gzip_end - file.gzip_start),
+			(size_t) (file.deflate_end - file.deflate_start) };
+	const bool identity_stored = sizes[0] > 0;
+	if (!identity_stored && sizes[1] >= 29) {
+		const uint8_t *end = file.gzip_end;
+		sizes[0] = end[-4] | (end[-3] << 8) | (end[-2] << 16)
+				| ((uint32_t) end[-1] << 24);
+	}
 
-	if (accepts_gzip) {
-		log_d("Client accepts gzip compressed data.");
-	} else {
-		log_d("Client doesn't accept gzip compressed data.");
+	// Clients without an Accept-Encoding header get the uncompressed file.
+	int16_t qvalues[] = { http::MAX_QVALUE, 0, 0 };
+	if (request->hasHeader("Accept-Encoding")) {
+		http::getEncodingQValues(request->header("Accept-Encoding").c_str(),
+				encodings, 3, qvalues);
+	}
+
+	// If the client doesn't accept any of the variants, send the uncompressed file anyway.
+	uint8_t encoding = 0;
+	for (uint8_t i = 1; i < 3; i++) {
+		if (qvalues[i] > 0 && starts[i] != ends[i]
+				&& (qvalues[encoding] <= 0 || sizes[i] < sizes[encoding])) {
+			encoding = i;
+		}
 	}
+	log_d("Sending %s encoded file.", encodings[encoding]);
 
 	char *enc_etag = NULL;
 	if (etag != NULL) {
 		const size_t etag_len = strlen(etag);
-		enc_etag = new char[etag_len + 3 + 5 * accepts_gzip];
+		const size_t suffix_len = strlen(etag_suffixes[encoding]);
+		enc_etag = new char[etag_len + suffix_len + 3];
 		enc_etag[0] = '"';
 		memcpy(enc_etag + 1, etag, etag_len);
-		if (accepts_gzip) {
-			memcpy(enc_etag + etag_len + 1, "-gzip", 5);
-		}
-		enc_etag[etag_len + 1 + 5 * accepts_gzip] = '"';
-		enc_etag[etag_len + 2 + 5 * accepts_gzip] = 0;
+		memcpy(enc_etag + etag_len + 1, etag_suffixes[encoding], suffix_len);
+		enc_etag[etag_len + suffix_len + 1] = '"';
+		enc_etag[etag_len + suffix_len + 2] = 0;
+	}
+
+	// The size of the sent representation, which is the compressed file for compressed variants.
+	const size_t size = sizes[encoding];
+
+	// Only respect the Range header if If-Range is missing, or matches the current entity tag.
+	size_t first = 0;
+	size_t last = size - 1;
+	uint16_t range_code = 200;
+	if (status_code == 200 && request->hasHeader("Range")
+			&& (!request->hasHeader("If-Range")
+					|| (enc_etag != NULL
+							&& strcmp(request->header("If-Range").c_str(),
+									enc_etag) == 0))) {
+		range_code = parseRangeHeader(request->header("Range").c_str(), size,
+				first, last);
 	}
 
 	AsyncWebServerResponse *response = NULL;
@@ -518,31 +1218,85 @@ web::ResponseData web::compressedStaticHandler(const uint16_t status_code,
 		// TODO find a better way to avoid sending the content length.
 		response = request->beginResponse(content_type, content_length,
 				dummyResponseFiller);
-		if (accepts_gzip) {
-			response->addHeader("Content-Encoding", "gzip");
+		if (encoding != 0) {
+			response->addHeader("Content-Encoding", encodings[encoding]);
+		}
+	} else if (range_code == 416) {
+		log_d("Client requested an unsatisfiable range.");
+		delete[] enc_etag;
+		// Error responses don't represent the file, so they don't get its caching headers.
+		response = request->beginResponse(416);
+		response->addHeader("Content-Range", "bytes */" + String(size));
+		response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+		return ResponseData(response, 0, 416);
+	} else if (encoding != 0 || identity_stored) {
+		code = range_code == 206 ? range_code : code;
+		content_length = last - first + 1;
+		response = request->beginResponse_P(code, content_type,
+				starts[encoding] + first, content_length);
+		if (encoding != 0) {
+			response->addHeader("Content-Encoding", encodings[encoding]);
 		}
-	} else if (accepts_gzip) {
-		content_length = end - start;
-		response = request->beginResponse_P(code, content_type, start,
-				content_length);
-		response->addHeader("Content-Encoding", "gzip");
 	} else {
 		using namespace std::placeholders;
-		std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp = std::make_shared<
-				gzip::uzlib_ungzip_wrapper>(start, end,
-				GZIP_DECOMP_WINDOW_SIZE);
-		content_length = max(0, decomp->getDecompressedSize());
-		if (content_length == 0) {
-			// Make sure to send the content length regardless.
-			response = request->beginResponse(code, content_type, "");
-		} else {
+		code = range_code == 206 ? range_code : code;
+		std::shared_ptr<const uint8_t> cached;
+		bool no_dict = false;
+		if (DECOMPRESSED_CACHE_SIZE > 0) {
+			cached = decompressed_cache.get(file.gzip_start, file.gzip_end,
+					content_length, no_dict);
+		}
+
+		if (cached) {
+			content_length = last - first + 1;
+			// Share ownership of the cached file, while pointing to the first byte of the range.
 			response = request->beginResponse(content_type, content_length,
-					std::bind(decompressingResponseFiller, decomp, _1, _2, _3));
+					std::bind(sharedBufferResponseFiller,
+							std::shared_ptr<const uint8_t>(cached,
+									cached.get() + first), content_length, _1,
+							_2, _3));
+		} else {
+			// Start decompressing at the last checkpoint before the range, to avoid inflating the entire file.
+			// If the cache didn't get a dict, trying again right away would only count another pool failure.
+			std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp;
+			if (!no_dict) {
+				decomp = std::make_shared<gzip::uzlib_ungzip_wrapper>(
+						file.gzip_start, file.gzip_end, file.checkpoints,
+						file.checkpoints_len, first, GZIP_DECOMP_WINDOW_SIZE,
+						&decomp_dict_pool);
+			}
+			if (!decomp || !decomp->hasDict()) {
+				log_w("No free decompression dict, sending 503 response.");
+				delete[] enc_etag;
+				// A cache must not revalidate this transient error against the entity tag of the file.
+				response = request->beginResponse(503);
+				response->addHeader("Retry-After", "1");
+				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+				return ResponseData(response, 0, 503);
+			}
+
+			content_length = size > 0 ? last - first + 1 : 0;
+			if (content_length == 0) {
+				// Make sure to send the content length regardless.
+				response = request->beginResponse(code, content_type, "");
+			} else {
+				response = request->beginResponse(content_type, content_length,
+						std::bind(decompressingResponseFiller, decomp, _1, _2,
+								_3));
+			}
 		}
 	}
 
 	response->setCode(code);
 	response->addHeader("Vary", "Accept-Encoding");
+	if (code == 200 || code == 206) {
+		response->addHeader("Accept-Ranges", "bytes");
+	}
+	if (code == 206) {
+		response->addHeader("Content-Range",
+				"bytes " + String(first) + '-' + String(last) + '/'
+						+ String(size));
+	}
 
 #if ENABLE_CONTENT_SECURITY_POLICY == 1
 	if (strcmp(content_type.c_str(), "text/html") == 0) {
@@ -562,51 +1316,43 @@ web::ResponseData web::compressedStaticHandler(const uint16_t status_code,
 }
 
 web::ResponseData web::replacingRequestHandler(
-		const std::map<String, std::function<std::string()>> replacements,
+		const std::vector<std::function<std::string()>> &replacements,
 		const uint16_t status_code, const String &content_type,
-		const uint8_t *start, const uint8_t *end,
-		AsyncWebServerRequest *request) {
-	std::map<String, String> repl;
-	for (std::pair<String, std::function<std::string()>> replacement : replacements) {
-		repl[replacement.first] = replacement.second().c_str();
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		AsyncWebServerRequest *request, const char *etag_prefix) {
+	std::string etag;
+	if (etag_prefix != NULL) {
+		etag = getMeasurementETag(etag_prefix);
+		if (hasCurrentETag(request, etag.c_str())) {
+			return notModifiedHandler(content_type, etag.c_str(), request);
+		}
 	}
 
-	return replacingRequestHandler(repl, status_code, content_type, start, end,
-			request);
+	std::vector<std::string> values;
+	values.reserve(replacements.size());
+	for (const std::function<std::string()> &replacement : replacements) {
+		values.push_back(replacement());
+	}
+
+	return replacingRequestHandler(std::move(values), status_code,
+			content_type, tmpl, request,
+			etag_prefix != NULL ? etag.c_str() : NULL);
 }
 
 web::ResponseData web::replacingRequestHandler(
-		const std::map<String, String> replacements, const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
-		AsyncWebServerRequest *request) {
+		std::vector<std::string> &&values, const uint16_t status_code,
+		const String &content_type,
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		AsyncWebServerRequest *request, const char *etag) {
 	using namespace std::placeholders;
-	int64_t len_diff = 0;
-	const uint8_t *idx = start;
-	while (idx && (idx = (uint8_t*) memchr(idx, TEMPLATE_CHAR, end - idx))) {
-		const uint8_t *template_end = (uint8_t*) memchr(idx + 1, TEMPLATE_CHAR,
-				end - idx - 1);
-		if (!template_end) {
-			break;
-		}
-		uint8_t *buf = new uint8_t[template_end - idx];
-		memcpy(buf, idx + 1, template_end - idx - 1);
-		buf[template_end - idx - 1] = 0;
-		if (replacements.find(String((char*) buf)) != replacements.end()) {
-			len_diff += replacements.at(String((char*) buf)).length()
-					- (template_end - idx + 1);
-		} else {
-			len_diff -= 2;
-		}
-		delete[] buf;
-		idx = template_end + 1;
-	}
-
-	const size_t content_length = (end - start) + len_diff;
-	std::shared_ptr<int64_t> offset = std::make_shared<int64_t>(0);
+	const size_t content_length = tmpl->getLength(values);
+	std::shared_ptr<const std::vector<std::string>> shared_values =
+			std::make_shared<std::vector<std::string>>(
+					std::move(values));
 	AsyncWebServerResponse *response = request->beginResponse(content_type,
 			content_length,
-			std::bind(replacingResponseFiller, replacements, offset, start, end,
-					_1, _2, _3));
+			std::bind(replacingResponseFiller, tmpl, shared_values, _1, _2,
+					_3));
 	response->setCode(status_code);
 
 #if ENABLE_CONTENT_SECURITY_POLICY == 1
@@ -615,10 +1361,28 @@ web::ResponseData web::replacingRequestHandler(
 	}
 #endif
 
-	response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+	if (etag != NULL) {
+		response->addHeader("ETag", etag);
+		response->addHeader("Cache-Control", CACHE_CONTROL_CACHE);
+	} else {
+		response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+	}
 	return ResponseData(response, content_length, status_code);
 }
 
+web::ResponseData web::notModifiedHandler(const String &content_type,
+		const char *etag, AsyncWebServerRequest *request) {
+	log_d("Client has up-to-date cached page.");
+	const uint16_t status_code = 304;
+	// TODO find a better way to avoid sending the content length.
+	AsyncWebServerResponse *response = request->beginResponse(content_type, 0,
+			dummyResponseFiller);
+	response->setCode(status_code);
+	response->addHeader("ETag", etag);
+	response->addHeader("Cache-Control", CACHE_CONTROL_CACHE);
+	return ResponseData(response, 0, status_code);
+}
+
 web::ResponseData web::redirectHandler(const char *target,
 		AsyncWebServerRequest *request) {
 	const uint16_t status_code = 307;
@@ -628,19 +1392,19 @@ web::ResponseData web::redirectHandler(const char *target,
 }
 
 void web::registerRequestHandler(const char *uri,
-		const WebRequestMethodComposite method, HTTPRequestHandler handler) {
-	const String uri_s = uri;
-	AsyncTrackingFallbackWebHandler *hand = handlers[uri_s];
+		const WebRequestMethodComposite method, HTTPRequestHandler handler,
+		const bool record_durations) {
+	AsyncTrackingFallbackWebHandler *hand = handlers[uri];
 	if (!hand) {
-		hand = handlers[uri_s] = new AsyncTrackingFallbackWebHandler(uri_s,
+		hand = handlers[uri] = new AsyncTrackingFallbackWebHandler(uri,
 				invalidMethodHandler);
-		server.addHandler(hand);
 	}
 	using namespace std::placeholders;
-	hand->setHandler(method, handler);
+	hand->setHandler(method, handler, record_durations);
 	if ((method & HTTP_GET) && !(hand->getHandledMethods() & HTTP_HEAD)) {
 		hand->setHandler(HTTP_HEAD,
-				std::bind(defaultHeadRequestHandlerWrapper, handler, _1));
+				std::bind(defaultHeadRequestHandlerWrapper, handler, _1),
+				record_durations);
 	}
 }
 
@@ -658,38 +1422,54 @@ void web::registerStaticHandler(const char *uri, const String &content_type,
 }
 
 void web::registerCompressedStaticHandler(const char *uri,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const String &content_type, const StaticFileVariants &file,
 		const char *etag) {
 	using namespace std::placeholders;
 	registerRequestHandler(uri, HTTP_GET,
-			std::bind(compressedStaticHandler, 200, content_type, start, end,
-					_1, etag));
+			std::bind(compressedStaticHandler, 200, content_type, file, _1,
+					etag));
 }
 
 void web::registerReplacingStaticHandler(const char *uri,
 		const String &content_type, const char *page,
-		const std::map<String, std::function<std::string()>> replacements) {
+		const std::map<String, std::function<std::string()>> replacements,
+		const char *etag_prefix) {
 	registerReplacingStaticHandler(uri, content_type, (uint8_t*) page,
-			(uint8_t*) page + strlen(page), replacements);
+			(uint8_t*) page + strlen(page), replacements, etag_prefix);
 }
 
 void web::registerReplacingStaticHandler(const char *uri,
 		const String &content_type, const uint8_t *start, const uint8_t *end,
-		const std::map<String, std::function<std::string()>> replacements) {
+		const std::map<String, std::function<std::string()>> replacements,
+		const char *etag_prefix) {
 	using namespace std::placeholders;
+	// Parse the template once, and store the replacement functions by placeholder index.
+	std::vector<std::string> placeholders;
+	std::vector<std::function<std::string()>> functions;
+	placeholders.reserve(replacements.size());
+	functions.reserve(replacements.size());
+	for (const std::pair<const String, std::function<std::string()>> &replacement : replacements) {
+		placeholders.push_back(replacement.first.c_str());
+		functions.push_back(replacement.second);
+	}
+
+	const std::shared_ptr<const http::CompiledTemplate> tmpl =
+			std::make_shared<http::CompiledTemplate>(start, end,
+					placeholders, TEMPLATE_CHAR);
 	registerRequestHandler(uri, HTTP_GET,
 			std::bind<
 					ResponseData(
-							const std::map<String, std::function<std::string()>>,
-							const uint16_t, const String&, const uint8_t*,
-							const uint8_t*, AsyncWebServerRequest*)>(
-					replacingRequestHandler, replacements, 200, content_type,
-					start, end, _1));
+							const std::vector<std::function<std::string()>>&,
+							const uint16_t, const String&,
+							const std::shared_ptr<const http::CompiledTemplate>,
+							AsyncWebServerRequest*, const char*)>(
+					replacingRequestHandler, functions, 200, content_type, tmpl,
+					_1, etag_prefix));
 }
 
 void web::registerRedirect(const char *uri, const char *target) {
 	using namespace std::placeholders;
 	registerRequestHandler(uri, HTTP_ANY,
-			std::bind(redirectHandler, target, _1));
+			std::bind(redirectHandler, target, _1), false);
 }
 #endif /* ENABLE_WEB_SERVER == 1 */
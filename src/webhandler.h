@@ -14,10 +14,14 @@
 #include "config.h"
 #if ENABLE_WEB_SERVER == 1
 #include <ESPAsyncWebServer.h>
+#if ENABLE_EVENT_STREAM == 1
+#include <AsyncEventSource.h>
+#endif
 namespace web {
 class ResponseData;
 class AsyncHeadOnlyResponse;
 class AsyncTrackingFallbackWebHandler;
+class AsyncRouteDispatcher;
 
 /**
  * A function handling HTTP requests for some set of urls.
@@ -38,7 +42,13 @@ typedef std::function<
 }
 
 #include "AsyncTrackingFallbackWebHandler.h"
+#include "AsyncRouteDispatcher.h"
+#include "DecompressedFileCache.h"
+#include "MeasurementCache.h"
 #include <uzlib_gzip_wrapper.h>
+#include <compiled_template.h>
+#include <task_shared.h>
+#include <route_table.h>
 #include <map>
 
 /**
@@ -121,6 +131,132 @@ extern const uint8_t FAVICON_SVG_GZ_START[] asm("_binary_data_gzip_favicon_svg_g
  */
 extern const uint8_t FAVICON_SVG_GZ_END[] asm("_binary_data_gzip_favicon_svg_gz_end");
 
+/**
+ * A pointer to the first byte of the deflate compressed main css stylesheet.
+ */
+extern const uint8_t MAIN_CSS_DEFLATE_START[] asm("_binary_data_deflate_main_css_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed main css stylesheet.
+ */
+extern const uint8_t MAIN_CSS_DEFLATE_END[] asm("_binary_data_deflate_main_css_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed main css stylesheet.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t MAIN_CSS_IDENTITY_START[] asm("_binary_data_identity_main_css_start");
+
+/**
+ * A pointer to the first byte after the uncompressed main css stylesheet.
+ */
+extern const uint8_t MAIN_CSS_IDENTITY_END[] asm("_binary_data_identity_main_css_end");
+
+/**
+ * A pointer to the first byte of the deflate compressed main page javascript file.
+ */
+extern const uint8_t INDEX_JS_DEFLATE_START[] asm("_binary_data_deflate_index_js_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed main page javascript file.
+ */
+extern const uint8_t INDEX_JS_DEFLATE_END[] asm("_binary_data_deflate_index_js_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed main page javascript file.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t INDEX_JS_IDENTITY_START[] asm("_binary_data_identity_index_js_start");
+
+/**
+ * A pointer to the first byte after the uncompressed main page javascript file.
+ */
+extern const uint8_t INDEX_JS_IDENTITY_END[] asm("_binary_data_identity_index_js_end");
+
+/**
+ * A pointer to the first byte of the deflate compressed web app manifest.
+ */
+extern const uint8_t MANIFEST_JSON_DEFLATE_START[] asm("_binary_data_deflate_manifest_json_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed web app manifest.
+ */
+extern const uint8_t MANIFEST_JSON_DEFLATE_END[] asm("_binary_data_deflate_manifest_json_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed web app manifest.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t MANIFEST_JSON_IDENTITY_START[] asm("_binary_data_identity_manifest_json_start");
+
+/**
+ * A pointer to the first byte after the uncompressed web app manifest.
+ */
+extern const uint8_t MANIFEST_JSON_IDENTITY_END[] asm("_binary_data_identity_manifest_json_end");
+
+/**
+ * A pointer to the first byte of the deflate compressed favicon ico.
+ */
+extern const uint8_t FAVICON_ICO_DEFLATE_START[] asm("_binary_data_deflate_favicon_ico_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed favicon ico.
+ */
+extern const uint8_t FAVICON_ICO_DEFLATE_END[] asm("_binary_data_deflate_favicon_ico_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed favicon ico.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t FAVICON_ICO_IDENTITY_START[] asm("_binary_data_identity_favicon_ico_start");
+
+/**
+ * A pointer to the first byte after the uncompressed favicon ico.
+ */
+extern const uint8_t FAVICON_ICO_IDENTITY_END[] asm("_binary_data_identity_favicon_ico_end");
+
+/**
+ * A pointer to the first byte of the deflate compressed favicon png.
+ */
+extern const uint8_t FAVICON_PNG_DEFLATE_START[] asm("_binary_data_deflate_favicon_png_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed favicon png.
+ */
+extern const uint8_t FAVICON_PNG_DEFLATE_END[] asm("_binary_data_deflate_favicon_png_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed favicon png.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t FAVICON_PNG_IDENTITY_START[] asm("_binary_data_identity_favicon_png_start");
+
+/**
+ * A pointer to the first byte after the uncompressed favicon png.
+ */
+extern const uint8_t FAVICON_PNG_IDENTITY_END[] asm("_binary_data_identity_favicon_png_end");
+
+/**
+ * A pointer to the first byte of the deflate compressed favicon svg.
+ */
+extern const uint8_t FAVICON_SVG_DEFLATE_START[] asm("_binary_data_deflate_favicon_svg_zz_start");
+
+/**
+ * A pointer to the first byte after the deflate compressed favicon svg.
+ */
+extern const uint8_t FAVICON_SVG_DEFLATE_END[] asm("_binary_data_deflate_favicon_svg_zz_end");
+
+/**
+ * A pointer to the first byte of the uncompressed favicon svg.
+ * Empty if the uncompressed file isn't smaller than the gzip compressed one.
+ */
+extern const uint8_t FAVICON_SVG_IDENTITY_START[] asm("_binary_data_identity_favicon_svg_start");
+
+/**
+ * A pointer to the first byte after the uncompressed favicon svg.
+ */
+extern const uint8_t FAVICON_SVG_IDENTITY_END[] asm("_binary_data_identity_favicon_svg_end");
+
 /**
  * The namespace for all the web server related stuff in this project.
  */
@@ -156,6 +292,86 @@ public:
 			const uint16_t status_code);
 };
 
+/**
+ * The precompressed variants of a static file, one for each supported content coding.
+ *
+ * The gzip variant always has to exist, and is used to decompress the file for clients that don't accept compressed files.
+ * The other variants are empty, meaning their start and end pointers are equal, if they aren't smaller than the gzip variant.
+ */
+struct StaticFileVariants {
+	/**
+	 * A pointer to the first byte of the gzip compressed file.
+	 */
+	const uint8_t *gzip_start;
+
+	/**
+	 * A pointer to the first byte after the end of the gzip compressed file.
+	 */
+	const uint8_t *gzip_end;
+
+	/**
+	 * A pointer to the first byte of the deflate(zlib) compressed file.
+	 */
+	const uint8_t *deflate_start;
+
+	/**
+	 * A pointer to the first byte after the end of the deflate compressed file.
+	 */
+	const uint8_t *deflate_end;
+
+	/**
+	 * A pointer to the first byte of the uncompressed file.
+	 */
+	const uint8_t *identity_start;
+
+	/**
+	 * A pointer to the first byte after the end of the uncompressed file.
+	 */
+	const uint8_t *identity_end;
+
+	/**
+	 * The inflate checkpoints of the gzip compressed file, used for range requests.
+	 * Each checkpoint is an uncompressed offset, and the compressed offset to start at for it.
+	 * NULL to always decompress from the start of the file.
+	 */
+	const uint32_t (*checkpoints)[2];
+
+	/**
+	 * The number of inflate checkpoints.
+	 */
+	size_t checkpoints_len;
+};
+
+/**
+ * The statistics of the responses compressed by compressingResponseFiller.
+ */
+struct CompressionStats {
+	/**
+	 * The number of uncompressed bytes of all completely compressed responses.
+	 */
+	utils::shared_t<uint64_t> input_bytes;
+
+	/**
+	 * The number of compressed bytes of all completely compressed responses.
+	 */
+	utils::shared_t<uint64_t> output_bytes;
+
+	/**
+	 * The total time spent compressing responses, in microseconds.
+	 */
+	utils::shared_t<uint64_t> time_micros;
+
+	/**
+	 * The compression ratio of the last completely compressed response.
+	 */
+	utils::shared_t<double> ratio;
+
+	/**
+	 * Creates new compression statistics, without any compressed responses.
+	 */
+	CompressionStats();
+};
+
 /**
  * The Cache-Control header value to send for pages that should not be cached.
  */
@@ -184,9 +400,72 @@ static const char TEMPLATE_CHAR = '$';
 extern AsyncWebServer server;
 
 /**
- * A map containing the registered request handler for each uri.
+ * A route table containing the registered request handler for each uri.
  */
-extern std::map<String, AsyncTrackingFallbackWebHandler*> handlers;
+extern http::RouteTable<AsyncTrackingFallbackWebHandler*> handlers;
+
+/**
+ * The web handler dispatching requests to the registered request handler for their uri.
+ */
+extern AsyncRouteDispatcher dispatcher;
+
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The counters of the requests for paths without a registered handler.
+ * All unknown paths share these counters, so requests for random paths can't use up the heap.
+ */
+extern RequestCounters not_found_counters;
+#endif
+
+#if ENABLE_HTTP_REQUEST_DURATION_METRICS == 1
+/**
+ * The durations of the requests for paths without a registered handler.
+ */
+extern RequestDurations not_found_durations;
+#endif
+
+/**
+ * The cache for decompressed static files, sent to clients that don't accept gzip.
+ */
+extern DecompressedFileCache decompressed_cache;
+
+/**
+ * The pool of preallocated decompression dicts, used to decompress static files for clients that don't accept gzip.
+ */
+extern gzip::uzlib_dict_pool decomp_dict_pool;
+
+/**
+ * The cached response body of the /temperature endpoint.
+ */
+extern sensors::MeasurementCache temperature_cache;
+
+/**
+ * The cached response body of the /humidity endpoint.
+ */
+extern sensors::MeasurementCache humidity_cache;
+
+/**
+ * The compiled error page template, with the placeholders TITLE, ERROR, and DETAILS, in that order.
+ */
+extern const std::shared_ptr<const http::CompiledTemplate> error_template;
+
+/**
+ * A random number chosen at startup, and included in the entity tags of measurement responses and the event ids.
+ * Makes sure entity tags and event ids from before a restart don't match, since the measurement generation starts at zero again.
+ */
+extern uint32_t etag_boot_id;
+
+#if ENABLE_EVENT_STREAM == 1
+/**
+ * The Server-Sent Events stream pushing new measurements to the web interface.
+ */
+extern AsyncEventSource events;
+
+/**
+ * The measurement generation last pushed to the event stream clients.
+ */
+extern uint32_t events_generation;
+#endif
 #else /* ENABLE_WEB_SERVER == 1 */
 namespace web {
 #endif
@@ -223,6 +502,21 @@ void connect();
  */
 bool csvHeaderContains(const char *header, const char *value);
 
+/**
+ * Parses the value of a Range request header, for a representation of the given size.
+ *
+ * Only supports a single byte range.
+ * Requests for multiple ranges, and syntactically invalid headers, are ignored, as allowed by RFC 9110.
+ *
+ * @param header	The Range header value to parse.
+ * @param size		The size of the selected representation, in bytes.
+ * @param first		A reference to write the offset of the first byte of the range to.
+ * @param last		A reference to write the offset of the last byte of the range to.
+ * @return	206 if the range is valid, 416 if it is unsatisfiable, and 200 if the header should be ignored.
+ */
+uint16_t parseRangeHeader(const char *header, const size_t size, size_t &first,
+		size_t &last);
+
 /**
  * The request handler for /data.json.
  * Responds with a json object containing the current temperature and humidity,
@@ -233,6 +527,71 @@ bool csvHeaderContains(const char *header, const char *value);
  */
 ResponseData getJson(AsyncWebServerRequest *request);
 
+/**
+ * The max length of the json object written by writeMeasurementJson, excluding the NUL terminator.
+ */
+static constexpr size_t MEASUREMENT_JSON_MAX_LEN = 95;
+
+/**
+ * Writes the json object sent by /data.json and the event stream to the given buffer.
+ * Contains the current temperature and humidity, as well as the time since the last measurement.
+ *
+ * @param buffer	The buffer to write the NUL terminated json object to.
+ * @return	The length of the json object, excluding the NUL terminator.
+ */
+size_t writeMeasurementJson(char (&buffer)[MEASUREMENT_JSON_MAX_LEN + 1]);
+
+/**
+ * Creates the entity tag for a response generated from the current measurements.
+ * The entity tag changes with every new measurement, and after every restart.
+ *
+ * Has to be called before generating the response body,
+ * so that a measurement finishing in between results in an outdated entity tag, rather than an outdated body.
+ *
+ * @param prefix	The hash of the static part of the response, for example a template file.
+ * 					Use NULL for responses without a static part.
+ * @return	The quoted entity tag.
+ */
+std::string getMeasurementETag(const char *prefix = NULL);
+
+/**
+ * Checks whether the If-None-Match header of the given request contains the given entity tag.
+ *
+ * @param request	The request to check.
+ * @param etag		The quoted entity tag of the current response.
+ * @return	True if the client has an up-to-date copy of the response.
+ */
+bool hasCurrentETag(AsyncWebServerRequest *request, const char *etag);
+
+#if ENABLE_EVENT_STREAM == 1
+/**
+ * The request filter deciding whether a new client can connect to the event stream.
+ * Rejects clients if the max number of clients is connected, or the free heap is too low.
+ * Rejected clients are handled by the regular /events handler, responding with a 503 Service Unavailable.
+ *
+ * @param request	The request to check.
+ * @return	True if the event stream should handle the request.
+ */
+bool eventStreamFilter(AsyncWebServerRequest *request);
+
+/**
+ * Gets the event id for the given measurement generation.
+ * Event ids have to be numbers, so the boot id is added to the generation,
+ * to make sure a Last-Event-ID from before a restart doesn't match.
+ * Never returns 0, since an id of 0 means no id.
+ *
+ * @param generation	The measurement generation to get the event id for.
+ * @return	The event id.
+ */
+uint32_t getEventId(const uint32_t generation);
+
+/**
+ * Pushes the current measurements to all event stream clients, if there is a new measurement.
+ * Does nothing if the free heap is too low, so the measurement is pushed in a later loop iteration.
+ */
+void pushMeasurementEvent();
+#endif
+
 /**
  * An AwsResponseFiller decompressing a file from memory using uzlib.
  *
@@ -247,25 +606,54 @@ size_t decompressingResponseFiller(
 		uint8_t *buffer, const size_t max_len, const size_t index);
 
 /**
- * An AwsResponseFiller copying the given static file, and replacing the given template strings.
- * If the output buffer can hold more data than available, the remainder is filled with null bytes.
+ * An AwsResponseFiller copying data from a shared buffer.
+ * Keeps the buffer alive until the response is done, even if it is removed from its cache in the meantime.
  *
- * @param replacements	A map containing the template strings to replace, and their replacement values.
- * @param offset		The offset between the current static page position and output index.
- * 						Will automatically be updated by this function.
- * @param start			A pointer to the first byte of the static page.
- * @param end			A pointer to the first byte after the static page.
- * 						For C strings this is the terminating NUL byte.
- * @param buffer		The output buffer to write to.
- * @param max_len		The max number of bytes to write to the output buffer.
- * @param index			The number of bytes already created by this method.
+ * @param data		The buffer to copy the response body from.
+ * @param size		The size of the buffer, in bytes.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already written for this response.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t sharedBufferResponseFiller(const std::shared_ptr<const uint8_t> data,
+		const size_t size, uint8_t *buffer, const size_t max_len,
+		const size_t index);
+
+/**
+ * An AwsResponseFiller gzip compressing data from a source using uzlib.
+ * Meant to be used with a chunked response, since the compressed size isn't known in advance.
+ *
+ * @param comp		The uzlib compressing persistent data.
+ * @param stats		The statistics to add the time spent compressing to,
+ * 					and the input and output size once the whole response was compressed.
+ * 					NULL to not record any statistics.
+ * @param buffer	The output buffer to write the compressed data to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already generated for this response.
  * @return	The number of bytes written to the output buffer.
  */
-size_t replacingResponseFiller(const std::map<String, String> &replacements,
-		std::shared_ptr<int64_t> offset, const uint8_t *start,
-		const uint8_t *end, uint8_t *buffer, const size_t max_len,
+size_t compressingResponseFiller(
+		const std::shared_ptr<gzip::uzlib_gzip_wrapper> comp,
+		CompressionStats *stats, uint8_t *buffer, const size_t max_len,
 		const size_t index);
 
+/**
+ * An AwsResponseFiller writing the given compiled template, with its placeholders replaced by the given values.
+ * Never writes past the end of the filled template.
+ *
+ * @param tmpl		The compiled template to fill.
+ * @param values	The value of each placeholder, by placeholder index.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already created by this method.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t replacingResponseFiller(
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		const std::shared_ptr<const std::vector<std::string>> values,
+		uint8_t *buffer, const size_t max_len, const size_t index);
+
 /**
  * An AwsResponseFiller doing absolutely nothing, used to avoid sending the content length of 0.
  *
@@ -342,8 +730,15 @@ ResponseData staticHandler(const uint16_t status_code,
 /**
  * A web request handler for a compressed static file.
  *
- * If the client accepts gzip compressed files, the file is sent as is.
- * Otherwise it is decompressed on the fly.
+ * Sends the smallest stored variant of the file the client accepts, as is.
+ * If that is the uncompressed file, and it isn't stored, it is sent from the decompressed file cache,
+ * or decompressed on the fly if it can't be cached.
+ * Each variant uses its own entity tag, by appending its content coding to the given etag.
+ *
+ * Supports single byte range requests.
+ * For compressed variants, ranges refer to the compressed file.
+ * Otherwise decompression starts at the last inflate checkpoint before the range,
+ * so the time to answer a range request doesn't depend on its offset.
  *
  * Automatically adds a "default-src 'self'" content security policy to "text/html" responses.
  *
@@ -351,66 +746,74 @@ ResponseData staticHandler(const uint16_t status_code,
  *
  * @param status_code	The HTTP response status code to send to the client.
  * @param content_type	The content type of the static file.
- * @param start			A pointer to the first byte of the compressed static file.
- * @param end			A pointer to the first byte after the end of the compressed static file.
- * 						For C strings this is the terminating NUL byte.
+ * @param file			The stored variants of the static file.
  * @param request		The request to handle.
  * @param etag			The HTTP entity tag to use for caching.
  * 						Use NULL to disable sending an ETag for this page.
  * @return	The response to be sent to the client.
  */
 ResponseData compressedStaticHandler(const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const String &content_type, const StaticFileVariants &file,
 		AsyncWebServerRequest *request, const char *etag = NULL);
 
 /**
- * A web request handler for a static file with some templates to replace.
- * Template strings have to be formatted like this: $TEMPLATE$.
+ * A web request handler for a compiled template with some placeholders to replace.
  *
- * The templates will be replaced with the result of the function registered for them.
- * Note that each function will be called once, no matter how often its template appears.
+ * The placeholders will be replaced with the result of the function registered for them.
+ * Note that each function will be called once, no matter how often its placeholder appears.
  *
  * Automatically adds a "default-src 'self'" content security policy to "text/html" responses.
  *
  * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
+ * If an entity tag prefix is given, the page is instead revalidated using an entity tag based on the measurement generation.
  *
- * @param replacements	A map mapping a template string to be replaced,
- * 						to a function returning its replacement value.
+ * @param replacements	The functions returning the value of each placeholder, by placeholder index.
  * @param status_code	The HTTP response status code to send to the client.
  * @param content_type	The content type of the file to send.
- * @param start			A pointer to the first byte of the static file.
- * @param end			A pointer to the first byte after the static file.
- * 						For C strings this is the terminating NUL byte.
+ * @param tmpl			The compiled template to send.
  * @param request		The request to handle.
+ * @param etag_prefix	The hash of the template file, to combine with the measurement generation for the entity tag.
+ * 						Use NULL to disable sending an ETag for this page.
  * @return	The response to be sent to the client.
  */
 ResponseData replacingRequestHandler(
-		const std::map<String, std::function<std::string()>> replacements,
+		const std::vector<std::function<std::string()>> &replacements,
 		const uint16_t status_code, const String &content_type,
-		const uint8_t *start, const uint8_t *end,
-		AsyncWebServerRequest *request);
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		AsyncWebServerRequest *request, const char *etag_prefix = NULL);
 
 /**
- * A web request handler for a static file with some templates to replace.
- * Template strings have to be formatted like this: $TEMPLATE$.
+ * A web request handler for a compiled template with some placeholders to replace.
  *
  * Automatically adds a "default-src 'self'" content security policy to "text/html" responses.
  *
  * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
+ * If an entity tag is given, the page is instead revalidated using that entity tag.
  *
- * @param replacements	A map mapping a template string to be replaced,
- * 						to its replacement string.
+ * @param values		The value of each placeholder, by placeholder index.
  * @param status_code	The HTTP response status code to send to the client.
  * @param content_type	The content type of the file to send.
- * @param start			A pointer to the first byte of the static file.
- * @param end			A pointer to the first byte after the static file.
- * 						For C strings this is the terminating NUL byte.
+ * @param tmpl			The compiled template to send.
  * @param request		The request to handle.
+ * @param etag			The quoted entity tag of the filled template.
+ * 						Use NULL to disable sending an ETag for this page.
  * @return	The response to be sent to the client.
  */
-ResponseData replacingRequestHandler(
-		const std::map<String, String> replacements, const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+ResponseData replacingRequestHandler(std::vector<std::string> &&values,
+		const uint16_t status_code, const String &content_type,
+		const std::shared_ptr<const http::CompiledTemplate> tmpl,
+		AsyncWebServerRequest *request, const char *etag = NULL);
+
+/**
+ * A web request handler generating a Not Modified(304) response.
+ * Used for dynamic responses, if the client has an up-to-date copy.
+ *
+ * @param content_type	The content type of the response the client has.
+ * @param etag			The quoted entity tag of the current response.
+ * @param request		The request to handle.
+ * @return	The response to send to the client.
+ */
+ResponseData notModifiedHandler(const String &content_type, const char *etag,
 		AsyncWebServerRequest *request);
 
 /**
@@ -431,12 +834,15 @@ ResponseData redirectHandler(const char *target,
  * A HEAD request handler will automatically be registered, if no HEAD handler was registered for the uri yes,
  * and the new handler handles GET requests.
  *
- * @param uri		The path on which the page can be found.
- * @param method	The HTTP request method(s) for which to register the handler.
- * @param handler	A function responding to AsyncWebServerRequests and returning the response to send.
+ * @param uri					The path on which the page can be found.
+ * @param method			The HTTP request method(s) for which to register the handler.
+ * @param handler			A function responding to AsyncWebServerRequests and returning the response to send.
+ * @param record_durations	Whether to allocate separate request duration histograms for these methods.
+ * 							If false, their durations are recorded in the fallback histograms of the uri.
  */
 void registerRequestHandler(const char *uri,
-		const WebRequestMethodComposite method, HTTPRequestHandler handler);
+		const WebRequestMethodComposite method, HTTPRequestHandler handler,
+		const bool record_durations = true);
 
 /**
  * Registers a request handler that returns the given content type and web page each time it is called.
@@ -480,19 +886,17 @@ void registerStaticHandler(const char *uri, const String &content_type,
  * Always sends response code 200.
  *
  * Will automatically increment the prometheus request counter.
- * Expects the content to be a gzip compressed binary.
+ * Sends the smallest variant of the file the client accepts.
  * Allows ETag based caching, if an etag was given.
  *
  * @param uri			The path on which the file can be found.
  * @param content_type	The content type for the file.
- * @param start			The pointer to the first byte of the file.
- * @param end			The pointer to the first byte after the end of the file.
- * 						For C strings this is the terminating NUL byte.
+ * @param file			The stored variants of the file.
  * @param etag			The HTTP entity tag to use for caching.
  * 						Use NULL to disable sending an ETag for this page.
  */
 void registerCompressedStaticHandler(const char *uri,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const String &content_type, const StaticFileVariants &file,
 		const char *etag = NULL);
 
 /**
@@ -508,16 +912,20 @@ void registerCompressedStaticHandler(const char *uri,
  * Will automatically increment the prometheus request counter.
  *
  * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
+ * If an entity tag prefix is given, the page is instead revalidated using an entity tag based on the measurement generation.
  *
  * @param uri			The path on which the page can be found.
  * @param content_type	The content type for the page.
  * @param page			The content for the page to be sent to the client.
  * @param replacements	A map mapping a template string to be replaced,
  * 						to a function returning its replacement value.
+ * @param etag_prefix	The hash of the page, to combine with the measurement generation for the entity tag.
+ * 						Use NULL to disable sending an ETag for this page.
  */
 void registerReplacingStaticHandler(const char *uri, const String &content_type,
 		const char *page,
-		const std::map<String, std::function<std::string()>> replacements);
+		const std::map<String, std::function<std::string()>> replacements,
+		const char *etag_prefix = NULL);
 
 /**
  * Registers a request handler that returns the given content type and web page each time it is called.
@@ -526,12 +934,14 @@ void registerReplacingStaticHandler(const char *uri, const String &content_type,
  *
  * The templates will be replaced with the result of the function registered for them.
  * Note that each function will be called once per request, no matter how often its template appears.
+ * The file is parsed once, when registering the handler, so it has to stay valid after that.
  *
  * Registers request handlers for the request methods GET, HEAD, and OPTIONS.
  * Always sends response code 200.
  * Will automatically increment the prometheus request counter.
  *
  * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
+ * If an entity tag prefix is given, the page is instead revalidated using an entity tag based on the measurement generation.
  *
  * @param uri			The path on which the page can be found.
  * @param content_type	The content type for the page.
@@ -540,10 +950,13 @@ void registerReplacingStaticHandler(const char *uri, const String &content_type,
  * 						For C strings this is the terminating NUL byte.
  * @param replacements	A map mapping a template string to be replaced,
  * 						to a function returning its replacement value.
+ * @param etag_prefix	The hash of the file, to combine with the measurement generation for the entity tag.
+ * 						Use NULL to disable sending an ETag for this page.
  */
 void registerReplacingStaticHandler(const char *uri, const String &content_type,
 		const uint8_t *start, const uint8_t *end,
-		const std::map<String, std::function<std::string()>> replacements);
+		const std::map<String, std::function<std::string()>> replacements,
+		const char *etag_prefix = NULL);
 
 /**
  * Registers a request handler redirecting to the given target url.
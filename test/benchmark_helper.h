@@ -0,0 +1,75 @@
+/*
+ * benchmark_helper.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ *
+ * This file contains the result output shared by all native benchmarks.
+ * Each benchmark is a single test file, so this header defines its functions and variables directly.
+ *
+ * Define BENCHMARK_CUSTOM_FIXTURES before including this to implement setUp and tearDown in the benchmark itself.
+ */
+
+#ifndef TEST_BENCHMARK_HELPER_H_
+#define TEST_BENCHMARK_HELPER_H_
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * The environment variable that can be set to a file path to append the results to.
+ */
+const char OUTPUT_ENV_VAR[] = "ESPTHERM_BENCHMARK_OUTPUT";
+
+/**
+ * The file the results are appended to, if the output env variable is set.
+ */
+FILE *output_file = NULL;
+
+#ifndef BENCHMARK_CUSTOM_FIXTURES
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+#endif
+
+/**
+ * Opens the output file, if the output env variable is set.
+ * Has to be called before running the benchmarks.
+ */
+void open_output() {
+	const char *output_path = getenv(OUTPUT_ENV_VAR);
+	if (output_path) {
+		output_file = fopen(output_path, "a");
+	}
+}
+
+/**
+ * Closes the output file, if it was opened.
+ */
+void close_output() {
+	if (output_file) {
+		fclose(output_file);
+		output_file = NULL;
+	}
+}
+
+/**
+ * Writes a single result line, as a JSON object, to stdout and the output file.
+ *
+ * @param line	The JSON object to write.
+ */
+void write_result(const char *line) {
+	printf("%s\n", line);
+	if (output_file) {
+		fprintf(output_file, "%s\n", line);
+	}
+}
+
+#endif /* TEST_BENCHMARK_HELPER_H_ */
@@ -0,0 +1,45 @@
+/*
+ * metric_fixtures.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ *
+ * This file contains the metric family descriptions shared by the prometheus metrics tests.
+ * The metrics using them, and their expected output, are defined by each test.
+ */
+
+#ifndef TEST_METRIC_FIXTURES_H_
+#define TEST_METRIC_FIXTURES_H_
+
+#include <metric_registry.h>
+
+/**
+ * The description of the test gauge.
+ */
+static constexpr prom::MetricFamily TEMPERATURE_FAMILY =
+		PROM_GAUGE_FAMILY_WITH_UNIT("test_temperature", "celsius",
+				"The test temperature.");
+
+/**
+ * The description of the test counter.
+ */
+static constexpr prom::MetricFamily REQUESTS_FAMILY = PROM_COUNTER_FAMILY(
+		"test_requests_total", "The test requests.");
+
+/**
+ * The description of the test info metric.
+ */
+static constexpr prom::MetricFamily BUILD_INFO_FAMILY = PROM_INFO_FAMILY(
+		"test_build_info", "The test build info.");
+
+/**
+ * The description of the test histogram.
+ */
+static constexpr prom::MetricFamily DURATION_FAMILY =
+		PROM_HISTOGRAM_FAMILY_WITH_UNIT("test_duration", "seconds",
+				"The test durations.");
+
+#endif /* TEST_METRIC_FIXTURES_H_ */
@@ -0,0 +1,202 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../benchmark_helper.h"
+#include <http_utils.h>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * The clock used to measure the parsing time.
+ */
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * The min total time to spend parsing each header.
+ */
+const std::chrono::milliseconds MIN_DURATION(200);
+
+/**
+ * The number of times to parse a header between two clock reads.
+ */
+const size_t BATCH_SIZE = 1000;
+
+/**
+ * The content codings the static file handler can send.
+ */
+const char *const ENCODINGS[] = { "gzip", "identity" };
+
+/**
+ * The media types the metrics handler can send.
+ */
+const char *const MEDIA_TYPES[] = { "text/plain",
+		"application/openmetrics-text" };
+
+/**
+ * A value written by every benchmark, to prevent the compiler from optimizing the parsing away.
+ */
+volatile int32_t sink = 0;
+
+/**
+ * A copy of web::csvHeaderContains from src/webhandler.cpp, as a baseline.
+ * Copied because the main source files can't be compiled without the Arduino framework.
+ *
+ * @param header	The header value to check.
+ * @param value		The value to look for.
+ * @return	True if the header contains the given value.
+ */
+bool csvHeaderContains(const char *header, const char *value) {
+	const char *cpos = header - 1;
+	const char *start = NULL;
+	const size_t header_len = strlen(header);
+	const size_t val_len = strlen(value);
+	while (header + header_len > ++cpos) {
+		if (start == NULL && isspace(*cpos) == 0 && *cpos != ','
+				&& *cpos != ';') {
+			start = cpos;
+		} else if (start != NULL && (*cpos == ',' || *cpos == ';')) {
+			if ((size_t) (cpos - start) == val_len
+					&& strncmp(start, value, val_len) == 0) {
+				return true;
+			}
+
+			if (*cpos == ',') {
+				start = NULL;
+			}
+		}
+	}
+
+	if (start != NULL && (size_t) (cpos - start) == val_len
+			&& strncmp(start, value, val_len) == 0) {
+		return true;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * Repeatedly calls the given function with the given header, and writes the result.
+ *
+ * @param name		The name of the benchmarked function, for the output.
+ * @param header	The name of the benchmarked header, for the output.
+ * @param value		The header value to parse.
+ * @param func		The function parsing the header.
+ */
+void benchmark_header(const char *name, const char *header, const char *value,
+		int8_t (*func)(const char*)) {
+	size_t iterations = 0;
+	bench_clock::duration total(0);
+	while (total < MIN_DURATION) {
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t i = 0; i < BATCH_SIZE; i++) {
+			sink += func(value);
+		}
+		total += bench_clock::now() - start;
+		iterations += BATCH_SIZE;
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"%s\", \"header\": \"%s\", "
+					"\"header_bytes\": %zu, \"iterations\": %zu, "
+					"\"mean_call_ns\": %.3f}", name, header, strlen(value),
+			iterations,
+			std::chrono::duration<double, std::nano>(total).count()
+					/ iterations);
+	write_result(line);
+}
+
+/**
+ * The old Accept-Encoding check of the static file handler.
+ */
+int8_t baseline_encoding(const char *header) {
+	return csvHeaderContains(header, "gzip") ? 0 : 1;
+}
+
+/**
+ * The new Accept-Encoding check of the static file handler.
+ */
+int8_t negotiate_encoding(const char *header) {
+	return http::negotiateEncoding(header, ENCODINGS, 2);
+}
+
+/**
+ * The old Accept check of the metrics handler.
+ */
+int8_t baseline_media_type(const char *header) {
+	return csvHeaderContains(header, "application/openmetrics-text") ? 1 : 0;
+}
+
+/**
+ * The new Accept check of the metrics handler.
+ */
+int8_t negotiate_media_type(const char *header) {
+	return http::negotiateMediaType(header, MEDIA_TYPES, 2);
+}
+
+/**
+ * Benchmark both Accept-Encoding parsers with headers sent by common clients.
+ */
+void test_benchmark_accept_encoding() {
+	const char *const headers[][2] = { { "chrome", "gzip, deflate, br, zstd" },
+			{ "curl", "deflate, gzip, br, zstd" }, { "qvalues",
+					"br;q=1.0, gzip;q=0.8, *;q=0.1" } };
+	for (const char *const *header : headers) {
+		TEST_ASSERT_EQUAL_INT8(baseline_encoding(header[1]),
+				negotiate_encoding(header[1]));
+		benchmark_header("csvHeaderContains", header[0], header[1],
+				baseline_encoding);
+		benchmark_header("negotiateEncoding", header[0], header[1],
+				negotiate_encoding);
+	}
+}
+
+/**
+ * Benchmark both Accept parsers with headers sent by common clients.
+ */
+void test_benchmark_accept() {
+	const char *const headers[][2] = { { "firefox",
+			"text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8" },
+			{ "prometheus",
+					"application/openmetrics-text;version=1.0.0,application/openmetrics-text;version=0.0.1;q=0.75,"
+							"text/plain;version=0.0.4;q=0.5,*/*;q=0.1" } };
+	for (const char *const *header : headers) {
+		TEST_ASSERT_EQUAL_INT8(baseline_media_type(header[1]),
+				negotiate_media_type(header[1]));
+		benchmark_header("csvHeaderContains", header[0], header[1],
+				baseline_media_type);
+		benchmark_header("negotiateMediaType", header[0], header[1],
+				negotiate_media_type);
+	}
+}
+
+/**
+ * The entrypoint running this benchmark file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	open_output();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_benchmark_accept_encoding);
+	RUN_TEST(test_benchmark_accept);
+
+	close_output();
+
+	return UNITY_END();
+}
@@ -0,0 +1,204 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../benchmark_helper.h"
+#include <json_writer.h>
+#include <utils.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/**
+ * The clock used to measure the write time.
+ */
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * The min total time to spend writing each document.
+ */
+const std::chrono::milliseconds MIN_DURATION(200);
+
+/**
+ * The number of documents written between two clock reads.
+ */
+const size_t BATCH_SIZE = 1000;
+
+/**
+ * A value written by every benchmark, to prevent the compiler from optimizing the writing away.
+ */
+volatile size_t sink = 0;
+
+/**
+ * The measurements to write, changed between documents, like a real sensor.
+ */
+volatile float temperature = 21.37;
+
+/**
+ * The humidity to write.
+ */
+volatile float humidity = 48.2;
+
+/**
+ * The time since the last measurement to write.
+ */
+volatile int64_t time_ms = 4711;
+
+/**
+ * The previous implementation of utils::timespan_to_string, using a string stream.
+ *
+ * @param time_ms	The timespan to convert to a string.
+ * @return	The newly created string.
+ */
+std::string baseline_timespan_to_string(const int64_t time_ms) {
+	if (time_ms < 0) {
+		return "Unknown";
+	}
+
+	std::ostringstream stream;
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 3600000 % 24 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 60000 % 60 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 1000 % 60 << '.';
+	stream << std::internal << std::setfill('0') << std::setw(3);
+	stream << time_ms % 1000;
+	return stream.str();
+}
+
+/**
+ * The previous /data.json generation, using strcpy and snprintf for the measurements,
+ * and a string stream for the time, to build a std::string.
+ *
+ * @return	The length of the generated document.
+ */
+size_t baseline_json() {
+	const size_t max_len = 64;
+	char buffer[max_len + 1];
+
+	strcpy(buffer, "{\"temperature\": ");
+	size_t len = 16;
+	if (std::isnan(temperature)) {
+		strcpy(buffer + len, "\"Unknown\"");
+		len += 9;
+	} else {
+		len += snprintf(buffer + len, max_len - len, "%.2f", temperature);
+	}
+
+	strcpy(buffer + len, ", \"humidity\": ");
+	len += 14;
+	if (std::isnan(humidity)) {
+		strcpy(buffer + len, "\"Unknown\"");
+		len += 9;
+	} else {
+		len += snprintf(buffer + len, max_len - len, "%.2f", humidity);
+	}
+	const std::string measurements(buffer, len);
+
+	const std::string time_string = baseline_timespan_to_string(time_ms);
+	std::string json;
+	json.reserve(measurements.length() + 14 + time_string.length());
+	json += measurements;
+	json += ", \"time\": \"";
+	json += time_string;
+	json += "\"}";
+	return json.length();
+}
+
+/**
+ * The /data.json generation using the JSON writer, writing to a stack buffer.
+ *
+ * @return	The length of the generated document.
+ */
+size_t writer_json() {
+	char buffer[128];
+	utils::JsonWriter writer(buffer, sizeof(buffer));
+	writer.beginObject();
+	writer.key("temperature");
+	if (std::isnan(temperature)) {
+		writer.value("Unknown");
+	} else {
+		writer.value(temperature, 2);
+	}
+	writer.key("humidity");
+	if (std::isnan(humidity)) {
+		writer.value("Unknown");
+	} else {
+		writer.value(humidity, 2);
+	}
+	char time_string[13];
+	const size_t time_len = utils::timespan_to_chars(time_ms, time_string);
+	writer.key("time").value(time_string, time_len);
+	writer.endObject();
+	return writer.written();
+}
+
+/**
+ * Repeatedly calls the given function, and writes the result.
+ *
+ * @param name		The name of the benchmarked implementation, for the output.
+ * @param write		The function writing the document.
+ */
+template<typename F>
+void benchmark_write(const char *name, F write) {
+	size_t iterations = 0;
+	bench_clock::duration total(0);
+	while (total < MIN_DURATION) {
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t i = 0; i < BATCH_SIZE; i++) {
+			time_ms = time_ms + 1;
+			sink += write();
+		}
+		total += bench_clock::now() - start;
+		iterations += BATCH_SIZE;
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"%s\", \"document\": \"data.json\", "
+					"\"iterations\": %zu, \"mean_call_ns\": %.3f}", name,
+			iterations,
+			std::chrono::duration<double, std::nano>(total).count()
+					/ iterations);
+	write_result(line);
+}
+
+/**
+ * Benchmark the previous /data.json generation and the JSON writer.
+ */
+void test_benchmark_data_json() {
+	benchmark_write("baseline", baseline_json);
+	benchmark_write("JsonWriter", writer_json);
+}
+
+/**
+ * The entrypoint running this benchmark file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	open_output();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_benchmark_data_json);
+
+	close_output();
+
+	return UNITY_END();
+}
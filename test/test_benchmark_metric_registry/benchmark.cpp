@@ -0,0 +1,363 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../benchmark_helper.h"
+#include <metric_registry.h>
+#include <metrics_generator.h>
+#include <uzlib_gzip_wrapper.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+/**
+ * The clock used to measure the render time.
+ */
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * The min total time to spend rendering each exposition.
+ */
+const std::chrono::milliseconds MIN_DURATION(200);
+
+/**
+ * The number of expositions rendered between two clock reads.
+ */
+const size_t BATCH_SIZE = 100;
+
+/**
+ * The size of the chunks the exposition is written in, about the size of a TCP segment.
+ */
+const size_t CHUNK_SIZE = 1436;
+
+/**
+ * The window size parameter used to compress the exposition, the default METRICS_GZIP_WINDOW_SIZE.
+ */
+const int8_t GZIP_WINDOW_SIZE = -10;
+
+/**
+ * A value written by every benchmark, to prevent the compiler from optimizing the rendering away.
+ */
+volatile size_t sink = 0;
+
+/**
+ * The value of all benchmarked metrics, changed between expositions, like a real sensor.
+ */
+volatile double value = 21.37;
+
+/**
+ * The description of a metric rendered by both implementations.
+ */
+struct MetricDescription {
+	/**
+	 * The name of the metric, without namespace and unit.
+	 */
+	const char *name;
+
+	/**
+	 * The unit of the metric. May be empty.
+	 */
+	const char *unit;
+
+	/**
+	 * The metric type.
+	 */
+	const char *type;
+
+	/**
+	 * The description text of the metric.
+	 */
+	const char *help;
+};
+
+/**
+ * The single sample metrics of the thermometer, rendered by the baseline.
+ */
+const MetricDescription METRICS[] = {
+		{ "external_temperature", "celsius", "gauge",
+				"The current measured external temperature in degrees celsius." },
+		{ "external_humidity", "percent", "gauge",
+				"The current measured external relative humidity in percent." },
+		{ "decompressed_cache_hits_total", "", "counter",
+				"The number of requests answered from the decompressed static file cache." },
+		{ "decompressed_cache_misses_total", "", "counter",
+				"The number of requests for files not in the decompressed static file cache." },
+		{ "decompressed_cache_evictions_total", "", "counter",
+				"The number of files removed from the decompressed static file cache." },
+		{ "decompressed_cache_size", "bytes", "gauge",
+				"The total size of all files in the decompressed static file cache." },
+		{ "gzip_dict_pool_dicts", "", "gauge",
+				"The total number of preallocated gzip decompression dicts." },
+		{ "gzip_dict_pool_dicts_in_use", "", "gauge",
+				"The number of gzip decompression dicts currently in use." },
+		{ "gzip_dict_pool_exhausted_total", "", "counter",
+				"The number of times a gzip decompression dict was requested while all dicts were in use." } };
+
+/**
+ * The number of benchmarked metrics.
+ */
+const size_t METRIC_COUNT = sizeof(METRICS) / sizeof(METRICS[0]);
+
+/**
+ * The compile time descriptions of the same metrics, for the registry.
+ */
+static constexpr prom::MetricFamily FAMILIES[] = {
+		PROM_GAUGE_FAMILY_WITH_UNIT("esptherm_external_temperature", "celsius",
+				"The current measured external temperature in degrees celsius."),
+		PROM_GAUGE_FAMILY_WITH_UNIT("esptherm_external_humidity", "percent",
+				"The current measured external relative humidity in percent."),
+		PROM_COUNTER_FAMILY("esptherm_decompressed_cache_hits_total",
+				"The number of requests answered from the decompressed static file cache."),
+		PROM_COUNTER_FAMILY("esptherm_decompressed_cache_misses_total",
+				"The number of requests for files not in the decompressed static file cache."),
+		PROM_COUNTER_FAMILY("esptherm_decompressed_cache_evictions_total",
+				"The number of files removed from the decompressed static file cache."),
+		PROM_GAUGE_FAMILY_WITH_UNIT("esptherm_decompressed_cache_size", "bytes",
+				"The total size of all files in the decompressed static file cache."),
+		PROM_GAUGE_FAMILY("esptherm_gzip_dict_pool_dicts",
+				"The total number of preallocated gzip decompression dicts."),
+		PROM_GAUGE_FAMILY("esptherm_gzip_dict_pool_dicts_in_use",
+				"The number of gzip decompression dicts currently in use."),
+		PROM_COUNTER_FAMILY("esptherm_gzip_dict_pool_exhausted_total",
+				"The number of times a gzip decompression dict was requested while all dicts were in use.") };
+
+/**
+ * Reads the benchmark value as a gauge.
+ *
+ * @return	The current value.
+ */
+double read_gauge() {
+	return value;
+}
+
+/**
+ * Reads the benchmark value as a counter.
+ *
+ * @return	The current value, rounded down.
+ */
+uint64_t read_counter() {
+	return (uint64_t) value;
+}
+
+/**
+ * The previous prom::writeMetricMetadataLine implementation, formatting a metadata line at run time.
+ *
+ * @param buffer		The buffer to write to.
+ * @param size			The size of the buffer.
+ * @param field_name	The name of the metadata field.
+ * @param metric_name	The name of the metric.
+ * @param metric_unit	The unit of the metric. May be empty.
+ * @param value			The value of the metadata field.
+ * @return	The length of the line, like snprintf.
+ */
+size_t baseline_metadata_line(char *buffer, const size_t size,
+		const char *field_name, const char *metric_name,
+		const char *metric_unit, const char *value) {
+	return snprintf(buffer, size, "# %s esptherm_%s%s%s %s\n", field_name,
+			metric_name, metric_unit[0] != 0 ? "_" : "", metric_unit, value);
+}
+
+/**
+ * The previous prom::writeMetric implementation, formatting all lines of a metric at run time.
+ *
+ * @param buffer		The buffer to write to.
+ * @param size			The size of the buffer.
+ * @param metric		The metric to write.
+ * @param openmetrics	Whether to write the OpenMetrics UNIT line.
+ * @return	The length of the metric, like snprintf.
+ */
+size_t baseline_metric(char *buffer, const size_t size,
+		const MetricDescription &metric, const bool openmetrics) {
+	size_t written = baseline_metadata_line(buffer, size, "HELP", metric.name,
+			metric.unit, metric.help);
+	written += baseline_metadata_line(buffer + written, size - written, "TYPE",
+			metric.name, metric.unit, metric.type);
+	if (openmetrics && metric.unit[0] != 0) {
+		written += baseline_metadata_line(buffer + written, size - written,
+				"UNIT", metric.name, metric.unit, metric.unit);
+	}
+	written += snprintf(buffer + written, size - written, "esptherm_%s%s%s",
+			metric.name, metric.unit[0] != 0 ? "_" : "", metric.unit);
+	written += snprintf(buffer + written, size - written, " %.3f\n", value);
+	return written;
+}
+
+/**
+ * Renders the exposition of all metrics using the previous implementation,
+ * building the whole exposition in a std::string.
+ *
+ * @return	The length of the exposition.
+ */
+size_t baseline_exposition() {
+	char buffer[512];
+	std::string metrics;
+	for (size_t i = 0; i < METRIC_COUNT; i++) {
+		metrics.append(buffer,
+				baseline_metric(buffer, sizeof(buffer), METRICS[i], false));
+	}
+	return metrics.length();
+}
+
+/**
+ * Renders the exposition of all metrics in the given registry, in chunks of CHUNK_SIZE bytes.
+ *
+ * @param registry	The registry to render.
+ * @return	The length of the exposition.
+ */
+size_t registry_exposition(const prom::Registry &registry) {
+	uint8_t chunk[CHUNK_SIZE];
+	prom::MetricsGenerator generator(registry);
+	size_t total = 0;
+	size_t len;
+	while ((len = generator.fill(chunk, CHUNK_SIZE)) > 0) {
+		total += len;
+	}
+	return total;
+}
+
+/**
+ * Renders the exposition of all metrics in the given registry, and gzip compresses it while rendering,
+ * in chunks of CHUNK_SIZE bytes.
+ *
+ * @param registry	The registry to render.
+ * @return	The compressed length of the exposition.
+ */
+size_t registry_gzip_exposition(const prom::Registry &registry) {
+	uint8_t chunk[CHUNK_SIZE];
+	prom::MetricsGenerator generator(registry);
+	gzip::uzlib_gzip_wrapper comp(
+			[&generator](uint8_t *buf, const size_t max_len) -> size_t {
+				return generator.fill(buf, max_len);
+			}, GZIP_WINDOW_SIZE);
+	size_t total = 0;
+	size_t len;
+	while ((len = comp.compress(chunk, CHUNK_SIZE)) > 0) {
+		total += len;
+	}
+	return total;
+}
+
+/**
+ * Repeatedly calls the given function, and writes the result.
+ *
+ * @param name			The name of the benchmarked implementation, for the output.
+ * @param flash_bytes	The constant data used by the implementation.
+ * @param ram_bytes		The static RAM used by the implementation, excluding the output buffers.
+ * @param render		The function rendering the exposition.
+ */
+template<typename F>
+void benchmark_render(const char *name, const size_t flash_bytes,
+		const size_t ram_bytes, F render) {
+	size_t iterations = 0;
+	size_t length = 0;
+	bench_clock::duration total(0);
+	while (total < MIN_DURATION) {
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t i = 0; i < BATCH_SIZE; i++) {
+			value = value + 1;
+			length = render();
+			sink += length;
+		}
+		total += bench_clock::now() - start;
+		iterations += BATCH_SIZE;
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"%s\", \"document\": \"metrics\", \"metrics\": %zu, "
+					"\"iterations\": %zu, \"mean_call_ns\": %.3f, \"output_bytes\": %zu, "
+					"\"flash_bytes\": %zu, \"ram_bytes\": %zu}", name,
+			METRIC_COUNT, iterations,
+			std::chrono::duration<double, std::nano>(total).count()
+					/ iterations, length, flash_bytes, ram_bytes);
+	write_result(line);
+}
+
+/**
+ * Benchmark rendering the metrics with the previous hand-written functions and the registry,
+ * and rendering them with the registry while compressing them.
+ */
+void test_benchmark_metrics() {
+	size_t baseline_flash = sizeof(METRICS);
+	for (size_t i = 0; i < METRIC_COUNT; i++) {
+		baseline_flash += strlen(METRICS[i].name) + strlen(METRICS[i].unit)
+				+ strlen(METRICS[i].type) + strlen(METRICS[i].help) + 4;
+	}
+	benchmark_render("baseline", baseline_flash, 0, baseline_exposition);
+
+	// Declared before the registry, so they are destroyed after it.
+	std::unique_ptr<prom::Metric> metrics[METRIC_COUNT];
+	prom::Registry registry;
+	size_t registry_flash = sizeof(FAMILIES);
+	size_t registry_ram = sizeof(registry);
+	for (size_t i = 0; i < METRIC_COUNT; i++) {
+		const prom::MetricFamily &family = FAMILIES[i];
+		registry_flash += strlen(family.name) + family.metadata_len + 2;
+		// Identical string literals are usually merged, so families without a unit share their metadata.
+		if (family.openmetrics_metadata != family.metadata) {
+			registry_flash += family.openmetrics_metadata_len + 1;
+		}
+		if (family.type == prom::MetricType::COUNTER) {
+			metrics[i].reset(new prom::Counter(family, read_counter));
+			registry_ram += sizeof(prom::Counter);
+		} else {
+			metrics[i].reset(new prom::Gauge(family, read_gauge));
+			registry_ram += sizeof(prom::Gauge);
+		}
+		registry.add(*metrics[i]);
+	}
+
+	benchmark_render("registry", registry_flash, registry_ram,
+			[&registry]() -> size_t {
+				return registry_exposition(registry);
+			});
+
+	benchmark_render("registry_gzip", registry_flash, registry_ram,
+			[&registry]() -> size_t {
+				return registry_gzip_exposition(registry);
+			});
+
+	char line[256];
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"registry\", \"document\": \"generator_state\", \"ram_bytes\": %zu}",
+			sizeof(prom::MetricsGenerator));
+	write_result(line);
+
+	// A 1KiB dict with 1KiB of lookahead, a 256 entry hash table, and the output buffer.
+	const size_t dict_size = 1 << -GZIP_WINDOW_SIZE;
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"registry_gzip\", \"document\": \"compressor_state\", \"ram_bytes\": %zu}",
+			sizeof(gzip::uzlib_gzip_wrapper) + dict_size * 2 + 256 * 2
+					+ gzip::uzlib_gzip_wrapper::OUTBUF_SIZE);
+	write_result(line);
+}
+
+/**
+ * The entrypoint running this benchmark file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	open_output();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_benchmark_metrics);
+
+	close_output();
+
+	return UNITY_END();
+}
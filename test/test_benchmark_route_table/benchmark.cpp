@@ -0,0 +1,162 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../benchmark_helper.h"
+#include <route_table.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * The clock used to measure the lookup time.
+ */
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * The min total time to spend looking up each path.
+ */
+const std::chrono::milliseconds MIN_DURATION(200);
+
+/**
+ * The number of lookups between two clock reads.
+ */
+const size_t BATCH_SIZE = 1000;
+
+/**
+ * The route counts to benchmark.
+ */
+const size_t ROUTE_COUNTS[] = { 4, 16, 64, 256, 1024 };
+
+/**
+ * A value written by every benchmark, to prevent the compiler from optimizing the lookup away.
+ */
+volatile size_t sink = 0;
+
+/**
+ * Creates the given number of routes, similar to the ones registered by the web server.
+ *
+ * @param count	The number of routes to create.
+ * @return	The created routes, in registration order.
+ */
+std::vector<std::string> create_routes(const size_t count) {
+	std::vector<std::string> routes;
+	routes.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		routes.push_back("/route_" + std::to_string(i) + "/endpoint");
+	}
+	return routes;
+}
+
+/**
+ * The previous dispatch, checking the routes one at a time, the way ESPAsyncWebServer calls canHandle.
+ * Like AsyncTrackingFallbackWebHandler::canHandle, it builds the route plus a slash for every check.
+ *
+ * @param routes	The registered routes, in registration order.
+ * @param path		The request path.
+ * @return	The index of the matching route, or the number of routes if none matches.
+ */
+size_t baseline_match(const std::vector<std::string> &routes,
+		const std::string &path) {
+	for (size_t i = 0; i < routes.size(); i++) {
+		if (routes[i] == path || path.compare(0, routes[i].length() + 1,
+				routes[i] + '/') == 0) {
+			return i;
+		}
+	}
+	return routes.size();
+}
+
+/**
+ * Repeatedly calls the given lookup function with the given path, and writes the result.
+ *
+ * @param name		The name of the benchmarked lookup, for the output.
+ * @param routes	The number of registered routes, for the output.
+ * @param path_name	The name of the benchmarked path, for the output.
+ * @param lookup	The function looking up the path.
+ */
+template<typename F>
+void benchmark_lookup(const char *name, const size_t routes,
+		const char *path_name, F lookup) {
+	size_t iterations = 0;
+	bench_clock::duration total(0);
+	while (total < MIN_DURATION) {
+		const bench_clock::time_point start = bench_clock::now();
+		for (size_t i = 0; i < BATCH_SIZE; i++) {
+			sink += lookup();
+		}
+		total += bench_clock::now() - start;
+		iterations += BATCH_SIZE;
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line),
+			"{\"benchmark\": \"%s\", \"routes\": %zu, \"path\": \"%s\", "
+					"\"iterations\": %zu, \"mean_call_ns\": %.3f}", name,
+			routes, path_name, iterations,
+			std::chrono::duration<double, std::nano>(total).count()
+					/ iterations);
+	write_result(line);
+}
+
+/**
+ * Benchmark the linear dispatch and the route table with a growing number of routes.
+ * Looks up the last registered route, a path below it, and an unknown path.
+ */
+void test_benchmark_lookup() {
+	for (const size_t count : ROUTE_COUNTS) {
+		const std::vector<std::string> routes = create_routes(count);
+		http::RouteTable<size_t> table;
+		for (size_t i = 0; i < routes.size(); i++) {
+			table[routes[i]] = i;
+		}
+
+		const std::string paths[][2] = { { "last", routes.back() }, {
+				"subpath", routes.back() + "/x" }, { "unknown",
+				"/unknown/path" } };
+		for (const std::string *path : paths) {
+			const size_t expected = baseline_match(routes, path[1]);
+			const size_t *value = table.match(path[1].c_str(),
+					path[1].length());
+			TEST_ASSERT_EQUAL_UINT(expected, value ? *value : routes.size());
+
+			benchmark_lookup("linear", count, path[0].c_str(),
+					[&routes, path]() -> size_t {
+						return baseline_match(routes, path[1]);
+					});
+			benchmark_lookup("RouteTable", count, path[0].c_str(),
+					[&table, path]() -> size_t {
+						return table.match(path[1].c_str(), path[1].length())
+								!= NULL;
+					});
+		}
+	}
+}
+
+/**
+ * The entrypoint running this benchmark file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	open_output();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_benchmark_lookup);
+
+	close_output();
+
+	return UNITY_END();
+}
@@ -0,0 +1,314 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#define BENCHMARK_CUSTOM_FIXTURES
+#include "../benchmark_helper.h"
+#include <uzlib_gzip_wrapper.h>
+#include <utils.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * The clock used to measure the decompression time.
+ */
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * Use a constant seed, to get reproducible results.
+ * Used to generate the random data for the synthetic benchmark file.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1685018244;
+
+/**
+ * The command to be used to compress a file, without the window size and filename.
+ */
+const char BASE_COMMAND[] = "python3 -m shared.gzip_compressing_stream";
+
+/**
+ * The window sizes to benchmark.
+ * A window size of -10 means a 1024 byte buffer, while -15(the max) means a 32768 byte buffer.
+ * Starts at -9, because zlib, and by extension the python compressor, doesn't support raw deflate with a window size of -8.
+ */
+const int8_t WINDOW_SIZES[] = { -9, -10, -11, -12, -13, -14, -15 };
+
+/**
+ * The output buffer sizes to benchmark.
+ * These match the chunk sizes AsyncWebServer commonly requests from a response filler,
+ * which are based on the free space in the TCP send buffer.
+ */
+const size_t BUFFER_SIZES[] = { 512, 1436, 2872, 5744 };
+
+/**
+ * The min total time to spend decompressing each combination of file, window size, and buffer size.
+ */
+const std::chrono::milliseconds MIN_DURATION(200);
+
+/**
+ * The min number of times to decompress each combination of file, window size, and buffer size.
+ */
+const size_t MIN_ITERATIONS = 10;
+
+/**
+ * The path of the temporary uncompressed file.
+ * Initialized in setUp and deleted in tearDown.
+ */
+char *uncompressed_path = NULL;
+
+/**
+ * The path of the temporary compressed file.
+ * Initialized in setUp and deleted in tearDown.
+ */
+std::string compressed_path;
+
+/**
+ * Generates the temporary file paths.
+ */
+void setUp() {
+	const size_t u_buf_len = (L_tmpnam < 260 ? 260 : L_tmpnam) + 1; // L_tmpnam seems to be incorrect sometimes.
+	uncompressed_path = new char[u_buf_len];
+	if (tmpnam(uncompressed_path)) {
+		compressed_path = std::string(uncompressed_path) + ".gz";
+	} else {
+		delete[] uncompressed_path;
+		uncompressed_path = NULL;
+	}
+}
+
+/**
+ * Deletes the temporary files.
+ */
+void tearDown() {
+	if (uncompressed_path != NULL) {
+		remove(uncompressed_path);
+		remove(compressed_path.c_str());
+		delete[] uncompressed_path;
+		uncompressed_path = NULL;
+	}
+}
+
+/**
+ * Reads the entire given file.
+ *
+ * @param path	The path of the file to read.
+ * @return	The content of the file.
+ */
+std::vector<uint8_t> read_file(const char *path) {
+	std::ifstream in(path, std::ios::in | std::ios::binary);
+	TEST_ASSERT_TRUE_MESSAGE(in.is_open(), "Failed to open input file.");
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+			std::istreambuf_iterator<char>());
+}
+
+/**
+ * Decompresses the given gzip file in its entirety.
+ *
+ * @param compressed	The gzip file to decompress.
+ * @return	The decompressed data.
+ */
+std::vector<uint8_t> decompress_all(const std::vector<uint8_t> &compressed) {
+	gzip::uzlib_ungzip_wrapper unzip(compressed.data(),
+			compressed.data() + compressed.size(), -15);
+	TEST_ASSERT_TRUE_MESSAGE(unzip.getDecompressedSize() >= 0,
+			"Failed to read the uncompressed size.");
+	std::vector<uint8_t> decompressed(unzip.getDecompressedSize());
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(decompressed.size(),
+			unzip.decompress(decompressed.data(), decompressed.size()),
+			"Failed to decompress input file.");
+	return decompressed;
+}
+
+/**
+ * Compresses the given data with the given window size, using the same compressor as the web file build step.
+ *
+ * @param data	The data to compress.
+ * @param wsize	The window size to use.
+ * @return	The compressed gzip file.
+ */
+std::vector<uint8_t> compress(const std::vector<uint8_t> &data,
+		const int8_t wsize) {
+	TEST_ASSERT_NOT_NULL_MESSAGE(uncompressed_path,
+			"Failed to generate temporary file path.");
+	std::ofstream out(uncompressed_path, std::ios::out | std::ios::binary);
+	out.write((const char*) data.data(), data.size());
+	out.close();
+	TEST_ASSERT_FALSE_MESSAGE(out.fail(), "Writing uncompressed file failed.");
+
+	const std::string command = std::string(BASE_COMMAND) + " --window-size "
+			+ std::to_string(wsize) + ' ' + uncompressed_path;
+	// Assume that a successful command returns 0.
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, std::system(command.c_str()),
+			"GZIP compression command failed.");
+	return read_file(compressed_path.c_str());
+}
+
+/**
+ * Benchmarks decompressing the given data with all window and buffer sizes.
+ *
+ * @param name	The name of the benchmarked file, for the output.
+ * @param data	The uncompressed data to benchmark.
+ */
+void benchmark_file(const char *name, const std::vector<uint8_t> &data) {
+	for (const int8_t wsize : WINDOW_SIZES) {
+		const std::vector<uint8_t> compressed = compress(data, wsize);
+		for (const size_t buf_size : BUFFER_SIZES) {
+			uint8_t *buffer = new uint8_t[buf_size];
+			size_t iterations = 0;
+			size_t calls = 0;
+			bench_clock::duration total(0);
+			bench_clock::duration max_call(0);
+			while (iterations < MIN_ITERATIONS || total < MIN_DURATION) {
+				gzip::uzlib_ungzip_wrapper unzip(compressed.data(),
+						compressed.data() + compressed.size(), wsize);
+				size_t decompressed = 0;
+				while (!unzip.done()) {
+					const bench_clock::time_point start = bench_clock::now();
+					const size_t read = unzip.decompress(buffer, buf_size);
+					const bench_clock::duration time = bench_clock::now()
+							- start;
+					total += time;
+					max_call = std::max(max_call, time);
+					decompressed += read;
+					calls++;
+					if (read == 0) {
+						break;
+					}
+				}
+				TEST_ASSERT_EQUAL_UINT_MESSAGE(data.size(), decompressed,
+						"Decompressed size didn't match uncompressed size.");
+				iterations++;
+			}
+			delete[] buffer;
+
+			const double total_s = std::chrono::duration<double>(total).count();
+			char line[512];
+			snprintf(line, sizeof(line),
+					"{\"benchmark\": \"uzlib_ungzip_wrapper::decompress\", \"file\": \"%s\", "
+							"\"window_size\": %d, \"buffer_size\": %zu, "
+							"\"uncompressed_bytes\": %zu, \"compressed_bytes\": %zu, "
+							"\"iterations\": %zu, \"mb_per_s\": %.3f, "
+							"\"mean_call_us\": %.3f, \"max_call_us\": %.3f}",
+					name, wsize, buf_size, data.size(), compressed.size(),
+					iterations, data.size() * iterations / total_s / 1000000,
+					total_s * 1000000 / calls,
+					std::chrono::duration<double, std::micro>(max_call).count());
+			write_result(line);
+		}
+	}
+}
+
+/**
+ * Benchmarks decompressing the web file from the given path in data/gzip.
+ *
+ * @param name	The name of the file in data/gzip, without the .gz extension.
+ */
+void benchmark_web_file(const char *name) {
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, std::system("python3 -V"),
+			"Failed to find python 3 interpreter.");
+	const std::string path = std::string("data/gzip/") + name + ".gz";
+	benchmark_file(name, decompress_all(read_file(path.c_str())));
+}
+
+/**
+ * Benchmark decompressing the main css stylesheet.
+ */
+void test_benchmark_main_css() {
+	benchmark_web_file("main.css");
+}
+
+/**
+ * Benchmark decompressing the main page javascript file.
+ */
+void test_benchmark_index_js() {
+	benchmark_web_file("index.js");
+}
+
+/**
+ * Benchmark decompressing the web app manifest.
+ */
+void test_benchmark_manifest_json() {
+	benchmark_web_file("manifest.json");
+}
+
+/**
+ * Benchmark decompressing the favicon ico.
+ */
+void test_benchmark_favicon_ico() {
+	benchmark_web_file("favicon.ico");
+}
+
+/**
+ * Benchmark decompressing the favicon png.
+ */
+void test_benchmark_favicon_png() {
+	benchmark_web_file("favicon.png");
+}
+
+/**
+ * Benchmark decompressing the favicon svg.
+ */
+void test_benchmark_favicon_svg() {
+	benchmark_web_file("favicon.svg");
+}
+
+/**
+ * Benchmark decompressing a larger file, to measure the throughput without the per file setup cost.
+ * Repeats the main css and javascript files with random text in between, to get realistic matches.
+ */
+void test_benchmark_synthetic() {
+	std::mt19937 rng(RANDOM_SEED);
+	std::uniform_int_distribution<uint8_t> distribution('a', 'z');
+	const std::vector<uint8_t> css = decompress_all(
+			read_file("data/gzip/main.css.gz"));
+	const std::vector<uint8_t> js = decompress_all(
+			read_file("data/gzip/index.js.gz"));
+
+	std::vector<uint8_t> data;
+	while (data.size() < 65536) {
+		data.insert(data.end(), css.begin(), css.end());
+		for (size_t i = 0; i < 256; i++) {
+			data.push_back(distribution(rng));
+		}
+		data.insert(data.end(), js.begin(), js.end());
+	}
+	benchmark_file("synthetic", data);
+}
+
+/**
+ * The entrypoint running this benchmark file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	open_output();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_benchmark_main_css);
+	RUN_TEST(test_benchmark_index_js);
+	RUN_TEST(test_benchmark_manifest_json);
+	RUN_TEST(test_benchmark_favicon_ico);
+	RUN_TEST(test_benchmark_favicon_png);
+	RUN_TEST(test_benchmark_favicon_svg);
+	RUN_TEST(test_benchmark_synthetic);
+
+	close_output();
+
+	return UNITY_END();
+}
@@ -0,0 +1,223 @@
+/*
+ * compiled_template.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <compiled_template.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * A template similar to the main page, containing known and unknown placeholders, and a single delimiter.
+ */
+const char TEMPLATE[] =
+		"<p>Temperature: $TEMP$</p><p>Humidity: $HUMID$</p>$UNKNOWN$<p>$TEMP$ again, costs 5$.</p>";
+
+/**
+ * The placeholders to replace in the template.
+ */
+const std::vector<std::string> PLACEHOLDERS = { "TEMP", "HUMID", "TIME" };
+
+/**
+ * The byte used to detect writes past the returned length.
+ */
+const uint8_t GUARD_BYTE = 0xA5;
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Fills the given template with a naive find and replace, as a reference.
+ *
+ * @param tmpl		The template to fill.
+ * @param values	The value of each placeholder in PLACEHOLDERS.
+ * @return	The filled template.
+ */
+std::string reference_fill(const std::string &tmpl,
+		const std::vector<std::string> &values) {
+	std::string result;
+	size_t pos = 0;
+	while (pos < tmpl.size()) {
+		const size_t open = tmpl.find('$', pos);
+		const size_t close =
+				open == std::string::npos ?
+						std::string::npos : tmpl.find('$', open + 1);
+		if (close == std::string::npos) {
+			result += tmpl.substr(pos);
+			break;
+		}
+
+		result += tmpl.substr(pos, open - pos);
+		const std::string name = tmpl.substr(open + 1, close - open - 1);
+		std::string replacement = name;
+		for (size_t i = 0; i < PLACEHOLDERS.size(); i++) {
+			if (PLACEHOLDERS[i] == name) {
+				replacement = i < values.size() ? values[i] : "";
+			}
+		}
+		result += replacement;
+		pos = close + 1;
+	}
+	return result;
+}
+
+/**
+ * Fills the given compiled template using chunks of the given size.
+ * Checks that no call writes past the length it returns.
+ *
+ * @param tmpl			The template to fill.
+ * @param values		The placeholder values to use.
+ * @param chunk_size	The max number of bytes to write per call.
+ * @return	The filled template.
+ */
+std::string chunked_fill(const http::CompiledTemplate &tmpl,
+		const std::vector<std::string> &values, const size_t chunk_size) {
+	std::string result;
+	std::vector<uint8_t> buffer(chunk_size + 1);
+	size_t written = 0;
+	do {
+		memset(buffer.data(), GUARD_BYTE, buffer.size());
+		written = tmpl.fill(values, buffer.data(), chunk_size, result.size());
+		TEST_ASSERT_LESS_OR_EQUAL_UINT_MESSAGE(chunk_size, written,
+				"Filling the template wrote more than the max length.");
+		for (size_t i = written; i < buffer.size(); i++) {
+			TEST_ASSERT_EQUAL_HEX8_MESSAGE(GUARD_BYTE, buffer[i],
+					"Filling the template wrote past the returned length.");
+		}
+		result.append((const char*) buffer.data(), written);
+	} while (written > 0);
+	return result;
+}
+
+/**
+ * Test that a template is split into the expected segments.
+ */
+void test_compile_segments() {
+	const char tmpl[] = "a$TEMP$b$UNKNOWN$$HUMID$ $ c";
+	const http::CompiledTemplate compiled((const uint8_t*) tmpl,
+			(const uint8_t*) tmpl + strlen(tmpl), PLACEHOLDERS);
+	const std::vector<http::CompiledTemplate::Segment> &segments =
+			compiled.getSegments();
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(6, segments.size(),
+			"The template had an unexpected number of segments.");
+	TEST_ASSERT_EQUAL_UINT8(http::CompiledTemplate::LITERAL,
+			segments[0].placeholder);
+	TEST_ASSERT_EQUAL_UINT(1, segments[0].len);
+	TEST_ASSERT_EQUAL_UINT8(0, segments[1].placeholder);
+	TEST_ASSERT_EQUAL_UINT8(http::CompiledTemplate::LITERAL,
+			segments[2].placeholder);
+	TEST_ASSERT_EQUAL_UINT(1, segments[2].len);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(7, segments[3].len,
+			"An unknown placeholder wasn't replaced with its name.");
+	TEST_ASSERT_EQUAL_UINT8(1, segments[4].placeholder);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(4, segments[5].len,
+			"A single delimiter wasn't kept as is.");
+	TEST_ASSERT_EQUAL_UINT(13, compiled.getLiteralLength());
+}
+
+/**
+ * Test the length calculation with different placeholder values.
+ */
+void test_length() {
+	const http::CompiledTemplate compiled((const uint8_t*) TEMPLATE,
+			(const uint8_t*) TEMPLATE + strlen(TEMPLATE), PLACEHOLDERS);
+	const std::vector<std::vector<std::string>> value_sets = { { }, { "",
+			"", "" }, { "21.50°C", "45.00%", "00:00:01.000" }, { std::string(
+			3000, 'x') } };
+	for (const std::vector<std::string> &values : value_sets) {
+		TEST_ASSERT_EQUAL_UINT(reference_fill(TEMPLATE, values).size(),
+				compiled.getLength(values));
+	}
+}
+
+/**
+ * Test filling the template with every chunk size up to beyond its length.
+ * Makes sure chunk boundaries in the middle of literals and placeholder values work.
+ */
+void test_fill_chunked() {
+	const http::CompiledTemplate compiled((const uint8_t*) TEMPLATE,
+			(const uint8_t*) TEMPLATE + strlen(TEMPLATE), PLACEHOLDERS);
+	const std::vector<std::string> values = { "21.50°C", "45.00%",
+			"00:00:01.000" };
+	const std::string expected = reference_fill(TEMPLATE, values);
+	for (size_t chunk_size = 1; chunk_size <= expected.size() + 3;
+			chunk_size++) {
+		TEST_ASSERT_EQUAL_STRING(expected.c_str(),
+				chunked_fill(compiled, values, chunk_size).c_str());
+	}
+}
+
+/**
+ * Test filling the template with a placeholder value larger than the chunk size.
+ */
+void test_fill_large_value() {
+	const http::CompiledTemplate compiled((const uint8_t*) TEMPLATE,
+			(const uint8_t*) TEMPLATE + strlen(TEMPLATE), PLACEHOLDERS);
+	const std::vector<std::string> values = { std::string(5000, 't'), "h" };
+	const std::string expected = reference_fill(TEMPLATE, values);
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(),
+			chunked_fill(compiled, values, 1436).c_str());
+}
+
+/**
+ * Test that missing and empty placeholder values are handled like empty strings.
+ */
+void test_fill_missing_values() {
+	const http::CompiledTemplate compiled((const uint8_t*) TEMPLATE,
+			(const uint8_t*) TEMPLATE + strlen(TEMPLATE), PLACEHOLDERS);
+	const std::vector<std::string> values = { "" };
+	const std::string expected = reference_fill(TEMPLATE, values);
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(),
+			chunked_fill(compiled, values, 7).c_str());
+	TEST_ASSERT_EQUAL_UINT(expected.size(), compiled.getLength(values));
+}
+
+/**
+ * Test templates without placeholders, and empty templates.
+ */
+void test_no_placeholders() {
+	const char tmpl[] = "<html>No placeholders here.</html>";
+	const http::CompiledTemplate compiled((const uint8_t*) tmpl,
+			(const uint8_t*) tmpl + strlen(tmpl), PLACEHOLDERS);
+	TEST_ASSERT_EQUAL_UINT(1, compiled.getSegments().size());
+	TEST_ASSERT_EQUAL_STRING(tmpl, chunked_fill(compiled, { }, 10).c_str());
+
+	const http::CompiledTemplate empty((const uint8_t*) tmpl,
+			(const uint8_t*) tmpl, PLACEHOLDERS);
+	TEST_ASSERT_EQUAL_UINT(0, empty.getSegments().size());
+	TEST_ASSERT_EQUAL_UINT(0, empty.getLength( { }));
+	uint8_t buffer[4];
+	TEST_ASSERT_EQUAL_UINT(0, empty.fill( { }, buffer, sizeof(buffer), 0));
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_compile_segments);
+	RUN_TEST(test_length);
+	RUN_TEST(test_fill_chunked);
+	RUN_TEST(test_fill_large_value);
+	RUN_TEST(test_fill_missing_values);
+	RUN_TEST(test_no_placeholders);
+
+	return UNITY_END();
+}
@@ -0,0 +1,87 @@
+/*
+ * histogram.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <histogram.h>
+
+/**
+ * The bucket upper bounds used for the tests.
+ */
+const uint32_t BOUNDS[] = { 10, 100, 1000 };
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Test that values are recorded in the first bucket whose bound isn't smaller than the value.
+ */
+void test_record() {
+	utils::Histogram<3> histogram(BOUNDS);
+	TEST_ASSERT_EQUAL_UINT(4, utils::Histogram<3>::BUCKETS);
+	TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+	TEST_ASSERT_EQUAL_UINT64(0, histogram.getSum());
+
+	const uint32_t values[] = { 0, 10, 11, 100, 500, 1000, 1001, 50000 };
+	for (const uint32_t value : values) {
+		histogram.record(value);
+	}
+
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, histogram.getCumulativeCount(0),
+			"A value equal to a bound wasn't recorded in its bucket.");
+	TEST_ASSERT_EQUAL_UINT32(4, histogram.getCumulativeCount(1));
+	TEST_ASSERT_EQUAL_UINT32(6, histogram.getCumulativeCount(2));
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(8, histogram.getCumulativeCount(3),
+			"The +Inf bucket didn't contain all values.");
+	TEST_ASSERT_EQUAL_UINT32(8, histogram.getCount());
+	TEST_ASSERT_EQUAL_UINT64(52622, histogram.getSum());
+	TEST_ASSERT_EQUAL_UINT32(100, histogram.getBound(1));
+}
+
+/**
+ * Test that the sum doesn't wrap around when exceeding 32 bits, since prometheus would see it as a counter reset.
+ */
+void test_sum_overflow() {
+	utils::Histogram<3> histogram(BOUNDS);
+	histogram.record(UINT32_MAX);
+	histogram.record(5);
+	TEST_ASSERT_EQUAL_UINT64((uint64_t) UINT32_MAX + 5, histogram.getSum());
+	TEST_ASSERT_EQUAL_UINT32(1, histogram.getCumulativeCount(0));
+	TEST_ASSERT_EQUAL_UINT32(2, histogram.getCount());
+}
+
+/**
+ * Test that recording uses lock-free atomics on this platform.
+ */
+void test_lock_free() {
+	TEST_ASSERT_EQUAL_INT_MESSAGE(2, ATOMIC_INT_LOCK_FREE,
+			"32 bit atomics aren't always lock-free.");
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_record);
+	RUN_TEST(test_sum_overflow);
+	RUN_TEST(test_lock_free);
+
+	return UNITY_END();
+}
@@ -0,0 +1,484 @@
+/*
+ * negotiation.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <http_utils.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Use a constant seed, to get reproducible results.
+ * Used to generate the random headers for the fuzz tests.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1685018244;
+
+/**
+ * The number of random headers to check in each fuzz test.
+ */
+const size_t FUZZ_ITERATIONS = 200000;
+
+/**
+ * The content codings used as candidates for the encoding tests.
+ */
+const char *const ENCODINGS[] = { "gzip", "identity" };
+
+/**
+ * The media types used as candidates for the media type tests.
+ */
+const char *const MEDIA_TYPES[] = { "text/plain",
+		"application/openmetrics-text" };
+
+/**
+ * The tokens used to build random headers for the structured fuzz test.
+ */
+const char *const FUZZ_TOKENS[] = { "gzip", "GZIP", "x-gzip", "identity",
+		"deflate", "br", "*", "text/plain", "TEXT/Plain", "text/*",
+		"application/openmetrics-text", "application/*", "*/*", "text/html",
+		"" };
+
+/**
+ * The parameters used to build random headers for the structured fuzz test.
+ * Doesn't contain unterminated quoted strings, since their handling depends on the following elements.
+ * Those are checked by test_negotiate_media_type and test_fuzz_random instead.
+ */
+const char *const FUZZ_PARAMS[] = { "q=0", "q=1", "q=0.5", "q=0.25",
+		"q=0.001", "q=1.000", "Q=0.3", "q=1.5", "q=2", "q=", "q", "q=0.0000",
+		"q=.5", "version=1.0.0", "charset=utf-8", "a=\"b,c\"", "a=\"b\\\"c\"",
+		"q = 0.5", "=x" };
+
+/**
+ * The separators used between elements and parameters in the structured fuzz test.
+ */
+const char *const FUZZ_SEPARATORS[] = { ",", ", ", " ,", ",,", "\t,\t", " , " };
+
+/**
+ * A pointer to the random number generator to be used.
+ * Initialized in setUp and destroyed in tearDown.
+ */
+std::mt19937 *rng;
+
+/**
+ * Initializes the random number generator.
+ */
+void setUp() {
+	rng = new std::mt19937(RANDOM_SEED);
+}
+
+/**
+ * Destroys the random number generator.
+ */
+void tearDown() {
+	delete rng;
+	rng = NULL;
+}
+
+/**
+ * Converts the given string to lower case.
+ *
+ * @param str	The string to convert.
+ * @return	The lower case string.
+ */
+std::string to_lower(std::string str) {
+	for (char &c : str) {
+		if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+	}
+	return str;
+}
+
+/**
+ * Removes leading and trailing spaces and tabs from the given string.
+ *
+ * @param str	The string to trim.
+ * @return	The trimmed string.
+ */
+std::string trim(const std::string &str) {
+	const size_t start = str.find_first_not_of(" \t");
+	if (start == std::string::npos) {
+		return "";
+	}
+	return str.substr(start, str.find_last_not_of(" \t") - start + 1);
+}
+
+/**
+ * Splits the given string at the given separator, ignoring separators in quoted strings.
+ *
+ * @param str		The string to split.
+ * @param separator	The character to split at.
+ * @return	The parts of the string.
+ */
+std::vector<std::string> split(const std::string &str, const char separator) {
+	std::vector<std::string> parts(1);
+	bool quoted = false;
+	for (size_t i = 0; i < str.size(); i++) {
+		if (quoted && str[i] == '\\' && i + 1 < str.size()) {
+			parts.back() += str[i];
+			parts.back() += str[++i];
+			continue;
+		} else if (str[i] == '"') {
+			quoted = !quoted;
+		} else if (!quoted && str[i] == separator) {
+			parts.push_back("");
+			continue;
+		}
+		parts.back() += str[i];
+	}
+	return parts;
+}
+
+/**
+ * A simple, allocating reference implementation of the negotiation functions.
+ * Used to check the results of the real implementation for random headers.
+ *
+ * @param header		The header value to parse, or NULL if the header is missing.
+ * @param candidates	The values the server can send.
+ * @param len			The number of candidates.
+ * @param encoding		Whether to negotiate a content coding, rather than a media type.
+ * @return	The index of the best candidate, or -1 if none is acceptable.
+ */
+int8_t reference_negotiate(const char *header, const char *const candidates[],
+		const size_t len, const bool encoding) {
+	if (header == NULL) {
+		return 0;
+	}
+
+	std::vector<int> qvalues(len, 0);
+	std::vector<int> specificity(len, 0);
+	for (const std::string &raw_element : split(header, ',')) {
+		// An unterminated quoted string makes the element invalid.
+		if ([&raw_element]() {
+			bool quoted = false;
+			for (size_t i = 0; i < raw_element.size(); i++) {
+				if (quoted && raw_element[i] == '\\' && i + 1 < raw_element.size()) {
+					i++;
+				} else if (raw_element[i] == '"') {
+					quoted = !quoted;
+				}
+			}
+			return quoted;
+		}()) {
+			continue;
+		}
+
+		const std::vector<std::string> parts = split(raw_element, ';');
+		const std::string token = to_lower(trim(parts[0]));
+		if (token.empty() || token.find_first_of(" \t") != std::string::npos) {
+			continue;
+		}
+
+		bool valid = true;
+		int qvalue = 1000;
+		for (size_t i = 1; i < parts.size(); i++) {
+			const std::string param = trim(parts[i]);
+			const size_t eq = param.find('=');
+			const std::string name = param.substr(0, eq);
+			const std::string value =
+					eq == std::string::npos ? "" : param.substr(eq + 1);
+			if (name.find_first_of(" \t") != std::string::npos
+					|| (value.find_first_of(" \t") != std::string::npos
+							&& value[0] != '"')) {
+				valid = false;
+			} else if (name == "q" || name == "Q") {
+				qvalue = -1;
+				if (value.size() >= 1 && value.size() <= 5
+						&& (value[0] == '0' || value[0] == '1')
+						&& (value.size() == 1 || value[1] == '.')) {
+					qvalue = (value[0] - '0') * 1000;
+					int factor = 100;
+					for (size_t j = 2; j < value.size(); j++) {
+						if (value[j] < '0' || value[j] > '9') {
+							qvalue = -1;
+							break;
+						}
+						qvalue += (value[j] - '0') * factor;
+						factor /= 10;
+					}
+				}
+				if (qvalue < 0 || qvalue > 1000) {
+					valid = false;
+				}
+			} else if (!value.empty() && value[0] == '"'
+					&& (value.size() < 2 || value.back() != '"')) {
+				valid = false;
+			}
+		}
+		if (!valid) {
+			continue;
+		}
+
+		for (size_t i = 0; i < len; i++) {
+			const std::string candidate = to_lower(candidates[i]);
+			int spec = 0;
+			if (encoding) {
+				if (token == "*") {
+					spec = 1;
+				} else if (token == candidate
+						|| (candidate == "gzip" && token == "x-gzip")) {
+					spec = 2;
+				}
+			} else {
+				if (token == "*" || token == "*/*") {
+					spec = 1;
+				} else if (token.size() >= 2
+						&& token.compare(token.size() - 2, 2, "/*") == 0
+						&& candidate.compare(0, token.size() - 1, token, 0,
+								token.size() - 1) == 0) {
+					spec = 2;
+				} else if (token == candidate) {
+					spec = 3;
+				}
+			}
+
+			if (spec > specificity[i]
+					|| (spec > 0 && spec == specificity[i]
+							&& qvalue > qvalues[i])) {
+				specificity[i] = spec;
+				qvalues[i] = qvalue;
+			}
+		}
+	}
+
+	int8_t best = -1;
+	for (size_t i = 0; i < len; i++) {
+		if (encoding && specificity[i] == 0
+				&& to_lower(candidates[i]) == "identity") {
+			qvalues[i] = 1000;
+		}
+		if (qvalues[i] > 0 && (best < 0 || qvalues[i] > qvalues[best])) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+/**
+ * Test parsing valid and invalid q-values.
+ */
+void test_parse_qvalue() {
+	TEST_ASSERT_EQUAL_INT16(1000, http::parseQValue("1", 1));
+	TEST_ASSERT_EQUAL_INT16(1000, http::parseQValue("1.000", 5));
+	TEST_ASSERT_EQUAL_INT16(0, http::parseQValue("0", 1));
+	TEST_ASSERT_EQUAL_INT16(0, http::parseQValue("0.", 2));
+	TEST_ASSERT_EQUAL_INT16(500, http::parseQValue("0.5", 3));
+	TEST_ASSERT_EQUAL_INT16(1, http::parseQValue("0.001", 5));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue("1.001", 5));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue("0.0001", 6));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue("2", 1));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue(".5", 2));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue("0.a", 3));
+	TEST_ASSERT_EQUAL_INT16(-1, http::parseQValue("", 0));
+}
+
+/**
+ * Test negotiating a content coding with common and edge case Accept-Encoding headers.
+ */
+void test_negotiate_encoding() {
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(0, http::negotiateEncoding(NULL, ENCODINGS, 2),
+			"A missing header should accept the preferred candidate.");
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(1, http::negotiateEncoding("", ENCODINGS, 2),
+			"An empty header should only accept identity.");
+	TEST_ASSERT_EQUAL_INT8(0,
+			http::negotiateEncoding("gzip, deflate, br, zstd", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8(0, http::negotiateEncoding("GZip", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8(0, http::negotiateEncoding("x-gzip", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8(0, http::negotiateEncoding("*", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(1,
+			http::negotiateEncoding("gzip;q=0", ENCODINGS, 2),
+			"gzip;q=0 was treated as accepting gzip.");
+	TEST_ASSERT_EQUAL_INT8(1,
+			http::negotiateEncoding("gzip ; q=0, deflate", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8(1,
+			http::negotiateEncoding("gzip;q=0.5, identity", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8(0,
+			http::negotiateEncoding("gzip;q=0.5, identity;q=0.4", ENCODINGS,
+					2));
+	TEST_ASSERT_EQUAL_INT8(0,
+			http::negotiateEncoding("gzip, *;q=0", ENCODINGS, 2));
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(-1,
+			http::negotiateEncoding("br, *;q=0", ENCODINGS, 2),
+			"Identity wasn't excluded by *;q=0.");
+	TEST_ASSERT_EQUAL_INT8(-1,
+			http::negotiateEncoding("identity;q=0", ENCODINGS + 1, 1));
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(1,
+			http::negotiateEncoding("gzip;q=abc", ENCODINGS, 2),
+			"An element with an invalid q-value wasn't ignored.");
+	TEST_ASSERT_EQUAL_INT8(0,
+			http::negotiateEncoding("*;q=0.1, gzip;q=0.2", ENCODINGS, 2));
+}
+
+/**
+ * Test getting the q-values of multiple content codings.
+ */
+void test_encoding_qvalues() {
+	const char *const encodings[] = { "deflate", "gzip", "identity" };
+	int16_t qvalues[3];
+	http::getEncodingQValues(NULL, encodings, 3, qvalues);
+	const int16_t all[] = { 1000, 1000, 1000 };
+	TEST_ASSERT_EQUAL_INT16_ARRAY_MESSAGE(all, qvalues, 3,
+			"A missing header should accept every candidate.");
+
+	http::getEncodingQValues("gzip, deflate;q=0.5", encodings, 3, qvalues);
+	const int16_t weighted[] = { 500, 1000, 1000 };
+	TEST_ASSERT_EQUAL_INT16_ARRAY(weighted, qvalues, 3);
+
+	http::getEncodingQValues("x-gzip;q=0.3, *;q=0", encodings, 3, qvalues);
+	const int16_t excluded[] = { 0, 300, 0 };
+	TEST_ASSERT_EQUAL_INT16_ARRAY(excluded, qvalues, 3);
+
+	const char *const many[] = { "a", "b", "c", "d", "e", "f", "g", "h", "i" };
+	int16_t many_qvalues[9];
+	http::getEncodingQValues("*", many, 9, many_qvalues);
+	TEST_ASSERT_EQUAL_INT16(1000, many_qvalues[7]);
+	TEST_ASSERT_EQUAL_INT16_MESSAGE(0, many_qvalues[8],
+			"Candidates after the max number of candidates should be ignored.");
+}
+
+/**
+ * Test negotiating a media type with common and edge case Accept headers.
+ */
+void test_negotiate_media_type() {
+	// The Accept header sent by prometheus 2.x.
+	TEST_ASSERT_EQUAL_INT8(1,
+			http::negotiateMediaType(
+					"application/openmetrics-text;version=1.0.0,application/openmetrics-text;version=0.0.1;q=0.75,text/plain;version=0.0.4;q=0.5,*/*;q=0.1",
+					MEDIA_TYPES, 2));
+	// The Accept header sent by firefox.
+	TEST_ASSERT_EQUAL_INT8(0,
+			http::negotiateMediaType(
+					"text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+					MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(0, http::negotiateMediaType(NULL, MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(-1, http::negotiateMediaType("", MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(1,
+			http::negotiateMediaType("application/*", MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(1,
+			http::negotiateMediaType("Application/OpenMetrics-Text",
+					MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(0, http::negotiateMediaType("*", MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(1,
+			http::negotiateMediaType("text/*;q=0.2, */*;q=0.5", MEDIA_TYPES,
+					2),
+			"The more specific media range didn't take precedence.");
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(0,
+			http::negotiateMediaType(
+					"text/plain;foo=\"a,application/openmetrics-text\"",
+					MEDIA_TYPES, 2),
+			"A comma in a quoted string was treated as a separator.");
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(0,
+			http::negotiateMediaType("text/plain, text/html;a=\"b,*/*",
+					MEDIA_TYPES, 2),
+			"An element with an unterminated quoted string wasn't ignored.");
+	TEST_ASSERT_EQUAL_INT8(-1,
+			http::negotiateMediaType("text/html, image/png", MEDIA_TYPES, 2));
+	TEST_ASSERT_EQUAL_INT8(-1,
+			http::negotiateMediaType("text/plain;q=0", MEDIA_TYPES, 1));
+}
+
+/**
+ * Fuzz the negotiation functions with headers built from random tokens, parameters, and separators,
+ * and compare the results to the reference implementation.
+ */
+void test_fuzz_structured() {
+	std::uniform_int_distribution<size_t> count_dist(0, 6);
+	std::uniform_int_distribution<size_t> token_dist(0,
+			sizeof(FUZZ_TOKENS) / sizeof(FUZZ_TOKENS[0]) - 1);
+	std::uniform_int_distribution<size_t> param_dist(0,
+			sizeof(FUZZ_PARAMS) / sizeof(FUZZ_PARAMS[0]) - 1);
+	std::uniform_int_distribution<size_t> sep_dist(0,
+			sizeof(FUZZ_SEPARATORS) / sizeof(FUZZ_SEPARATORS[0]) - 1);
+	std::uniform_int_distribution<int> coin(0, 3);
+
+	for (size_t i = 0; i < FUZZ_ITERATIONS; i++) {
+		std::string header;
+		const size_t elements = count_dist(*rng);
+		for (size_t j = 0; j < elements; j++) {
+			if (j > 0) {
+				header += FUZZ_SEPARATORS[sep_dist(*rng)];
+			}
+			header += FUZZ_TOKENS[token_dist(*rng)];
+			const size_t params = count_dist(*rng) / 3;
+			for (size_t k = 0; k < params; k++) {
+				header += coin(*rng) == 0 ? " ; " : ";";
+				header += FUZZ_PARAMS[param_dist(*rng)];
+			}
+		}
+
+		const int8_t encoding = http::negotiateEncoding(header.c_str(),
+				ENCODINGS, 2);
+		const int8_t expected_encoding = reference_negotiate(header.c_str(),
+				ENCODINGS, 2, true);
+		if (encoding != expected_encoding) {
+			TEST_FAIL_MESSAGE(
+					("Encoding negotiation differed from the reference for \"" + header + "\".").c_str());
+		}
+
+		const int8_t media_type = http::negotiateMediaType(header.c_str(),
+				MEDIA_TYPES, 2);
+		const int8_t expected_media_type = reference_negotiate(header.c_str(),
+				MEDIA_TYPES, 2, false);
+		if (media_type != expected_media_type) {
+			TEST_FAIL_MESSAGE(
+					("Media type negotiation differed from the reference for \"" + header + "\".").c_str());
+		}
+	}
+}
+
+/**
+ * Fuzz the negotiation functions with random bytes, to make sure they never read past the end of the header,
+ * and always return a valid result.
+ */
+void test_fuzz_random() {
+	std::uniform_int_distribution<size_t> len_dist(0, 64);
+	// Bias the random bytes towards the characters with special meaning.
+	const char SPECIAL[] = ",;=\"\\ \t*/qQ01.";
+	std::uniform_int_distribution<int> byte_dist(1, 255 + sizeof(SPECIAL) * 8);
+
+	for (size_t i = 0; i < FUZZ_ITERATIONS; i++) {
+		const size_t len = len_dist(*rng);
+		char *header = new char[len + 1];
+		for (size_t j = 0; j < len; j++) {
+			const int value = byte_dist(*rng);
+			header[j] = value <= 255 ? value : SPECIAL[(value - 256) / 8];
+		}
+		header[len] = 0;
+
+		const int8_t encoding = http::negotiateEncoding(header, ENCODINGS, 2);
+		TEST_ASSERT_TRUE_MESSAGE(encoding >= -1 && encoding < 2,
+				"Encoding negotiation returned an invalid index.");
+		const int8_t media_type = http::negotiateMediaType(header, MEDIA_TYPES,
+				2);
+		TEST_ASSERT_TRUE_MESSAGE(media_type >= -1 && media_type < 2,
+				"Media type negotiation returned an invalid index.");
+		delete[] header;
+	}
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_parse_qvalue);
+	RUN_TEST(test_negotiate_encoding);
+	RUN_TEST(test_encoding_qvalues);
+	RUN_TEST(test_negotiate_media_type);
+	RUN_TEST(test_fuzz_structured);
+	RUN_TEST(test_fuzz_random);
+
+	return UNITY_END();
+}
@@ -0,0 +1,274 @@
+/*
+ * json_writer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <json_writer.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+/**
+ * The size of the buffers used by the tests.
+ */
+const size_t BUFFER_SIZE = 256;
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Writes a document containing every kind of value to the given writer.
+ *
+ * @param writer	The writer to write the document to.
+ */
+void write_document(utils::JsonWriter &writer) {
+	writer.beginObject();
+	writer.key("temperature").value(21.5f, 2);
+	writer.key("humidity").value("Unknown");
+	writer.key("time").value("00:01:02.003");
+	writer.key("values").beginArray();
+	writer.value(-1).value(42u).value(true).value(false).null();
+	writer.beginObject().endObject();
+	writer.beginArray().endArray();
+	writer.endArray();
+	writer.key("raw").raw("[1,2]", 5);
+	writer.endObject();
+}
+
+/**
+ * The document written by write_document.
+ */
+const char DOCUMENT[] =
+		"{\"temperature\":21.50,\"humidity\":\"Unknown\",\"time\":\"00:01:02.003\","
+				"\"values\":[-1,42,true,false,null,{},[]],\"raw\":[1,2]}";
+
+/**
+ * Writes a single value to a new writer, and returns the result.
+ *
+ * @param write	A function writing the value to the given writer.
+ * @return	The written document.
+ */
+template<typename F>
+std::string write_value(F write) {
+	char buffer[BUFFER_SIZE];
+	utils::JsonWriter writer(buffer, sizeof(buffer));
+	write(writer);
+	TEST_ASSERT_TRUE_MESSAGE(writer.isComplete(),
+			"Writing a single value didn't create a complete document.");
+	return std::string(buffer, writer.written());
+}
+
+/**
+ * Test writing nested objects and arrays.
+ */
+void test_structure() {
+	char buffer[BUFFER_SIZE];
+	utils::JsonWriter writer(buffer, sizeof(buffer));
+	write_document(writer);
+	TEST_ASSERT_TRUE(writer.isComplete());
+	TEST_ASSERT_FALSE(writer.overflowed());
+	TEST_ASSERT_EQUAL_UINT(strlen(DOCUMENT), writer.length());
+	TEST_ASSERT_EQUAL_UINT(strlen(DOCUMENT), writer.written());
+	TEST_ASSERT_EQUAL_STRING(DOCUMENT,
+			std::string(buffer, writer.written()).c_str());
+}
+
+/**
+ * Test escaping keys and string values.
+ */
+void test_escape() {
+	const char str[] = "a\"b\\c/\b\f\n\r\t\x01\x1f\xc3\xa4";
+	const std::string json = write_value([&str](utils::JsonWriter &writer) {
+		writer.value(str);
+	});
+	TEST_ASSERT_EQUAL_STRING(
+			"\"a\\\"b\\\\c/\\b\\f\\n\\r\\t\\u0001\\u001f\xc3\xa4\"",
+			json.c_str());
+
+	const std::string with_nul = write_value([](utils::JsonWriter &writer) {
+		writer.beginObject().key("k\"", 2).value("a\0b", 3).endObject();
+	});
+	TEST_ASSERT_EQUAL_STRING("{\"k\\\"\":\"a\\u0000b\"}", with_nul.c_str());
+}
+
+/**
+ * Test formatting integers.
+ */
+void test_integers() {
+	TEST_ASSERT_EQUAL_STRING("0",
+			write_value([](utils::JsonWriter &w) {w.value(0);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("-12345",
+			write_value([](utils::JsonWriter &w) {w.value(-12345);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("65535",
+			write_value([](utils::JsonWriter &w) {w.value((uint16_t) 65535);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("-9223372036854775808",
+			write_value([](utils::JsonWriter &w) {
+				w.value(std::numeric_limits<int64_t>::min());
+			}).c_str());
+	TEST_ASSERT_EQUAL_STRING("18446744073709551615",
+			write_value([](utils::JsonWriter &w) {
+				w.value(std::numeric_limits<uint64_t>::max());
+			}).c_str());
+}
+
+/**
+ * Test formatting floating point values.
+ */
+void test_floats() {
+	TEST_ASSERT_EQUAL_STRING("21.30",
+			write_value([](utils::JsonWriter &w) {w.value(21.3f, 2);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("-0.50",
+			write_value([](utils::JsonWriter &w) {w.value(-0.5, 2);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("1.00",
+			write_value([](utils::JsonWriter &w) {w.value(0.999, 2);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("3",
+			write_value([](utils::JsonWriter &w) {w.value(2.5, 0);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("0.000000001",
+			write_value([](utils::JsonWriter &w) {w.value(1e-9, 9);}).c_str());
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("0.00",
+			write_value([](utils::JsonWriter &w) {w.value(-0.001, 2);}).c_str(),
+			"A value rounded to zero kept its minus sign.");
+	TEST_ASSERT_EQUAL_STRING("null",
+			write_value([](utils::JsonWriter &w) {w.value(NAN, 2);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("null",
+			write_value([](utils::JsonWriter &w) {w.value(-INFINITY, 2);}).c_str());
+	TEST_ASSERT_EQUAL_STRING("1e+20",
+			write_value([](utils::JsonWriter &w) {w.value(1e20, 2);}).c_str());
+
+	// Compare every value with two decimal digits in a typical sensor range to snprintf.
+	for (int i = -5000; i <= 15000; i++) {
+		const float value = i / 100.0f;
+		char expected[32];
+		snprintf(expected, sizeof(expected), "%.2f", value);
+		if (strcmp(expected, "-0.00") == 0) {
+			strcpy(expected, "0.00");
+		}
+		const std::string json = write_value([value](utils::JsonWriter &w) {
+			w.value(value, 2);
+		});
+		TEST_ASSERT_EQUAL_STRING(expected, json.c_str());
+	}
+}
+
+/**
+ * Test that output that doesn't fit is dropped, but still counted.
+ */
+void test_overflow() {
+	char buffer[16];
+	memset(buffer, 'x', sizeof(buffer));
+	utils::JsonWriter writer(buffer, 10);
+	write_document(writer);
+	TEST_ASSERT_TRUE(writer.isComplete());
+	TEST_ASSERT_TRUE(writer.overflowed());
+	TEST_ASSERT_EQUAL_UINT(strlen(DOCUMENT), writer.length());
+	TEST_ASSERT_EQUAL_UINT(10, writer.written());
+	TEST_ASSERT_EQUAL_MEMORY(DOCUMENT, buffer, 10);
+	TEST_ASSERT_EQUAL_HEX8_MESSAGE('x', buffer[10],
+			"The writer wrote past the end of the buffer.");
+
+	utils::JsonWriter counter(NULL, 0);
+	write_document(counter);
+	TEST_ASSERT_EQUAL_UINT(strlen(DOCUMENT), counter.length());
+	TEST_ASSERT_EQUAL_UINT(0, counter.written());
+}
+
+/**
+ * Test writing a document in chunks of every size, starting at the end of the previous chunk.
+ */
+void test_chunks() {
+	const size_t len = strlen(DOCUMENT);
+	for (size_t chunk_size = 1; chunk_size <= len; chunk_size++) {
+		std::string result;
+		char buffer[BUFFER_SIZE];
+		while (result.length() < len) {
+			utils::JsonWriter writer(buffer, chunk_size, result.length());
+			write_document(writer);
+			TEST_ASSERT_GREATER_THAN_UINT_MESSAGE(0, writer.written(),
+					"A chunk before the end of the document was empty.");
+			result.append(buffer, writer.written());
+		}
+		TEST_ASSERT_EQUAL_STRING(DOCUMENT, result.c_str());
+	}
+
+	char buffer[BUFFER_SIZE];
+	utils::JsonWriter writer(buffer, sizeof(buffer), len + 5);
+	write_document(writer);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, writer.written(),
+			"Data was written after the end of the document.");
+	TEST_ASSERT_FALSE(writer.overflowed());
+}
+
+/**
+ * Test that using the writer incorrectly is detected.
+ */
+void test_errors() {
+	char buffer[BUFFER_SIZE];
+	utils::JsonWriter missing_key(buffer, sizeof(buffer));
+	missing_key.beginObject().value(1);
+	TEST_ASSERT_TRUE_MESSAGE(missing_key.hasError(),
+			"A value without a key in an object wasn't detected.");
+
+	utils::JsonWriter key_in_array(buffer, sizeof(buffer));
+	key_in_array.beginArray().key("a");
+	TEST_ASSERT_TRUE(key_in_array.hasError());
+
+	utils::JsonWriter wrong_end(buffer, sizeof(buffer));
+	wrong_end.beginObject().endArray();
+	TEST_ASSERT_TRUE(wrong_end.hasError());
+
+	utils::JsonWriter missing_value(buffer, sizeof(buffer));
+	missing_value.beginObject().key("a").endObject();
+	TEST_ASSERT_TRUE(missing_value.hasError());
+
+	utils::JsonWriter two_values(buffer, sizeof(buffer));
+	two_values.value(1).value(2);
+	TEST_ASSERT_TRUE(two_values.hasError());
+
+	utils::JsonWriter unclosed(buffer, sizeof(buffer));
+	unclosed.beginArray().value(1);
+	TEST_ASSERT_FALSE(unclosed.hasError());
+	TEST_ASSERT_FALSE(unclosed.isComplete());
+
+	utils::JsonWriter deep(buffer, sizeof(buffer));
+	for (size_t i = 0; i < utils::JsonWriter::MAX_DEPTH; i++) {
+		deep.beginArray();
+	}
+	TEST_ASSERT_FALSE(deep.hasError());
+	deep.beginArray();
+	TEST_ASSERT_TRUE_MESSAGE(deep.hasError(),
+			"Exceeding the max depth wasn't detected.");
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_structure);
+	RUN_TEST(test_escape);
+	RUN_TEST(test_integers);
+	RUN_TEST(test_floats);
+	RUN_TEST(test_overflow);
+	RUN_TEST(test_chunks);
+	RUN_TEST(test_errors);
+
+	return UNITY_END();
+}
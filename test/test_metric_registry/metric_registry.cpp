@@ -0,0 +1,404 @@
+/*
+ * metric_registry.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../metric_fixtures.h"
+#include <metric_filter.h>
+#include <metric_registry.h>
+#include <metrics_generator.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * The value of the test gauge.
+ */
+double temperature = 21.5;
+
+/**
+ * The value of the test counter.
+ */
+uint64_t requests = 0;
+
+/**
+ * The number of samples written by the test collector.
+ */
+size_t collector_samples = 3;
+
+/**
+ * The number of times the test collector was called.
+ */
+size_t collector_calls = 0;
+
+/**
+ * The state kept by the test collector between two samples.
+ */
+struct CollectorState {
+	/**
+	 * The value copied before the first sample.
+	 */
+	uint32_t copied;
+};
+
+/**
+ * The expected Prometheus exposition of the test registry, with the default values.
+ */
+const char EXPOSITION[] =
+		"# HELP test_temperature_celsius The test temperature.\n"
+		"# TYPE test_temperature_celsius gauge\n"
+		"test_temperature_celsius 21.500\n"
+		"# HELP test_requests_total The test requests.\n"
+		"# TYPE test_requests_total counter\n"
+		"test_requests_total 0\n"
+		"# HELP test_build_info The test build info.\n"
+		"# TYPE test_build_info gauge\n"
+		"test_build_info{version=\"1.0\"} 1\n"
+		"# HELP test_duration_seconds The test durations.\n"
+		"# TYPE test_duration_seconds histogram\n"
+		"test_duration_seconds_bucket{le=\"0\"} 7\n"
+		"test_duration_seconds_bucket{le=\"1\"} 7\n"
+		"test_duration_seconds_bucket{le=\"2\"} 7\n";
+
+/**
+ * Writes the labels of the test info metric.
+ *
+ * @param buffer	The buffer to write to.
+ * @param size		The size of the buffer.
+ * @return	The length of the labels.
+ */
+size_t write_build_labels(char *buffer, const size_t size) {
+	return snprintf(buffer, size, "version=\"%s\"", "1.0");
+}
+
+/**
+ * Writes the next sample of the test collector.
+ * Copies a value into the cursor state before the first sample, to check that it is kept.
+ *
+ * @param buffer	The buffer to write to.
+ * @param size		The size of the buffer.
+ * @param family	The description of the collector.
+ * @param cursor	The position in the samples of the collector.
+ * @return	The length of the sample line.
+ */
+size_t write_duration_sample(char *buffer, const size_t size,
+		const prom::MetricFamily &family, prom::SampleCursor &cursor) {
+	collector_calls++;
+	CollectorState &state = cursor.getState<CollectorState>();
+	if (cursor.index == 0) {
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, state.copied,
+				"The collector state wasn't reset before the first sample.");
+		state.copied = 7;
+	}
+	if (cursor.index >= collector_samples) {
+		return 0;
+	}
+	return snprintf(buffer, size, "%s_bucket{le=\"%u\"} %u\n", family.name,
+			(unsigned int) cursor.index++, (unsigned int) state.copied);
+}
+
+prom::Gauge temperature_metric(TEMPERATURE_FAMILY, []() -> double {
+	return temperature;
+});
+prom::Counter requests_metric(REQUESTS_FAMILY, []() -> uint64_t {
+	return requests;
+});
+prom::Info build_info_metric(BUILD_INFO_FAMILY, write_build_labels);
+prom::Collector duration_metric(DURATION_FAMILY, write_duration_sample);
+
+/**
+ * The registry containing all test metrics.
+ */
+prom::Registry registry;
+
+void setUp() {
+	temperature = 21.5;
+	requests = 0;
+	collector_samples = 3;
+	collector_calls = 0;
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Writes the whole exposition of the test registry, in chunks of the given size.
+ *
+ * @param openmetrics	Whether to write OpenMetrics output.
+ * @param chunk_size	The max size of each chunk.
+ * @param filter		The filter selecting the metrics to write.
+ * @return	The written exposition.
+ */
+std::string generate(const bool openmetrics, const size_t chunk_size,
+		const prom::MetricFilter &filter = prom::MetricFilter()) {
+	prom::MetricsGenerator generator(registry, openmetrics, true, filter);
+	std::vector<uint8_t> buffer(chunk_size);
+	std::string result;
+	size_t len;
+	while ((len = generator.fill(buffer.data(), chunk_size)) > 0) {
+		TEST_ASSERT_LESS_OR_EQUAL_UINT(chunk_size, len);
+		result.append((const char*) buffer.data(), len);
+	}
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, generator.fill(buffer.data(), chunk_size),
+			"The generator wrote data after the end of the exposition.");
+	return result;
+}
+
+/**
+ * Test that the metadata lines are created correctly at compile time.
+ */
+void test_metadata() {
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius", TEMPERATURE_FAMILY.name);
+	TEST_ASSERT_TRUE(TEMPERATURE_FAMILY.type == prom::MetricType::GAUGE);
+	TEST_ASSERT_EQUAL_STRING(
+			"# HELP test_temperature_celsius The test temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n",
+			TEMPERATURE_FAMILY.metadata);
+	TEST_ASSERT_EQUAL_STRING(
+			"# HELP test_temperature_celsius The test temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"# UNIT test_temperature_celsius celsius\n",
+			TEMPERATURE_FAMILY.openmetrics_metadata);
+	TEST_ASSERT_EQUAL_UINT(strlen(TEMPERATURE_FAMILY.metadata),
+			TEMPERATURE_FAMILY.metadata_len);
+	TEST_ASSERT_EQUAL_UINT(strlen(TEMPERATURE_FAMILY.openmetrics_metadata),
+			TEMPERATURE_FAMILY.openmetrics_metadata_len);
+
+	TEST_ASSERT_EQUAL_STRING_MESSAGE(
+			"# HELP test_build_info The test build info.\n"
+			"# TYPE test_build_info info\n",
+			BUILD_INFO_FAMILY.openmetrics_metadata,
+			"The OpenMetrics type of an info metric isn't info.");
+	TEST_ASSERT_EQUAL_STRING("# HELP test_requests_total The test requests.\n"
+			"# TYPE test_requests_total counter\n",
+			REQUESTS_FAMILY.openmetrics_metadata);
+}
+
+/**
+ * Test writing the samples of single sample metrics.
+ */
+void test_samples() {
+	char buffer[64];
+	prom::SampleCursor cursor;
+	memset(&cursor, 0, sizeof(cursor));
+	TEST_ASSERT_EQUAL_UINT(strlen("test_temperature_celsius 21.500\n"),
+			temperature_metric.writeSample(buffer, sizeof(buffer), cursor));
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius 21.500\n", buffer);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0,
+			temperature_metric.writeSample(buffer, sizeof(buffer), cursor),
+			"A gauge wrote more than one sample.");
+
+	temperature = NAN;
+	memset(&cursor, 0, sizeof(cursor));
+	temperature_metric.writeSample(buffer, sizeof(buffer), cursor);
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius NAN\n", buffer);
+
+	requests = UINT64_MAX;
+	memset(&cursor, 0, sizeof(cursor));
+	requests_metric.writeSample(buffer, sizeof(buffer), cursor);
+	TEST_ASSERT_EQUAL_STRING("test_requests_total 18446744073709551615\n",
+			buffer);
+
+	memset(&cursor, 0, sizeof(cursor));
+	const size_t len = build_info_metric.writeSample(buffer, 8, cursor);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(
+			strlen("test_build_info{version=\"1.0\"} 1\n"), len,
+			"The length of a truncated info sample was wrong.");
+	TEST_ASSERT_EQUAL_STRING("test_bu", buffer);
+}
+
+/**
+ * Test writing sample lines with a timestamp, in both text formats.
+ */
+void test_timestamps() {
+	char buffer[64];
+	TEST_ASSERT_EQUAL_UINT(
+			strlen("test_temperature_celsius 21.500 1792238400123\n"),
+			prom::writeSampleLine(buffer, sizeof(buffer),
+					TEMPERATURE_FAMILY.name, 21.5, 1792238400123, false));
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius 21.500 1792238400123\n",
+			buffer);
+
+	prom::writeSampleLine(buffer, sizeof(buffer), TEMPERATURE_FAMILY.name, 21.5,
+			1792238400012, true);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE(
+			"test_temperature_celsius 21.500 1792238400.012\n", buffer,
+			"An OpenMetrics timestamp wasn't written in seconds.");
+
+	prom::writeSampleLine(buffer, sizeof(buffer), TEMPERATURE_FAMILY.name, NAN,
+			1000, false);
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius NAN 1000\n", buffer);
+
+	const size_t len = prom::writeSampleLine(buffer, 28,
+			TEMPERATURE_FAMILY.name, 21.5, 1792238400123, false);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(
+			strlen("test_temperature_celsius 21.500 1792238400123\n"), len,
+			"The length of a truncated sample with a timestamp was wrong.");
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius 21", buffer);
+
+	// The generator has to tell metrics which output options to use.
+	static constexpr prom::MetricFamily OPTIONS_FAMILY = PROM_GAUGE_FAMILY(
+			"test_options", "The output options of the generator.");
+	prom::Collector options_metric(OPTIONS_FAMILY,
+			[](char *buffer, const size_t size, const prom::MetricFamily &family,
+					prom::SampleCursor &cursor) -> size_t {
+				if (cursor.index++ > 0) {
+					return 0;
+				}
+				return snprintf(buffer, size,
+						"%s{openmetrics=\"%d\",timestamps=\"%d\",consumer=\"%u\"} 1\n",
+						family.name, cursor.openmetrics, cursor.timestamps,
+						(unsigned int) cursor.consumer);
+			});
+	prom::Registry options_registry;
+	options_registry.add(options_metric);
+
+	uint8_t output[256];
+	prom::MetricsGenerator generator(options_registry, true, false);
+	output[generator.fill(output, sizeof(output) - 1)] = 0;
+	TEST_ASSERT_NOT_NULL(
+			strstr((const char*) output,
+					"test_options{openmetrics=\"1\",timestamps=\"0\",consumer=\"0\"} 1\n"));
+
+	prom::MetricsGenerator default_generator(options_registry);
+	output[default_generator.fill(output, sizeof(output) - 1)] = 0;
+	TEST_ASSERT_NOT_NULL_MESSAGE(
+			strstr((const char*) output,
+					"test_options{openmetrics=\"0\",timestamps=\"1\",consumer=\"0\"} 1\n"),
+			"Timestamps weren't enabled by default.");
+
+	prom::MetricsGenerator consumer_generator(options_registry, false, true,
+			prom::MetricFilter(), 42);
+	output[consumer_generator.fill(output, sizeof(output) - 1)] = 0;
+	TEST_ASSERT_NOT_NULL_MESSAGE(
+			strstr((const char*) output,
+					"test_options{openmetrics=\"0\",timestamps=\"1\",consumer=\"42\"} 1\n"),
+			"The consumer wasn't passed to the metrics.");
+}
+
+/**
+ * Test that registering a metric twice is rejected.
+ */
+void test_register() {
+	prom::Registry other;
+	TEST_ASSERT_NULL(other.getFirst());
+	TEST_ASSERT_FALSE_MESSAGE(other.add(temperature_metric),
+			"A metric was added to a second registry.");
+	TEST_ASSERT_FALSE(registry.add(duration_metric));
+	TEST_ASSERT_NULL_MESSAGE(duration_metric.getNext(),
+			"Adding a metric twice changed the registry.");
+}
+
+/**
+ * Test generating the whole exposition, in chunks of every size.
+ */
+void test_generator() {
+	const std::string text = generate(false, 4096);
+	TEST_ASSERT_EQUAL_STRING(EXPOSITION, text.c_str());
+
+	const std::string openmetrics = generate(true, 4096);
+	TEST_ASSERT_EQUAL_STRING_MESSAGE("# EOF\n",
+			openmetrics.c_str() + openmetrics.length() - 6,
+			"The OpenMetrics exposition didn't end with an EOF line.");
+	TEST_ASSERT_NOT_NULL(
+			strstr(openmetrics.c_str(),
+					"# UNIT test_duration_seconds seconds\n"));
+
+	for (size_t chunk_size = 1; chunk_size <= text.length(); chunk_size++) {
+		TEST_ASSERT_EQUAL_STRING(text.c_str(),
+				generate(false, chunk_size).c_str());
+	}
+}
+
+/**
+ * Test that a sample line longer than the line buffer is skipped.
+ */
+void test_long_line() {
+	static constexpr prom::MetricFamily LONG_FAMILY = PROM_GAUGE_FAMILY(
+			"test_long", "A gauge with a long label.");
+	prom::Info long_metric(LONG_FAMILY,
+			[](char *buffer, const size_t size) -> size_t {
+				std::string label(prom::MetricsGenerator::LINE_BUFFER_SIZE, 'a');
+				return snprintf(buffer, size, "label=\"%s\"", label.c_str());
+			});
+	prom::Registry long_registry;
+	long_registry.add(long_metric);
+
+	prom::MetricsGenerator generator(long_registry);
+	uint8_t buffer[1024];
+	const size_t len = generator.fill(buffer, sizeof(buffer));
+	TEST_ASSERT_EQUAL_UINT(LONG_FAMILY.metadata_len, len);
+	TEST_ASSERT_EQUAL_MEMORY(LONG_FAMILY.metadata, buffer, len);
+}
+
+/**
+ * Test that a filter writes only the requested metric families, without rendering the others.
+ */
+void test_filter() {
+	prom::MetricFilter filter;
+	TEST_ASSERT_TRUE(filter.empty());
+	TEST_ASSERT_TRUE(filter.add("test_build_info"));
+	TEST_ASSERT_TRUE(filter.add("test_temperature_celsius"));
+	// Names have to match the whole family name, not a sample name or prefix.
+	TEST_ASSERT_TRUE(filter.add("test_duration_seconds_bucket"));
+	TEST_ASSERT_TRUE(filter.add("test_requests"));
+
+	TEST_ASSERT_EQUAL_STRING(
+			"# HELP test_temperature_celsius The test temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 21.500\n"
+			"# HELP test_build_info The test build info.\n"
+			"# TYPE test_build_info gauge\n"
+			"test_build_info{version=\"1.0\"} 1\n",
+			generate(false, 4096, filter).c_str());
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, collector_calls,
+			"A filtered out collector was called.");
+
+	// A filter without a matching family results in an empty exposition.
+	prom::MetricFilter missing;
+	missing.add("test_missing");
+	TEST_ASSERT_EQUAL_STRING("", generate(false, 4096, missing).c_str());
+	TEST_ASSERT_EQUAL_STRING("# EOF\n", generate(true, 4096, missing).c_str());
+
+	prom::MetricFilter full;
+	for (size_t i = 0; i < prom::MetricFilter::MAX_NAMES; i++) {
+		TEST_ASSERT_TRUE(full.add("test_missing"));
+	}
+	TEST_ASSERT_FALSE_MESSAGE(full.add("test_requests_total"),
+			"A filter accepted more than MAX_NAMES names.");
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	registry.add(temperature_metric);
+	registry.add(requests_metric);
+	registry.add(build_info_metric);
+	registry.add(duration_metric);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_metadata);
+	RUN_TEST(test_samples);
+	RUN_TEST(test_timestamps);
+	RUN_TEST(test_register);
+	RUN_TEST(test_generator);
+	RUN_TEST(test_long_line);
+	RUN_TEST(test_filter);
+
+	return UNITY_END();
+}
@@ -0,0 +1,558 @@
+/*
+ * protobuf_exposition.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../metric_fixtures.h"
+#include <metric_registry.h>
+#include <metrics_generator.h>
+#include <protobuf_generator.h>
+#include <sample_line.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * The description of the collector without samples used by the tests.
+ */
+static constexpr prom::MetricFamily EMPTY_FAMILY = PROM_GAUGE_FAMILY(
+		"test_empty", "A gauge without samples.");
+
+/**
+ * The description of the collector with many samples used by the tests.
+ */
+static constexpr prom::MetricFamily MANY_FAMILY = PROM_GAUGE_FAMILY(
+		"test_many", "A gauge with more samples than fit a single message.");
+
+/**
+ * The number of samples written by the collector with many samples.
+ */
+static constexpr size_t MANY_SAMPLES = 100;
+
+/**
+ * A single sample, decoded from a MetricFamily message or parsed from a text sample line.
+ */
+struct DecodedSample {
+	/**
+	 * The name of the sample.
+	 */
+	std::string name;
+
+	/**
+	 * The unescaped labels of the sample, as name=value pairs separated by commas.
+	 */
+	std::string labels;
+
+	/**
+	 * The value of the sample.
+	 */
+	double value;
+
+	/**
+	 * The timestamp of the sample, or -1 if it has none.
+	 */
+	int64_t timestamp;
+};
+
+/**
+ * A decoded MetricFamily message.
+ */
+struct DecodedFamily {
+	/**
+	 * The name of the metric family.
+	 */
+	std::string name;
+
+	/**
+	 * The help text of the metric family.
+	 */
+	std::string help;
+
+	/**
+	 * The value of the type field.
+	 */
+	uint64_t type;
+
+	/**
+	 * The samples of the metric family, converted to the text format samples.
+	 */
+	std::vector<DecodedSample> samples;
+};
+
+prom::Gauge temperature_metric(TEMPERATURE_FAMILY, []() -> double {
+	return 21.5;
+});
+prom::Collector requests_metric(REQUESTS_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			switch (cursor.index++) {
+			case 0:
+				return snprintf(buffer, size, "%s{path=\"/a\\\"b\\\\\",code=\"200\"} 5\n", family.name);
+			case 1:
+				return snprintf(buffer, size, "%s{path=\"/\",code=\"404\"} 0 1792238400123\n", family.name);
+			default:
+				return 0;
+			}
+		});
+prom::Info build_info_metric(BUILD_INFO_FAMILY,
+		[](char *buffer, const size_t size) -> size_t {
+			return snprintf(buffer, size, "version=\"%s\"", "1.0");
+		});
+prom::Collector duration_metric(DURATION_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			static const char *const LINES[] = { "_bucket{path=\"/\",le=\"0.1\"} 1\n",
+					"_bucket{path=\"/\",le=\"1\"} 3\n", "_bucket{path=\"/\",le=\"+Inf\"} 4\n",
+					"_sum{path=\"/\"} 2.5\n", "_count{path=\"/\"} 4\n",
+					"_bucket{path=\"/b\",le=\"0.1\"} 0\n", "_bucket{path=\"/b\",le=\"1\"} 0\n",
+					"_bucket{path=\"/b\",le=\"+Inf\"} 1\n", "_sum{path=\"/b\"} 1.25\n",
+					"_count{path=\"/b\"} 1\n" };
+			if (cursor.index >= sizeof(LINES) / sizeof(LINES[0])) {
+				return 0;
+			}
+			return snprintf(buffer, size, "%s%s", family.name, LINES[cursor.index++]);
+		});
+prom::Collector empty_metric(EMPTY_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			return 0;
+		});
+prom::Collector many_metric(MANY_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			if (cursor.index >= MANY_SAMPLES) {
+				return 0;
+			}
+			const unsigned int index = cursor.index++;
+			return snprintf(buffer, size, "%s{index=\"%u\"} %u\n", family.name, index, index);
+		});
+
+/**
+ * The registry containing all test metrics.
+ */
+prom::Registry registry;
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Writes the whole exposition of the given generator, in chunks of the given size.
+ *
+ * @param generator		The generator to write the exposition of.
+ * @param chunk_size	The max size of each chunk.
+ * @return	The written exposition.
+ */
+std::string generate(prom::ExpositionGenerator &generator,
+		const size_t chunk_size) {
+	std::vector<uint8_t> buffer(chunk_size);
+	std::string result;
+	size_t len;
+	while ((len = generator.fill(buffer.data(), chunk_size)) > 0) {
+		TEST_ASSERT_LESS_OR_EQUAL_UINT(chunk_size, len);
+		result.append((const char*) buffer.data(), len);
+	}
+	return result;
+}
+
+/**
+ * Reads a varint from the given data.
+ *
+ * @param pos	The position to read from. Moved after the varint.
+ * @param end	The end of the data.
+ * @return	The read value.
+ */
+uint64_t readVarint(const uint8_t *&pos, const uint8_t *end) {
+	uint64_t value = 0;
+	for (uint8_t shift = 0; pos < end; shift += 7) {
+		const uint8_t byte = *pos++;
+		value |= (uint64_t) (byte & 0x7F) << shift;
+		if (byte < 0x80) {
+			return value;
+		}
+	}
+	TEST_FAIL_MESSAGE("A varint was truncated.");
+	return value;
+}
+
+/**
+ * Reads a single field from the given data.
+ *
+ * @param pos		The position to read from. Moved after the field.
+ * @param end		The end of the data.
+ * @param field		The variable to write the field number to.
+ * @param value		The variable to write varint and fixed64 values to.
+ * @param content	The variable to write the start of length delimited content to.
+ * @param len		The variable to write the length of length delimited content to.
+ */
+void readField(const uint8_t *&pos, const uint8_t *end, uint32_t &field,
+		uint64_t &value, const uint8_t *&content, size_t &len) {
+	const uint64_t tag = readVarint(pos, end);
+	field = tag >> 3;
+	switch (tag & 7) {
+	case 0:
+		value = readVarint(pos, end);
+		break;
+	case 1:
+		TEST_ASSERT_LESS_OR_EQUAL_UINT((size_t) (end - pos), 8);
+		value = 0;
+		for (size_t i = 0; i < 8; i++) {
+			value |= (uint64_t) pos[i] << (i * 8);
+		}
+		pos += 8;
+		break;
+	case 2:
+		len = readVarint(pos, end);
+		TEST_ASSERT_LESS_OR_EQUAL_UINT((size_t) (end - pos), len);
+		content = pos;
+		pos += len;
+		break;
+	default:
+		TEST_FAIL_MESSAGE("A field had an unexpected wire type.");
+	}
+}
+
+/**
+ * Converts the bits of a fixed64 field to a double.
+ *
+ * @param bits	The value of the field.
+ * @return	The double value.
+ */
+double toDouble(const uint64_t bits) {
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/**
+ * Decodes a Metric message, and adds the text format samples it represents to a family.
+ *
+ * @param pos		The start of the message.
+ * @param end		The end of the message.
+ * @param family	The family to add the samples to.
+ */
+void decodeMetric(const uint8_t *pos, const uint8_t *end,
+		DecodedFamily &family) {
+	std::string labels;
+	double value = NAN;
+	int64_t timestamp = -1;
+	const uint8_t *histogram = NULL;
+	size_t histogram_len = 0;
+	while (pos < end) {
+		uint32_t field;
+		uint64_t raw = 0;
+		const uint8_t *content = NULL;
+		size_t len = 0;
+		readField(pos, end, field, raw, content, len);
+		if (field == 1) {
+			std::string name, label_value;
+			const uint8_t *label_end = content + len;
+			while (content < label_end) {
+				uint32_t label_field;
+				const uint8_t *str;
+				size_t str_len;
+				readField(content, label_end, label_field, raw, str, str_len);
+				(label_field == 1 ? name : label_value).assign((const char*) str,
+						str_len);
+			}
+			labels += (labels.empty() ? "" : ",") + name + "=" + label_value;
+		} else if (field == 2 || field == 3) {
+			TEST_ASSERT_EQUAL_UINT_MESSAGE(field == 2 ? 1 : 0, family.type,
+					"A metric had a value type not matching its family.");
+			const uint8_t *value_end = content + len;
+			uint32_t value_field;
+			readField(content, value_end, value_field, raw, content, len);
+			TEST_ASSERT_EQUAL_UINT(1, value_field);
+			value = toDouble(raw);
+		} else if (field == 6) {
+			timestamp = (int64_t) raw;
+		} else if (field == 7) {
+			histogram = content;
+			histogram_len = len;
+		} else {
+			TEST_FAIL_MESSAGE("A metric had an unexpected field.");
+		}
+	}
+
+	if (!histogram) {
+		family.samples.push_back( { family.name, labels, value, timestamp });
+		return;
+	}
+
+	const uint8_t *histogram_end = histogram + histogram_len;
+	uint64_t count = 0;
+	double sum = NAN;
+	while (histogram < histogram_end) {
+		uint32_t field;
+		uint64_t raw = 0;
+		const uint8_t *content = NULL;
+		size_t len = 0;
+		readField(histogram, histogram_end, field, raw, content, len);
+		if (field == 1) {
+			count = raw;
+		} else if (field == 2) {
+			sum = toDouble(raw);
+		} else if (field == 3) {
+			uint64_t cumulative = 0;
+			double upper_bound = NAN;
+			const uint8_t *bucket_end = content + len;
+			while (content < bucket_end) {
+				uint32_t bucket_field;
+				const uint8_t *unused;
+				readField(content, bucket_end, bucket_field, raw, unused, len);
+				if (bucket_field == 1) {
+					cumulative = raw;
+				} else {
+					upper_bound = toDouble(raw);
+				}
+			}
+			char le[32];
+			snprintf(le, sizeof(le), "le=%g", upper_bound);
+			family.samples.push_back( { family.name + "_bucket", labels
+					+ (labels.empty() ? "" : ",") + le, (double) cumulative,
+					timestamp });
+		}
+	}
+	family.samples.push_back( { family.name + "_bucket", labels
+			+ (labels.empty() ? "" : ",") + "le=+Inf", (double) count,
+			timestamp });
+	family.samples.push_back( { family.name + "_sum", labels, sum, timestamp });
+	family.samples.push_back( { family.name + "_count", labels, (double) count,
+			timestamp });
+}
+
+/**
+ * Decodes a delimited protobuf exposition.
+ * Consecutive messages for the same family are merged.
+ *
+ * @param exposition	The exposition to decode.
+ * @return	The decoded metric families.
+ */
+std::vector<DecodedFamily> decodeProtobuf(const std::string &exposition) {
+	std::vector<DecodedFamily> families;
+	const uint8_t *pos = (const uint8_t*) exposition.data();
+	const uint8_t *end = pos + exposition.length();
+	while (pos < end) {
+		const size_t len = readVarint(pos, end);
+		TEST_ASSERT_LESS_OR_EQUAL_UINT((size_t) (end - pos), len);
+		const uint8_t *message_end = pos + len;
+		DecodedFamily family;
+		std::vector<std::pair<const uint8_t*, size_t>> metrics;
+		while (pos < message_end) {
+			uint32_t field;
+			uint64_t value = 0;
+			const uint8_t *content = NULL;
+			size_t content_len = 0;
+			readField(pos, message_end, field, value, content, content_len);
+			switch (field) {
+			case 1:
+				family.name.assign((const char*) content, content_len);
+				break;
+			case 2:
+				family.help.assign((const char*) content, content_len);
+				break;
+			case 3:
+				family.type = value;
+				break;
+			case 4:
+				metrics.push_back( { content, content_len });
+				break;
+			default:
+				TEST_FAIL_MESSAGE("A metric family had an unexpected field.");
+			}
+		}
+
+		TEST_ASSERT_FALSE_MESSAGE(metrics.empty(),
+				"A metric family without metrics was written.");
+		if (families.empty() || families.back().name != family.name) {
+			families.push_back(family);
+		}
+		for (const std::pair<const uint8_t*, size_t> &metric : metrics) {
+			decodeMetric(metric.first, metric.first + metric.second,
+					families.back());
+		}
+	}
+	return families;
+}
+
+/**
+ * Parses a Prometheus text exposition.
+ * Families without samples are skipped, since they aren't part of the protobuf exposition.
+ *
+ * @param exposition	The exposition to parse.
+ * @return	The parsed metric families.
+ */
+std::vector<DecodedFamily> parseText(const std::string &exposition) {
+	std::vector<DecodedFamily> families;
+	size_t start = 0;
+	while (start < exposition.length()) {
+		const size_t line_end = exposition.find('\n', start) + 1;
+		const std::string line = exposition.substr(start, line_end - start);
+		start = line_end;
+		if (line.compare(0, 7, "# HELP ") == 0) {
+			if (!families.empty() && families.back().samples.empty()) {
+				families.pop_back();
+			}
+			DecodedFamily family;
+			const size_t name_end = line.find(' ', 7);
+			family.name = line.substr(7, name_end - 7);
+			family.help = line.substr(name_end + 1,
+					line.length() - name_end - 2);
+			families.push_back(family);
+		} else if (line.compare(0, 7, "# TYPE ") == 0) {
+			const std::string type = line.substr(8 + families.back().name.length());
+			families.back().type =
+					type == "counter\n" ? 0 : type == "histogram\n" ? 4 : 1;
+		} else {
+			prom::SampleLine sample;
+			TEST_ASSERT_TRUE(
+					prom::parseSampleLine(line.c_str(), line.length(), sample));
+			std::string labels;
+			const char *pos = sample.labels;
+			prom::SampleLabel label;
+			while (prom::nextSampleLabel(pos, sample.labels + sample.labels_len,
+					label)) {
+				char value[64];
+				const size_t value_len = prom::unescapeLabelValue(label.value,
+						label.value_len, value);
+				labels += (labels.empty() ? "" : ",")
+						+ std::string(label.name, label.name_len) + "="
+						+ std::string(value, value_len);
+			}
+			families.back().samples.push_back( { std::string(sample.name,
+					sample.name_len), labels, sample.value,
+					sample.has_timestamp ? sample.timestamp : -1 });
+		}
+	}
+	if (!families.empty() && families.back().samples.empty()) {
+		families.pop_back();
+	}
+	return families;
+}
+
+/**
+ * Test that the protobuf exposition contains the same families and samples as the text exposition.
+ */
+void test_round_trip() {
+	prom::MetricsGenerator text_generator(registry);
+	const std::vector<DecodedFamily> expected = parseText(
+			generate(text_generator, 4096));
+	prom::ProtobufGenerator protobuf_generator(registry);
+	const std::vector<DecodedFamily> actual = decodeProtobuf(
+			generate(protobuf_generator, 4096));
+
+	TEST_ASSERT_EQUAL_UINT(5, expected.size());
+	TEST_ASSERT_EQUAL_UINT(expected.size(), actual.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		TEST_ASSERT_EQUAL_STRING(expected[i].name.c_str(),
+				actual[i].name.c_str());
+		TEST_ASSERT_EQUAL_STRING(expected[i].help.c_str(),
+				actual[i].help.c_str());
+		TEST_ASSERT_EQUAL_UINT64(expected[i].type, actual[i].type);
+		TEST_ASSERT_EQUAL_UINT_MESSAGE(expected[i].samples.size(),
+				actual[i].samples.size(), expected[i].name.c_str());
+		for (size_t j = 0; j < expected[i].samples.size(); j++) {
+			const DecodedSample &exp = expected[i].samples[j];
+			const DecodedSample &act = actual[i].samples[j];
+			TEST_ASSERT_EQUAL_STRING(exp.name.c_str(), act.name.c_str());
+			TEST_ASSERT_EQUAL_STRING(exp.labels.c_str(), act.labels.c_str());
+			TEST_ASSERT_EQUAL_DOUBLE(exp.value, act.value);
+			TEST_ASSERT_EQUAL_INT64(exp.timestamp, act.timestamp);
+		}
+	}
+}
+
+/**
+ * Test the encoding of a single gauge, byte by byte.
+ */
+void test_gauge_message() {
+	prom::Registry gauge_registry;
+	prom::Gauge gauge(TEMPERATURE_FAMILY, []() -> double {
+		return 1;
+	});
+	gauge_registry.add(gauge);
+	prom::ProtobufGenerator generator(gauge_registry);
+	const std::string exposition = generate(generator, 4096);
+
+	const char name[] = "test_temperature_celsius";
+	const char help[] = "The test temperature.";
+	std::string expected;
+	expected += (char) 0x0a;
+	expected += (char) (sizeof(name) - 1);
+	expected += name;
+	expected += (char) 0x12;
+	expected += (char) (sizeof(help) - 1);
+	expected += help;
+	// The type is GAUGE, and the metric contains a gauge with the value 1.0.
+	expected += std::string("\x18\x01\x22\x0b\x12\x09\x09", 7);
+	expected += std::string("\x00\x00\x00\x00\x00\x00\xf0\x3f", 8);
+
+	TEST_ASSERT_EQUAL_UINT(expected.length() + 1, exposition.length());
+	TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected.length(), exposition[0],
+			"The message length prefix was wrong.");
+	TEST_ASSERT_EQUAL_MEMORY(expected.data(), exposition.data() + 1,
+			expected.length());
+}
+
+/**
+ * Test that a large family is split into multiple messages, and that the exposition can be read in chunks of any size.
+ */
+void test_split_family() {
+	prom::ProtobufGenerator generator(registry);
+	const std::string exposition = generate(generator, 4096);
+	TEST_ASSERT_GREATER_THAN_UINT(prom::ProtobufGenerator::MESSAGE_BUFFER_SIZE,
+			exposition.length());
+
+	size_t messages = 0;
+	const uint8_t *pos = (const uint8_t*) exposition.data();
+	const uint8_t *end = pos + exposition.length();
+	while (pos < end) {
+		const size_t len = readVarint(pos, end);
+		TEST_ASSERT_LESS_OR_EQUAL_UINT(prom::ProtobufGenerator::MESSAGE_BUFFER_SIZE, len);
+		pos += len;
+		messages++;
+	}
+	TEST_ASSERT_GREATER_THAN_UINT_MESSAGE(5, messages,
+			"The family with many samples wasn't split.");
+
+	for (size_t chunk_size = 1; chunk_size < 300; chunk_size += 7) {
+		prom::ProtobufGenerator chunked(registry);
+		TEST_ASSERT_TRUE(exposition == generate(chunked, chunk_size));
+	}
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	registry.add(temperature_metric);
+	registry.add(requests_metric);
+	registry.add(build_info_metric);
+	registry.add(duration_metric);
+	registry.add(empty_metric);
+	registry.add(many_metric);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_round_trip);
+	RUN_TEST(test_gauge_message);
+	RUN_TEST(test_split_family);
+
+	return UNITY_END();
+}
@@ -0,0 +1,305 @@
+/*
+ * remote_write.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include "../metric_fixtures.h"
+#include <metric_registry.h>
+#include <protobuf_writer.h>
+#include <remote_write.h>
+#include <sample_line.h>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * The timestamp of the test write request, in milliseconds since the unix epoch.
+ */
+static constexpr int64_t REQUEST_TIMESTAMP = 1792238400123;
+
+/**
+ * The external labels added to every series.
+ */
+const prom::RemoteWriteLabel EXTERNAL_LABELS[] = { { "job", "test" }, {
+		"instance", "esp" } };
+
+/**
+ * The expected WriteRequest for the test registry.
+ * Encoded by protoc from the text format of the message.
+ */
+const uint8_t WRITE_REQUEST[] = {
+		0x0a, 0x56, 0x0a, 0x24, 0x0a, 0x08, 0x5f, 0x5f, 0x6e, 0x61, 0x6d, 0x65,
+		0x5f, 0x5f, 0x12, 0x18, 0x74, 0x65, 0x73, 0x74, 0x5f, 0x74, 0x65, 0x6d,
+		0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65, 0x5f, 0x63, 0x65, 0x6c,
+		0x73, 0x69, 0x75, 0x73, 0x0a, 0x0f, 0x0a, 0x08, 0x69, 0x6e, 0x73, 0x74,
+		0x61, 0x6e, 0x63, 0x65, 0x12, 0x03, 0x65, 0x73, 0x70, 0x0a, 0x0b, 0x0a,
+		0x03, 0x6a, 0x6f, 0x62, 0x12, 0x04, 0x74, 0x65, 0x73, 0x74, 0x12, 0x10,
+		0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x35, 0x40, 0x10, 0xfb, 0xe4,
+		0xee, 0xcd, 0x94, 0x34, 0x0a, 0x48, 0x0a, 0x1f, 0x0a, 0x08, 0x5f, 0x5f,
+		0x6e, 0x61, 0x6d, 0x65, 0x5f, 0x5f, 0x12, 0x13, 0x74, 0x65, 0x73, 0x74,
+		0x5f, 0x72, 0x65, 0x71, 0x75, 0x65, 0x73, 0x74, 0x73, 0x5f, 0x74, 0x6f,
+		0x74, 0x61, 0x6c, 0x0a, 0x0f, 0x0a, 0x08, 0x69, 0x6e, 0x73, 0x74, 0x61,
+		0x6e, 0x63, 0x65, 0x12, 0x03, 0x65, 0x73, 0x70, 0x0a, 0x0b, 0x0a, 0x03,
+		0x6a, 0x6f, 0x62, 0x12, 0x04, 0x74, 0x65, 0x73, 0x74, 0x12, 0x07, 0x10,
+		0xfb, 0xe4, 0xee, 0xcd, 0x94, 0x34, 0x0a, 0x5f, 0x0a, 0x1b, 0x0a, 0x08,
+		0x5f, 0x5f, 0x6e, 0x61, 0x6d, 0x65, 0x5f, 0x5f, 0x12, 0x0f, 0x74, 0x65,
+		0x73, 0x74, 0x5f, 0x62, 0x75, 0x69, 0x6c, 0x64, 0x5f, 0x69, 0x6e, 0x66,
+		0x6f, 0x0a, 0x0f, 0x0a, 0x08, 0x69, 0x6e, 0x73, 0x74, 0x61, 0x6e, 0x63,
+		0x65, 0x12, 0x03, 0x65, 0x73, 0x70, 0x0a, 0x0c, 0x0a, 0x03, 0x6a, 0x6f,
+		0x62, 0x12, 0x05, 0x62, 0x75, 0x69, 0x6c, 0x64, 0x0a, 0x0f, 0x0a, 0x07,
+		0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x12, 0x04, 0x31, 0x22, 0x30,
+		0x5c, 0x12, 0x10, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x3f,
+		0x10, 0x80, 0xe4, 0xee, 0xcd, 0x94, 0x34
+};
+
+prom::Gauge temperature_metric(TEMPERATURE_FAMILY, []() -> double {
+	return 21.5;
+});
+prom::Counter requests_metric(REQUESTS_FAMILY, []() -> uint64_t {
+	return 0;
+});
+prom::Collector build_info_metric(BUILD_INFO_FAMILY,
+		[](char *buffer, const size_t size, const prom::MetricFamily &family,
+				prom::SampleCursor &cursor) -> size_t {
+			if (cursor.index++ > 0) {
+				return 0;
+			}
+			return snprintf(buffer, size,
+					"%s{job=\"build\",version=\"1\\\"0\\\\\"} 1 1792238400000\n",
+					family.name);
+		});
+
+/**
+ * The registry containing all test metrics.
+ */
+prom::Registry registry;
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Test writing protocol buffer fields, using the examples from the encoding documentation.
+ */
+void test_protobuf_fields() {
+	uint8_t buffer[32];
+	prom::ProtobufWriter writer(buffer, sizeof(buffer));
+	writer.writeVarintField(1, 150);
+	const uint8_t varint[] = { 0x08, 0x96, 0x01 };
+	TEST_ASSERT_EQUAL_UINT(sizeof(varint), writer.getLength());
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(varint, buffer, sizeof(varint));
+
+	writer.truncate(0);
+	writer.writeBytesField(2, "testing", 7);
+	const uint8_t string[] = { 0x12, 0x07, 't', 'e', 's', 't', 'i', 'n', 'g' };
+	TEST_ASSERT_EQUAL_UINT(sizeof(string), writer.getLength());
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(string, buffer, sizeof(string));
+
+	writer.truncate(0);
+	writer.writeDoubleField(1, 1.0);
+	const uint8_t fixed[] = { 0x09, 0, 0, 0, 0, 0, 0, 0xf0, 0x3f };
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(fixed, buffer, sizeof(fixed));
+
+	TEST_ASSERT_EQUAL_UINT(1, prom::ProtobufWriter::varintLength(127));
+	TEST_ASSERT_EQUAL_UINT(2, prom::ProtobufWriter::varintLength(128));
+	TEST_ASSERT_EQUAL_UINT(10, prom::ProtobufWriter::varintLength(UINT64_MAX));
+}
+
+/**
+ * Test writing nested messages, and running out of space.
+ */
+void test_protobuf_messages() {
+	uint8_t buffer[16];
+	prom::ProtobufWriter writer(buffer, sizeof(buffer));
+	const size_t outer = writer.beginMessage(3);
+	const size_t inner = writer.beginMessage(1);
+	writer.writeVarintField(1, 150);
+	writer.endMessage(inner);
+	writer.endMessage(outer);
+	const uint8_t nested[] = { 0x1a, 0x05, 0x0a, 0x03, 0x08, 0x96, 0x01 };
+	TEST_ASSERT_FALSE(writer.overflowed());
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(sizeof(nested), writer.getLength(),
+			"The reserved message length space wasn't removed.");
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(nested, buffer, sizeof(nested));
+
+	writer.writeBytesField(2, "too long", 8);
+	TEST_ASSERT_TRUE_MESSAGE(writer.overflowed(),
+			"Writing more data than fits wasn't detected.");
+	writer.writeVarintField(1, 1);
+	TEST_ASSERT_TRUE(writer.overflowed());
+
+	writer.truncate(sizeof(nested));
+	TEST_ASSERT_FALSE(writer.overflowed());
+	TEST_ASSERT_EQUAL_UINT(sizeof(nested), writer.getLength());
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(nested, buffer, sizeof(nested));
+}
+
+/**
+ * Test parsing sample lines of the Prometheus text format.
+ */
+void test_parse_sample_line() {
+	const char plain[] = "test_temperature_celsius 21.500\n";
+	prom::SampleLine line;
+	TEST_ASSERT_TRUE(prom::parseSampleLine(plain, strlen(plain), line));
+	TEST_ASSERT_EQUAL_UINT(strlen("test_temperature_celsius"), line.name_len);
+	TEST_ASSERT_EQUAL_STRING_LEN("test_temperature_celsius", line.name,
+			line.name_len);
+	TEST_ASSERT_EQUAL_UINT(0, line.labels_len);
+	TEST_ASSERT_EQUAL_DOUBLE(21.5, line.value);
+	TEST_ASSERT_FALSE(line.has_timestamp);
+
+	const char labeled[] =
+			"test_duration_seconds_bucket{le=\"+Inf\",path=\"/a\\\"b}\"} 7 -1000\n";
+	TEST_ASSERT_TRUE(prom::parseSampleLine(labeled, strlen(labeled), line));
+	TEST_ASSERT_EQUAL_STRING_LEN("le=\"+Inf\",path=\"/a\\\"b}\"", line.labels,
+			line.labels_len);
+	TEST_ASSERT_EQUAL_DOUBLE(7, line.value);
+	TEST_ASSERT_TRUE(line.has_timestamp);
+	TEST_ASSERT_EQUAL_INT64(-1000, line.timestamp);
+
+	const char *pos = line.labels;
+	prom::SampleLabel label;
+	TEST_ASSERT_TRUE(
+			prom::nextSampleLabel(pos, line.labels + line.labels_len, label));
+	TEST_ASSERT_EQUAL_STRING_LEN("le", label.name, label.name_len);
+	TEST_ASSERT_EQUAL_STRING_LEN("+Inf", label.value, label.value_len);
+	TEST_ASSERT_TRUE(
+			prom::nextSampleLabel(pos, line.labels + line.labels_len, label));
+	TEST_ASSERT_EQUAL_STRING_LEN("path", label.name, label.name_len);
+	char value[16];
+	const size_t value_len = prom::unescapeLabelValue(label.value,
+			label.value_len, value);
+	TEST_ASSERT_EQUAL_UINT(value_len,
+			prom::unescapeLabelValue(label.value, label.value_len, NULL));
+	TEST_ASSERT_EQUAL_STRING_LEN("/a\"b}", value, value_len);
+	TEST_ASSERT_FALSE(
+			prom::nextSampleLabel(pos, line.labels + line.labels_len, label));
+
+	const char no_newline[] = "test_requests_total 1";
+	TEST_ASSERT_FALSE(
+			prom::parseSampleLine(no_newline, strlen(no_newline), line));
+	const char no_value[] = "test_requests_total\n";
+	TEST_ASSERT_FALSE(prom::parseSampleLine(no_value, strlen(no_value), line));
+	const char unclosed[] = "test_build_info{version=\"1} 1\n";
+	TEST_ASSERT_FALSE(prom::parseSampleLine(unclosed, strlen(unclosed), line));
+}
+
+/**
+ * Test writing a WriteRequest for the test registry, and comparing it to the protoc output.
+ */
+void test_write_request() {
+	uint8_t buffer[512];
+	prom::ProtobufWriter writer(buffer, sizeof(buffer));
+	size_t dropped = 0;
+	TEST_ASSERT_EQUAL_UINT(3,
+			prom::writeRemoteWriteRequest(writer, registry, EXTERNAL_LABELS, 2,
+					REQUEST_TIMESTAMP, dropped));
+	TEST_ASSERT_EQUAL_UINT(0, dropped);
+	TEST_ASSERT_EQUAL_UINT(sizeof(WRITE_REQUEST), writer.getLength());
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(WRITE_REQUEST, buffer, sizeof(WRITE_REQUEST));
+}
+
+/**
+ * Test that series not fitting into the buffer are dropped, without affecting the other series.
+ */
+void test_write_request_overflow() {
+	// The first series is 88 bytes long, and the third 97 bytes.
+	uint8_t buffer[120];
+	prom::ProtobufWriter writer(buffer, sizeof(buffer));
+	size_t dropped = 0;
+	TEST_ASSERT_EQUAL_UINT(1,
+			prom::writeRemoteWriteRequest(writer, registry, EXTERNAL_LABELS, 2,
+					REQUEST_TIMESTAMP, dropped));
+	TEST_ASSERT_EQUAL_UINT(2, dropped);
+	TEST_ASSERT_FALSE(writer.overflowed());
+	TEST_ASSERT_EQUAL_UINT(88, writer.getLength());
+	TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(WRITE_REQUEST, buffer, 88,
+			"The series before the dropped ones was changed.");
+}
+
+/**
+ * Test that only metrics writing missed samples are written when only writing missed samples,
+ * and that such a request ends before the first series that doesn't fit.
+ */
+void test_write_request_missed() {
+	static constexpr prom::MetricFamily MISSED_FAMILY = PROM_GAUGE_FAMILY(
+			"test_missed", "A metric with three missed samples.");
+	prom::Collector missed_metric(MISSED_FAMILY,
+			[](char *buffer, const size_t size, const prom::MetricFamily &family,
+					prom::SampleCursor &cursor) -> size_t {
+				if (!cursor.missed_only) {
+					return cursor.index++ > 0 ? 0 :
+							prom::writeSampleLine(buffer, size, family.name, 4);
+				} else if (cursor.index >= 3) {
+					return 0;
+				}
+				cursor.index++;
+				return prom::writeSampleLine(buffer, size, family.name,
+						cursor.index, 1792238400000 + cursor.index, false);
+			}, true);
+	prom::Gauge current_metric(TEMPERATURE_FAMILY, []() -> double {
+		return 21.5;
+	});
+	prom::Registry missed_registry;
+	missed_registry.add(current_metric);
+	missed_registry.add(missed_metric);
+
+	uint8_t buffer[512];
+	prom::ProtobufWriter writer(buffer, sizeof(buffer));
+	size_t dropped = 0;
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(2,
+			prom::writeRemoteWriteRequest(writer, missed_registry,
+					EXTERNAL_LABELS, 2, REQUEST_TIMESTAMP, dropped, 1),
+			"The current samples weren't written.");
+
+	prom::ProtobufWriter missed_writer(buffer, sizeof(buffer));
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(3,
+			prom::writeRemoteWriteRequest(missed_writer, missed_registry,
+					EXTERNAL_LABELS, 2, REQUEST_TIMESTAMP, dropped, 1, true),
+			"Not only the missed samples were written.");
+	TEST_ASSERT_EQUAL_UINT(0, dropped);
+
+	// Each missed series has the same length.
+	const size_t series_len = missed_writer.getLength() / 3;
+	prom::ProtobufWriter small_writer(buffer, series_len * 2 - 1);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(1,
+			prom::writeRemoteWriteRequest(small_writer, missed_registry,
+					EXTERNAL_LABELS, 2, REQUEST_TIMESTAMP, dropped, 1, true),
+			"The request didn't end at the first missed sample that didn't fit.");
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, dropped,
+			"A missed sample that didn't fit was dropped.");
+	TEST_ASSERT_EQUAL_UINT(series_len, small_writer.getLength());
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	registry.add(temperature_metric);
+	registry.add(requests_metric);
+	registry.add(build_info_metric);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_protobuf_fields);
+	RUN_TEST(test_protobuf_messages);
+	RUN_TEST(test_parse_sample_line);
+	RUN_TEST(test_write_request);
+	RUN_TEST(test_write_request_overflow);
+	RUN_TEST(test_write_request_missed);
+
+	return UNITY_END();
+}
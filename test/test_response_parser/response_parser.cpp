@@ -0,0 +1,327 @@
+/*
+ * response_parser.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <response_parser.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * A typical Pushgateway response to a successful push.
+ */
+const char PUSH_RESPONSE[] = "HTTP/1.1 200 OK\r\n"
+		"Date: Sat, 17 Oct 2026 12:00:00 GMT\r\n"
+		"Content-Length: 0\r\n"
+		"\r\n";
+
+/**
+ * A chunked response with an error message, and a trailer field.
+ */
+const char CHUNKED_RESPONSE[] = "HTTP/1.1 400 Bad Request\r\n"
+		"Content-Type: text/plain; charset=utf-8\r\n"
+		"Transfer-Encoding: chunked\r\n"
+		"\r\n"
+		"1a;ext=1\r\n"
+		"text format parsing error\r\n"
+		"0\r\n"
+		"X-Trailer: 1\r\n"
+		"\r\n";
+
+/**
+ * Responses covering every parser state, used to test parsing split responses.
+ */
+const char *const SPLIT_RESPONSES[] = { PUSH_RESPONSE, CHUNKED_RESPONSE,
+		"HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 429 Too Many Requests\r\n"
+				"Retry-After: 30\r\nContent-Length: 4\r\n\r\nslow",
+		"HTTP/1.0 204 No Content\r\nConnection: keep-alive\r\n\r\n",
+		"\r\nHTTP/1.1 200 OK\nTransfer-Encoding: gzip, chunked\n\n3\nabc\n0\n\n" };
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Feeds the given response to the given parser in a single segment.
+ *
+ * @param parser	The parser to feed the response to.
+ * @param response	The response to parse.
+ * @return	The number of bytes the parser consumed.
+ */
+size_t parse(http::ResponseParser &parser, const std::string &response) {
+	return parser.parse((const uint8_t*) response.c_str(), response.length());
+}
+
+/**
+ * A header callback adding each header to the vector of strings given as its argument.
+ *
+ * @param arg		The vector to add the header to.
+ * @param name		The header name.
+ * @param name_len	The length of the header name.
+ * @param value		The header value.
+ * @param value_len	The length of the header value.
+ */
+void collectHeader(void *arg, const char *name, const size_t name_len,
+		const char *value, const size_t value_len) {
+	std::vector<std::string> &headers = *(std::vector<std::string>*) arg;
+	headers.push_back(
+			std::string(name, name_len) + ": " + std::string(value, value_len));
+}
+
+/**
+ * Checks that two parsers reached the same result.
+ *
+ * @param expected	The parser that parsed the whole response at once.
+ * @param actual	The parser that parsed the response in segments.
+ * @param message	The message to show if they differ.
+ */
+void assertSameResult(const http::ResponseParser &expected,
+		const http::ResponseParser &actual, const char *message) {
+	TEST_ASSERT_TRUE_MESSAGE(expected.getState() == actual.getState(), message);
+	TEST_ASSERT_EQUAL_UINT16_MESSAGE(expected.getStatusCode(),
+			actual.getStatusCode(), message);
+	TEST_ASSERT_TRUE_MESSAGE(expected.isKeepAlive() == actual.isKeepAlive(),
+			message);
+}
+
+/**
+ * Test parsing responses with a Content-Length.
+ */
+void test_content_length() {
+	http::ResponseParser parser;
+	TEST_ASSERT_EQUAL_UINT(strlen(PUSH_RESPONSE), parse(parser, PUSH_RESPONSE));
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_EQUAL_UINT16(200, parser.getStatusCode());
+	TEST_ASSERT_TRUE(parser.isKeepAlive());
+
+	parser.reset();
+	const std::string response =
+			"HTTP/1.1 500 Internal Server Error\r\ncontent-length:  5 \r\n\r\nerror";
+	TEST_ASSERT_EQUAL_UINT(response.length(), parse(parser, response));
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_EQUAL_UINT16(500, parser.getStatusCode());
+}
+
+/**
+ * Test parsing a response with chunked transfer encoding.
+ */
+void test_chunked() {
+	http::ResponseParser parser;
+	TEST_ASSERT_EQUAL_UINT(strlen(CHUNKED_RESPONSE),
+			parse(parser, CHUNKED_RESPONSE));
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_EQUAL_UINT16(400, parser.getStatusCode());
+	TEST_ASSERT_TRUE(parser.isKeepAlive());
+
+	parser.reset();
+	parse(parser, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n");
+	TEST_ASSERT_TRUE_MESSAGE(parser.failed(),
+			"An invalid chunk size was accepted.");
+}
+
+/**
+ * Test that the parser stops at the end of a response, so the rest can be parsed as the next response.
+ */
+void test_pipelined() {
+	const std::string responses = std::string(PUSH_RESPONSE) + CHUNKED_RESPONSE;
+	http::ResponseParser parser;
+	const size_t first = parse(parser, responses);
+	TEST_ASSERT_EQUAL_UINT(strlen(PUSH_RESPONSE), first);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0,
+			parser.parse((const uint8_t*) responses.c_str() + first, 1),
+			"A complete parser consumed data of the next response.");
+
+	parser.reset();
+	TEST_ASSERT_EQUAL_UINT(strlen(CHUNKED_RESPONSE),
+			parser.parse((const uint8_t*) responses.c_str() + first,
+					responses.length() - first));
+	TEST_ASSERT_EQUAL_UINT16(400, parser.getStatusCode());
+}
+
+/**
+ * Test whether connections are kept alive, depending on the HTTP version and Connection header.
+ */
+void test_keep_alive() {
+	http::ResponseParser parser;
+	parse(parser, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_FALSE(parser.isKeepAlive());
+
+	parser.reset();
+	parse(parser, "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_FALSE_MESSAGE(parser.isKeepAlive(),
+			"A HTTP/1.0 connection was kept alive by default.");
+
+	parser.reset();
+	parse(parser,
+			"HTTP/1.0 200 OK\r\nConnection: Upgrade, Keep-Alive\r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_TRUE(parser.isKeepAlive());
+
+	// A response without a length ends when the connection is closed.
+	parser.reset();
+	parse(parser, "HTTP/1.1 200 OK\r\n\r\nbody");
+	TEST_ASSERT_TRUE(
+			parser.getState() == http::ResponseParser::State::BODY_UNTIL_CLOSE);
+	TEST_ASSERT_FALSE(parser.isKeepAlive());
+	TEST_ASSERT_TRUE(parser.finish());
+
+	parser.reset();
+	parse(parser, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nbody");
+	TEST_ASSERT_FALSE_MESSAGE(parser.finish(),
+			"A truncated response was accepted.");
+	TEST_ASSERT_TRUE(parser.failed());
+}
+
+/**
+ * Test responses with special status codes and invalid responses.
+ */
+void test_status() {
+	http::ResponseParser parser;
+	parse(parser,
+			"HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 204 No Content\r\nContent-Length: 7\r\n\r\n");
+	TEST_ASSERT_TRUE_MESSAGE(parser.done(),
+			"A 204 response wasn't complete after its headers.");
+	TEST_ASSERT_EQUAL_UINT16(204, parser.getStatusCode());
+
+	parser.reset();
+	parse(parser, "\r\nHTTP/1.1 202\nContent-Length: 0\n\n");
+	TEST_ASSERT_TRUE_MESSAGE(parser.done(),
+			"A response with bare line feeds and without a reason phrase wasn't accepted.");
+	TEST_ASSERT_EQUAL_UINT16(202, parser.getStatusCode());
+
+	const char *const invalid[] = { "HTTP/2 200 OK\r\n", "HTTP/1.1 20 OK\r\n",
+			"HTTP/1.1 200OK\r\n", "ICY 200 OK\r\n",
+			"HTTP/1.1 200 OK\r\nContent-Length: 1x\r\n",
+			"HTTP/1.1 200 OK\r\nContent-Length: 1\r\nContent-Length: 2\r\n",
+			"HTTP/1.1 200 OK\r\nInvalid\r\n" };
+	for (const char *response : invalid) {
+		parser.reset();
+		parse(parser, response);
+		TEST_ASSERT_TRUE_MESSAGE(parser.failed(), response);
+	}
+}
+
+/**
+ * Test that long header lines are only rejected for the headers required to find the end of the response.
+ */
+void test_long_lines() {
+	const std::string long_value(http::ResponseParser::LINE_BUFFER_SIZE * 2,
+			'a');
+	http::ResponseParser parser;
+	parse(parser,
+			"HTTP/1.1 200 OK\r\nX-Long: " + long_value
+					+ "\r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_TRUE(parser.done());
+
+	parser.reset();
+	parse(parser,
+			"HTTP/1.1 200 OK\r\nTransfer-Encoding: " + long_value
+					+ ", chunked\r\n\r\n");
+	TEST_ASSERT_TRUE_MESSAGE(parser.failed(),
+			"A truncated Transfer-Encoding header was accepted.");
+}
+
+/**
+ * Test that responses split into two segments at every offset, or into single bytes, are parsed like whole responses.
+ */
+void test_split() {
+	for (const char *response : SPLIT_RESPONSES) {
+		const size_t len = strlen(response);
+		const uint8_t *data = (const uint8_t*) response;
+		http::ResponseParser whole;
+		std::vector<std::string> whole_headers;
+		whole.setHeaderCallback(collectHeader, &whole_headers);
+		TEST_ASSERT_EQUAL_UINT_MESSAGE(len, whole.parse(data, len), response);
+		TEST_ASSERT_TRUE_MESSAGE(whole.done(), response);
+
+		http::ResponseParser parser;
+		std::vector<std::string> headers;
+		parser.setHeaderCallback(collectHeader, &headers);
+		for (size_t split = 0; split <= len; split++) {
+			parser.reset();
+			headers.clear();
+			const size_t first = parser.parse(data, split);
+			TEST_ASSERT_EQUAL_UINT_MESSAGE(split, first, response);
+			TEST_ASSERT_EQUAL_UINT_MESSAGE(len - split,
+					parser.parse(data + split, len - split), response);
+			assertSameResult(whole, parser, response);
+			TEST_ASSERT_TRUE_MESSAGE(whole_headers == headers, response);
+		}
+
+		parser.reset();
+		headers.clear();
+		for (size_t i = 0; i < len; i++) {
+			TEST_ASSERT_EQUAL_UINT_MESSAGE(1, parser.parse(data + i, 1),
+					response);
+		}
+		assertSameResult(whole, parser, response);
+		TEST_ASSERT_TRUE_MESSAGE(whole_headers == headers, response);
+	}
+}
+
+/**
+ * Test that the header callback receives every complete header, but no trailers.
+ */
+void test_header_callback() {
+	std::vector<std::string> headers;
+	http::ResponseParser parser;
+	parser.setHeaderCallback(collectHeader, &headers);
+	parse(parser, CHUNKED_RESPONSE);
+	TEST_ASSERT_EQUAL_UINT(2, headers.size());
+	TEST_ASSERT_EQUAL_STRING("Content-Type: text/plain; charset=utf-8",
+			headers[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("Transfer-Encoding: chunked", headers[1].c_str());
+
+	// The callback is kept when resetting the parser, and truncated headers are skipped.
+	parser.reset();
+	headers.clear();
+	const std::string long_value(http::ResponseParser::LINE_BUFFER_SIZE, 'a');
+	parse(parser,
+			"HTTP/1.1 503 Service Unavailable\r\nX-Long: " + long_value
+					+ "\r\nRetry-After:\t120 \r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_EQUAL_UINT(2, headers.size());
+	TEST_ASSERT_EQUAL_STRING("Retry-After: 120", headers[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("Content-Length: 0", headers[1].c_str());
+
+	parser.setHeaderCallback(NULL);
+	parser.reset();
+	headers.clear();
+	parse(parser, PUSH_RESPONSE);
+	TEST_ASSERT_TRUE(parser.done());
+	TEST_ASSERT_TRUE_MESSAGE(headers.empty(),
+			"A removed header callback was called.");
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_content_length);
+	RUN_TEST(test_chunked);
+	RUN_TEST(test_pipelined);
+	RUN_TEST(test_keep_alive);
+	RUN_TEST(test_status);
+	RUN_TEST(test_long_lines);
+	RUN_TEST(test_split);
+	RUN_TEST(test_header_callback);
+
+	return UNITY_END();
+}
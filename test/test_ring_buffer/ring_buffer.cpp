@@ -0,0 +1,100 @@
+/*
+ * ring_buffer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <ring_buffer.h>
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Test adding entries to a buffer that isn't full yet.
+ */
+void test_push() {
+	utils::RingBuffer<int, 4> buffer;
+	TEST_ASSERT_TRUE(buffer.empty());
+	TEST_ASSERT_EQUAL_UINT32(0, buffer.begin());
+	TEST_ASSERT_EQUAL_UINT32(0, buffer.end());
+	TEST_ASSERT_EQUAL_UINT(0, buffer.size());
+
+	TEST_ASSERT_EQUAL_UINT32(0, buffer.push(10));
+	TEST_ASSERT_EQUAL_UINT32(1, buffer.push(11));
+	TEST_ASSERT_EQUAL_UINT32(2, buffer.push(12));
+	TEST_ASSERT_FALSE(buffer.empty());
+	TEST_ASSERT_EQUAL_UINT32(0, buffer.begin());
+	TEST_ASSERT_EQUAL_UINT32(3, buffer.end());
+	TEST_ASSERT_EQUAL_UINT(3, buffer.size());
+	TEST_ASSERT_EQUAL_INT(10, buffer.get(0));
+	TEST_ASSERT_EQUAL_INT(12, buffer.get(2));
+	TEST_ASSERT_EQUAL_INT(12, buffer.back());
+}
+
+/**
+ * Test that a full buffer overwrites the oldest entries, and keeps the sequence numbers of the others.
+ */
+void test_overwrite() {
+	utils::RingBuffer<int, 4> buffer;
+	for (int i = 0; i < 10; i++) {
+		buffer.push(i * 10);
+	}
+
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(4, buffer.size(),
+			"A full buffer kept more entries than its capacity.");
+	TEST_ASSERT_EQUAL_UINT32(6, buffer.begin());
+	TEST_ASSERT_EQUAL_UINT32(10, buffer.end());
+	for (uint32_t seq = buffer.begin(); seq < buffer.end(); seq++) {
+		TEST_ASSERT_EQUAL_INT_MESSAGE(seq * 10, buffer.get(seq),
+				"An entry didn't keep its sequence number.");
+	}
+	TEST_ASSERT_EQUAL_INT(90, buffer.back());
+}
+
+/**
+ * Test that a reader can resume after the last entry it read, skipping overwritten entries.
+ */
+void test_resume() {
+	utils::RingBuffer<int, 3> buffer;
+	buffer.push(1);
+	buffer.push(2);
+	const uint32_t next = buffer.end();
+
+	buffer.push(3);
+	TEST_ASSERT_TRUE(buffer.begin() <= next);
+	TEST_ASSERT_EQUAL_INT(3, buffer.get(next));
+
+	for (int i = 4; i < 8; i++) {
+		buffer.push(i);
+	}
+	TEST_ASSERT_TRUE_MESSAGE(buffer.begin() > next,
+			"An overwritten entry was still reported as kept.");
+	TEST_ASSERT_EQUAL_INT(5, buffer.get(buffer.begin()));
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_push);
+	RUN_TEST(test_overwrite);
+	RUN_TEST(test_resume);
+
+	return UNITY_END();
+}
@@ -0,0 +1,204 @@
+/*
+ * route_table.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <route_table.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Use a constant seed, to get reproducible results.
+ * Used to generate the random paths for the fuzz test.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1697500800;
+
+/**
+ * The number of random paths to check in the fuzz test.
+ */
+const size_t FUZZ_ITERATIONS = 100000;
+
+/**
+ * The routes registered by the web server, in registration order.
+ */
+const char *const ROUTES[] = { "/", "/index.html", "/main.css", "/index.js",
+		"/manifest.json", "/temperature", "/humidity",
+		"/timings/since_startup_ms", "/timings/since_measurement_ms",
+		"/timings/since_successful_measurement_ms", "/timings/info",
+		"/timings", "/timings/", "/data.json", "/events", "/favicon.ico",
+		"/favicon.png", "/favicon.svg", "*", "/metrics" };
+
+/**
+ * The path segments used to build random paths for the fuzz test.
+ */
+const char *const FUZZ_SEGMENTS[] = { "", "/", "/timings", "/info", "/index",
+		".html", "/metrics", "x", "*", "//", "/favicon.ico", "/since_startup_ms" };
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Gets the route handling the given path, the way the previous per uri web handlers did.
+ * That is the first registered route, that is equal to the path, or followed by a slash in the path.
+ *
+ * @param path	The request path.
+ * @return	The index of the route in ROUTES, or -1 if none matches.
+ */
+int reference_match(const std::string &path) {
+	// Exact matches always win, since they can't also be a prefix of the path.
+	for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); i++) {
+		if (path == ROUTES[i]) {
+			return i;
+		}
+	}
+
+	// The longest matching prefix, since the web server registers more specific routes first.
+	int match = -1;
+	for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); i++) {
+		const std::string prefix = std::string(ROUTES[i]) + '/';
+		if (path.compare(0, prefix.length(), prefix) == 0
+				&& (match == -1 || strlen(ROUTES[i]) > strlen(ROUTES[match]))) {
+			match = i;
+		}
+	}
+	return match;
+}
+
+/**
+ * Creates a route table containing all ROUTES, with their index as the value.
+ *
+ * @return	The new route table.
+ */
+http::RouteTable<int> create_table() {
+	http::RouteTable<int> table;
+	for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); i++) {
+		table[ROUTES[i]] = i;
+	}
+	return table;
+}
+
+/**
+ * Looks up the given path in the given table.
+ *
+ * @param table	The table to search.
+ * @param path	The path to look for.
+ * @return	The value of the matching route, or -1 if none matches.
+ */
+int match(http::RouteTable<int> &table, const std::string &path) {
+	const int *value = table.match(path.c_str(), path.length());
+	return value ? *value : -1;
+}
+
+/**
+ * Test that routes are kept sorted, and inserting an existing route replaces its value.
+ */
+void test_insert() {
+	http::RouteTable<int> table = create_table();
+	TEST_ASSERT_EQUAL_UINT(sizeof(ROUTES) / sizeof(ROUTES[0]), table.size());
+	const std::vector<http::RouteTable<int>::Route> &routes =
+			table.getRoutes();
+	for (size_t i = 1; i < routes.size(); i++) {
+		TEST_ASSERT_TRUE_MESSAGE(routes[i - 1].first < routes[i].first,
+				"The routes weren't sorted.");
+	}
+
+	table["/metrics"] = 100;
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(sizeof(ROUTES) / sizeof(ROUTES[0]),
+			table.size(), "Inserting an existing route added a new route.");
+	TEST_ASSERT_EQUAL_INT(100, match(table, "/metrics"));
+}
+
+/**
+ * Test exact lookups, including paths that aren't NUL terminated.
+ */
+void test_find() {
+	http::RouteTable<int> table = create_table();
+	const char path[] = "/index.html";
+	TEST_ASSERT_NOT_NULL(table.find(path, strlen(path)));
+	TEST_ASSERT_EQUAL_INT(1, *table.find(path, strlen(path)));
+	TEST_ASSERT_EQUAL_INT_MESSAGE(5, *table.find("/temperaturex", 12),
+			"A path that wasn't NUL terminated wasn't found.");
+	TEST_ASSERT_NULL(table.find("/index", 6));
+	TEST_ASSERT_NULL(table.find("/timings/info/x", 15));
+	TEST_ASSERT_NULL(table.find("", 0));
+
+	http::RouteTable<int> empty;
+	TEST_ASSERT_NULL(empty.find("/", 1));
+	TEST_ASSERT_NULL(empty.match("/", 1));
+}
+
+/**
+ * Test matching paths below a route.
+ */
+void test_match_prefix() {
+	http::RouteTable<int> table = create_table();
+	TEST_ASSERT_EQUAL_INT(11, match(table, "/timings"));
+	TEST_ASSERT_EQUAL_INT(12, match(table, "/timings/"));
+	TEST_ASSERT_EQUAL_INT(10, match(table, "/timings/info"));
+	TEST_ASSERT_EQUAL_INT_MESSAGE(10, match(table, "/timings/info/x"),
+			"The longest matching route wasn't used.");
+	TEST_ASSERT_EQUAL_INT(11, match(table, "/timings/unknown"));
+	TEST_ASSERT_EQUAL_INT(12, match(table, "/timings//x"));
+	TEST_ASSERT_EQUAL_INT_MESSAGE(-1, match(table, "/timingsx"),
+			"A route matched a path without a slash after it.");
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, match(table, "//"),
+			"The root route didn't match a path starting with two slashes.");
+	TEST_ASSERT_EQUAL_INT(-1, match(table, "/unknown"));
+	TEST_ASSERT_EQUAL_INT(-1, match(table, ""));
+	TEST_ASSERT_EQUAL_INT(18, match(table, "*"));
+}
+
+/**
+ * Test random paths built from route segments against the reference implementation.
+ */
+void test_fuzz() {
+	http::RouteTable<int> table = create_table();
+	std::mt19937 rand(RANDOM_SEED);
+	std::uniform_int_distribution<size_t> segment_dist(0,
+			sizeof(FUZZ_SEGMENTS) / sizeof(FUZZ_SEGMENTS[0]) - 1);
+	std::uniform_int_distribution<size_t> count_dist(1, 5);
+	for (size_t i = 0; i < FUZZ_ITERATIONS; i++) {
+		std::string path;
+		const size_t segments = count_dist(rand);
+		for (size_t j = 0; j < segments; j++) {
+			path += FUZZ_SEGMENTS[segment_dist(rand)];
+		}
+
+		if (reference_match(path) != match(table, path)) {
+			TEST_FAIL_MESSAGE(
+					("Route table and reference disagree for path \"" + path
+							+ "\".").c_str());
+		}
+	}
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_insert);
+	RUN_TEST(test_find);
+	RUN_TEST(test_match_prefix);
+	RUN_TEST(test_fuzz);
+
+	return UNITY_END();
+}
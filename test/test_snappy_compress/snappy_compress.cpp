@@ -0,0 +1,235 @@
+/*
+ * snappy_compress.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <snappy_compress.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Use a constant seed, to get reproducible results.
+ * Used to generate the random data to compress.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1792238400;
+
+/**
+ * A line of prometheus text exposition, used as highly repetitive test data.
+ * Contains a format specifier for an incrementing number.
+ */
+const char METRICS_LINE[] =
+		"esptherm_http_requests_total{method=\"get\",path=\"/metrics\",code=\"200\"} %u\n";
+
+/**
+ * The hash table used by all tests, large enough for every tested size.
+ */
+uint16_t table[1 << 14];
+
+void setUp() {
+
+}
+
+void tearDown() {
+
+}
+
+/**
+ * Decompresses snappy compressed data, following the format description of the reference implementation.
+ *
+ * @param data	The compressed data.
+ * @param len	The length of the compressed data.
+ * @param out	The string to write the decompressed data to.
+ * @return	False if the data is invalid.
+ */
+bool decompress(const uint8_t *data, const size_t len, std::string &out) {
+	size_t pos = 0;
+	uint64_t expected = 0;
+	for (uint8_t shift = 0; pos < len; shift += 7) {
+		const uint8_t byte = data[pos++];
+		expected |= (uint64_t) (byte & 0x7F) << shift;
+		if (byte < 0x80) {
+			break;
+		}
+	}
+
+	out.clear();
+	while (pos < len) {
+		const uint8_t tag = data[pos++];
+		size_t length;
+		size_t offset;
+		switch (tag & 3) {
+		case 0:
+			length = (tag >> 2) + 1;
+			if (length > 60) {
+				const size_t bytes = length - 60;
+				length = 0;
+				for (size_t i = 0; i < bytes && pos < len; i++) {
+					length |= (size_t) data[pos++] << (i * 8);
+				}
+				length++;
+			}
+			if (len - pos < length) {
+				return false;
+			}
+			out.append((const char*) data + pos, length);
+			pos += length;
+			continue;
+		case 1:
+			length = ((tag >> 2) & 7) + 4;
+			offset = ((size_t) (tag >> 5) << 8) | data[pos++];
+			break;
+		case 2:
+			length = (tag >> 2) + 1;
+			offset = data[pos] | (data[pos + 1] << 8);
+			pos += 2;
+			break;
+		default:
+			return false;
+		}
+
+		if (offset == 0 || offset > out.length()) {
+			return false;
+		}
+		// Copies may overlap their own output, so they are copied byte by byte.
+		for (size_t i = 0; i < length; i++) {
+			out += out[out.length() - offset];
+		}
+	}
+	return pos == len && out.length() == expected;
+}
+
+/**
+ * Compresses the given data, and checks that decompressing it results in the original data.
+ *
+ * @param data			The data to compress.
+ * @param table_bits	The hash table size to use.
+ * @return	The length of the compressed data.
+ */
+size_t checkRoundTrip(const std::string &data, const uint8_t table_bits) {
+	std::vector<uint8_t> compressed(snappy::maxCompressedLength(data.length()));
+	const size_t len = snappy::compress((const uint8_t*) data.c_str(),
+			data.length(), compressed.data(), table, table_bits);
+	TEST_ASSERT_LESS_OR_EQUAL_UINT(compressed.size(), len);
+
+	std::string decompressed;
+	TEST_ASSERT_TRUE_MESSAGE(decompress(compressed.data(), len, decompressed),
+			"The compressed data was invalid.");
+	TEST_ASSERT_TRUE_MESSAGE(decompressed == data,
+			"The decompressed data didn't match the input.");
+	return len;
+}
+
+/**
+ * Compresses the given data, and compares the result to the given reference bytes.
+ *
+ * @param data		The data to compress.
+ * @param len		The length of the data.
+ * @param expected	The expected compressed data.
+ * @param exp_len	The length of the expected data.
+ */
+void checkReference(const char *data, const size_t len,
+		const uint8_t *expected, const size_t exp_len) {
+	uint8_t compressed[256];
+	TEST_ASSERT_LESS_OR_EQUAL_UINT(sizeof(compressed),
+			snappy::maxCompressedLength(len));
+	TEST_ASSERT_EQUAL_UINT(exp_len,
+			snappy::compress((const uint8_t*) data, len, compressed, table,
+					10));
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, compressed, exp_len);
+}
+
+/**
+ * Test inputs that can only be written as literals.
+ */
+void test_literals() {
+	const uint8_t empty[] = { 0x00 };
+	checkReference("", 0, empty, sizeof(empty));
+
+	const uint8_t abc[] = { 0x03, 0x08, 'a', 'b', 'c' };
+	checkReference("abc", 3, abc, sizeof(abc));
+
+	// Literals of more than 60 bytes have their length after the tag.
+	char distinct[100];
+	uint8_t long_literal[103] = { 100, 60 << 2, 99 };
+	for (size_t i = 0; i < sizeof(distinct); i++) {
+		distinct[i] = (char) i;
+		long_literal[i + 3] = (uint8_t) i;
+	}
+	checkReference(distinct, sizeof(distinct), long_literal,
+			sizeof(long_literal));
+}
+
+/**
+ * Test inputs containing repetitions, written as copies.
+ */
+void test_copies() {
+	// A run of a single byte is a literal followed by an overlapping copy with a two byte offset.
+	const uint8_t run[] = { 40, 0x00, 'a', 0x9a, 0x01, 0x00 };
+	checkReference(std::string(40, 'a').c_str(), 40, run, sizeof(run));
+
+	// Short copies with a small offset use a single offset byte.
+	const char repeat[] = "abcdefghabcdefgh0123456789ABCDEF";
+	const uint8_t repeat_ref[] = { 32, 0x1c, 'a', 'b', 'c', 'd', 'e', 'f',
+			'g', 'h', 0x11, 0x08, 0x3c, '0', '1', '2', '3', '4', '5', '6', '7',
+			'8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+	checkReference(repeat, sizeof(repeat) - 1, repeat_ref, sizeof(repeat_ref));
+}
+
+/**
+ * Test that compressed data can be decompressed, for different kinds of data and hash table sizes.
+ */
+void test_round_trip() {
+	std::string metrics;
+	char line[128];
+	for (unsigned int i = 0; metrics.length() < 100000; i++) {
+		snprintf(line, sizeof(line), METRICS_LINE, i);
+		metrics += line;
+	}
+
+	std::mt19937 rng(RANDOM_SEED);
+	std::string random;
+	for (size_t i = 0; i < 70000; i++) {
+		random += (char) rng();
+	}
+
+	for (const uint8_t table_bits : { 8, 10, 14 }) {
+		const size_t metrics_len = checkRoundTrip(metrics, table_bits);
+		TEST_ASSERT_LESS_THAN_UINT_MESSAGE(metrics.length() / 4, metrics_len,
+				"Repetitive metrics weren't compressed well.");
+		checkRoundTrip(random, table_bits);
+		checkRoundTrip(metrics.substr(0, 14), table_bits);
+		checkRoundTrip(metrics.substr(0, 15), table_bits);
+	}
+
+	// Copies never reference data before their fragment, so a repetition across fragments isn't found.
+	const std::string fragments = random.substr(0, snappy::FRAGMENT_SIZE)
+			+ random.substr(0, 1000);
+	TEST_ASSERT_GREATER_THAN_UINT(fragments.length(),
+			checkRoundTrip(fragments, 14));
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_literals);
+	RUN_TEST(test_copies);
+	RUN_TEST(test_round_trip);
+
+	return UNITY_END();
+}
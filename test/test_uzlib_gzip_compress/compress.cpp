@@ -0,0 +1,294 @@
+/*
+ * compress.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <uzlib_gzip_wrapper.h>
+#include <utils.h>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Use a constant seed, to get reproducible results.
+ * Used to generate the random data to compress.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1685018244;
+
+/**
+ * The characters to be used as part of the generated random data.
+ */
+constexpr char RANDOM_CHARS[] =
+		"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/**
+ * The number of random characters to use.
+ */
+constexpr size_t RANDOM_CHARS_LEN = utils::strlen(RANDOM_CHARS);
+
+/**
+ * A line of prometheus text exposition, used as highly repetitive test data.
+ * Contains a format specifier for an incrementing number.
+ */
+const char METRICS_LINE[] =
+		"esptherm_http_requests_total{method=\"GET\",path=\"/metrics\",code=\"200\"} %u\n";
+
+/**
+ * The python command used to check that the compressed file can be decompressed by an independent implementation.
+ * Takes the compressed and the uncompressed path as arguments.
+ */
+const char CHECK_COMMAND[] =
+		"python3 -c \"import gzip,sys; sys.exit(gzip.open(sys.argv[1]).read() != open(sys.argv[2], 'rb').read())\" ";
+
+/**
+ * The integer distribution for the random data.
+ * Initialized in setUp and destroyed in tearDown.
+ */
+std::uniform_int_distribution<uint8_t> *distribution;
+
+/**
+ * A pointer to the random number generator to be used.
+ * Initialized in setUp and destroyed in tearDown.
+ */
+std::mt19937 *rng;
+
+/**
+ * Initializes the random number generator.
+ */
+void setUp() {
+	gzip::init();
+	rng = new std::mt19937(RANDOM_SEED);
+	distribution = new std::uniform_int_distribution<uint8_t>(0,
+			RANDOM_CHARS_LEN - 1);
+}
+
+/**
+ * Destroys the random number generator.
+ */
+void tearDown() {
+	delete rng;
+	rng = NULL;
+	delete distribution;
+	distribution = NULL;
+}
+
+/**
+ * Generates the given number of random bytes matching this regex: `[0-9a-zA-Z]`.
+ *
+ * @param bytes	The number of bytes to generate.
+ * @return	The generated data.
+ */
+std::vector<uint8_t> generate_random_data(const size_t bytes) {
+	std::vector<uint8_t> data(bytes);
+	for (size_t i = 0; i < bytes; i++) {
+		data[i] = RANDOM_CHARS[(*distribution)(*rng)];
+	}
+	return data;
+}
+
+/**
+ * Compresses everything the given compressor produces, in chunks of the given size.
+ *
+ * @param zip			The compressor to read from.
+ * @param chunk_size	The size of the output buffer to use for each compress call.
+ * @return	The entire compressed file.
+ */
+std::vector<uint8_t> compress_all(gzip::uzlib_gzip_wrapper &zip,
+		const size_t chunk_size) {
+	std::vector<uint8_t> compressed;
+	uint8_t *buf = new uint8_t[chunk_size];
+	while (!zip.done()) {
+		const size_t written = zip.compress(buf, chunk_size);
+		TEST_ASSERT_TRUE_MESSAGE(written == chunk_size || zip.done(),
+				"The compressor didn't fill the buffer before the file end.");
+		compressed.insert(compressed.end(), buf, buf + written);
+	}
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, zip.compress(buf, chunk_size),
+			"The compressor wrote data after it was done.");
+	delete[] buf;
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(compressed.size(), zip.getCompressed(),
+			"The compressed size didn't match the number of written bytes.");
+	return compressed;
+}
+
+/**
+ * Decompresses the given gzip file using uzlib_ungzip_wrapper, and compares it to the expected data.
+ *
+ * @param compressed	The gzip file to decompress.
+ * @param expected		The expected decompressed data.
+ * @param wsize			The window size to use for decompression.
+ */
+void check_decompressed(const std::vector<uint8_t> &compressed,
+		const std::vector<uint8_t> &expected, const int8_t wsize) {
+	gzip::uzlib_ungzip_wrapper unzip(compressed.data(),
+			compressed.data() + compressed.size(), wsize);
+	TEST_ASSERT_EQUAL_INT32_MESSAGE(expected.size(),
+			unzip.getDecompressedSize(),
+			"The gzip trailer size didn't match the uncompressed size.");
+
+	std::vector<uint8_t> decompressed(expected.size() + 1);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(expected.size(),
+			unzip.decompress(decompressed.data(), decompressed.size()),
+			"The number of decompressed bytes didn't match the uncompressed size.");
+	TEST_ASSERT_TRUE_MESSAGE(unzip.done(),
+			"The decompression wasn't considered done after decompressing everything.");
+	if (!expected.empty()) {
+		TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.data(), decompressed.data(),
+				expected.size(),
+				"The decompressed data didn't match the uncompressed data.");
+	}
+}
+
+/**
+ * Test compressing a small block of random data from memory, in a single call.
+ */
+void test_compress_small() {
+	const std::vector<uint8_t> data = generate_random_data(512);
+	gzip::uzlib_gzip_wrapper zip(data.data(), data.data() + data.size(), -10);
+	const std::vector<uint8_t> compressed = compress_all(zip, 1024);
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(data.size(), zip.getUncompressed(),
+			"The number of read bytes didn't match the input size.");
+	check_decompressed(compressed, data, -10);
+}
+
+/**
+ * Test compressing an empty input, which should still result in a valid gzip file.
+ */
+void test_compress_empty() {
+	const std::vector<uint8_t> data;
+	gzip::uzlib_gzip_wrapper zip(data.data(), data.data(), -10);
+	const std::vector<uint8_t> compressed = compress_all(zip, 64);
+	// Header, an empty static huffman block, a crc32 of 0, and a size of 0.
+	const uint8_t expected[] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF, 3, 0, 0,
+			0, 0, 0, 0, 0, 0, 0 };
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(sizeof(expected), compressed.size(),
+			"An empty gzip file should be 20 bytes.");
+	TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, compressed.data(),
+			sizeof(expected), "The empty gzip file didn't match expectations.");
+}
+
+/**
+ * Test compressing data that is a lot larger than the window, into small output chunks.
+ */
+void test_compress_large() {
+	const std::vector<uint8_t> data = generate_random_data(131072);
+	gzip::uzlib_gzip_wrapper zip(data.data(), data.data() + data.size(), -10);
+	const std::vector<uint8_t> compressed = compress_all(zip, 97);
+	check_decompressed(compressed, data, -10);
+}
+
+/**
+ * Test compressing generated, highly repetitive data from a callback, returning odd sized chunks.
+ */
+void test_compress_streaming() {
+	const uint32_t LINES = 5000;
+	std::string expected;
+	char line[sizeof(METRICS_LINE) + 10];
+	for (uint32_t i = 0; i < LINES; i++) {
+		snprintf(line, sizeof(line), METRICS_LINE, i);
+		expected += line;
+	}
+
+	uint32_t next_line = 0;
+	std::string pending;
+	gzip::uzlib_gzip_wrapper zip(
+			[&next_line, &pending, &line](uint8_t *buf,
+					const size_t max_len) -> size_t {
+				if (pending.empty() && next_line < LINES) {
+					snprintf(line, sizeof(line), METRICS_LINE, next_line++);
+					pending = line;
+				}
+				const size_t len = std::min<size_t>(
+						std::min<size_t>(max_len, 37), pending.size());
+				memcpy(buf, pending.data(), len);
+				pending.erase(0, len);
+				return len;
+			}, -10);
+	const std::vector<uint8_t> compressed = compress_all(zip, 1436);
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.size(), zip.getUncompressed(),
+			"The number of read bytes didn't match the generated size.");
+	TEST_ASSERT_LESS_THAN_UINT32_MESSAGE(expected.size() / 4,
+			compressed.size(),
+			"Repetitive metrics text should compress to less than a quarter of its size.");
+	check_decompressed(compressed,
+			std::vector<uint8_t>(expected.begin(), expected.end()), -10);
+}
+
+/**
+ * Test compressing with the smallest and the largest window size.
+ */
+void test_compress_wsize() {
+	const std::vector<uint8_t> data = generate_random_data(65536);
+	for (const int8_t wsize : { -8, -15 }) {
+		gzip::uzlib_gzip_wrapper zip(data.data(), data.data() + data.size(),
+				wsize);
+		const std::vector<uint8_t> compressed = compress_all(zip, 512);
+		check_decompressed(compressed, data, wsize);
+	}
+}
+
+/**
+ * Test that the compressed file can be decompressed by the python gzip module.
+ */
+void test_compress_python() {
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, std::system("python3 -V"),
+			"Failed to find python 3 interpreter.");
+
+	std::string data;
+	char line[sizeof(METRICS_LINE) + 10];
+	for (uint32_t i = 0; i < 1000; i++) {
+		snprintf(line, sizeof(line), METRICS_LINE, i);
+		data += line;
+	}
+	gzip::uzlib_gzip_wrapper zip((const uint8_t*) data.data(),
+			(const uint8_t*) data.data() + data.size(), -10);
+	const std::vector<uint8_t> compressed = compress_all(zip, 256);
+
+	char uncompressed_path[L_tmpnam < 260 ? 261 : L_tmpnam + 1];
+	TEST_ASSERT_NOT_NULL_MESSAGE(tmpnam(uncompressed_path),
+			"Failed to generate temporary file path.");
+	const std::string compressed_path = std::string(uncompressed_path) + ".gz";
+
+	std::ofstream uncompressed_out(uncompressed_path, std::ios::binary);
+	uncompressed_out.write(data.data(), data.size());
+	uncompressed_out.close();
+	std::ofstream compressed_out(compressed_path, std::ios::binary);
+	compressed_out.write((const char*) compressed.data(), compressed.size());
+	compressed_out.close();
+
+	const std::string command = std::string(CHECK_COMMAND) + compressed_path
+			+ ' ' + uncompressed_path;
+	const int result = std::system(command.c_str());
+	remove(uncompressed_path);
+	remove(compressed_path.c_str());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, result,
+			"Python failed to decompress the compressed file.");
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_compress_small);
+	RUN_TEST(test_compress_empty);
+	RUN_TEST(test_compress_large);
+	RUN_TEST(test_compress_streaming);
+	RUN_TEST(test_compress_wsize);
+	RUN_TEST(test_compress_python);
+
+	return UNITY_END();
+}
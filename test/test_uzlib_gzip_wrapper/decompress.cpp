@@ -11,10 +11,13 @@
 #include <unity.h>
 #include <uzlib_gzip_wrapper.h>
 #include <utils.h>
+#include <array>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <string>
+#include <vector>
 
 /**
  * Use a constant seed, to get reproducible results.
@@ -486,6 +489,332 @@ void test_decompress_large_wsize() {
 	delete[] decompressed;
 }
 
+/**
+ * Decompresses the file from the given wrapper in blocks of the given size, and compares it to the uncompressed data.
+ *
+ * @param unzip			The wrapper to decompress from.
+ * @param uncompressed	The expected decompressed data.
+ * @param size			The size of the uncompressed data.
+ * @param block_size	The max number of bytes to decompress at once.
+ */
+void check_decompress_blocks(gzip::uzlib_ungzip_wrapper &unzip,
+		const char *uncompressed, const size_t size, const size_t block_size) {
+	char *decompressed = new char[size + block_size];
+	size_t read = 0;
+	while (!unzip.done() && read < size + block_size) {
+		read += unzip.decompress((uint8_t*) decompressed + read, block_size);
+	}
+
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(size, read,
+			"The number of decompressed bytes didn't match the decompressed size.");
+	TEST_ASSERT_TRUE_MESSAGE(unzip.done(),
+			"The decompression wasn't considered done after decompressing everything.");
+	TEST_ASSERT_EQUAL_INT32_MESSAGE(size, unzip.getDecompressedSize(),
+			"The final decompressed size didn't match expectations.");
+	TEST_ASSERT_EQUAL_STRING_LEN_MESSAGE(uncompressed, decompressed, size,
+			"The decompressed file didn't match the uncompressed file.");
+	delete[] decompressed;
+}
+
+/**
+ * Test decompressing a file from memory using a chunk source, with chunk sizes that split the gzip trailer in various ways.
+ */
+void test_decompress_chunked() {
+	// The size of the uncompressed file used for testing.
+	const size_t FILE_SIZE = 65536;
+	// The chunk sizes to test.
+	const size_t CHUNK_SIZES[] = { 1, 2, 3, 4, 5, 7, 13, 1021, 4096, 1048576 };
+
+	check_fixtures();
+	prepare_compressed_file(FILE_SIZE);
+
+	compressed_in = new std::ifstream();
+	compressed_in->open(compressed_path, std::ios::in | std::ios::binary);
+	TEST_ASSERT_TRUE_MESSAGE(compressed_in->is_open(),
+			"Failed to open compressed file.");
+	char *compressed = new char[FILE_SIZE];
+	compressed_length = compressed_in->read(compressed, FILE_SIZE).gcount();
+	compressed_in->close();
+
+	std::ifstream uncompressed_in;
+	uncompressed_in.open(uncompressed_path);
+	TEST_ASSERT_TRUE_MESSAGE(uncompressed_in.is_open(),
+			"Failed to open uncompressed file.");
+	char *uncompressed = new char[FILE_SIZE];
+	uncompressed_in.read(uncompressed, FILE_SIZE);
+	uncompressed_in.close();
+
+	for (const size_t chunk_size : CHUNK_SIZES) {
+		size_t pos = 0;
+		size_t calls = 0;
+		gzip::uzlib_ungzip_wrapper unzip(
+				[compressed, chunk_size, &pos, &calls](
+						const uint8_t **chunk) -> size_t {
+					calls++;
+					const size_t len = std::min(chunk_size,
+							compressed_length - pos);
+					*chunk = (const uint8_t*) compressed + pos;
+					pos += len;
+					return len;
+				}, -10);
+		TEST_ASSERT_EQUAL_INT32_MESSAGE(-1, unzip.getDecompressedSize(),
+				"The initial decompressed size didn't match expectations.");
+		check_decompress_blocks(unzip, uncompressed, FILE_SIZE, 1436);
+		TEST_ASSERT_EQUAL_UINT_MESSAGE(compressed_length, pos,
+				"The compressed file wasn't read completely.");
+		TEST_ASSERT_LESS_OR_EQUAL_UINT_MESSAGE(
+				compressed_length / chunk_size + 2, calls,
+				"The source was called more often than required.");
+	}
+
+	delete[] compressed;
+	delete[] uncompressed;
+}
+
+/**
+ * Test decompressing a file streamed from the filesystem using a chunk source with an odd sized read buffer.
+ */
+void test_decompress_chunked_file() {
+	// The size of the uncompressed file used for testing.
+	const size_t FILE_SIZE = 1048576;
+	// The size of the file read buffer.
+	const size_t READ_BUFFER_SIZE = 509;
+
+	check_fixtures();
+	prepare_compressed_file(FILE_SIZE);
+
+	compressed_in = new std::ifstream();
+	compressed_in->open(compressed_path, std::ios::in | std::ios::binary);
+	TEST_ASSERT_TRUE_MESSAGE(compressed_in->is_open(),
+			"Failed to open compressed file.");
+
+	std::ifstream uncompressed_in;
+	uncompressed_in.open(uncompressed_path);
+	TEST_ASSERT_TRUE_MESSAGE(uncompressed_in.is_open(),
+			"Failed to open uncompressed file.");
+	char *uncompressed = new char[FILE_SIZE];
+	uncompressed_in.read(uncompressed, FILE_SIZE);
+	uncompressed_in.close();
+
+	uint8_t read_buffer[READ_BUFFER_SIZE];
+	gzip::uzlib_ungzip_wrapper unzip(
+			[&read_buffer](const uint8_t **chunk) -> size_t {
+				*chunk = read_buffer;
+				return compressed_in->read((char*) read_buffer,
+						READ_BUFFER_SIZE).gcount();
+			}, -10);
+	check_decompress_blocks(unzip, uncompressed, FILE_SIZE, 4096);
+	compressed_in->close();
+
+	delete[] uncompressed;
+}
+
+/**
+ * Test acquiring and releasing dicts from a dict pool.
+ */
+void test_dict_pool() {
+	gzip::uzlib_dict_pool pool(3, -10);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(3, pool.getSize(),
+			"The dict pool didn't allocate the expected number of dicts.");
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(1024, pool.getDictSize(),
+			"The dict size didn't match the window size.");
+
+	uint8_t *dicts[3];
+	for (size_t i = 0; i < 3; i++) {
+		dicts[i] = pool.acquire();
+		TEST_ASSERT_NOT_NULL_MESSAGE(dicts[i],
+				"Failed to acquire a dict from a pool with unused dicts.");
+		TEST_ASSERT_TRUE_MESSAGE(pool.contains(dicts[i]),
+				"An acquired dict wasn't considered part of the pool.");
+		for (size_t j = 0; j < i; j++) {
+			TEST_ASSERT_TRUE_MESSAGE(dicts[i] != dicts[j],
+					"The same dict was acquired twice.");
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(3, pool.getInUse(),
+			"The number of dicts in use didn't match expectations.");
+
+	TEST_ASSERT_NULL_MESSAGE(pool.acquire(),
+			"Acquired a dict from a pool without unused dicts.");
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, pool.getFailures(),
+			"The failed acquire wasn't counted.");
+
+	pool.release(dicts[1]);
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(2, pool.getInUse(),
+			"Releasing a dict didn't reduce the number of dicts in use.");
+	TEST_ASSERT_TRUE_MESSAGE(pool.acquire() == dicts[1],
+			"Didn't get the released dict back from the pool.");
+
+	for (size_t i = 0; i < 3; i++) {
+		pool.release(dicts[i]);
+	}
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, pool.getInUse(),
+			"Not all dicts were released.");
+}
+
+/**
+ * Test decompressing a file using a dict from a dict pool.
+ */
+void test_decompress_pool() {
+	// The size of the uncompressed file used for testing.
+	const size_t FILE_SIZE = 16384;
+
+	check_fixtures();
+	prepare_compressed_file(FILE_SIZE);
+
+	compressed_in = new std::ifstream();
+	compressed_in->open(compressed_path, std::ios::in | std::ios::binary);
+	TEST_ASSERT_TRUE_MESSAGE(compressed_in->is_open(),
+			"Failed to open compressed file.");
+	char *compressed = new char[FILE_SIZE];
+	compressed_length = compressed_in->read(compressed, FILE_SIZE).gcount();
+	compressed_in->close();
+
+	std::ifstream uncompressed_in;
+	uncompressed_in.open(uncompressed_path);
+	TEST_ASSERT_TRUE_MESSAGE(uncompressed_in.is_open(),
+			"Failed to open uncompressed file.");
+	char *uncompressed = new char[FILE_SIZE];
+	uncompressed_in.read(uncompressed, FILE_SIZE);
+	uncompressed_in.close();
+
+	gzip::uzlib_dict_pool pool(1, -10);
+	char *decompressed = new char[FILE_SIZE];
+	{
+		gzip::uzlib_ungzip_wrapper unzip((uint8_t*) compressed,
+				(uint8_t*) compressed + compressed_length, -10, &pool);
+		TEST_ASSERT_TRUE_MESSAGE(unzip.hasDict(),
+				"Failed to get a dict from the pool.");
+		TEST_ASSERT_EQUAL_UINT_MESSAGE(1, pool.getInUse(),
+				"The decompressor didn't take a dict from the pool.");
+
+		gzip::uzlib_ungzip_wrapper second((uint8_t*) compressed,
+				(uint8_t*) compressed + compressed_length, -10, &pool);
+		TEST_ASSERT_FALSE_MESSAGE(second.hasDict(),
+				"Got a dict from an empty pool.");
+
+		size_t read = 0;
+		while (!unzip.done() && read < FILE_SIZE) {
+			read += unzip.decompress((uint8_t*) decompressed + read,
+					std::min((size_t) 1436, FILE_SIZE - read));
+		}
+		TEST_ASSERT_EQUAL_UINT_MESSAGE(FILE_SIZE, read,
+				"The number of decompressed bytes didn't match the decompressed size.");
+		TEST_ASSERT_EQUAL_STRING_LEN_MESSAGE(uncompressed, decompressed,
+				FILE_SIZE, "The decompressed file didn't match the uncompressed file.");
+	}
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(0, pool.getInUse(),
+			"The decompressor didn't release its dict.");
+
+	delete[] compressed;
+	delete[] uncompressed;
+	delete[] decompressed;
+}
+
+/**
+ * Test starting decompression at various offsets, using inflate checkpoints from a full flushed file.
+ */
+void test_decompress_checkpoints() {
+	// The size of the uncompressed file used for testing.
+	const size_t FILE_SIZE = 65536;
+	// The number of uncompressed bytes between two checkpoints.
+	const size_t CHECKPOINT_INTERVAL = 4096;
+	// The uncompressed offsets to start decompressing at.
+	const size_t OFFSETS[] = { 0, 1, 4095, 4096, 4097, 20000, 65535 };
+
+	check_fixtures();
+
+	std::ofstream uncompressed_out;
+	uncompressed_out.open(uncompressed_path);
+	TEST_ASSERT_TRUE_MESSAGE(uncompressed_out.is_open(),
+			"Failed to open uncompressed file.");
+	write_random_data(uncompressed_out, FILE_SIZE);
+	uncompressed_out.close();
+
+	const std::string checkpoint_path = std::string(uncompressed_path) + ".cp";
+	const std::string command = std::string(BASE_COMMAND)
+			+ "--checkpoint-interval " + std::to_string(CHECKPOINT_INTERVAL)
+			+ " --checkpoint-file " + checkpoint_path + ' ' + uncompressed_path;
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, std::system(command.c_str()),
+			"GZIP compression command failed.");
+
+	std::ifstream checkpoint_in(checkpoint_path);
+	TEST_ASSERT_TRUE_MESSAGE(checkpoint_in.is_open(),
+			"Failed to open checkpoint file.");
+	std::vector<std::array<uint32_t, 2>> checkpoints;
+	uint32_t uncompressed_offset, compressed_offset;
+	while (checkpoint_in >> uncompressed_offset >> compressed_offset) {
+		checkpoints.push_back( { uncompressed_offset, compressed_offset });
+	}
+	checkpoint_in.close();
+	remove(checkpoint_path.c_str());
+	TEST_ASSERT_EQUAL_UINT_MESSAGE(FILE_SIZE / CHECKPOINT_INTERVAL,
+			checkpoints.size(),
+			"The number of checkpoints didn't match expectations.");
+
+	compressed_in = new std::ifstream();
+	compressed_in->open(compressed_path, std::ios::in | std::ios::binary);
+	TEST_ASSERT_TRUE_MESSAGE(compressed_in->is_open(),
+			"Failed to open compressed file.");
+	char *compressed = new char[FILE_SIZE];
+	compressed_length = compressed_in->read(compressed, FILE_SIZE).gcount();
+	compressed_in->close();
+
+	std::ifstream uncompressed_in;
+	uncompressed_in.open(uncompressed_path);
+	TEST_ASSERT_TRUE_MESSAGE(uncompressed_in.is_open(),
+			"Failed to open uncompressed file.");
+	char *uncompressed = new char[FILE_SIZE];
+	uncompressed_in.read(uncompressed, FILE_SIZE);
+	uncompressed_in.close();
+
+	char *decompressed = new char[FILE_SIZE];
+	for (const size_t offset : OFFSETS) {
+		// Check with and without checkpoints, to make sure both give the same result.
+		for (const bool use_checkpoints : { true, false }) {
+			gzip::uzlib_ungzip_wrapper unzip((uint8_t*) compressed,
+					(uint8_t*) compressed + compressed_length,
+					use_checkpoints ?
+							(const uint32_t (*)[2]) checkpoints.data() : NULL,
+					use_checkpoints ? checkpoints.size() : 0, offset, -10);
+			TEST_ASSERT_EQUAL_UINT32_MESSAGE(offset, unzip.getDecompressed(),
+					"The decompressor didn't start at the requested offset.");
+
+			size_t read = 0;
+			while (!unzip.done() && read < FILE_SIZE - offset) {
+				read += unzip.decompress((uint8_t*) decompressed + read,
+						std::min((size_t) 1436, FILE_SIZE - read));
+			}
+			TEST_ASSERT_EQUAL_UINT_MESSAGE(FILE_SIZE - offset, read,
+					"The number of decompressed bytes didn't match the remaining size.");
+			TEST_ASSERT_TRUE_MESSAGE(unzip.done(),
+					"The decompression wasn't considered done after decompressing everything.");
+			TEST_ASSERT_EQUAL_INT32_MESSAGE(FILE_SIZE,
+					unzip.getDecompressedSize(),
+					"The final decompressed size didn't match expectations.");
+			TEST_ASSERT_EQUAL_STRING_LEN_MESSAGE(uncompressed + offset,
+					decompressed, FILE_SIZE - offset,
+					"The decompressed file didn't match the uncompressed file.");
+		}
+	}
+
+	// Without a dict nothing can be skipped safely, so the decompressor has to stay at the start.
+	gzip::uzlib_dict_pool pool(1, -10);
+	gzip::uzlib_ungzip_wrapper first((uint8_t*) compressed,
+			(uint8_t*) compressed + compressed_length, -10, &pool);
+	gzip::uzlib_ungzip_wrapper second((uint8_t*) compressed,
+			(uint8_t*) compressed + compressed_length,
+			(const uint32_t (*)[2]) checkpoints.data(), checkpoints.size(),
+			20000, -10, &pool);
+	TEST_ASSERT_FALSE_MESSAGE(second.hasDict(), "Got a dict from an empty pool.");
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, second.getDecompressed(),
+			"The decompressor skipped data without a dict.");
+
+	delete[] compressed;
+	delete[] uncompressed;
+	delete[] decompressed;
+}
+
 /**
  * The entrypoint running this test file.
  *
@@ -500,6 +829,11 @@ int main(int argc, char **argv) {
 	RUN_TEST(test_decompress_large);
 	RUN_TEST(test_decompress_streaming);
 	RUN_TEST(test_decompress_large_wsize);
+	RUN_TEST(test_decompress_chunked);
+	RUN_TEST(test_decompress_chunked_file);
+	RUN_TEST(test_dict_pool);
+	RUN_TEST(test_decompress_pool);
+	RUN_TEST(test_decompress_checkpoints);
 
 	return UNITY_END();
 }